@@ -0,0 +1,189 @@
+/*
+ * Micro-benchmark of the Galois field region arithmetic.
+ *
+ * Reports throughput of galois_multiply_add_region(), galois_multiply_region()
+ * and galois2n_multiply_add_region() for every field size, multiplier class
+ * (0, 1, general), region size (16 B to 1 MiB), aligned/unaligned buffers
+ * and every region kernel the CPU supports. Results are printed in CSV or
+ * JSON, one record per case, so that they can be collected per host type.
+ *
+ * The SNC_GF_SIMD environment variable must not be set, otherwise all
+ * kernels fall back to the pinned one.
+ */
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "common.h"
+#include "galois.h"
+
+char usage[] = "usage: ./bench_galois [csv|json] [min_time_ms] [gfpower]\n\
+                       csv|json    - output format (default: csv)\n\
+                       min_time_ms - minimum measuring time of each case (default: 5)\n\
+                       gfpower     - only benchmark GF(2^gfpower) (default: 1-8 and 16)\n";
+
+enum { MULTIPLY_ADD, MULTIPLY, MULTIPLY_ADD_2N, NUM_FUNCS };
+static const char *func_names[NUM_FUNCS] = {
+    "galois_multiply_add_region",
+    "galois_multiply_region",
+    "galois2n_multiply_add_region"
+};
+
+#define MIN_BYTES   16
+#define MAX_BYTES   (1 << 20)
+#define ALIGNMENT   64
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void run_once(int func, struct gf_field *gf, int gfpower, GF_ELEMENT *dst, GF_ELEMENT *src, GF_WORD multiplier, int bytes)
+{
+    switch (func) {
+    case MULTIPLY_ADD:
+        galois_multiply_add_region(gf, dst, src, multiplier, bytes);
+        break;
+    case MULTIPLY:
+        galois_multiply_region(gf, dst, multiplier, bytes);
+        break;
+    case MULTIPLY_ADD_2N:
+        galois2n_multiply_add_region(gf, dst, src, (GF_ELEMENT) multiplier, bytes);
+        break;
+    }
+}
+
+#define ROUNDS      3
+
+/*
+ * Find the number of calls that take at least min_time seconds by doubling
+ * it, then time ROUNDS rounds of that many calls. Return the best seconds
+ * per call.
+ */
+static double measure(int func, struct gf_field *gf, int gfpower, GF_ELEMENT *dst, GF_ELEMENT *src, GF_WORD multiplier, int bytes, double min_time, long *calls)
+{
+    long n = 1;
+    double elapsed, best;
+    run_once(func, gf, gfpower, dst, src, multiplier, bytes);      // warm up
+    while (1) {
+        double start = now();
+        for (long i=0; i<n; i++)
+            run_once(func, gf, gfpower, dst, src, multiplier, bytes);
+        elapsed = now() - start;
+        if (elapsed >= min_time)
+            break;
+        n *= 2;
+    }
+    best = elapsed;
+    for (int r=0; r<ROUNDS; r++) {
+        double start = now();
+        for (long i=0; i<n; i++)
+            run_once(func, gf, gfpower, dst, src, multiplier, bytes);
+        elapsed = now() - start;
+        if (elapsed < best)
+            best = elapsed;
+    }
+    *calls = n;
+    return best / n;
+}
+
+int main(int argc, char *argv[])
+{
+    int json = 0;
+    double min_time = 0.005;
+    int only_power = 0;
+    if (argc > 1) {
+        if (strcmp(argv[1], "json") == 0) {
+            json = 1;
+        } else if (strcmp(argv[1], "csv") != 0) {
+            printf("%s\n", usage);
+            exit(1);
+        }
+    }
+    if (argc > 2)
+        min_time = atof(argv[2]) / 1000;
+    if (argc > 3)
+        only_power = atoi(argv[3]);
+    if (getenv("SNC_GF_SIMD") != NULL)
+        fprintf(stderr, "SNC_GF_SIMD is set, all kernels are pinned to %s\n", getenv("SNC_GF_SIMD"));
+
+    int powers[] = {1, 2, 3, 4, 5, 6, 7, 8, 16};
+    int npowers = sizeof(powers) / sizeof(powers[0]);
+
+    GF_ELEMENT *srcbuf, *dstbuf;
+    if (posix_memalign((void **) &srcbuf, ALIGNMENT, MAX_BYTES + ALIGNMENT) != 0
+            || posix_memalign((void **) &dstbuf, ALIGNMENT, MAX_BYTES + ALIGNMENT) != 0) {
+        fprintf(stderr, "allocate buffers failed\n");
+        exit(1);
+    }
+    for (int i=0; i<MAX_BYTES+ALIGNMENT; i++) {
+        srcbuf[i] = rand();
+        dstbuf[i] = rand();
+    }
+
+    const char *host_simd = galois_simd_name(galois_cpu_simd());
+    if (json)
+        printf("{\"cpu_simd\": \"%s\", \"results\": [\n", host_simd);
+    else
+        printf("cpu_simd,isa,gfpower,function,multiplier,bytes,aligned,calls,ns_per_call,gbps\n");
+    int records = 0;
+
+    for (int simd=GF_SIMD_SCALAR; simd<GF_SIMD_NUM; simd++) {
+        // skip kernels the CPU does not support (galois_set_simd falls back)
+        galois_set_simd(simd);
+        if (galois_get_simd() != simd)
+            continue;
+        for (int p=0; p<npowers; p++) {
+            int gfpower = powers[p];
+            if (only_power != 0 && gfpower != only_power)
+                continue;
+            struct gf_field *gf = gf_field_get(gfpower);
+            if (gf == NULL) {
+                fprintf(stderr, "create GF(2^%d) failed\n", gfpower);
+                exit(1);
+            }
+            // a general multiplier, neither 0 nor 1
+            GF_WORD general = gfpower == 16 ? 0x5b3d : (0x5b & ((1 << gfpower) - 1));
+            for (int func=0; func<NUM_FUNCS; func++) {
+                // galois2n_ takes one-byte multipliers
+                if (func == MULTIPLY_ADD_2N && gfpower == 16)
+                    continue;
+                for (int m=0; m<3; m++) {
+                    GF_WORD multiplier = m == 2 ? general : m;
+                    const char *mclass = m == 0 ? "0" : (m == 1 ? "1" : "general");
+                    if (m == 2 && gfpower == 1)
+                        continue;       // GF(2) has no other multipliers
+                    for (int bytes=MIN_BYTES; bytes<=MAX_BYTES; bytes*=4) {
+                        for (int aligned=1; aligned>=0; aligned--) {
+                            GF_ELEMENT *src = srcbuf + (aligned ? 0 : 1);
+                            GF_ELEMENT *dst = dstbuf + (aligned ? 0 : 3);
+                            long calls;
+                            double t = measure(func, gf, gfpower, dst, src, multiplier, bytes, min_time, &calls);
+                            double gbps = bytes / t / 1e9;
+                            if (json) {
+                                printf("%s{\"isa\": \"%s\", \"gfpower\": %d, \"function\": \"%s\", \"multiplier\": \"%s\", "
+                                       "\"bytes\": %d, \"aligned\": %d, \"calls\": %ld, \"ns_per_call\": %.3f, \"gbps\": %.4f}",
+                                       records ? ",\n" : "", galois_simd_name(simd), gfpower, func_names[func], mclass,
+                                       bytes, aligned, calls, t * 1e9, gbps);
+                            } else {
+                                printf("%s,%s,%d,%s,%s,%d,%d,%ld,%.3f,%.4f\n",
+                                       host_simd, galois_simd_name(simd), gfpower, func_names[func], mclass,
+                                       bytes, aligned, calls, t * 1e9, gbps);
+                            }
+                            records++;
+                        }
+                    }
+                }
+            }
+            gf_field_put(gf);
+        }
+    }
+    if (json)
+        printf("\n]}\n");
+    free(srcbuf);
+    free(dstbuf);
+    return 0;
+}
@@ -63,6 +63,8 @@ int main(int argc, char *argv[])
     sp.bnc      = 0;
     sp.sys      = 0;
     sp.seed     = -1;
+    sp.nnz      = 0;
+    sp.seeded   = 0;
 
     double delta = atof(argv[8]);
     double epsil = atof(argv[9]);
@@ -37,6 +37,8 @@ int main(int argc, char *argv[])
     sp.bnc      = 0;
     sp.sys      = 1;
     sp.seed     = -1;
+    sp.nnz      = 0;
+    sp.seeded   = 0;
 
     int bufsize = atoi(argv[3]);
     double delta = atof(argv[4]);
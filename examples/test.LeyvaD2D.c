@@ -94,6 +94,8 @@ int main(int argc, char *argv[])
     sp.gfpower  = 8;
     sp.sys      = 1;
     sp.seed     = -1;
+    sp.nnz      = 0;
+    sp.seeded   = 0;
 
     double alpha = 0.05;        // DO NOT change this. The value is in accordance with that in the paper.
 
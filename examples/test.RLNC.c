@@ -30,6 +30,8 @@ int main(int argc, char *argv[])
     sp.bpc      = 0;
     sp.sys      = 0;
     sp.seed     = -1;  // Initialize seed as -1
+    sp.nnz      = 0;
+    sp.seeded   = 0;
     if (argc == 4 && atoi(argv[3]) == 1)
         sp.bnc = 1;
     else
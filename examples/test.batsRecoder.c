@@ -74,6 +74,8 @@ int main(int argc, char *argv[])
     sp.gfpower  = gfpower;
     sp.sys      = 0;
     sp.seed     = -1;
+    sp.nnz      = 0;
+    sp.seeded   = 0;
     sp.type     = BATS_SNC;
 
 
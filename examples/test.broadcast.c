@@ -40,6 +40,8 @@ int main(int argc, char *argv[])
     sp.gfpower  = 8;
     sp.sys      = 1;
     sp.seed     = -1;
+    sp.nnz      = 0;
+    sp.seeded   = 0;
 
     double alpha = 0.05;
     int nUsers = atoi(argv[1]);
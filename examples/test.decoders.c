@@ -5,11 +5,12 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <pthread.h>
 #include "sparsenc.h"
 
-char usage[] = "usage: ./sncDecoder code_t dec_t datasize size_p size_c size_b size_g bpc gfpower sys\n\
-                       code_t   - RAND, BAND, WINDWRAP\n\
-                       dec_t    - GG, OA, BD, CBD, PP\n\
+char usage[] = "usage: ./sncDecoder code_t dec_t datasize size_p size_c size_b size_g bpc gfpower sys [nnz [seeded]]\n\
+                       code_t   - RAND, BAND, WINDWRAP, BATS, RAPTOR\n\
+                       dec_t    - GG, OA, BD, CBD, PP, RP (RAPTOR only)\n\
                        datasize - Number of bytes\n\
                        size_p   - Packet size in bytes\n\
                        size_c   - Nnumebr of check packets\n\
@@ -17,10 +18,42 @@ char usage[] = "usage: ./sncDecoder code_t dec_t datasize size_p size_c size_b s
                        size_g   - Subgeneration size\n\
                        bpc      - Use binary precode (0 or 1)\n\
                        gfpower  - Power of GF size\n\
-                       sys      - Systematic code (0 or 1)\n";
+                       sys      - Systematic code (0 or 1)\n\
+                       nnz      - Non-zero coefficients of coded packets (optional, 0 for all)\n\
+                       seeded   - Packets carry a counter instead of coefficients (optional, 0 or 1)\n\
+                       env SNC_BATCH=n - Generate coded packets n at a time by snc_generate_packets()\n\
+                       env SNC_BORROW=1 - Encode from the data buffer in place (snc_create_enc_context_borrowed())\n\
+                       env SNC_ENC_WORKERS=n - Generate coded packets by n encode workers on n threads\n\
+                                               (RAND, BAND, WINDWRAP; SNC_BATCH packets per worker)\n";
+
+struct worker_arg {
+    struct snc_enc_worker *worker;
+    struct snc_packet     **pkts;   // packets to be generated by the worker
+    int                   n;
+};
+
+static void *generate_by_worker(void *arg)
+{
+    struct worker_arg *wa = arg;
+    for (int i=0; i<wa->n; i++)
+        snc_worker_generate_packet_im(wa->worker, wa->pkts[i]);
+    return NULL;
+}
+
+// Generate a batch of coded packets by the workers concurrently
+static void generate_by_workers(struct worker_arg *wargs, int nworkers)
+{
+    pthread_t *tids = malloc(sizeof(pthread_t) * nworkers);
+    for (int i=0; i<nworkers; i++)
+        pthread_create(&tids[i], NULL, generate_by_worker, &wargs[i]);
+    for (int i=0; i<nworkers; i++)
+        pthread_join(tids[i], NULL);
+    free(tids);
+}
+
 int main(int argc, char *argv[])
 {
-    if (argc != 11) {
+    if (argc < 11 || argc > 13) {
         printf("%s\n", usage);
         exit(1);
     }
@@ -33,6 +66,8 @@ int main(int argc, char *argv[])
         sp.type = WINDWRAP_SNC;
     else if (strcmp(argv[1], "BATS") == 0)
         sp.type = BATS_SNC;
+    else if (strcmp(argv[1], "RAPTOR") == 0)
+        sp.type = RAPTOR_SNC;
     else {
         printf("%s\n", usage);
         exit(1);
@@ -49,6 +84,8 @@ int main(int argc, char *argv[])
         decoder_type = CBD_DECODER;
     else if (strcmp(argv[2], "PP") == 0)
         decoder_type = PP_DECODER;
+    else if (strcmp(argv[2], "RP") == 0)
+        decoder_type = RP_DECODER;
     else {
         printf("%s\n", usage);
         exit(1);
@@ -62,6 +99,8 @@ int main(int argc, char *argv[])
     sp.gfpower  = atoi(argv[9]);
     sp.sys      = atoi(argv[10]);
     sp.seed     = -1;  // Initialize seed as -1
+    sp.nnz      = argc >= 12 ? atoi(argv[11]) : 0;
+    sp.seeded   = argc == 13 ? atoi(argv[12]) : 0;
 
     char *ur = getenv("SNC_NONUNIFORM_RAND");
     if ( ur != NULL && atoi(ur) == 1) {
@@ -79,8 +118,15 @@ int main(int argc, char *argv[])
     read(rnd, buf, sp.datasize);
     close(rnd);
 
+    // The buffer outlives the encode context, so it may be borrowed instead of copied
+    char *bw = getenv("SNC_BORROW");
+    int borrow = bw != NULL && atoi(bw) == 1;
     struct snc_context *sc;
-    if ((sc = snc_create_enc_context(buf, &sp)) == NULL) {
+    if (borrow)
+        sc = snc_create_enc_context_borrowed(buf, &sp);
+    else
+        sc = snc_create_enc_context(buf, &sp);
+    if (sc == NULL) {
         fprintf(stderr, "Cannot create File Context.\n");
         return 1;
     }
@@ -112,13 +158,52 @@ int main(int argc, char *argv[])
 
     decoder = snc_restore_decoder("CBDdecoder.part");
     */
+    // Coded packets generated in batches are sent one by one
+    char *bs = getenv("SNC_BATCH");
+    int batch = bs != NULL ? atoi(bs) : 0;
+    char *ew = getenv("SNC_ENC_WORKERS");
+    int nworkers = ew != NULL ? atoi(ew) : 0;
+    int per_worker = batch > 0 ? batch : 1;
+    if (nworkers > 0)
+        batch = nworkers * per_worker;
+    struct snc_packet **pkts = NULL;
+    if (batch > 0) {
+        pkts = malloc(sizeof(struct snc_packet *) * batch);
+        for (int i=0; i<batch; i++)
+            pkts[i] = snc_alloc_empty_packet(&sp);
+    }
+    struct worker_arg *wargs = NULL;
+    if (nworkers > 0) {
+        wargs = malloc(sizeof(struct worker_arg) * nworkers);
+        for (int i=0; i<nworkers; i++) {
+            if ((wargs[i].worker = snc_create_enc_worker(sc, i, nworkers)) == NULL)
+                exit(1);
+            wargs[i].pkts = &pkts[i*per_worker];
+            wargs[i].n    = per_worker;
+        }
+    }
+    int next = batch;
+
     clock_t send_start = clock();
     clock_t decode_delay = 0;
     while (snc_decoder_finished(decoder) != 1) {
-        struct snc_packet *pkt = snc_generate_packet(sc);
+        struct snc_packet *pkt;
+        if (batch > 0) {
+            if (next == batch) {
+                if (nworkers > 0)
+                    generate_by_workers(wargs, nworkers);
+                else
+                    snc_generate_packets(sc, pkts, batch);
+                next = 0;
+            }
+            pkt = pkts[next++];
+        } else {
+            pkt = snc_generate_packet(sc);
+        }
         /* Measure decoding time */
         unsigned char *pktstr = snc_serialize_packet(pkt, &sp);
-        snc_free_packet(pkt);
+        if (batch == 0)
+            snc_free_packet(pkt);
         pkt = snc_deserialize_packet(pktstr, &sp);
         start = clock();
         snc_process_packet(decoder, pkt);
@@ -138,6 +223,12 @@ int main(int argc, char *argv[])
 
     print_code_summary(dsc, snc_decode_overhead(decoder), snc_decode_cost(decoder));
 
+    for (int i=0; i<nworkers; i++)
+        snc_free_enc_worker(wargs[i].worker);
+    free(wargs);
+    for (int i=0; i<batch; i++)
+        snc_free_packet(pkts[i]);
+    free(pkts);
     snc_free_enc_context(sc);
     snc_free_decoder(decoder);
     return 0;
@@ -0,0 +1,123 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "sparsenc.h"
+
+char usage[] = "usage: ./sncFeedback code_t dec_t datasize size_p size_c size_b size_g gfpower pe fbint\n\
+                       code_t   - RAND, BAND, WINDWRAP\n\
+                       dec_t    - GG, OA, BD, CBD, PP\n\
+                       datasize - Number of bytes\n\
+                       size_p   - Packet size in bytes\n\
+                       size_c   - Number of parity-check packets of precode\n\
+                       size_b   - Base subgeneration size\n\
+                       size_g   - Subgeneration size (after adding overlap)\n\
+                       gfpower  - Power of GF size\n\
+                       pe       - Erasure probability of the channel\n\
+                       fbint    - Packets sent between feedbacks of the decoder\n";
+
+/*
+ * Send coded packets over an erasure channel until the decoder finishes. If
+ * fbint > 0, the decoder feeds back every fbint sent packets (over a reliable
+ * channel) and the encoder schedules subgenerations accordingly.
+ */
+static long transmit(unsigned char *data, struct snc_parameters *sp, int decoder_type, double pe, int fbint, int *errors)
+{
+    struct snc_context *sc = snc_create_enc_context(data, sp);
+    struct snc_decoder *decoder = snc_create_decoder(sp, decoder_type);
+    if (sc == NULL || decoder == NULL)
+        exit(1);
+    struct snc_packet *pkt = snc_alloc_empty_packet(sp);
+    long sent = 0;
+    int fbbytes = 0;
+    while (!snc_decoder_finished(decoder)) {
+        snc_generate_packet_im(sc, pkt);
+        sent++;
+        if ((double) rand() / RAND_MAX >= pe) {
+            struct snc_packet *rcv = snc_duplicate_packet(pkt, sp);
+            snc_process_packet(decoder, rcv);
+            snc_free_packet(rcv);
+        }
+        if (fbint > 0 && sent % fbint == 0) {
+            struct snc_feedback *fb = snc_generate_feedback(decoder);
+            unsigned char *fbstr = snc_serialize_feedback(fb);
+            fbbytes = snc_feedback_length(fb);
+            snc_free_feedback(fb);
+            fb = snc_deserialize_feedback(fbstr);
+            snc_apply_feedback(sc, fb);
+            snc_free_feedback(fb);
+            free(fbstr);
+        }
+    }
+    unsigned char *rec = snc_recover_data(snc_get_enc_context(decoder));
+    if (memcmp(rec, data, sp->datasize) != 0)
+        *errors += 1;
+    if (fbint > 0)
+        printf("feedback size: %d bytes\n", fbbytes);
+    snc_free_recovered(rec);
+    snc_free_packet(pkt);
+    snc_free_decoder(decoder);
+    snc_free_enc_context(sc);
+    return sent;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 11) {
+        printf("%s\n", usage);
+        exit(1);
+    }
+    struct snc_parameters sp;
+    if (strcmp(argv[1], "RAND") == 0)
+        sp.type = RAND_SNC;
+    else if (strcmp(argv[1], "BAND") == 0)
+        sp.type = BAND_SNC;
+    else if (strcmp(argv[1], "WINDWRAP") == 0)
+        sp.type = WINDWRAP_SNC;
+    else {
+        printf("%s\n", usage);
+        exit(1);
+    }
+    int decoder_type;
+    if (strcmp(argv[2], "GG") == 0)
+        decoder_type = GG_DECODER;
+    else if (strcmp(argv[2], "OA") == 0)
+        decoder_type = OA_DECODER;
+    else if (strcmp(argv[2], "BD") == 0)
+        decoder_type = BD_DECODER;
+    else if (strcmp(argv[2], "CBD") == 0)
+        decoder_type = CBD_DECODER;
+    else if (strcmp(argv[2], "PP") == 0)
+        decoder_type = PP_DECODER;
+    else {
+        printf("%s\n", usage);
+        exit(1);
+    }
+    sp.datasize = atoi(argv[3]);
+    sp.size_p   = atoi(argv[4]);
+    sp.size_c   = atoi(argv[5]);
+    sp.size_b   = atoi(argv[6]);
+    sp.size_g   = atoi(argv[7]);
+    sp.gfpower  = atoi(argv[8]);
+    double pe   = atof(argv[9]);
+    int fbint   = atoi(argv[10]);
+    sp.bpc      = 0;
+    sp.sys      = 0;
+    sp.seed     = -1;
+    sp.nnz      = 0;
+    sp.seeded   = 0;
+
+    srand(1234);
+    unsigned char *data = malloc(sp.datasize);
+    for (long i=0; i<sp.datasize; i++)
+        data[i] = rand() % 256;
+
+    // Both runs code the same data with the same seed
+    int errors = 0;
+    long sent_nofb = transmit(data, &sp, decoder_type, pe, 0, &errors);
+    long sent_fb   = transmit(data, &sp, decoder_type, pe, fbint, &errors);
+    int snum = (sp.datasize + sp.size_p - 1) / sp.size_p;
+    printf("snum: %d sent without feedback: %ld (%.4f) sent with feedback every %d: %ld (%.4f) errors: %d\n",
+           snum, sent_nofb, (double) sent_nofb / snum, fbint, sent_fb, (double) sent_fb / snum, errors);
+    free(data);
+    return errors != 0;
+}
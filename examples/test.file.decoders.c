@@ -9,7 +9,8 @@
 
 char usage[] = "usage: ./programName code_t dec_t chunksize size_p size_c size_b size_g filename\n\
                        code_t - RAND, BAND, WINDWRAP\n\
-                       dec_t  - GG, OA, BD, CBD\n";
+                       dec_t  - GG, OA, BD, CBD\n\
+                       env SNC_MAP_FILE=1 - Map chunks of the file instead of loading them (snc_map_file_to_context())\n";
 int main(int argc, char *argv[])
 {
     if (argc != 9) {
@@ -48,9 +49,11 @@ int main(int argc, char *argv[])
     sp.size_g   = atoi(argv[7]);
     char *filename = argv[8];
     sp.bpc      = 0;
-    sp.bnc      = 0;
+    sp.gfpower  = 8;
     sp.sys      = 0;
     sp.seed     = -1;  // Initialize seed as -1
+    sp.nnz      = 0;
+    sp.seeded   = 0;
     char *copyname = calloc(strlen(argv[8])+strlen(".dec.copy")+1, sizeof(char));
     strcat(copyname, filename);
     strcat(copyname, ".dec.copy");
@@ -66,6 +69,8 @@ int main(int argc, char *argv[])
 
     int chunks = filesize % sp.datasize == 0 ? filesize/sp.datasize : filesize/sp.datasize+1;
     printf("File size: %d splitted to %d chunks\n", filesize, chunks);
+    char *mf = getenv("SNC_MAP_FILE");
+    int map = mf != NULL && atoi(mf) == 1;
     struct snc_context *sc;
     long remaining = filesize;
     long start = 0;
@@ -82,7 +87,12 @@ int main(int argc, char *argv[])
             fprintf(stderr, "Cannot create File Context.\n");
             return 1;
         }
-        snc_load_file_to_context(filename, start, sc);
+        int loaded = map ? snc_map_file_to_context(filename, start, sc)
+                         : snc_load_file_to_context(filename, start, sc);
+        if (loaded != 0) {
+            fprintf(stderr, "Cannot load file into File Context.\n");
+            return 1;
+        }
         remaining -= toEncode;
         start += toEncode;
         chunks--;
@@ -92,6 +92,8 @@ int main(int argc, char *argv[])
     sp.gfpower  = atoi(argv[10]);
     sp.sys      = atoi(argv[11]);
     sp.seed     = -1;
+    sp.nnz      = 0;
+    sp.seeded   = 0;
     int bufsize = atoi(argv[12]);
     int numhop  = atoi(argv[13]);    // Number of hops of the line network
     int *rate   = malloc(sizeof(int) * numhop);
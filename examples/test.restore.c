@@ -59,6 +59,8 @@ int main(int argc, char *argv[])
     sp.bnc      = atoi(argv[9]);
     sp.sys      = atoi(argv[10]);
     sp.seed     = -1;  // Initialize seed as -1
+    sp.nnz      = 0;
+    sp.seeded   = 0;
 
     srand( (int) time(0) );
     unsigned char *buf = malloc(sp.datasize);
@@ -0,0 +1,177 @@
+#include <sys/time.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "sparsenc.h"
+
+#define BATCH   32      // packets of each unfinished segment per round
+
+char usage[] = "usage: ./sncSession code_t dec_t size segsize size_p size_c size_b size_g gfpower nthreads pe\n\
+                       code_t   - RAND, BAND, WINDWRAP, BATS, RAPTOR\n\
+                       dec_t    - GG, OA, BD, CBD, PP, RP (RAPTOR only)\n\
+                       size     - Object size in bytes\n\
+                       segsize  - Segment size in bytes\n\
+                       size_p   - Packet size in bytes\n\
+                       size_c   - Number of check packets of each segment\n\
+                       size_b   - Subgeneration distance\n\
+                       size_g   - Subgeneration size\n\
+                       gfpower  - Power of GF size\n\
+                       nthreads - Threads of the sessions (0 for automatic)\n\
+                       pe       - Erasure probability of the channel\n";
+static char infile[]  = "snc_session.in";
+static char outfile[] = "snc_session.out";
+
+/*
+ * Code an object of size bytes by sessions, send the packets of unfinished
+ * segments over an erasure channel, and verify the recovered object.
+ */
+static int run_session(long size, struct snc_parameters *spp, int decoder_type, int nthreads, double pe)
+{
+    struct snc_parameters sp = *spp;
+    srand(1234);
+    unsigned char *data = malloc(size);
+    for (long i=0; i<size; i++)
+        data[i] = rand() % 256;
+    FILE *fp = fopen(infile, "w");
+    if (fp == NULL || fwrite(data, 1, size, fp) != size) {
+        printf("cannot write %s\n", infile);
+        exit(1);
+    }
+    fclose(fp);
+
+    struct timeval t0, t1;
+    gettimeofday(&t0, NULL);
+    struct snc_session *enc = snc_create_enc_session_file(infile, 0, -1, &sp, nthreads);
+    gettimeofday(&t1, NULL);
+    struct snc_session *dec = snc_create_dec_session(size, &sp, decoder_type, nthreads);
+    if (enc == NULL || dec == NULL)
+        exit(1);
+    int nseg = snc_session_segments(enc);
+
+    // Coded packets of every unfinished segment are generated, sent over
+    // the channel and decoded in batches
+    int maxpkt = nseg * BATCH;
+    struct snc_packet *pkt = snc_alloc_empty_packet(snc_get_parameters(snc_session_get_context(enc, 0)));
+    struct snc_packet **rcvd = calloc(maxpkt, sizeof(struct snc_packet *));
+    int *segids = calloc(maxpkt, sizeof(int));
+    long sent = 0;
+    double decode_time = 0;
+    while (!snc_session_finished(dec)) {
+        int n = 0;
+        for (int s=0; s<nseg; s++) {
+            if (snc_session_segment_finished(dec, s))
+                continue;
+            for (int k=0; k<BATCH; k++) {
+                snc_session_generate_packet_im(enc, s, pkt);
+                sent++;
+                if ((double) rand() / RAND_MAX < pe)
+                    continue;
+                unsigned char *pktstr = snc_session_serialize_packet(enc, s, pkt);
+                rcvd[n] = snc_session_deserialize_packet(dec, pktstr, &segids[n]);
+                free(pktstr);
+                n++;
+            }
+        }
+        struct timeval d0, d1;
+        gettimeofday(&d0, NULL);
+        if (snc_session_process_packets(dec, segids, rcvd, n) != 0) {
+            printf("cannot process packets of the session\n");
+            exit(1);
+        }
+        gettimeofday(&d1, NULL);
+        decode_time += d1.tv_sec - d0.tv_sec + (d1.tv_usec - d0.tv_usec) * 1e-6;
+        for (int i=0; i<n; i++)
+            snc_free_packet(rcvd[i]);
+    }
+
+    int errors = 0;
+    unsigned char *rec = snc_session_recover_data(dec);
+    if (rec == NULL || memcmp(rec, data, size) != 0)
+        errors++;
+    snc_free_recovered(rec);
+    remove(outfile);
+    if (snc_session_recover_to_file(outfile, 0, dec) != size) {
+        errors++;
+    } else {
+        rec = malloc(size);
+        fp = fopen(outfile, "r");
+        if (fp == NULL || fread(rec, 1, size, fp) != size || memcmp(rec, data, size) != 0)
+            errors++;
+        if (fp != NULL)
+            fclose(fp);
+        free(rec);
+    }
+    remove(infile);
+    remove(outfile);
+
+    printf("segments: %d seed: %d sent: %ld overhead: %.4f encode setup: %.3f s decode: %.3f s (%.1f MB/s) errors: %d\n",
+           nseg, sp.seed, sent, (double) sent * sp.size_p / size,
+           t1.tv_sec - t0.tv_sec + (t1.tv_usec - t0.tv_usec) * 1e-6,
+           decode_time, size / decode_time / 1e6, errors);
+    snc_free_packet(pkt);
+    free(rcvd);
+    free(segids);
+    free(data);
+    snc_free_session(enc);
+    snc_free_session(dec);
+    return errors;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 12) {
+        printf("%s\n", usage);
+        exit(1);
+    }
+    struct snc_parameters sp;
+    if (strcmp(argv[1], "RAND") == 0)
+        sp.type = RAND_SNC;
+    else if (strcmp(argv[1], "BAND") == 0)
+        sp.type = BAND_SNC;
+    else if (strcmp(argv[1], "WINDWRAP") == 0)
+        sp.type = WINDWRAP_SNC;
+    else if (strcmp(argv[1], "BATS") == 0)
+        sp.type = BATS_SNC;
+    else if (strcmp(argv[1], "RAPTOR") == 0)
+        sp.type = RAPTOR_SNC;
+    else {
+        printf("%s\n", usage);
+        exit(1);
+    }
+    int decoder_type;
+    if (strcmp(argv[2], "GG") == 0)
+        decoder_type = GG_DECODER;
+    else if (strcmp(argv[2], "OA") == 0)
+        decoder_type = OA_DECODER;
+    else if (strcmp(argv[2], "BD") == 0)
+        decoder_type = BD_DECODER;
+    else if (strcmp(argv[2], "CBD") == 0)
+        decoder_type = CBD_DECODER;
+    else if (strcmp(argv[2], "PP") == 0)
+        decoder_type = PP_DECODER;
+    else if (strcmp(argv[2], "RP") == 0)
+        decoder_type = RP_DECODER;
+    else {
+        printf("%s\n", usage);
+        exit(1);
+    }
+    long size     = atol(argv[3]);
+    sp.datasize   = atol(argv[4]);
+    sp.size_p     = atoi(argv[5]);
+    sp.size_c     = atoi(argv[6]);
+    sp.size_b     = atoi(argv[7]);
+    sp.size_g     = atoi(argv[8]);
+    sp.gfpower    = atoi(argv[9]);
+    int nthreads  = atoi(argv[10]);
+    double pe     = atof(argv[11]);
+    sp.bpc        = 0;
+    sp.sys        = 0;
+    sp.seed       = -1;
+    sp.nnz        = 0;
+    sp.seeded     = 0;
+
+    // The object of the given size, and one with a 1-byte last segment
+    int errors = run_session(size, &sp, decoder_type, nthreads, pe);
+    errors += run_session(size / sp.datasize * sp.datasize + 1, &sp, decoder_type, nthreads, pe);
+    return errors != 0;
+}
@@ -0,0 +1,92 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "sparsenc.h"
+
+char usage[] = "usage: ./sncStream size_p size_w gfpower npackets pe repair sys\n\
+                       size_p   - Packet size in bytes\n\
+                       size_w   - Coding window size\n\
+                       gfpower  - Power of GF size (1, 8 or 16)\n\
+                       npackets - Number of source packets of the stream\n\
+                       pe       - Erasure probability of the channel\n\
+                       repair   - Number of extra coded packets per source packet (e.g., 0.25)\n\
+                       sys      - Send each source packet uncoded first (0 or 1)\n";
+int main(int argc, char *argv[])
+{
+    if (argc != 8) {
+        printf("%s\n", usage);
+        exit(1);
+    }
+    int size_p   = atoi(argv[1]);
+    int size_w   = atoi(argv[2]);
+    int gfpower  = atoi(argv[3]);
+    int npackets = atoi(argv[4]);
+    double pe    = atof(argv[5]);
+    double repair = atof(argv[6]);
+    int sys      = atoi(argv[7]);
+
+    srand(1234);
+    struct snc_stream_encoder *enc = snc_create_stream_encoder(size_p, size_w, gfpower, 1234);
+    struct snc_stream_decoder *dec = snc_create_stream_decoder(size_p, size_w, gfpower);
+    struct snc_stream_packet *pkt  = snc_alloc_stream_packet(size_p, size_w, gfpower);
+    if (enc == NULL || dec == NULL || pkt == NULL)
+        exit(1);
+    unsigned char *data = malloc((size_t) npackets * size_p);
+    unsigned char *out  = malloc(size_p);
+    for (long i=0; i<(long) npackets*size_p; i++)
+        data[i] = rand() % 256;
+
+    int sent = 0, delivered = 0, lost = 0, errors = 0;
+    int popped = 0;
+    long delay = 0;         // sum of the number of packets appended after each delivered one
+    double credit = 0;
+    for (int i=0; i<npackets+size_w; i++) {
+        int nsend = 1;
+        if (i < npackets) {
+            snc_stream_append(enc, &data[(long) i*size_p], size_p);
+            credit += repair;
+            while (credit >= 1) {
+                nsend++;
+                credit -= 1;
+            }
+        }
+        for (int k=0; k<nsend; k++) {
+            if (sys && k == 0 && i < npackets)
+                snc_stream_source_packet_im(enc, pkt);
+            else
+                snc_stream_generate_packet_im(enc, pkt);
+            sent++;
+            if ((double) rand() / RAND_MAX < pe)
+                continue;
+            // packets cross the channel serialized
+            unsigned char *pktstr = snc_stream_serialize_packet(pkt, size_p, gfpower);
+            struct snc_stream_packet *rcv = snc_stream_deserialize_packet(pktstr, size_p, size_w, gfpower);
+            snc_stream_process_packet(dec, rcv);
+            snc_free_stream_packet(rcv);
+            free(pktstr);
+        }
+        int seq, islost;
+        while ((seq = snc_stream_pop(dec, out, &islost)) != -1) {
+            if (seq < popped)
+                errors++;       // out of order
+            popped = seq + 1;
+            if (islost) {
+                lost++;
+                continue;
+            }
+            delivered++;
+            delay += (i < npackets ? i : npackets - 1) - seq;
+            if (memcmp(out, &data[(long) seq*size_p], size_p) != 0)
+                errors++;
+        }
+    }
+    printf("size_p: %d size_w: %d GF(2^%d) sys: %d sent: %d delivered: %d lost: %d mean delay: %.2f packets errors: %d\n",
+           size_p, size_w, gfpower, sys, sent, delivered, lost,
+           delivered ? (double) delay / delivered : 0.0, errors);
+    snc_free_stream_packet(pkt);
+    snc_free_stream_encoder(enc);
+    snc_free_stream_decoder(dec);
+    free(data);
+    free(out);
+    return errors != 0;
+}
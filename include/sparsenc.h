@@ -23,12 +23,15 @@ typedef unsigned char GF_ELEMENT;
  * OA  - Overlap aware decoder
  * BD  - Band decoder with pivoting
  * CBD - Compact band decoder with compact decoding matrix representation
+ * PP  - Perpetual decoder
+ * RP  - Raptor decoder (peeling with inactivation), for RAPTOR code only
  */
 #define GG_DECODER  0
 #define OA_DECODER  1
 #define BD_DECODER  2
 #define CBD_DECODER 3
 #define PP_DECODER  4
+#define RP_DECODER  5
 
 /*
  * Type of scheduling algorithms for SNC recoding
@@ -51,6 +54,8 @@ struct snc_packet {
                         // (note: not the packet index; -1 if it's coded)
     GF_ELEMENT  *coes;  // SIZE_G coding coefficients of coded packet
     GF_ELEMENT  *syms;  // SIZE_P symbols of coded packet
+    unsigned int ctr;   // counter of a seeded coefficient vector (see snc_parameters.seeded);
+                        // 0 if the coefficients are explicit
 };
 
 // SNC parameters for the data to be snc-coded
@@ -62,17 +67,58 @@ struct snc_parameters {
     int     size_g;     // subgeneration size
     int     type;       // Code type
     int     bpc;        // binary precode or GF(256) precode
-    int     gfpower;    // Power of Galois field for NC, supports {1,2,...,8}, i.e., GF(2),...,GF(256)
+    int     gfpower;    // Power of Galois field for NC, supports {1,2,...,8,16}, i.e., GF(2),...,GF(256),GF(65536)
     int     sys;        // systematic code
     int     seed;       // seed of local RNG
+    int     nnz;        // non-zero coefficients of coded packets (0 for all size_g)
+    int     seeded;     // coded packets carry a counter instead of their coefficients (0 or 1)
 };
 
+/*
+ * Options of encode contexts and decoders. snc_default_options() fills
+ * in the defaults, which are read from the environment variables below
+ * once per process; options passed at creation override them.
+ */
+struct snc_options {
+    int     loglevel;           // SNC_LOG_LEVEL: 5 (TRACE) prints decoding traces, 0 prints none (process-wide)
+    int     hdpc;               // SNC_PRECODE=HDPC: dense reference precode instead of LDPC (development only)
+    int     nonuniform_rand;    // SNC_NONUNIFORM_RAND=1: non-uniform scheduling of BAND code with size_b=1
+    int     precode_threads;    // SNC_PRECODE_THREADS: threads of precoding, 0 for automatic
+    int     gfpower;            // GF_POWER: overrides gfpower of code parameters if non-zero (research only)
+    double  oa_aoh;             // SNC_OA_AOH: allowed overhead of OA decoder, as a fraction of source packets
+    int     oa_oneround;        // SNC_OA_ONEROUND=1: one-round inactivation pivoting in OA decoder
+    int     bd_oneround;        // SNC_BD_ONEROUND=1: one-round inactivation pivoting in BD decoder
+};
+
+struct snc_enc_worker;  // Worker generating packets from a shared encode context
+
 struct snc_decoder;     // Sparse network code decoder
 
 struct snc_buffer;      // Buffer for storing snc packets
 
 struct snc_buffer_bats;
 
+struct snc_stream_encoder;  // Sliding-window encoder of an unbounded packet stream
+
+struct snc_stream_decoder;  // In-order decoder of a sliding-window coded stream
+
+struct snc_session;         // Object split into segments, each coded by its own context/decoder
+
+// Packet of a sliding-window coded stream
+struct snc_stream_packet {
+    int         first;  // sequence number of the first source packet in the coding window
+    int         count;  // number of source packets in the coding window
+    GF_ELEMENT  *coes;  // count coding coefficients, one byte each (two bytes for GF(2^16))
+    GF_ELEMENT  *syms;  // SIZE_P symbols of coded packet
+};
+
+// Decoder feedback on the subgenerations of a code (RAND, BAND and WINDWRAP)
+struct snc_feedback {
+    int             gnum;       // number of subgenerations
+    unsigned char  *completed;  // bitmap of completed subgenerations, (gnum+7)/8 bytes
+    int            *missing;    // missing DoF of each subgeneration, 0 if completed
+};
+
 /*------------------------------- sncEncoder -------------------------------*/
 /**
  * Create encode context from a message buffer pointed by buf. Code parameters
@@ -84,12 +130,24 @@ struct snc_buffer_bats;
  **/
 struct snc_context *snc_create_enc_context(unsigned char *buf, struct snc_parameters *sp);
 
+// Create an encode context whose source packets point into buf (not copied). buf must outlive the context.
+struct snc_context *snc_create_enc_context_borrowed(unsigned char *buf, struct snc_parameters *sp);
+
+// Create encode context with options (NULL for the defaults); snc_create_enc_context() uses the defaults
+struct snc_context *snc_create_enc_context_opt(unsigned char *buf, struct snc_parameters *sp, const struct snc_options *opt);
+
+// Fill opt with the default options, read from the environment once per process
+void snc_default_options(struct snc_options *opt);
+
 // Get code parameters of an encode context
 struct snc_parameters *snc_get_parameters(struct snc_context *sc);
 
 // Load file content into encode context
 int snc_load_file_to_context(const char *filepath, long start, struct snc_context *sc);
 
+// Map file content into encode context (source packets are paged in on demand)
+int snc_map_file_to_context(const char *filepath, long start, struct snc_context *sc);
+
 // Free up encode context
 void snc_free_enc_context(struct snc_context *sc);
 
@@ -108,6 +166,9 @@ struct snc_packet *snc_alloc_empty_packet(struct snc_parameters *sp);
 // Length of serialized snc_packet (unit: bytes)
 int snc_packet_length(struct snc_parameters *param);
 
+// Length of a given serialized snc_packet, shorter than snc_packet_length if coefficients are seeded
+int snc_serialized_length(struct snc_packet *pkt, struct snc_parameters *param);
+
 // Serialize snc_packet to a byte buffer
 unsigned char *snc_serialize_packet(struct snc_packet *pkt, struct snc_parameters *param);
 
@@ -123,9 +184,25 @@ struct snc_packet *snc_duplicate_packet(struct snc_packet *pkt, struct snc_param
 // Generate an snc packet to the memory of an existing snc_packet struct
 int snc_generate_packet_im(struct snc_context *sc, struct snc_packet *pkt);
 
+// Generate n snc packets to the memory of existing snc_packet structs, same as n calls of snc_generate_packet_im
+int snc_generate_packets(struct snc_context *sc, struct snc_packet *pkts[], int n);
+
 // Free up an snc packet
 void snc_free_packet(struct snc_packet *pkt);
 
+// Create encode worker wid of nworkers; workers generate coded packets of one context concurrently
+struct snc_enc_worker *snc_create_enc_worker(struct snc_context *sc, int wid, int nworkers);
+
+// Generate a coded packet by an encode worker to the memory of an existing snc_packet struct;
+// return -1 once a worker of a seeded code has used up its 2^31 coefficient counters
+int snc_worker_generate_packet_im(struct snc_enc_worker *w, struct snc_packet *pkt);
+
+// Free up an encode worker
+void snc_free_enc_worker(struct snc_enc_worker *w);
+
+// Schedule only the subgenerations that decoder feedback reports unfinished (NULL to schedule all again)
+int snc_apply_feedback(struct snc_context *sc, struct snc_feedback *fb);
+
 // Print encode/decode summary of an snc (for benchmarking)
 void print_code_summary(struct snc_context *sc, double overhead, double operations);
 
@@ -135,14 +212,19 @@ int snc_get_GF_power(struct snc_parameters *sp);
 /*------------------------------- sncDecoder -------------------------------*/
 /**
  * Create an snc decoder given code parameter and decoder type
- *   4 decoders are supported:
+ *   6 decoders are supported:
  *      GG_DECODER
  *      OA_DECODER
  *      BD_DECODER
  *      CBD_DECODER
+ *      PP_DECODER
+ *      RP_DECODER (RAPTOR code only, which no other decoder supports)
  */
 struct snc_decoder *snc_create_decoder(struct snc_parameters *sp, int d_type);
 
+// Create an snc decoder with options (NULL for the defaults)
+struct snc_decoder *snc_create_decoder_opt(struct snc_parameters *sp, int d_type, const struct snc_options *opt);
+
 // Get the encode context that the decoder is working on/finished.
 struct snc_context *snc_get_enc_context(struct snc_decoder *decoder);
 
@@ -175,6 +257,25 @@ long snc_save_decoder_context(struct snc_decoder *decoder, const char *filepath)
 // Restore decoder from the context stored in a file
 struct snc_decoder *snc_restore_decoder(const char *filepath);
 
+/**
+ * Generate feedback of the completed subgenerations and the missing DoF of
+ * the others, which the encoder applies by snc_apply_feedback().
+ * Return NULL if the code has no fixed subgenerations (BATS, RAPTOR).
+ */
+struct snc_feedback *snc_generate_feedback(struct snc_decoder *decoder);
+
+// Length of serialized feedback
+int snc_feedback_length(struct snc_feedback *fb);
+
+// Serialize feedback to a byte buffer
+unsigned char *snc_serialize_feedback(struct snc_feedback *fb);
+
+// De-serialize feedback string to an snc_feedback struct
+struct snc_feedback *snc_deserialize_feedback(unsigned char *fbstr);
+
+// Free up feedback
+void snc_free_feedback(struct snc_feedback *fb);
+
 /*----------------------------- sncRecoder ------------------------------*/
 /**
  * Create a buffer for storing snc packets.
@@ -209,4 +310,115 @@ struct snc_packet *snc_recode_packet_bats(struct snc_buffer_bats *buf);
 int snc_recode_packet_bats_im(struct snc_buffer_bats *buf, struct snc_packet *pkt);
 
 void snc_free_buffer_bats(struct snc_buffer_bats *buf);
+
+/*------------------------------- sncStream -------------------------------*/
+/**
+ * Sliding-window codes over an unbounded stream of source packets of size_p
+ * bytes. The encoder codes over the last size_w appended packets; the decoder
+ * releases source packets in sequence order as soon as they are decoded, or
+ * as lost once no future packet can cover them. Both keep memory bounded by
+ * the window size. gfpower is 1, 8 or 16.
+ **/
+struct snc_stream_encoder *snc_create_stream_encoder(int size_p, int size_w, int gfpower, int seed);
+
+// Append a source packet of len <= size_p bytes (zero padded) and return its sequence number
+int snc_stream_append(struct snc_stream_encoder *enc, const unsigned char *data, int len);
+
+// Generate a packet coded over the current window to an allocated snc_stream_packet; -1 if nothing appended
+int snc_stream_generate_packet_im(struct snc_stream_encoder *enc, struct snc_stream_packet *pkt);
+
+// Put the latest appended source packet uncoded to an allocated snc_stream_packet (systematic); -1 if nothing appended
+int snc_stream_source_packet_im(struct snc_stream_encoder *enc, struct snc_stream_packet *pkt);
+
+void snc_free_stream_encoder(struct snc_stream_encoder *enc);
+
+// Allocate a stream packet with room for windows of up to size_w packets
+struct snc_stream_packet *snc_alloc_stream_packet(int size_p, int size_w, int gfpower);
+
+void snc_free_stream_packet(struct snc_stream_packet *pkt);
+
+// Length of a given serialized stream packet (unit: bytes), depending on its window size
+int snc_stream_packet_length(struct snc_stream_packet *pkt, int size_p, int gfpower);
+
+// Serialize a stream packet to a byte buffer
+unsigned char *snc_stream_serialize_packet(struct snc_stream_packet *pkt, int size_p, int gfpower);
+
+// De-serialize packet string to a stream packet; NULL if its window is larger than size_w
+struct snc_stream_packet *snc_stream_deserialize_packet(unsigned char *pktstr, int size_p, int size_w, int gfpower);
+
+struct snc_stream_decoder *snc_create_stream_decoder(int size_p, int size_w, int gfpower);
+
+// Feed decoder with a stream packet; return the number of source packets released by it
+int snc_stream_process_packet(struct snc_stream_decoder *dec, struct snc_stream_packet *pkt);
+
+/**
+ * Take the next released source packet in sequence order.
+ *   Return Value:
+ *     Sequence number of the packet, its size_p bytes copied to data unless
+ *     *lost is set; -1 if no packet has been released
+ **/
+int snc_stream_pop(struct snc_stream_decoder *dec, unsigned char *data, int *lost);
+
+void snc_free_stream_decoder(struct snc_stream_decoder *dec);
+
+/*------------------------------- sncSession -------------------------------*/
+/**
+ * Sessions of large objects split into segments of sp->datasize bytes (the
+ * last segment holds the remainder), each with its own encode context or
+ * decoder. Packets carry the id of their segment. Creation, processing of
+ * packet batches and recovery run on nthreads threads (0 for automatic),
+ * each owning the segments s with s % nthreads equal to its index. A seed
+ * of -1 is replaced and written back to sp, which the decode session needs.
+ **/
+// Create an encode session of size bytes of buf; segments point into buf, which must outlive the session
+struct snc_session *snc_create_enc_session(unsigned char *buf, long size, struct snc_parameters *sp, int nthreads);
+
+// Create an encode session of size bytes (-1 for the rest of the file) of a file from offset start
+struct snc_session *snc_create_enc_session_file(const char *filepath, long start, long size, struct snc_parameters *sp, int nthreads);
+
+// Create a decode session of a size-byte object
+struct snc_session *snc_create_dec_session(long size, struct snc_parameters *sp, int d_type, int nthreads);
+
+// Number of segments of a session
+int snc_session_segments(struct snc_session *ss);
+
+// Encode context of a segment (for a decode session, the context its decoder fills)
+struct snc_context *snc_session_get_context(struct snc_session *ss, int segid);
+
+// Generate a coded packet of segment segid to the memory of an existing snc_packet struct
+int snc_session_generate_packet_im(struct snc_session *ss, int segid, struct snc_packet *pkt);
+
+// Maximum length of serialized packets of a session, segment id included (unit: bytes)
+int snc_session_packet_length(struct snc_session *ss);
+
+// Length of a given serialized packet of segment segid, segment id included
+int snc_session_serialized_length(struct snc_session *ss, int segid, struct snc_packet *pkt);
+
+// Serialize a packet of segment segid, prefixed by the segment id
+unsigned char *snc_session_serialize_packet(struct snc_session *ss, int segid, struct snc_packet *pkt);
+
+// De-serialize a packet of a session, storing its segment id in segid
+struct snc_packet *snc_session_deserialize_packet(struct snc_session *ss, unsigned char *pktstr, int *segid);
+
+// Process a packet of segment segid
+void snc_session_process_packet(struct snc_session *ss, int segid, struct snc_packet *pkt);
+
+// Process n packets, pkts[i] of segment segids[i], segment-parallel;
+// return 0 on success, -1 on error
+int snc_session_process_packets(struct snc_session *ss, int segids[], struct snc_packet *pkts[], int n);
+
+// Whether segment segid is decoded
+int snc_session_segment_finished(struct snc_session *ss, int segid);
+
+// Whether all segments are decoded
+int snc_session_finished(struct snc_session *ss);
+
+// Restore the object to a char buffer (free with snc_free_recovered())
+unsigned char *snc_session_recover_data(struct snc_session *ss);
+
+// Write the object to a file at offset start (the file is created if needed)
+long snc_session_recover_to_file(const char *filepath, long start, struct snc_session *ss);
+
+// Free up a session
+void snc_free_session(struct snc_session *ss);
 #endif /* SNC_H */
@@ -242,6 +242,8 @@ main (int argc, char *argv[])
   sp.bpc      = 1;
   sp.sys      = 0;
   sp.seed     = -1;
+  sp.nnz      = 0;
+  sp.seeded   = 0;
 
   uint32_t gfPower   = 8;
   uint32_t batchSize = 160;
@@ -2,12 +2,13 @@
 from __future__ import division
 from math import floor, ceil, sqrt
 # from ctypes import *
-from ctypes import cdll, c_int, c_ubyte, c_double, c_long, c_longlong, c_char_p, POINTER, sizeof, byref, cast, memmove, Structure, create_string_buffer
+from ctypes import cdll, c_int, c_uint, c_ubyte, c_double, c_long, c_longlong, c_char_p, POINTER, sizeof, byref, cast, memmove, Structure, create_string_buffer
 # code types
 RAND_SNC = 0
 BAND_SNC = 1
 BATS_SNC = 2
 RLNC = 9
+RAPTOR_SNC = 99
 
 # decoder types
 GG_DECODER  = 0
@@ -15,6 +16,7 @@ OA_DECODER  = 1
 BD_DECODER  = 2
 CBD_DECODER = 3
 PP_DECODER  = 4
+RP_DECODER  = 5
 
 # scheduling algorithm of recoder
 TRIV_SCHED     = 0
@@ -32,7 +34,8 @@ class snc_packet(Structure):
     _fields_ = [("gid",  c_int),
                 ("ucid",  c_int),
                 ("coes", POINTER(c_ubyte)),
-                ("syms", POINTER(c_ubyte))]
+                ("syms", POINTER(c_ubyte)),
+                ("ctr",  c_uint)]
 
     def serialize(self, size_g, size_p, gfpower):
         """ Serialize an SNC packet to a binary byte string
@@ -57,6 +60,7 @@ class snc_packet(Structure):
         memmove(self.coes, coes, ce_len)
         syms = (c_ubyte * size_p).from_buffer_copy(pktstr, 2*sizeof(c_int)+ce_len)
         memmove(self.syms, syms, size_p)
+        self.ctr = 0
 
 
 class snc_parameters(Structure):
@@ -69,7 +73,9 @@ class snc_parameters(Structure):
                 ("bpc",         c_int),
                 ("gfpower",     c_int),
                 ("sys",         c_int),
-                ("seed",        c_int)]
+                ("seed",        c_int),
+                ("nnz",         c_int),
+                ("seeded",      c_int)]
 
 
 class snc_decoder(Structure):
@@ -13,10 +13,10 @@
 #include "common.h"
 #include <math.h>
 static int is_prime(int number);
-static int include_left_node(int l_index, int r_index, BP_graph *graph);
+static int include_left_node(int l_index, int r_index, BP_graph *graph, struct snc_rng *rng);
 
 // construct LDPC graph
-int create_bipartite_graph(BP_graph *graph, int nleft, int nright)
+int create_bipartite_graph(BP_graph *graph, int nleft, int nright, struct snc_rng *rng)
 {
     int LDPC_SYS = nleft;
     int S        = nright;
@@ -42,23 +42,22 @@ int create_bipartite_graph(BP_graph *graph, int nleft, int nright)
         graph->r_nbrs_of_l[i]->first = graph->r_nbrs_of_l[i]->last = NULL;
     }
 
-    char *hdpc = getenv("SNC_PRECODE");
-    if (hdpc != NULL && strcmp(hdpc, "HDPC") == 0) {
-        // A reference bipartite graph, which is highly dense. This is only used 
-        // when SNC_PRECODE env var is set to HDPC. The env var is ONLY for development
-        // and testing use.
+    if (graph->hdpc) {
+        // A reference bipartite graph, which is highly dense. This is only used
+        // when the hdpc option is set (SNC_PRECODE=HDPC). The option is ONLY for
+        // development and testing use.
         for (i=0; i<S; i++) {
             for (j=0; j<LDPC_SYS; j++) {
                 int included = 1;
                 if (graph->binaryce == 1) {
-                    if (genrand_int32() % 2 == 0)
+                    if (snc_rng_next(rng) % 2 == 0)
                         included = 0;
                 } else {
-                    if (genrand_int32() % 256 == 0)
+                    if (snc_rng_next(rng) % 256 == 0)
                         included = 0;
                 }
                 if (included) {
-                    if (include_left_node(j, i, graph) < 0)
+                    if (include_left_node(j, i, graph, rng) < 0)
                         goto failure;
                 }
             }
@@ -76,15 +75,15 @@ int create_bipartite_graph(BP_graph *graph, int nleft, int nright)
         // assign non-zero positions for the first column in each circulant matrix
         // each check node connects to exactly 3 left nodes
         // 1, P[0][i*S] = 1;
-        if (include_left_node(i*S, 0, graph) < 0)
+        if (include_left_node(i*S, 0, graph, rng) < 0)
             goto failure;
         //2, P[a-1][i*S] = 1;
         a = (((i+1)+1)%S == 0) ? S : ((i+1)+1)%S;
-        if (include_left_node(i*S, a-1, graph) < 0)
+        if (include_left_node(i*S, a-1, graph, rng) < 0)
             goto failure;
         //3, P[b-1][i*S] = 1;
         b = ((2*(i+1)+1)%S == 0) ? S : (2*(i+1)+1)%S;
-        if (include_left_node(i*S, b-1, graph) < 0)
+        if (include_left_node(i*S, b-1, graph, rng) < 0)
             goto failure;
 
         // circulant part
@@ -95,15 +94,15 @@ int create_bipartite_graph(BP_graph *graph, int nleft, int nright)
             }
             // shift down the non-zero positions of previous columns in the circulant matrix
             //1, P[0+j][i*S+j] = 1;
-            if (include_left_node(i*S+j, 0+j, graph) < 0)
+            if (include_left_node(i*S+j, 0+j, graph, rng) < 0)
                 goto failure;
             //2, P[a-1][i*S+j] = 1;
             a = (((i+1)+1+j)%S == 0) ? S : ((i+1)+1+j)%S;
-            if (include_left_node(i*S+j, a-1, graph) < 0)
+            if (include_left_node(i*S+j, a-1, graph, rng) < 0)
                 goto failure;
             //3, P[b-1][i*S+j] = 1;
             b = ((2*(i+1)+1+j)%S == 0) ? S : (2*(i+1)+1+j)%S;
-            if (include_left_node(i*S+j, b-1, graph) < 0)
+            if (include_left_node(i*S+j, b-1, graph, rng) < 0)
                 goto failure;
         }
     }
@@ -115,7 +114,7 @@ failure:
 }
 
 // include left node index in the LDPC graph
-static int include_left_node(int l_index, int r_index, BP_graph *graph)
+static int include_left_node(int l_index, int r_index, BP_graph *graph, struct snc_rng *rng)
 {
     // Skip if the two nodes are already neighbors
     // Note: a good ``bipartitin'' algorithm should not get into such 
@@ -128,7 +127,9 @@ static int include_left_node(int l_index, int r_index, BP_graph *graph)
     if (graph->binaryce == 1) {
         ce = 1;
     } else {
-        ce = (GF_ELEMENT) (genrand_int32() % 255 + 1); // Value range: [1-255]
+        // Value range: [1, 2^gfpower-1], or [1-255] for GF(2^8) and GF(2^16)
+        int nonzeros = graph->gfpower < 8 ? (1 << graph->gfpower) - 1 : 255;
+        ce = (GF_ELEMENT) (snc_rng_next(rng) % nonzeros + 1);
     }
     // Record neighbor of a right-side node
     NBR_node *nb = calloc(1, sizeof(NBR_node));
@@ -16,10 +16,13 @@ typedef struct bipartite_graph {
     int         nleft;
     int         nright;
     int         binaryce;       // Whether coefficients of edges are 1 or higher order
+    int         gfpower;        // Higher order coefficients are non-zero elements of GF(2^gfpower)
+    int         hdpc;           // Whether to create the dense reference graph (SNC_PRECODE=HDPC)
     NBR_nodes **l_nbrs_of_r;    // left side neighbours of right
     NBR_nodes **r_nbrs_of_l;    // right side neighbours of left
 } BP_graph;
 
 /* bipartite.c */
-int create_bipartite_graph(BP_graph *graph, int nleft, int nright);
+struct snc_rng;
+int create_bipartite_graph(BP_graph *graph, int nleft, int nright, struct snc_rng *rng);
 void free_bipartite_graph(BP_graph *graph);
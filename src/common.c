@@ -1,17 +1,20 @@
 /*
  * Common utility functions used by many routines in the library.
  */
+#define _POSIX_C_SOURCE 200112L     // posix_memalign()
 #include <stdint.h>
+#include <pthread.h>
 #include "common.h"
 #include "galois.h"
 int BALLOC = 500;
 
 static int loglevel = 0;    // log level for the library
 static int compare_int(const void *elem1, const void *elem2);
-void set_loglevel(const char *level)
+void set_loglevel(int level)
 {
-    if (strcmp(level, "TRACE") == 0)
-        loglevel = TRACE;
+    // Contexts created concurrently with the same options only read it
+    if (loglevel != level)
+        loglevel = level;
     return;
 }
 
@@ -20,6 +23,39 @@ int get_loglevel()
     return loglevel;
 }
 
+/*
+ * Allocate a zeroed payload buffer of nbytes. The buffer starts at an
+ * SNC_ALIGN-byte boundary and is padded to PADDED(nbytes) bytes, so that
+ * region operations between internal buffers can run over the padded
+ * length with aligned full vectors only. The padding stays zero as long as
+ * every operation on it is a linear combination of other padded buffers.
+ * Release with free().
+ */
+GF_ELEMENT *calloc_payload(int nbytes)
+{
+    void *p = NULL;
+    size_t size = PADDED(nbytes > 0 ? nbytes : 1);
+    if (posix_memalign(&p, SNC_ALIGN, size) != 0)
+        return NULL;
+    memset(p, 0, size);
+    return p;
+}
+
+/*
+ * Allocate n zeroed payload buffers of nbytes in one slab. Buffer i starts
+ * at i*PADDED(nbytes), so each buffer is aligned and padded the same way as
+ * calloc_payload() buffers. Release the slab with free().
+ */
+GF_ELEMENT *calloc_payload_slab(int n, int nbytes)
+{
+    void *p = NULL;
+    size_t size = (size_t) (n > 0 ? n : 1) * PADDED(nbytes > 0 ? nbytes : 1);
+    if (posix_memalign(&p, SNC_ALIGN, size) != 0)
+        return NULL;
+    memset(p, 0, size);
+    return p;
+}
+
 // check if an item is existed in an int array
 int has_item(int array[], int item, int length)
 {
@@ -200,30 +236,62 @@ inline unsigned char read_bits_from_byte_array(unsigned char *coes, int nbytes,
     return co;
 }
 
-// A wrapper function of multiply_add_region for GF(2^2), ..., GF(2^7)
-// nelem - number of GF(4), GF(8), GF(16), ..., GF(128) elements
-// nbytes - number of bytes pointed by dst and src
-void galois2n_multiply_add_region(GF_ELEMENT *dst, GF_ELEMENT *src, GF_ELEMENT multiplier, int gfpower, int nelem, int nbytes)
+/*
+ * Expand/compress nelem len-bit elements between the packed form used by
+ * packets (see pack_bits_in_byte_array) and one element per byte. Bits
+ * beyond nbytes are read as zeros and dropped when packing.
+ */
+void read_elements_from_byte_array(GF_ELEMENT *elem, int nelem, unsigned char *coes, int nbytes, int len)
 {
-    if (multiplier == 0) {
-        // add nothing
-        return;
-    }
     int i, j;
-    if (multiplier == 1) {
-        // add is XOR for all GF(2) extension fields
-        for (i=0; i<nbytes; i++)
-            dst[i] ^= src[i];
+    if (len == 4) {
+        for (i=0, j=0; j<nelem; i++, j+=2) {
+            unsigned char b = i < nbytes ? coes[i] : 0;
+            elem[j] = b >> 4;
+            if (j+1 < nelem)
+                elem[j+1] = b & 0x0f;
+        }
         return;
     }
-    // Complication is here
-    for (j=0; j<nelem; j++) {
-        GF_ELEMENT dst_elem = read_bits_from_byte_array(dst, nbytes, gfpower, j);
-        GF_ELEMENT new_elem = galois_add(dst_elem, galois_multiply(read_bits_from_byte_array(src, nbytes, gfpower, j), multiplier));
-        pack_bits_in_byte_array(dst, nbytes, new_elem, gfpower, j);
+    uint32_t acc = 0;               // bits read but not yet consumed are at the bottom
+    int nbits = 0;
+    unsigned char mask = 0xffU >> (8 - len);
+    for (i=0, j=0; j<nelem; j++) {
+        if (nbits < len) {
+            acc = (acc << 8) | (i < nbytes ? coes[i] : 0);
+            i++;
+            nbits += 8;
+        }
+        nbits -= len;
+        elem[j] = (acc >> nbits) & mask;
     }
 }
 
+void pack_elements_in_byte_array(unsigned char *coes, int nbytes, GF_ELEMENT *elem, int nelem, int len)
+{
+    int i, j;
+    uint32_t acc = 0;
+    int nbits = 0;
+    for (i=0, j=0; j<nelem && i<nbytes; j++) {
+        acc = (acc << len) | elem[j];
+        nbits += len;
+        if (nbits >= 8) {
+            nbits -= 8;
+            coes[i++] = acc >> nbits;
+        }
+    }
+    if (nbits > 0 && i < nbytes)
+        coes[i] = acc << (8 - nbits);
+}
+
+// A wrapper function of multiply_add_region for GF(2^2), ..., GF(2^7)
+// nbytes - number of bytes pointed by dst and src
+void galois2n_multiply_add_region(const struct gf_field *gf, GF_ELEMENT *dst, GF_ELEMENT *src, GF_ELEMENT multiplier, int nbytes)
+{
+    // Work directly on the packed elements
+    galois_multiply_add_region_packed(gf, dst, src, multiplier, nbytes);
+}
+
 /**
  * Get/set the i-th bit from a sequence of bytes pointed
  * by coes. The indices of bits are as following:
@@ -246,6 +314,63 @@ inline void set_bit_in_array(unsigned char *coes, int i)
     return;
 }
 
+/*
+ * Load nbits bits of a byte array in the above order into a full-length
+ * bit row (see BITROW_WORDS in common.h). The bit order is the same, so
+ * byte k simply becomes byte k%8 of word k/8.
+ */
+void bitrow_load(uint64_t *w, unsigned char *coes, int nbits)
+{
+    int nbytes = ALIGN(nbits, 8);
+    memset(w, 0, sizeof(uint64_t) * ALIGN(nbits, 64));
+    for (int k=0; k<nbytes; k++)
+        w[k/8] |= (uint64_t) coes[k] << (8 * (k % 8));
+    if (nbits % 8)
+        w[(nbits-1)/64] &= ~((uint64_t) 0) >> (63 - (nbits-1) % 64);
+}
+
+// vec += row, where row starts at column p and spans len columns
+void bitrow_xor(uint64_t *vec, const uint64_t *row, int p, int len)
+{
+    int n = BITROW_WORDS(p, len);
+    uint64_t *v = vec + (p >> 6);
+    for (int k=0; k<n; k++)
+        v[k] ^= row[k];
+}
+
+// Index of the first nonzero column of vec at or after from, or -1
+int bitrow_next(const uint64_t *vec, int from, int nbits)
+{
+    if (from >= nbits)
+        return -1;
+    int k = from >> 6;
+    uint64_t w = vec[k] & (~((uint64_t) 0) << (from & 63));
+    int nwords = ALIGN(nbits, 64);
+    while (w == 0) {
+        if (++k >= nwords)
+            return -1;
+        w = vec[k];
+    }
+    int c = (k << 6) + __builtin_ctzll(w);
+    return c < nbits ? c : -1;
+}
+
+/*
+ * Allocate a bit row holding columns [p, p+len) of a full-length vector.
+ * Columns of vec outside of the range are not copied.
+ */
+uint64_t *bitrow_extract(const uint64_t *vec, int p, int len)
+{
+    int n = BITROW_WORDS(p, len);
+    uint64_t *row = malloc(sizeof(uint64_t) * n);
+    if (row == NULL)
+        return NULL;
+    memcpy(row, vec + (p >> 6), sizeof(uint64_t) * n);
+    row[0] &= ~((uint64_t) 0) << (p & 63);
+    row[n-1] &= ~((uint64_t) 0) >> (63 - (p + len - 1) % 64);
+    return row;
+}
+
 // Build subgeneration neighbors list for each packet according to subgeneration grouping scheme
 ID_list **build_subgen_nbr_list(struct snc_context *sc)
 {
@@ -286,30 +411,206 @@ void free_subgen_nbr_list(struct snc_context *sc, ID_list **gene_nbr)
     return;
 }
 
-// generate a number of n<ub unique random numbers within the range of [0, ub-1]
-// using Fisher-Yates shuffle method
-void get_random_unique_numbers(int ids[], int n, int ub)
-{
-	int init_array[ub];
-	int i, j;
-	for (i=0; i<ub; i++)
-		init_array[i] = i;
-
-	// randomly shuffle the init_array
-	for (i=ub-1; i>=1; i--) {
-		int rd = genrand_int32() % (i+1);
-		//int rd = gsl_rng_uniform_int(r, i+1);
-		int tmp = init_array[rd];
-		init_array[rd] = init_array[i];
-		init_array[i] = tmp;
-	}
-
-    // sort the obtained unique random numbers so that coding coefficients corresponding
-    // to packets are stored in the ascending order (to simplify decoder implementation)
-    qsort(init_array, n, sizeof(int), compare_int);
-    memcpy(ids, init_array, n*sizeof(int));
-	//for (j=0; j<n; j++)
-	//	ids[j] = init_array[j];
+static struct snc_options env_options;     // defaults read from the environment
+static pthread_once_t env_once = PTHREAD_ONCE_INIT;
+
+static int env_flag(const char *name)
+{
+    char *v = getenv(name);
+    return v != NULL && atoi(v) == 1;
+}
+
+static void read_env_options(void)
+{
+    char *v;
+    if ((v = getenv("SNC_LOG_LEVEL")) != NULL && strcmp(v, "TRACE") == 0)
+        env_options.loglevel = TRACE;
+    if ((v = getenv("SNC_PRECODE")) != NULL && strcmp(v, "HDPC") == 0)
+        env_options.hdpc = 1;
+    env_options.nonuniform_rand = env_flag("SNC_NONUNIFORM_RAND");
+    if ((v = getenv("SNC_PRECODE_THREADS")) != NULL && atoi(v) > 0)
+        env_options.precode_threads = atoi(v);
+    if ((v = getenv("GF_POWER")) != NULL && ((atoi(v) > 0 && atoi(v) <= 8) || atoi(v) == 16))
+        env_options.gfpower = atoi(v);
+    if ((v = getenv("SNC_OA_AOH")) != NULL)
+        env_options.oa_aoh = atof(v);
+    env_options.oa_oneround = env_flag("SNC_OA_ONEROUND");
+    env_options.bd_oneround = env_flag("SNC_BD_ONEROUND");
+}
+
+/*
+ * Default options, read from the environment on the first call only
+ */
+const struct snc_options *default_options(void)
+{
+    pthread_once(&env_once, read_env_options);
+    return &env_options;
+}
+
+void snc_default_options(struct snc_options *opt)
+{
+    *opt = *default_options();
+}
+
+/*
+ * Counter-based generator of seeded coefficient vectors (Philox4x32-10,
+ * Salmon et al., SC'11). Block b of the vector of packet counter ctr from
+ * subgeneration gid is Philox of the counter (ctr, gid, b, 0) under the key
+ * derived from the code seed, and holds coefficients 4b,...,4b+3. Any
+ * vector can be regenerated from (seed, gid, ctr) alone.
+ */
+void seeded_coefficient_block(uint32_t r[4], int seed, int gid, unsigned int ctr, int block)
+{
+    uint32_t c0 = ctr, c1 = (uint32_t) gid, c2 = (uint32_t) block, c3 = 0;
+    uint32_t k0 = (uint32_t) seed, k1 = 0x5eedc0e5;
+    for (int i=0; i<10; i++) {
+        uint64_t p0 = (uint64_t) 0xD2511F53 * c0;
+        uint64_t p1 = (uint64_t) 0xCD9E8D57 * c2;
+        c0 = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+        c1 = (uint32_t) p1;
+        c2 = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+        c3 = (uint32_t) p0;
+        k0 += 0x9E3779B9;
+        k1 += 0xBB67AE85;
+    }
+    r[0] = c0;
+    r[1] = c1;
+    r[2] = c2;
+    r[3] = c3;
+}
+
+/*
+ * Degree distribution of the Raptor code of RFC 5053 (Section 5.4.4.2):
+ * a uniform 20-bit value v selects degree raptor_degrees[j] for the first
+ * j with v < raptor_cdf[j].
+ */
+static const int raptor_cdf[]     = {10241, 491582, 712794, 831695, 948446, 1032189, 1048576};
+static const int raptor_degrees[] = {1, 2, 3, 4, 10, 11, 40};
+
+/*
+ * Draw the subset of coded packet gid of a Raptor code over numpp
+ * precoded packets: a degree from the distribution above, capped at
+ * maxdeg and numpp, then that many distinct packet IDs, stored in
+ * pktid[0..degree). pktid[degree..maxdeg) are set to -1. The subset is
+ * drawn from seeded_coefficient_block() with counter 0, which is never
+ * used by coefficient vectors, so that decoders regenerate it from
+ * (seed, gid). Return the degree.
+ */
+int raptor_subset(int seed, int gid, int numpp, int maxdeg, int pktid[])
+{
+    uint32_t r[4];
+    int block = 0;
+    seeded_coefficient_block(r, seed, gid, 0, block);
+    int v = r[0] & 0xfffff;
+    int j = 0;
+    while (v >= raptor_cdf[j])
+        j++;
+    int degree = raptor_degrees[j];
+    if (degree > maxdeg)
+        degree = maxdeg;
+    if (degree > numpp)
+        degree = numpp;
+    int w = 1;
+    for (int i=0; i<degree; ) {
+        if (w == 4) {
+            seeded_coefficient_block(r, seed, gid, 0, ++block);
+            w = 0;
+        }
+        int id = r[w++] % numpp;
+        if (has_item(pktid, id, i) == -1)
+            pktid[i++] = id;
+    }
+    for (int i=degree; i<maxdeg; i++)
+        pktid[i] = -1;
+    return degree;
+}
+
+/*
+ * Store the i-th of n coding coefficients in the packed coes of a packet:
+ * one bit for GF(2), gfpower bits for GF(4),...,GF(128), one or two bytes
+ * for GF(256) and GF(2^16).
+ */
+void pack_coefficient(unsigned char *coes, int n, int co, int gfpower, int i)
+{
+    if (gfpower == 1) {
+        if (co == 1)
+            set_bit_in_array(coes, i);
+    } else if (gfpower == 8 || gfpower == 16) {
+        gf_set_element(coes, i, co, gfpower == 16 ? 2 : 1);
+    } else {
+        pack_bits_in_byte_array(coes, n, co, gfpower, i);
+    }
+}
+
+// Coefficient i of a vector packed by pack_coefficient()
+int read_coefficient(unsigned char *coes, int n, int gfpower, int i)
+{
+    if (gfpower == 1)
+        return get_bit_in_array(coes, i);
+    if (gfpower == 8 || gfpower == 16)
+        return gf_get_element(coes, i, gfpower == 16 ? 2 : 1);
+    return read_bits_from_byte_array(coes, n, gfpower, i);
+}
+
+/*
+ * Seed a per-context RNG. Streams of the same seed are disjoint for
+ * different stream numbers.
+ */
+void snc_rng_seed(struct snc_rng *rng, int seed, int stream)
+{
+    rng->state = (uint64_t) (uint32_t) seed | ((uint64_t) stream << 32);
+}
+
+/*
+ * Draw the n packet IDs of batch bid of a BATS code over numpp precoded
+ * packets into ids[], in ascending order (to simplify decoder
+ * implementation). IDs are drawn from seeded_coefficient_block() with
+ * counter 0, sorted, and duplicates are redrawn, so both sides derive
+ * a batch from (seed, bid) in O(n log n) without state of other batches.
+ */
+void get_batch_members(int seed, int bid, int numpp, int n, int ids[])
+{
+    uint32_t r[4];
+    int block = 0;
+    int w = 4;
+    int m = 0;
+    if (n > numpp)
+        n = numpp;
+    while (m < n) {
+        while (m < n) {
+            if (w == 4) {
+                seeded_coefficient_block(r, seed, bid, 0, block++);
+                w = 0;
+            }
+            ids[m++] = r[w++] % numpp;
+        }
+        qsort(ids, m, sizeof(int), compare_int);
+        int k = 1;
+        for (int i=1; i<m; i++) {
+            if (ids[i] != ids[k-1])
+                ids[k++] = ids[i];
+        }
+        m = k;
+    }
+}
+
+/*
+ * Return subgeneration gid. Batches of BATS codes come from the cache of
+ * recently used batches in sc->gene, where batch gid takes slot
+ * gid % BCACHE; a batch not in the cache is derived again from
+ * (seed, gid). The returned batch is valid until another batch of the
+ * same slot is requested.
+ */
+struct subgeneration *get_subgeneration(struct snc_context *sc, int gid)
+{
+    if (sc->params.type != BATS_SNC)
+        return sc->gene[gid];
+    struct subgeneration *batch = sc->gene[gid % BCACHE];
+    if (batch->gid != gid) {
+        batch->gid = gid;
+        get_batch_members(sc->params.seed, gid, sc->snum+sc->cnum, sc->params.size_g, batch->pktid);
+    }
+    return batch;
 }
 
 static int compare_int(const void *elem1, const void *elem2)
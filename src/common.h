@@ -6,18 +6,28 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 #include <assert.h>
 #include <time.h>
 #include "bipartite.h"
 #include "sparsenc.h"
 
+struct gf_field;    // Galois field, see galois.h
+
 /* log levels */
 #define TRACE       5
 
 #define ALIGN(a, b) ((a) % (b) == 0 ? (a)/(b) : (a)/(b) + 1)
 #define RESIDUAL(a, b) ((b) * ALIGN((a), (b)) - (a))
 
+/* Alignment and padding of internal payload buffers (see calloc_payload) */
+#define SNC_ALIGN   64
+#define PADDED(a)   (SNC_ALIGN * ALIGN((a), SNC_ALIGN))
+
+/* Number of recently used batches of BATS codes kept in sc->gene (see get_subgeneration) */
+#define BCACHE      16
+
 #ifndef GALOIS
 #define GALOIS
 typedef unsigned char GF_ELEMENT;
@@ -36,6 +46,23 @@ struct subgeneration {
     int *pktid;                 // SIZE_G source packet IDs
 };
 
+/*
+ * Per-context pseudo random number generator (SplitMix64). Every context
+ * draws from its own streams, so that contexts can be used concurrently
+ * and reproduce the same streams from the same seed.
+ */
+struct snc_rng {
+    uint64_t state;
+};
+
+static inline uint32_t snc_rng_next(struct snc_rng *rng)
+{
+    uint64_t z = (rng->state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return (uint32_t) ((z ^ (z >> 31)) >> 32);
+}
+
 /**
  * Definition of snc_context
  **/
@@ -47,8 +74,36 @@ struct snc_context {
     struct  subgeneration   **gene;     // array of pointers each points to a subgeneration.
     struct  bipartite_graph  *graph;
     GF_ELEMENT              **pp;       // Pointers to precoded source packets
+    GF_ELEMENT               *slab;     // Storage of pp of encoders, stride PADDED(size_p); NULL if pp are allocated individually
+    int                       borrowed; // Number of leading source packets in pp pointing into the caller's buffer or map
+    void                     *map;      // File mapping of snc_map_file_to_context(), NULL if none
+    size_t                    maplen;   // Length of the file mapping
     int                      *nccount;  // Count of coded packets generated from each subgeneration
     int                       count;    // Count of total coded packets generated
+    struct  gf_field         *gf;       // Galois field of the code
+    struct  snc_rng           rng;      // RNG of the code structure (precode graph, subgenerations, batches)
+    struct  snc_rng           crng;     // RNG of generation scheduling and coding coefficients
+    int                       currbid;  // used by BATS-like codes, ID of the current sending batch (subset of RAPTOR codes)
+    int                       batsent;  // used by BATS-like codes, number of sent packets from the current batch
+    int                      *fbgids;   // unfinished subgenerations reported by decoder feedback, NULL if none
+    int                       fbnum;    // number of fbgids
+    struct  snc_options       opts;     // options given at creation
+    GF_ELEMENT              **srcs;     // scratch of the source packets of a coded packet
+    GF_ELEMENT               *cos;      // scratch of the coefficients of a coded packet
+};
+
+
+/*
+ * Encode worker generating coded packets from a shared snc_context
+ */
+struct snc_enc_worker {
+    struct  snc_context      *sc;
+    int                       wid;      // worker ID, 0,...,nworkers-1
+    int                       nworkers;
+    struct  snc_rng           crng;     // RNG substream of scheduling and coefficients
+    uint64_t                  count;    // Count of coded packets generated by the worker
+    GF_ELEMENT              **srcs;     // scratch of the source packets of a coded packet
+    GF_ELEMENT               *cos;      // scratch of the coefficients of a coded packet
 };
 
 
@@ -89,6 +144,10 @@ struct snc_buffer {
     int                   *nc;          // Number of currently buffered packets of each generation
     int                   *pn;          // Positions to store next packet of each subgeneration
     int                   *nsched;      // Number of scheduled times of each subgeneration
+    struct gf_field       *gf;          // Galois field of the code
+    GF_ELEMENT            *cos;         // Scratch of the recoding coefficients
+    GF_ELEMENT           **coes;        // Scratch of the coefficient vectors of the buffered packets
+    GF_ELEMENT           **syms;        // Scratch of the payloads of the buffered packets
     // Use if code in buffer is systematic
     /* Systematic packet, when received, will be stored in the buffer of each subgen to 
      * which the systematic packet belongs. If sched_t is systematic, the packet will be buffered
@@ -133,19 +192,60 @@ struct snc_buffer_bats {
     int                     s_first;            // start pos index of sending buffer
     int                     r_last;             // end pos index of receiving buffer
                                                 // if ((r_last+1) % bufsize == s_start), discard old pkt
+    struct gf_field        *gf;                 // Galois field of the code
+    GF_ELEMENT             *cos;                // Scratch of the recoding coefficients
+    GF_ELEMENT            **coes;               // Scratch of the coefficient vectors of the buffered packets
+    GF_ELEMENT            **syms;               // Scratch of the payloads of the buffered packets
+};
+
+/*
+ * Scratch of forward_substitute() and back_substitute(): the rows that
+ * a pivot row eliminates and their quotients, for up to rows rows
+ */
+struct gauss_scratch {
+    int          rows;
+    GF_ELEMENT **dstA;
+    GF_ELEMENT **dstB;
+    GF_ELEMENT  *quotients;
 };
 
 /* Row vector of a matrix */
 struct row_vector
 {
     int len;            // length of the row
-    GF_ELEMENT *elem;   // elements of the row
+    GF_ELEMENT *elem;   // elements of the row (bit-packed words for GF(2), see below)
 };
 
+/*
+ * Bit-packed rows of GF(2) decoding matrices. A row starting at column p
+ * with len columns is stored in the 64-bit words covering [p, p+len) by
+ * absolute column, i.e., column c is bit c%64 of word c/64-p/64. Rows
+ * therefore line up word by word with a full-length vector (p = 0), and
+ * eliminating against a row is a plain XOR of its words.
+ */
+#define BITROW_WORDS(p, len)    ((((p) + (len) - 1) >> 6) - ((p) >> 6) + 1)
+
+static inline int bitrow_get(const uint64_t *w, int p, int c)
+{
+    return (w[(c >> 6) - (p >> 6)] >> (c & 63)) & 1;
+}
+
+static inline void bitrow_set(uint64_t *w, int p, int c)
+{
+    w[(c >> 6) - (p >> 6)] |= (uint64_t) 1 << (c & 63);
+}
+
+static inline void bitrow_clear(uint64_t *w, int p, int c)
+{
+    w[(c >> 6) - (p >> 6)] &= ~((uint64_t) 1 << (c & 63));
+}
+
 
 /* common.c */
-void set_loglevel(const char *level);
+void set_loglevel(int level);
 int get_loglevel();
+GF_ELEMENT *calloc_payload(int nbytes);
+GF_ELEMENT *calloc_payload_slab(int n, int nbytes);
 int has_item(int array[], int item, int length);
 void append_to_list(struct node_list *list, struct node *nd);
 int remove_from_list(struct node_list *list, int data);
@@ -154,12 +254,30 @@ void clear_list(struct node_list *list);
 void free_list(struct node_list *list);
 void pack_bits_in_byte_array(unsigned char *coes, int nbytes, unsigned char co, int len, int i);
 unsigned char read_bits_from_byte_array(unsigned char *coes, int nbytes, int len, int i);
-void galois2n_multiply_add_region(GF_ELEMENT *dst, GF_ELEMENT *src, GF_ELEMENT multiplier, int gfpower, int nelem, int nbytes);
+void read_elements_from_byte_array(GF_ELEMENT *elem, int nelem, unsigned char *coes, int nbytes, int len);
+void pack_elements_in_byte_array(unsigned char *coes, int nbytes, GF_ELEMENT *elem, int nelem, int len);
+void galois2n_multiply_add_region(const struct gf_field *gf, GF_ELEMENT *dst, GF_ELEMENT *src, GF_ELEMENT multiplier, int nbytes);
 unsigned char get_bit_in_array(unsigned char *coes, int i);
 void set_bit_in_array(unsigned char *coes, int i);
+void bitrow_load(uint64_t *w, unsigned char *coes, int nbits);
+void bitrow_xor(uint64_t *vec, const uint64_t *row, int p, int len);
+int bitrow_next(const uint64_t *vec, int from, int nbits);
+uint64_t *bitrow_extract(const uint64_t *vec, int p, int len);
 ID_list **build_subgen_nbr_list(struct snc_context *sc);
 void free_subgen_nbr_list(struct snc_context *sc, ID_list **gene_nbr);
-void get_random_unique_numbers(int ids[], int n, int ub);
+const struct snc_options *default_options(void);
+void seeded_coefficient_block(uint32_t r[4], int seed, int gid, unsigned int ctr, int block);
+void pack_coefficient(unsigned char *coes, int n, int co, int gfpower, int i);
+int read_coefficient(unsigned char *coes, int n, int gfpower, int i);
+int raptor_subset(int seed, int gid, int numpp, int maxdeg, int pktid[]);
+void get_batch_members(int seed, int bid, int numpp, int n, int ids[]);
+struct subgeneration *get_subgeneration(struct snc_context *sc, int gid);
+void snc_rng_seed(struct snc_rng *rng, int seed, int stream);
+/* sncEncoder.c */
+struct snc_context *create_enc_context(unsigned char *buf, struct snc_parameters *sp, int borrow, const struct snc_options *opt);
+/* gaussian.c */
+int alloc_gauss_scratch(struct gauss_scratch *gs, const struct gf_field *gf, int rows);
+void free_gauss_scratch(struct gauss_scratch *gs);
 //int snc_rand(void);
 //void snc_srand(unsigned int seed);
 // mt19937ar.c
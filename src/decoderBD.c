@@ -9,13 +9,13 @@ static int partially_diag_decoding_matrix(struct decoding_context_BD *dec_ctx);
 static int apply_parity_check_matrix(struct decoding_context_BD *dec_ctx);
 static void finish_recovering_BD(struct decoding_context_BD *dec_ctx);
 
-extern long long forward_substitute(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B);
-extern long long back_substitute(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B);
-extern long pivot_matrix_oneround(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B, int **ctoo_r, int **ctoo_c, int *inactives);
-extern long pivot_matrix_tworound(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B, int **ctoo_r, int **ctoo_c, int *inactives);
+extern long long forward_substitute(const struct gf_field *gf, struct gauss_scratch *gs, int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B);
+extern long long back_substitute(const struct gf_field *gf, struct gauss_scratch *gs, int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B);
+extern long pivot_matrix_oneround(const struct gf_field *gf, struct gauss_scratch *gs, int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B, int **ctoo_r, int **ctoo_c, int *inactives);
+extern long pivot_matrix_tworound(const struct gf_field *gf, struct gauss_scratch *gs, int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B, int **ctoo_r, int **ctoo_c, int *inactives);
 
 // create decoding context for band decoder
-struct decoding_context_BD *create_dec_context_BD(struct snc_parameters *sp)
+struct decoding_context_BD *create_dec_context_BD(struct snc_parameters *sp, const struct snc_options *opt)
 {
     static char fname[] = "snc_create_dec_context_BD";
     int i, j, k;
@@ -27,14 +27,19 @@ struct decoding_context_BD *create_dec_context_BD(struct snc_parameters *sp)
         fprintf(stderr, "Band decoder only applies to band GNC code.\n");
         return NULL;
     }
+    if (sp->gfpower == 16) {
+        fprintf(stderr, "%s: GF(2^16) is only supported by the CBD and OA decoders\n", fname);
+        return NULL;
+    }
 
     struct decoding_context_BD *dec_ctx;
     if ((dec_ctx = malloc(sizeof(struct decoding_context_BD))) == NULL) {
         fprintf(stderr, "malloc decoding_context_BD failed\n");
         return NULL;
     }
+    memset(&dec_ctx->gs, 0, sizeof(struct gauss_scratch));
     struct snc_context *sc;
-    if ((sc = snc_create_enc_context(NULL, sp)) == NULL) {
+    if ((sc = snc_create_enc_context_opt(NULL, sp, opt)) == NULL) {
         fprintf(stderr, "%s: create decoding context failed", fname);
         goto AllocError;
     }
@@ -60,7 +65,7 @@ struct decoding_context_BD *create_dec_context_BD(struct snc_parameters *sp)
         dec_ctx->coefficient[i] = calloc(numpp, sizeof(GF_ELEMENT));
         if (dec_ctx->coefficient[i] == NULL)
             goto AllocError;
-        dec_ctx->message[i]     = calloc(pktsize, sizeof(GF_ELEMENT));
+        dec_ctx->message[i]     = calloc_payload(pktsize);
         if (dec_ctx->message[i] == NULL)
             goto AllocError;
     }
@@ -71,6 +76,8 @@ struct decoding_context_BD *create_dec_context_BD(struct snc_parameters *sp)
     dec_ctx->ctoo_c = malloc(sizeof(int) * numpp);
     if (dec_ctx->ctoo_c == NULL)
         goto AllocError;
+    if (alloc_gauss_scratch(&dec_ctx->gs, sc->gf, numpp) != 0)
+        goto AllocError;
 
     dec_ctx->overhead     = 0;
     dec_ctx->overheads = calloc(dec_ctx->sc->gnum, sizeof(int));
@@ -114,8 +121,9 @@ void process_packet_BD(struct decoding_context_BD *dec_ctx, struct snc_packet *p
         } else if (pkt->gid == -1 && pkt->ucid >= 0) {
             ces[pkt->ucid] = 1;
         } else {
+            int *pktid = get_subgeneration(dec_ctx->sc, pkt->gid)->pktid;
             for (i=0; i<gensize; i++) {
-                int index = dec_ctx->sc->gene[pkt->gid]->pktid[i];
+                int index = pktid[i];
                 if (dec_ctx->sc->params.gfpower==1) {
                     ces[index] = get_bit_in_array(pkt->coes, i);
                 } else if (dec_ctx->sc->params.gfpower==8) {
@@ -128,12 +136,12 @@ void process_packet_BD(struct decoding_context_BD *dec_ctx, struct snc_packet *p
         for (i=0; i<numpp; i++) {
             if (ces[i] != 0) {
                 if (dec_ctx->coefficient[i][i] != 0) {
-                    quotient = galois_divide(ces[i], dec_ctx->coefficient[i][i]);
+                    quotient = galois_divide(dec_ctx->sc->gf, ces[i], dec_ctx->coefficient[i][i]);
                     dec_ctx->operations += 1;
                     int band_width = numpp-i > gensize ? gensize : numpp-i;
-                    galois_multiply_add_region(ces+i, &(dec_ctx->coefficient[i][i]), quotient, band_width);
+                    galois_multiply_add_region(dec_ctx->sc->gf, ces+i, &(dec_ctx->coefficient[i][i]), quotient, band_width);
                     dec_ctx->operations += band_width;
-                    galois_multiply_add_region(pkt->syms, dec_ctx->message[i], quotient, pktsize);
+                    galois_multiply_add_region(dec_ctx->sc->gf, pkt->syms, dec_ctx->message[i], quotient, pktsize);
                     dec_ctx->operations += pktsize;
                 } else {
                     pivotfound = 1;
@@ -155,8 +163,9 @@ void process_packet_BD(struct decoding_context_BD *dec_ctx, struct snc_packet *p
         } else if (pkt->gid == -1 && pkt->ucid >= 0) {
             ces[pkt->ucid] = 1;
         } else {
+            int *pktid = get_subgeneration(dec_ctx->sc, pkt->gid)->pktid;
             for (i=0; i<gensize; i++) {
-                int orig_index = dec_ctx->sc->gene[pkt->gid]->pktid[i];
+                int orig_index = pktid[i];
                 if (dec_ctx->sc->params.gfpower == 1) {
                     ces[orig_index] = get_bit_in_array(pkt->coes, i);
                 } else if (dec_ctx->sc->params.gfpower == 8){
@@ -169,13 +178,13 @@ void process_packet_BD(struct decoding_context_BD *dec_ctx, struct snc_packet *p
         for (i=0; i<numpp; i++) {
             if (ces[dec_ctx->ctoo_c[i]] != 0) {
                 if (dec_ctx->coefficient[dec_ctx->ctoo_r[i]][dec_ctx->ctoo_c[i]] != 0) {
-                    quotient = galois_divide(ces[dec_ctx->ctoo_c[i]], dec_ctx->coefficient[dec_ctx->ctoo_r[i]][dec_ctx->ctoo_c[i]]);
+                    quotient = galois_divide(dec_ctx->sc->gf, ces[dec_ctx->ctoo_c[i]], dec_ctx->coefficient[dec_ctx->ctoo_r[i]][dec_ctx->ctoo_c[i]]);
                     dec_ctx->operations += 1;
                     for (j=i; j<numpp; j++) {
-                        ces[dec_ctx->ctoo_c[j]] = galois_add(ces[dec_ctx->ctoo_c[j]], galois_multiply(dec_ctx->coefficient[dec_ctx->ctoo_r[i]][dec_ctx->ctoo_c[j]], quotient));
+                        ces[dec_ctx->ctoo_c[j]] = galois_add(ces[dec_ctx->ctoo_c[j]], galois_multiply(dec_ctx->sc->gf, dec_ctx->coefficient[dec_ctx->ctoo_r[i]][dec_ctx->ctoo_c[j]], quotient));
                     }
                     dec_ctx->operations += (numpp - i);
-                    galois_multiply_add_region(pkt->syms, dec_ctx->message[dec_ctx->ctoo_r[i]], quotient, pktsize);
+                    galois_multiply_add_region(dec_ctx->sc->gf, pkt->syms, dec_ctx->message[dec_ctx->ctoo_r[i]], quotient, pktsize);
                     dec_ctx->operations += pktsize;
                 } else {
                     pivotfound = 1;
@@ -264,19 +273,19 @@ static int partially_diag_decoding_matrix(struct decoding_context_BD *dec_ctx)
                 if (dec_ctx->coefficient[i][j] == 0)
                     continue;
 
-                quotient = galois_divide(dec_ctx->coefficient[i][j], dec_ctx->coefficient[j][j]);
+                quotient = galois_divide(dec_ctx->sc->gf, dec_ctx->coefficient[i][j], dec_ctx->coefficient[j][j]);
                 operations += 1;
                 dec_ctx->coefficient[i][j] = 0;         // eliminiate the element
                 // Important: corresponding operations on behind columns whose diagonal elements are zeros
                 for (int z=0; z<zero_p; z++) {
                     l = zeropivots[z];
                     if (dec_ctx->coefficient[j][l] != 0) {
-                        dec_ctx->coefficient[i][l] = galois_add(dec_ctx->coefficient[i][l], galois_multiply(dec_ctx->coefficient[j][l], quotient));
+                        dec_ctx->coefficient[i][l] = galois_add(dec_ctx->coefficient[i][l], galois_multiply(dec_ctx->sc->gf, dec_ctx->coefficient[j][l], quotient));
                         operations += 1;
                     }
                 }
                 // correspoding operations on the message matrix
-                galois_multiply_add_region(dec_ctx->message[i], dec_ctx->message[j], quotient, pktsize);
+                galois_multiply_add_region(dec_ctx->sc->gf, dec_ctx->message[i], dec_ctx->message[j], quotient, pktsize);
                 operations += pktsize;
             }
         }
@@ -313,11 +322,10 @@ static int apply_parity_check_matrix(struct decoding_context_BD *dec_ctx)
     }
 
     // 2, Pivot and re-order matrices
-    if (getenv("SNC_BD_ONEROUND") != NULL 
-         && atoi(getenv("SNC_BD_ONEROUND")) == 1) {
-        dec_ctx->operations += pivot_matrix_oneround(numpp, numpp, pktsize, dec_ctx->coefficient, dec_ctx->message, &dec_ctx->ctoo_r, &dec_ctx->ctoo_c, &(dec_ctx->inactivated));
+    if (dec_ctx->sc->opts.bd_oneround) {
+        dec_ctx->operations += pivot_matrix_oneround(dec_ctx->sc->gf, &dec_ctx->gs, numpp, numpp, pktsize, dec_ctx->coefficient, dec_ctx->message, &dec_ctx->ctoo_r, &dec_ctx->ctoo_c, &(dec_ctx->inactivated));
     } else {
-        dec_ctx->operations += pivot_matrix_tworound(numpp, numpp, pktsize, dec_ctx->coefficient, dec_ctx->message, &dec_ctx->ctoo_r, &dec_ctx->ctoo_c, &(dec_ctx->inactivated));
+        dec_ctx->operations += pivot_matrix_tworound(dec_ctx->sc->gf, &dec_ctx->gs, numpp, numpp, pktsize, dec_ctx->coefficient, dec_ctx->message, &dec_ctx->ctoo_r, &dec_ctx->ctoo_c, &(dec_ctx->inactivated));
     }
 
     /* Count available innovative rows */
@@ -345,8 +353,8 @@ static void finish_recovering_BD(struct decoding_context_BD *dec_ctx)
     for (j=numpp-1; j>=0; j--) {
         for (i=0; i<j; i++) {
             if (dec_ctx->coefficient[dec_ctx->ctoo_r[i]][dec_ctx->ctoo_c[j]] != 0) {
-                quotient = galois_divide(dec_ctx->coefficient[dec_ctx->ctoo_r[i]][dec_ctx->ctoo_c[j]], dec_ctx->coefficient[dec_ctx->ctoo_r[j]][dec_ctx->ctoo_c[j]]);
-                galois_multiply_add_region(dec_ctx->message[dec_ctx->ctoo_r[i]], dec_ctx->message[dec_ctx->ctoo_r[j]], quotient, pktsize);
+                quotient = galois_divide(dec_ctx->sc->gf, dec_ctx->coefficient[dec_ctx->ctoo_r[i]][dec_ctx->ctoo_c[j]], dec_ctx->coefficient[dec_ctx->ctoo_r[j]][dec_ctx->ctoo_c[j]]);
+                galois_multiply_add_region(dec_ctx->sc->gf, dec_ctx->message[dec_ctx->ctoo_r[i]], dec_ctx->message[dec_ctx->ctoo_r[j]], quotient, pktsize);
                 dec_ctx->coefficient[dec_ctx->ctoo_r[i]][dec_ctx->ctoo_c[j]] = 0;
                 bs_ops += 1 + pktsize;
             }
@@ -355,10 +363,10 @@ static void finish_recovering_BD(struct decoding_context_BD *dec_ctx)
     // Convert all diagonal element to 1
     for (i=0; i<numpp; i++) {
         if (dec_ctx->coefficient[dec_ctx->ctoo_r[i]][dec_ctx->ctoo_c[i]] != 1)
-            galois_multiply_region(dec_ctx->message[dec_ctx->ctoo_r[i]], galois_divide(1, dec_ctx->coefficient[dec_ctx->ctoo_r[i]][dec_ctx->ctoo_c[i]]), pktsize);
+            galois_multiply_region(dec_ctx->sc->gf, dec_ctx->message[dec_ctx->ctoo_r[i]], galois_divide(dec_ctx->sc->gf, 1, dec_ctx->coefficient[dec_ctx->ctoo_r[i]][dec_ctx->ctoo_c[i]]), pktsize);
         dec_ctx->coefficient[dec_ctx->ctoo_r[i]][dec_ctx->ctoo_c[i]] = 1;
         int pktid = dec_ctx->ctoo_c[i];
-        dec_ctx->sc->pp[pktid] = calloc(pktsize, sizeof(GF_ELEMENT));
+        dec_ctx->sc->pp[pktid] = calloc_payload(pktsize);
         memcpy(dec_ctx->sc->pp[pktid], dec_ctx->message[dec_ctx->ctoo_r[i]], pktsize*sizeof(GF_ELEMENT));
     }
     dec_ctx->operations += bs_ops;
@@ -391,11 +399,32 @@ void free_dec_context_BD(struct decoding_context_BD *dec_ctx)
         free(dec_ctx->ctoo_c);
     if (dec_ctx->overheads != NULL)
         free(dec_ctx->overheads);
+    free_gauss_scratch(&dec_ctx->gs);
     free(dec_ctx);
     dec_ctx = NULL;
     return;
 }
 
+/*
+ * Missing DoF of subgeneration gid, i.e., its packets having no pivot row yet.
+ * The matrix is pivoted once the parity-check matrix is applied, after which
+ * each unfinished subgeneration reports 1.
+ */
+int missing_dof_BD(struct decoding_context_BD *dec_ctx, int gid)
+{
+    if (dec_ctx->finished)
+        return 0;
+    if (dec_ctx->de_precode)
+        return 1;
+    int *pktid = get_subgeneration(dec_ctx->sc, gid)->pktid;
+    int missing = 0;
+    for (int i=0; i<dec_ctx->sc->params.size_g; i++) {
+        if (dec_ctx->coefficient[pktid[i]][pktid[i]] == 0)
+            missing += 1;
+    }
+    return missing;
+}
+
 /**
  * Save a decoding context to a file
  * Return values:
@@ -470,7 +499,7 @@ struct decoding_context_BD *restore_dec_context_BD(const char *filepath)
     fread(&sp, sizeof(struct snc_parameters), 1, fp);
     fseek(fp, sizeof(int), SEEK_CUR);  // skip decoding_type field
     // Create a fresh decoding context
-    struct decoding_context_BD *dec_ctx = create_dec_context_BD(&sp);
+    struct decoding_context_BD *dec_ctx = create_dec_context_BD(&sp, NULL);
     if (dec_ctx == NULL) {
         fprintf(stderr, "malloc decoding_context_GG failed\n");
         return NULL;
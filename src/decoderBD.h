@@ -19,6 +19,7 @@ struct decoding_context_BD
     // the following two mappings are to record pivoting processings
     int *ctoo_r;                // record the mapping from current row index to the original row id
     int *ctoo_c;                // record the mapping from current col index to the original row id
+    struct gauss_scratch gs;    // scratch of Gaussian elimination of pivoting
 
     /*performance index*/
     int overhead;               // record how many packets have been received
@@ -26,8 +27,9 @@ struct decoding_context_BD
     long long operations;       // record the number of computations used
 };
 
-struct decoding_context_BD *create_dec_context_BD(struct snc_parameters *sp);
+struct decoding_context_BD *create_dec_context_BD(struct snc_parameters *sp, const struct snc_options *opt);
 void process_packet_BD(struct decoding_context_BD *dec_ctx, struct snc_packet *pkt);
+int missing_dof_BD(struct decoding_context_BD *dec_ctx, int gid);
 void free_dec_context_BD(struct decoding_context_BD *dec_ctx);
 
 /**
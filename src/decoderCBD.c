@@ -8,16 +8,58 @@
  * (which are nonzeros) are stored. A price to pay is that pivoting
  * cannot be performed due to the limited random access and row/col
  * manipulation capability of using compact row vectors.
+ *
+ * For GF(2) codes the rows are bit-packed (see BITROW_WORDS in common.h)
+ * and forward substitution works on words.
  ********************************************************************/
 #include "common.h"
 #include "galois.h"
 #include "decoderCBD.h"
 static int process_vector_CBD(struct decoding_context_CBD *dec_ctx, GF_ELEMENT *vector, GF_ELEMENT *message);
+static int process_bitvector_CBD(struct decoding_context_CBD *dec_ctx, uint64_t *vector, GF_ELEMENT *message);
 static int apply_parity_check_matrix(struct decoding_context_CBD *dec_ctx);
 static void finish_recovering_CBD(struct decoding_context_CBD *dec_ctx);
 
+/*
+ * Rows are bit-packed if all coefficients of the decoding matrix are 0 or
+ * 1, i.e., GF(2) network coding with a binary precode (or none). With a
+ * GF(256) precode, the parity-check rows need full GF(256) elements.
+ */
+static inline int binary_rows(struct decoding_context_CBD *dec_ctx)
+{
+    return dec_ctx->sc->params.gfpower == 1 && (dec_ctx->sc->params.bpc || dec_ctx->sc->cnum == 0);
+}
+
+// Element at column c of the row whose pivot is i
+static inline GF_WORD row_element(struct decoding_context_CBD *dec_ctx, int i, int c)
+{
+    if (binary_rows(dec_ctx))
+        return bitrow_get((uint64_t *) dec_ctx->row[i]->elem, i, c);
+    return gf_get_element(dec_ctx->row[i]->elem, c-i, gf_field_esize(dec_ctx->sc->gf));
+}
+
+static inline void set_row_element(struct decoding_context_CBD *dec_ctx, int i, int c, GF_WORD v)
+{
+    if (binary_rows(dec_ctx)) {
+        if (v)
+            bitrow_set((uint64_t *) dec_ctx->row[i]->elem, i, c);
+        else
+            bitrow_clear((uint64_t *) dec_ctx->row[i]->elem, i, c);
+        return;
+    }
+    gf_set_element(dec_ctx->row[i]->elem, c-i, v, gf_field_esize(dec_ctx->sc->gf));
+}
+
+// Bytes of storage of the row whose pivot is i
+static inline int row_bytes(struct decoding_context_CBD *dec_ctx, int i)
+{
+    if (binary_rows(dec_ctx))
+        return sizeof(uint64_t) * BITROW_WORDS(i, dec_ctx->row[i]->len);
+    return dec_ctx->row[i]->len * gf_field_esize(dec_ctx->sc->gf);
+}
+
 // create decoding context for band decoder
-struct decoding_context_CBD *create_dec_context_CBD(struct snc_parameters *sp)
+struct decoding_context_CBD *create_dec_context_CBD(struct snc_parameters *sp, const struct snc_options *opt)
 {
     static char fname[] = "snc_create_dec_context_CBD";
     int i, j, k;
@@ -38,7 +80,7 @@ struct decoding_context_CBD *create_dec_context_CBD(struct snc_parameters *sp)
     }
 
     struct snc_context *sc;
-    if ((sc = snc_create_enc_context(NULL, sp)) == NULL) {
+    if ((sc = snc_create_enc_context_opt(NULL, sp, opt)) == NULL) {
         fprintf(stderr, "%s: create decoding context failed", fname);
         goto AllocError;
     }
@@ -65,11 +107,11 @@ struct decoding_context_CBD *create_dec_context_CBD(struct snc_parameters *sp)
         goto AllocError;
     }
     for (i=0; i<numpp; i++) {
-        if (dec_ctx->sc->params.gfpower == 1 || dec_ctx->sc->params.gfpower == 8) {
-            dec_ctx->message[i] = calloc(pktsize, sizeof(GF_ELEMENT));
+        if (dec_ctx->sc->params.gfpower == 1 || dec_ctx->sc->params.gfpower == 8 || dec_ctx->sc->params.gfpower == 16) {
+            dec_ctx->message[i] = calloc_payload(pktsize);
         } else {
             // Use one GF_ELEMENT for each coded symbol even if GF size is small. This is for easy access.
-            dec_ctx->message[i] = calloc(ALIGN(pktsize*8, dec_ctx->sc->params.gfpower), sizeof(GF_ELEMENT));
+            dec_ctx->message[i] = calloc_payload(ALIGN(pktsize*8, dec_ctx->sc->params.gfpower));
         }
         if (dec_ctx->message[i] == NULL) {
             fprintf(stderr, "%s: calloc dec_ctx->message[%d] failed\n", fname, i);
@@ -103,38 +145,60 @@ void process_packet_CBD(struct decoding_context_CBD *dec_ctx, struct snc_packet
     int gensize = dec_ctx->sc->params.size_g;
     int pktsize = dec_ctx->sc->params.size_p;
     int numpp   = dec_ctx->sc->snum + dec_ctx->sc->cnum;
+    int esize   = gf_field_esize(dec_ctx->sc->gf);
+    int lastDoF = dec_ctx->DoF;
 
-    // transform GNC encoding vector to full length
-    GF_ELEMENT *ces = calloc(numpp, sizeof(GF_ELEMENT));
-    if (ces == NULL)
-        fprintf(stderr, "%s: calloc ces failed\n", fname);
-
-    // Pay attention to systematic packets. It is easy to handle in CBD decoder. Let's 
-    // just transform it to full-length singleton vector.
-    if (pkt->gid == -1 && pkt->ucid == -1) {
-        fprintf(stderr, "%s: pkt's gid is -1 but ucid is not valid\n", fname);
-    } else if (pkt->gid == -1 && pkt->ucid >= 0) {
-        ces[pkt->ucid] = 1;
+    if (binary_rows(dec_ctx)) {
+        // transform GNC encoding vector to a full-length bit vector
+        uint64_t *bits = calloc(ALIGN(numpp, 64), sizeof(uint64_t));
+        if (bits == NULL)
+            fprintf(stderr, "%s: calloc bits failed\n", fname);
+        if (pkt->gid == -1 && pkt->ucid == -1) {
+            fprintf(stderr, "%s: pkt's gid is -1 but ucid is not valid\n", fname);
+        } else if (pkt->gid == -1 && pkt->ucid >= 0) {
+            bitrow_set(bits, 0, pkt->ucid);
+        } else {
+            int *pktid = get_subgeneration(dec_ctx->sc, pkt->gid)->pktid;
+            for (i=0; i<gensize; i++) {
+                if (get_bit_in_array(pkt->coes, i))
+                    bitrow_set(bits, 0, pktid[i]);
+            }
+        }
+        process_bitvector_CBD(dec_ctx, bits, pkt->syms);
+        free(bits);
     } else {
-        // This is normal GNC packet
-        for (i=0; i<gensize; i++) {
-            int index = dec_ctx->sc->gene[pkt->gid]->pktid[i];
-            if (dec_ctx->sc->params.gfpower==1) {
-                ces[index] = get_bit_in_array(pkt->coes, i);
-            } else if (dec_ctx->sc->params.gfpower==8) {
-                ces[index] = pkt->coes[i];
-            } else {
-                //ces[index] = read_bits_from_byte_array(pkt->coes, dec_ctx->sc->params.size_g, dec_ctx->sc->params.gfpower, i);
-                ces[index] = read_bits_from_byte_array(pkt->coes, ALIGN(gensize * dec_ctx->sc->params.gfpower, 8), dec_ctx->sc->params.gfpower, i);
+        // transform GNC encoding vector to full length
+        GF_ELEMENT *ces = calloc(numpp, sizeof(GF_ELEMENT)*esize);
+        if (ces == NULL)
+            fprintf(stderr, "%s: calloc ces failed\n", fname);
+
+        // Pay attention to systematic packets. It is easy to handle in CBD decoder. Let's 
+        // just transform it to full-length singleton vector.
+        if (pkt->gid == -1 && pkt->ucid == -1) {
+            fprintf(stderr, "%s: pkt's gid is -1 but ucid is not valid\n", fname);
+        } else if (pkt->gid == -1 && pkt->ucid >= 0) {
+            gf_set_element(ces, pkt->ucid, 1, esize);
+        } else {
+            // This is normal GNC packet
+            int *pktid = get_subgeneration(dec_ctx->sc, pkt->gid)->pktid;
+            for (i=0; i<gensize; i++) {
+                int index = pktid[i];
+                if (dec_ctx->sc->params.gfpower==1) {
+                    ces[index] = get_bit_in_array(pkt->coes, i);
+                } else if (dec_ctx->sc->params.gfpower==8 || dec_ctx->sc->params.gfpower==16) {
+                    gf_set_element(ces, index, gf_get_element(pkt->coes, i, esize), esize);
+                } else {
+                    //ces[index] = read_bits_from_byte_array(pkt->coes, dec_ctx->sc->params.size_g, dec_ctx->sc->params.gfpower, i);
+                    ces[index] = read_bits_from_byte_array(pkt->coes, ALIGN(gensize * dec_ctx->sc->params.gfpower, 8), dec_ctx->sc->params.gfpower, i);
+                }
             }
         }
-    }
 
-    /* Process full-length encoding vector against decoding matrix */
-    int lastDoF = dec_ctx->DoF;
-    int pivot = process_vector_CBD(dec_ctx, ces, pkt->syms);
-    free(ces);
-    ces = NULL;
+        /* Process full-length encoding vector against decoding matrix */
+        process_vector_CBD(dec_ctx, ces, pkt->syms);
+        free(ces);
+        ces = NULL;
+    }
     if (get_loglevel() == TRACE) 
         printf("received %d DoF: %d\n", dec_ctx->overhead, dec_ctx->DoF-lastDoF);
     // If the number of received DoF is equal to NUM_SRC, apply the parity-check matrix.
@@ -159,32 +223,33 @@ static int process_vector_CBD(struct decoding_context_CBD *dec_ctx, GF_ELEMENT *
     int i, j, k;
     int pivot = -1;
     int pivotfound = 0;
-    GF_ELEMENT quotient;
+    GF_WORD quotient;
 
     int gensize = dec_ctx->sc->params.size_g;
     int pktsize = dec_ctx->sc->params.size_p;           // in bytes
     int numpp   = dec_ctx->sc->snum + dec_ctx->sc->cnum;
     int gfpower = dec_ctx->sc->params.gfpower;
-    int scale   = (gfpower == 1 || gfpower == 8) ? pktsize : ALIGN(pktsize*8, gfpower);  // How many coded symbols using the corresponding GF
+    int esize   = gf_field_esize(dec_ctx->sc->gf);      // bytes per element of vector and rows
+    int bytewise = (gfpower == 1 || gfpower == 8 || gfpower == 16);
+    int scale   = bytewise ? pktsize : ALIGN(pktsize*8, gfpower);  // How many coded symbols using the corresponding GF
 
     GF_ELEMENT *msg_expa = message;
     // Expand messages if ncessary: the GF is GF(4), GF(8), ..., GF(128)
-    if (gfpower != 1 && gfpower != 8) {
-        msg_expa = calloc(scale, sizeof(GF_ELEMENT));          // to store expanded message
-        for (j=0; j<scale; j++) {
-            msg_expa[j] = read_bits_from_byte_array(message, pktsize, gfpower, j);
-        }
+    if (!bytewise) {
+        msg_expa = calloc_payload(scale);          // to store expanded message
+        read_elements_from_byte_array(msg_expa, scale, message, pktsize, gfpower);
     }
 
     int rowop = 0;
     for (i=0; i<numpp; i++) {
-        if (vector[i] != 0) {
+        GF_WORD v = gf_get_element(vector, i, esize);
+        if (v != 0) {
             if (dec_ctx->row[i] != NULL) {
                 /* There is a valid row saved for pivot-i, process against it */
-                assert(dec_ctx->row[i]->elem[0]);
-                quotient = galois_divide(vector[i], dec_ctx->row[i]->elem[0]);
-                galois_multiply_add_region(&(vector[i]), dec_ctx->row[i]->elem, quotient, dec_ctx->row[i]->len);
-                galois_multiply_add_region(msg_expa, dec_ctx->message[i], quotient, scale);
+                assert(gf_get_element(dec_ctx->row[i]->elem, 0, esize));
+                quotient = galois_divide(dec_ctx->sc->gf, v, gf_get_element(dec_ctx->row[i]->elem, 0, esize));
+                galois_multiply_add_region(dec_ctx->sc->gf, &(vector[i*esize]), dec_ctx->row[i]->elem, quotient, dec_ctx->row[i]->len*esize);
+                galois_multiply_add_region(dec_ctx->sc->gf, msg_expa, dec_ctx->message[i], quotient, bytewise ? scale : PADDED(scale));
                 dec_ctx->operations += 1 + dec_ctx->row[i]->len + scale;
                 if (!dec_ctx->de_precode) {
                     dec_ctx->ops1 += 1 + dec_ctx->row[i]->len + scale;
@@ -214,22 +279,78 @@ static int process_vector_CBD(struct decoding_context_CBD *dec_ctx, GF_ELEMENT *
             len = numpp - pivot;
         }
         dec_ctx->row[pivot]->len = len;
-        dec_ctx->row[pivot]->elem = (GF_ELEMENT *) calloc(len, sizeof(GF_ELEMENT));
+        dec_ctx->row[pivot]->elem = (GF_ELEMENT *) calloc(len, sizeof(GF_ELEMENT)*esize);
         if (dec_ctx->row[pivot]->elem == NULL)
             fprintf(stderr, "%s: calloc dec_ctx->row[%d]->elem failed\n", fname, pivot);
-        memcpy(dec_ctx->row[pivot]->elem, &(vector[pivot]), len*sizeof(GF_ELEMENT));
-        assert(dec_ctx->row[pivot]->elem[0]);
+        memcpy(dec_ctx->row[pivot]->elem, &(vector[pivot*esize]), len*sizeof(GF_ELEMENT)*esize);
+        assert(gf_get_element(dec_ctx->row[pivot]->elem, 0, esize));
         memcpy(dec_ctx->message[pivot], msg_expa,  scale*sizeof(GF_ELEMENT));
         if (get_loglevel() == TRACE) 
             printf("received-DoF %d new-DoF %d row_ops: %d\n", dec_ctx->DoF, pivot, rowop);
         dec_ctx->DoF += 1;
     }
-    if (gfpower != 1 && gfpower != 8) {
+    if (!bytewise) {
         free(msg_expa);
     }
     return pivot;
 }
 
+/*
+ * GF(2) version of process_vector_CBD(). The vector and the rows are
+ * bit-packed, so the next nonzero column is found by word scanning and
+ * eliminating against a row is a XOR of its words.
+ */
+static int process_bitvector_CBD(struct decoding_context_CBD *dec_ctx, uint64_t *vector, GF_ELEMENT *message)
+{
+    static char fname[] = "process_bitvector_CBD";
+    int pivot = -1;
+
+    int gensize = dec_ctx->sc->params.size_g;
+    int pktsize = dec_ctx->sc->params.size_p;
+    int numpp   = dec_ctx->sc->snum + dec_ctx->sc->cnum;
+
+    int rowop = 0;
+    int i = bitrow_next(vector, 0, numpp);
+    while (i >= 0) {
+        if (dec_ctx->row[i] == NULL) {
+            pivot = i;
+            break;
+        }
+        bitrow_xor(vector, (uint64_t *) dec_ctx->row[i]->elem, i, dec_ctx->row[i]->len);
+        galois_multiply_add_region(dec_ctx->sc->gf, message, dec_ctx->message[i], 1, pktsize);
+        dec_ctx->operations += 1 + dec_ctx->row[i]->len + pktsize;
+        if (!dec_ctx->de_precode) {
+            dec_ctx->ops1 += 1 + dec_ctx->row[i]->len + pktsize;
+        } else {
+            dec_ctx->ops2 += 1 + dec_ctx->row[i]->len + pktsize;
+        }
+        rowop += 1;
+        i = bitrow_next(vector, i+1, numpp);
+    }
+
+    if (pivot >= 0) {
+        /* Save it to the corresponding row */
+        dec_ctx->row[pivot] = (struct row_vector*) malloc(sizeof(struct row_vector));
+        if (dec_ctx->row[pivot] == NULL)
+            fprintf(stderr, "%s: malloc dec_ctx->row[%d] failed\n", fname, pivot);
+        int len;
+        if (!dec_ctx->de_precode && !dec_ctx->naive) {
+            len = numpp - pivot > gensize ? gensize : numpp - pivot;
+        } else {
+            len = numpp - pivot;
+        }
+        dec_ctx->row[pivot]->len = len;
+        dec_ctx->row[pivot]->elem = (GF_ELEMENT *) bitrow_extract(vector, pivot, len);
+        if (dec_ctx->row[pivot]->elem == NULL)
+            fprintf(stderr, "%s: malloc dec_ctx->row[%d]->elem failed\n", fname, pivot);
+        memcpy(dec_ctx->message[pivot], message, pktsize*sizeof(GF_ELEMENT));
+        if (get_loglevel() == TRACE)
+            printf("received-DoF %d new-DoF %d row_ops: %d\n", dec_ctx->DoF, pivot, rowop);
+        dec_ctx->DoF += 1;
+    }
+    return pivot;
+}
+
 // Apply the parity-check matrix to the decoding matrix
 static int apply_parity_check_matrix(struct decoding_context_CBD *dec_ctx)
 {
@@ -240,22 +361,33 @@ static int apply_parity_check_matrix(struct decoding_context_CBD *dec_ctx)
     int gensize = dec_ctx->sc->params.size_g;
     int pktsize = dec_ctx->sc->params.size_p;
     int numpp = dec_ctx->sc->snum + dec_ctx->sc->cnum;
+    int esize = gf_field_esize(dec_ctx->sc->gf);
 
     // 1, Copy parity-check vectors to the nonzero rows of the decoding matrix
-    GF_ELEMENT *ces = malloc(numpp*sizeof(GF_ELEMENT));
-    GF_ELEMENT *msg = malloc(pktsize*sizeof(GF_ELEMENT));
+    int binary = binary_rows(dec_ctx);
+    int cesbytes = binary ? sizeof(uint64_t)*ALIGN(numpp, 64) : numpp*sizeof(GF_ELEMENT)*esize;
+    GF_ELEMENT *ces = malloc(cesbytes);
+    GF_ELEMENT *msg = calloc_payload(pktsize);
     int p = 0;          // index pointer to the parity-check vector that is to be copyed
     for (int p=0; p<dec_ctx->sc->cnum; p++) {
-        memset(ces, 0, numpp*sizeof(GF_ELEMENT));
+        memset(ces, 0, cesbytes);
         memset(msg, 0, pktsize*sizeof(GF_ELEMENT));
         /* Set the coding vector according to parity-check bits */
         NBR_node *varnode = dec_ctx->sc->graph->l_nbrs_of_r[p]->first;
         while (varnode != NULL) {
-            ces[varnode->data] = varnode->ce;
+            if (binary)
+                bitrow_set((uint64_t *) ces, 0, varnode->data);
+            else
+                gf_set_element(ces, varnode->data, varnode->ce, esize);
             varnode = varnode->next;
         }
-        ces[dec_ctx->sc->snum+p] = 1;
-        int pivot = process_vector_CBD(dec_ctx, ces, msg);
+        if (binary) {
+            bitrow_set((uint64_t *) ces, 0, dec_ctx->sc->snum+p);
+            process_bitvector_CBD(dec_ctx, (uint64_t *) ces, msg);
+        } else {
+            gf_set_element(ces, dec_ctx->sc->snum+p, 1, esize);
+            process_vector_CBD(dec_ctx, ces, msg);
+        }
     }
     free(ces);
     free(msg);
@@ -265,7 +397,7 @@ static int apply_parity_check_matrix(struct decoding_context_CBD *dec_ctx)
     for (i=0; i<numpp; i++) {
         if (dec_ctx->row[i] == NULL)
             missing_DoF++;
-        else if (dec_ctx->row[i]->elem[0] ==0 && get_loglevel() == TRACE) {
+        else if (row_element(dec_ctx, i, i) == 0 && get_loglevel() == TRACE) {
             printf("%s: row[%d]->elem[0] is 0\n", fname, i);
         }
     }
@@ -283,41 +415,55 @@ static void finish_recovering_CBD(struct decoding_context_CBD *dec_ctx)
     int pktsize = dec_ctx->sc->params.size_p;
     int numpp = dec_ctx->sc->snum + dec_ctx->sc->cnum;
     int gfpower = dec_ctx->sc->params.gfpower;
-    int scale   = (gfpower == 1 || gfpower == 8) ? pktsize : ALIGN(pktsize*8, gfpower);  // How many coded symbols using the corresponding GF
+    int esize   = gf_field_esize(dec_ctx->sc->gf);
+    int bytewise = (gfpower == 1 || gfpower == 8 || gfpower == 16);
+    int scale   = bytewise ? pktsize : ALIGN(pktsize*8, gfpower);  // How many coded symbols using the corresponding GF
 
-    int i, j;
+    int i, j, n;
     int len;
-    GF_ELEMENT quotient;
+    // messages to be eliminated by message[i] and the quotients
+    GF_ELEMENT **dsts = malloc(sizeof(GF_ELEMENT*) * numpp);
+    GF_ELEMENT *quotients = malloc(sizeof(GF_ELEMENT) * numpp * esize);
+    if (dsts == NULL || quotients == NULL) {
+        fprintf(stderr, "finish_recovering_CBD: malloc elimination list failed\n");
+        free(dsts);
+        free(quotients);
+        return;
+    }
     for (i=numpp-1; i>=0; i--) {
         /* eliminate all nonzeros above diagonal elements from right to left*/
+        GF_WORD diag = row_element(dec_ctx, i, i);
+        n = 0;
         for (j=0; j<i; j++) {
             len = dec_ctx->row[j]->len;
-            if (j+len <= i || dec_ctx->row[j]->elem[i-j] == 0)
+            if (j+len <= i || row_element(dec_ctx, j, i) == 0)
                 continue;
-            assert(dec_ctx->row[i]->elem[0]);
-            quotient = galois_divide(dec_ctx->row[j]->elem[i-j], dec_ctx->row[i]->elem[0]);
-            galois_multiply_add_region(dec_ctx->message[j], dec_ctx->message[i], quotient, scale);
+            assert(diag);
+            gf_set_element(quotients, n, galois_divide(dec_ctx->sc->gf, row_element(dec_ctx, j, i), diag), esize);
+            dsts[n++] = dec_ctx->message[j];
             dec_ctx->operations += (scale + 1);
             dec_ctx->ops3 += (scale + 1);
-            dec_ctx->row[j]->elem[i-j] = 0;
+            set_row_element(dec_ctx, j, i, 0);
         }
+        galois_multiply_add_region_scatter(dec_ctx->sc->gf, dsts, dec_ctx->message[i], quotients, n, PADDED(scale));
         /* convert diagonal to 1*/
-        if (dec_ctx->row[i]->elem[0] != 1) {
-            galois_multiply_region(dec_ctx->message[i], galois_divide(1, dec_ctx->row[i]->elem[0]), scale);
+        if (diag != 1) {
+            galois_multiply_region(dec_ctx->sc->gf, dec_ctx->message[i], galois_divide(dec_ctx->sc->gf, 1, diag), PADDED(scale));
             dec_ctx->operations += (scale + 1);
             dec_ctx->ops3 += (scale + 1);
-            dec_ctx->row[i]->elem[0] = 1;
+            set_row_element(dec_ctx, i, i, 1);
         }
         /* save decoded packet */
-        dec_ctx->sc->pp[i] = calloc(pktsize, sizeof(GF_ELEMENT));
-        if (gfpower == 1 || gfpower == 8) { 
+        dec_ctx->sc->pp[i] = calloc_payload(pktsize);
+        if (bytewise) {
             memcpy(dec_ctx->sc->pp[i], dec_ctx->message[i], pktsize*sizeof(GF_ELEMENT));
         } else {
-            for (j=0; j<scale; j++) {
-                pack_bits_in_byte_array(dec_ctx->sc->pp[i], dec_ctx->sc->params.size_p, dec_ctx->message[i][j], gfpower, j);   // compress the expanded message to original length
-            }
+            // compress the expanded message to original length
+            pack_elements_in_byte_array(dec_ctx->sc->pp[i], dec_ctx->sc->params.size_p, dec_ctx->message[i], scale, gfpower);
         }
     }
+    free(dsts);
+    free(quotients);
     dec_ctx->finished = 1;
     if (get_loglevel() == TRACE) {
         int snum = dec_ctx->sc->snum;
@@ -355,6 +501,20 @@ void free_dec_context_CBD(struct decoding_context_CBD *dec_ctx)
     return;
 }
 
+// Missing DoF of subgeneration gid, i.e., its packets having no pivot row yet
+int missing_dof_CBD(struct decoding_context_CBD *dec_ctx, int gid)
+{
+    if (dec_ctx->finished)
+        return 0;
+    int *pktid = get_subgeneration(dec_ctx->sc, gid)->pktid;
+    int missing = 0;
+    for (int i=0; i<dec_ctx->sc->params.size_g; i++) {
+        if (dec_ctx->row[pktid[i]] == NULL)
+            missing += 1;
+    }
+    return missing;
+}
+
 /**
  * Save a decoding context to a file
  * Return values:
@@ -387,7 +547,7 @@ long save_dec_context_CBD(struct decoding_context_CBD *dec_ctx, const char *file
         int rowlen = dec_ctx->row[i] == NULL ? 0 : dec_ctx->row[i]->len;
         filesize += fwrite(&rowlen, sizeof(int), 1, fp);
         if (rowlen != 0) {
-            filesize += fwrite(dec_ctx->row[i]->elem, sizeof(GF_ELEMENT), rowlen, fp);
+            filesize += fwrite(dec_ctx->row[i]->elem, sizeof(GF_ELEMENT), row_bytes(dec_ctx, i), fp);
             filesize += fwrite(dec_ctx->message[i], sizeof(GF_ELEMENT), pktsize, fp);
         }
     }
@@ -411,7 +571,7 @@ struct decoding_context_CBD *restore_dec_context_CBD(const char *filepath)
     struct snc_parameters sp;
     fread(&sp, sizeof(struct snc_parameters), 1, fp);
     // Create a fresh decoding context
-    struct decoding_context_CBD *dec_ctx = create_dec_context_CBD(&sp);
+    struct decoding_context_CBD *dec_ctx = create_dec_context_CBD(&sp, NULL);
     if (dec_ctx == NULL) {
         fprintf(stderr, "malloc decoding_context_CBD failed\n");
         return NULL;
@@ -438,12 +598,12 @@ struct decoding_context_CBD *restore_dec_context_CBD(const char *filepath)
                 return NULL;
             }
             dec_ctx->row[i]->len = rowlen;
-            dec_ctx->row[i]->elem = (GF_ELEMENT *) calloc(rowlen, sizeof(GF_ELEMENT));
+            dec_ctx->row[i]->elem = (GF_ELEMENT *) calloc(row_bytes(dec_ctx, i), sizeof(GF_ELEMENT));
             if (dec_ctx->row[i]->elem == NULL) {
                 free_dec_context_CBD(dec_ctx);
                 return NULL;
             }
-            fread(dec_ctx->row[i]->elem, sizeof(GF_ELEMENT), rowlen, fp);
+            fread(dec_ctx->row[i]->elem, sizeof(GF_ELEMENT), row_bytes(dec_ctx, i), fp);
             fread(dec_ctx->message[i], sizeof(GF_ELEMENT), pktsize, fp);
         }
     }
@@ -28,8 +28,9 @@ struct decoding_context_CBD
     long long ops3;             // operations of backward sub
 };
 
-struct decoding_context_CBD *create_dec_context_CBD(struct snc_parameters *sp);
+struct decoding_context_CBD *create_dec_context_CBD(struct snc_parameters *sp, const struct snc_options *opt);
 void process_packet_CBD(struct decoding_context_CBD *dec_ctx, struct snc_packet *pkt);
+int missing_dof_CBD(struct decoding_context_CBD *dec_ctx, int gid);
 void free_dec_context_CBD(struct decoding_context_CBD *dec_ctx);
 
 /**
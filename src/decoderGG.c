@@ -8,7 +8,7 @@
 struct running_matrix {
     int DoF_miss;
     unsigned char *erased;   // bits indicating recovered packets
-    struct row_vector **row;
+    struct row_vector **row; // bit-packed for GF(2) (see BITROW_WORDS in common.h)
     GF_ELEMENT **message;
 };
 
@@ -21,19 +21,47 @@ static long update_running_matrix(struct decoding_context_GG *dec_ctx, int gid,
 static int check_for_new_recoverables(struct decoding_context_GG *dec_ctx);
 static int check_for_new_decodables(struct decoding_context_GG *dec_ctx);
 static void free_running_matrix(struct running_matrix *matrix, int rows);
+static void process_bitvector_GG(struct decoding_context_GG *dec_ctx, struct running_matrix *matrix, uint64_t *vector, GF_ELEMENT *syms, int from);
 
-static ID_list **gene_nbr = NULL;    // lists of subgeneration neighbors of each packet
+// Element at column c of row i of a running matrix
+static inline GF_WORD row_element(struct decoding_context_GG *dec_ctx, struct running_matrix *matrix, int i, int c)
+{
+    if (dec_ctx->sc->params.gfpower == 1)
+        return bitrow_get((uint64_t *) matrix->row[i]->elem, i, c);
+    return matrix->row[i]->elem[c-i];
+}
+
+static inline void set_row_element(struct decoding_context_GG *dec_ctx, struct running_matrix *matrix, int i, int c, GF_WORD v)
+{
+    if (dec_ctx->sc->params.gfpower == 1) {
+        if (v)
+            bitrow_set((uint64_t *) matrix->row[i]->elem, i, c);
+        else
+            bitrow_clear((uint64_t *) matrix->row[i]->elem, i, c);
+        return;
+    }
+    matrix->row[i]->elem[c-i] = v;
+}
 
-// Performance analysis use ONLY
-static int g_decoded = 0; // decoded from subgen
-static int c_decoded = 0; // recovered from precode decoding
+// Bytes of storage of row i of a running matrix
+static inline int row_bytes(struct decoding_context_GG *dec_ctx, struct running_matrix *matrix, int i)
+{
+    if (dec_ctx->sc->params.gfpower == 1)
+        return sizeof(uint64_t) * BITROW_WORDS(i, matrix->row[i]->len);
+    return matrix->row[i]->len;
+}
 
 // setup decoding context:
-struct decoding_context_GG *create_dec_context_GG(struct snc_parameters *sp)
+struct decoding_context_GG *create_dec_context_GG(struct snc_parameters *sp, const struct snc_options *opt)
 {
     static char fname[] = "snc_create_dec_context_GG";
     int i, j;
 
+    if (sp->gfpower == 16) {
+        fprintf(stderr, "%s: GF(2^16) is only supported by the CBD and OA decoders\n", fname);
+        return NULL;
+    }
+
     struct decoding_context_GG *dec_ctx;
     if ((dec_ctx = malloc(sizeof(struct decoding_context_GG))) == NULL) {
         fprintf(stderr, "%s: malloc decoding context GG failed\n", fname);
@@ -43,7 +71,7 @@ struct decoding_context_GG *create_dec_context_GG(struct snc_parameters *sp)
     // Since this is decoding, we construct GNC context without data
     // sc->pp will be filled by decoded packets
     struct snc_context *sc;
-    if ((sc = snc_create_enc_context(NULL, sp)) == NULL) {
+    if ((sc = snc_create_enc_context_opt(NULL, sp, opt)) == NULL) {
         fprintf(stderr, "%s: create decoding context failed", fname);
         goto AllocError;
     }
@@ -52,7 +80,7 @@ struct decoding_context_GG *create_dec_context_GG(struct snc_parameters *sp)
     // Since GG decoder frequently needs to find out which generations a packet belongs to, we
     // build the lists of subgeneration neighbors of each packet according to sc->gene. This list
     // avoids calling has_item() in all subgenerations.
-    gene_nbr = build_subgen_nbr_list(sc);
+    dec_ctx->gene_nbr = build_subgen_nbr_list(sc);
 
     // memory areas needed for decoding
     dec_ctx->evolving_checks = calloc(dec_ctx->sc->cnum, sizeof(GF_ELEMENT *));
@@ -112,7 +140,7 @@ struct decoding_context_GG *create_dec_context_GG(struct snc_parameters *sp)
             goto AllocError;
         }
         for (int j=0; j<dec_ctx->sc->params.size_g; j++) {
-            dec_ctx->Matrices[i]->message[j] = calloc(dec_ctx->sc->params.size_p, sizeof(GF_ELEMENT));
+            dec_ctx->Matrices[i]->message[j] = calloc_payload(dec_ctx->sc->params.size_p);
             if (dec_ctx->Matrices[i]->message[j] == NULL) {
                 fprintf(stderr, "%s: calloc dec_ctx->Matrices[%d]->messsage[%d]\n", fname, i, j);
                 goto AllocError;
@@ -130,6 +158,8 @@ struct decoding_context_GG *create_dec_context_GG(struct snc_parameters *sp)
     dec_ctx->grcount    = 0;
     dec_ctx->operations = 0;
     dec_ctx->overhead   = 0;
+    dec_ctx->g_decoded  = 0;
+    dec_ctx->c_decoded  = 0;
     dec_ctx->ops1 = dec_ctx->ops2 = 0;
     return dec_ctx;
 
@@ -164,7 +194,7 @@ void free_dec_context_GG(struct decoding_context_GG *dec_ctx)
         free(dec_ctx->Matrices);
     }
     if (dec_ctx->sc != NULL) {
-        free_subgen_nbr_list(dec_ctx->sc, gene_nbr);
+        free_subgen_nbr_list(dec_ctx->sc, dec_ctx->gene_nbr);
         snc_free_enc_context(dec_ctx->sc);
     }
 
@@ -213,7 +243,7 @@ void process_packet_GG(struct decoding_context_GG *dec_ctx, struct snc_packet *p
     dec_ctx->overhead += 1;
 
     if (get_loglevel() == TRACE)
-        printf("Received: %d g_decoded: %d c_decoded: %d\n", dec_ctx->overhead-1, g_decoded, c_decoded);
+        printf("Received: %d g_decoded: %d c_decoded: %d\n", dec_ctx->overhead-1, dec_ctx->g_decoded, dec_ctx->c_decoded);
 
     int i, j;
     int gensize = dec_ctx->sc->params.size_g;
@@ -226,7 +256,7 @@ void process_packet_GG(struct decoding_context_GG *dec_ctx, struct snc_packet *p
             printf("systematic packet %d has already been decoded/received.\n", pktid);
             return;
         }
-        dec_ctx->sc->pp[pktid] = malloc(sizeof(GF_ELEMENT)*pktsize);
+        dec_ctx->sc->pp[pktid] = calloc_payload(pktsize);
         memcpy(dec_ctx->sc->pp[pktid], pkt->syms, sizeof(GF_ELEMENT)*pktsize);
         // Record the as a recently decoded packet
         ID *new_id;
@@ -247,53 +277,66 @@ void process_packet_GG(struct decoding_context_GG *dec_ctx, struct snc_packet *p
         // 1, Process the packet against the running matrix
         int pivotfound = 0;
         int pivot;
-        GF_ELEMENT *pkt_coes = calloc(gensize, sizeof(GF_ELEMENT));
-        GF_ELEMENT ce;
-        for (i=0; i<gensize; i++) {
-            if (dec_ctx->sc->params.gfpower==1) {
-                ce = get_bit_in_array(pkt->coes, i);
-            } else if (dec_ctx->sc->params.gfpower==8) {
-                ce = pkt->coes[i];
-            } else {
-                ce = read_bits_from_byte_array(pkt->coes, dec_ctx->sc->params.size_g, dec_ctx->sc->params.gfpower, i);
-            }
-            pkt_coes[i] = ce;
-            // if the corresponding source packet has been decoded, remove it from the coded packet
-            if (get_bit_in_array(matrix->erased, i) == 1) {
-                //find the decoded packet, mask it with this source packet
-                int src_id = dec_ctx->sc->gene[gid]->pktid[i];      // index of the corresponding source packet
-                galois_multiply_add_region(pkt->syms, dec_ctx->sc->pp[src_id], ce, pktsize);
-                pkt_coes[i] = 0;
+        if (dec_ctx->sc->params.gfpower == 1) {
+            uint64_t *bits = malloc(sizeof(uint64_t) * ALIGN(gensize, 64));
+            bitrow_load(bits, pkt->coes, gensize);
+            // remove already decoded source packets from the coded packet
+            for (i=bitrow_next(bits, 0, gensize); i>=0; i=bitrow_next(bits, i+1, gensize)) {
+                if (get_bit_in_array(matrix->erased, i) == 1) {
+                    int src_id = get_subgeneration(dec_ctx->sc, gid)->pktid[i];
+                    galois_multiply_add_region(dec_ctx->sc->gf, pkt->syms, dec_ctx->sc->pp[src_id], 1, pktsize);
+                    bitrow_clear(bits, 0, i);
+                }
             }
-        }
-        // Translate the encoding vector to the sorted form as in the generation
-        GF_ELEMENT quotient;
-        for (i=0; i<gensize; i++) {
-            if (pkt_coes[i] != 0) {
-                if (matrix->row[i] != NULL) {
-                    quotient = galois_divide(pkt_coes[i], matrix->row[i]->elem[0]);
-                    galois_multiply_add_region(&(pkt_coes[i]), matrix->row[i]->elem, quotient, matrix->row[i]->len);
-                    galois_multiply_add_region(pkt->syms, matrix->message[i], quotient, pktsize);
-                    dec_ctx->operations += 1 + matrix->row[i]->len + pktsize;
-                    dec_ctx->ops1 += 1 + matrix->row[i]->len + pktsize;
+            process_bitvector_GG(dec_ctx, matrix, bits, pkt->syms, 0);
+            free(bits);
+        } else {
+            GF_ELEMENT *pkt_coes = calloc(gensize, sizeof(GF_ELEMENT));
+            GF_ELEMENT ce;
+            for (i=0; i<gensize; i++) {
+                if (dec_ctx->sc->params.gfpower==8) {
+                    ce = pkt->coes[i];
                 } else {
-                    pivotfound = 1;
-                    pivot = i;
-                    break;
+                    ce = read_bits_from_byte_array(pkt->coes, dec_ctx->sc->params.size_g, dec_ctx->sc->params.gfpower, i);
+                }
+                pkt_coes[i] = ce;
+                // if the corresponding source packet has been decoded, remove it from the coded packet
+                if (get_bit_in_array(matrix->erased, i) == 1) {
+                    //find the decoded packet, mask it with this source packet
+                    int src_id = get_subgeneration(dec_ctx->sc, gid)->pktid[i];      // index of the corresponding source packet
+                    galois_multiply_add_region(dec_ctx->sc->gf, pkt->syms, dec_ctx->sc->pp[src_id], ce, pktsize);
+                    pkt_coes[i] = 0;
                 }
             }
+            // Translate the encoding vector to the sorted form as in the generation
+            GF_ELEMENT quotient;
+            for (i=0; i<gensize; i++) {
+                if (pkt_coes[i] != 0) {
+                    if (matrix->row[i] != NULL) {
+                        quotient = galois_divide(dec_ctx->sc->gf, pkt_coes[i], matrix->row[i]->elem[0]);
+                        galois_multiply_add_region(dec_ctx->sc->gf, &(pkt_coes[i]), matrix->row[i]->elem, quotient, matrix->row[i]->len);
+                        galois_multiply_add_region(dec_ctx->sc->gf, pkt->syms, matrix->message[i], quotient, pktsize);
+                        dec_ctx->operations += 1 + matrix->row[i]->len + pktsize;
+                        dec_ctx->ops1 += 1 + matrix->row[i]->len + pktsize;
+                    } else {
+                        pivotfound = 1;
+                        pivot = i;
+                        break;
+                    }
+                }
+            }
+            // cache as normal GNC packet
+            if (pivotfound == 1) {
+                matrix->row[pivot] = malloc(sizeof(struct row_vector));
+                matrix->row[pivot]->len = gensize - pivot;
+                matrix->row[pivot]->elem = malloc(sizeof(GF_ELEMENT) * matrix->row[pivot]->len);
+                memcpy(matrix->row[pivot]->elem, &(pkt_coes[pivot]), sizeof(GF_ELEMENT)*matrix->row[pivot]->len);
+                matrix->message[pivot] = calloc_payload(pktsize);
+                memcpy(matrix->message[pivot], pkt->syms, pktsize*sizeof(GF_ELEMENT));
+                matrix->DoF_miss -= 1;
+            }
+            free(pkt_coes);
         }
-        // cache as normal GNC packet
-        if (pivotfound == 1) {
-            matrix->row[pivot] = malloc(sizeof(struct row_vector));
-            matrix->row[pivot]->len = gensize - pivot;
-            matrix->row[pivot]->elem = malloc(sizeof(GF_ELEMENT) * matrix->row[pivot]->len);
-            memcpy(matrix->row[pivot]->elem, &(pkt_coes[pivot]), sizeof(GF_ELEMENT)*matrix->row[pivot]->len);
-            matrix->message[pivot] = malloc(sizeof(GF_ELEMENT) * pktsize);
-            memcpy(matrix->message[pivot], pkt->syms, pktsize*sizeof(GF_ELEMENT));
-            matrix->DoF_miss -= 1;
-        }
-        free(pkt_coes);
         // 2, Check if the matrix is full rank, if yes, finish decode it
         if (matrix->DoF_miss == 0) {
             decode_generation(dec_ctx, gid); 
@@ -305,12 +348,44 @@ void process_packet_GG(struct decoding_context_GG *dec_ctx, struct snc_packet *p
             printf("GG splitted operations: %.2f %.2f\n",
                     (double) dec_ctx->ops1/dec_ctx->sc->snum/dec_ctx->sc->params.size_p,
                     (double) dec_ctx->ops2/dec_ctx->sc->snum/dec_ctx->sc->params.size_p);
-            printf("Received: %d g_decoded: %d c_decoded: %d\n", dec_ctx->overhead, g_decoded, c_decoded);
+            printf("Received: %d g_decoded: %d c_decoded: %d\n", dec_ctx->overhead, dec_ctx->g_decoded, dec_ctx->c_decoded);
         }
         return;
     }
 }
 
+/*
+ * Process a bit-packed GF(2) vector, which is zero before column from,
+ * against the running matrix. Save it as a new row if a pivot is found.
+ */
+static void process_bitvector_GG(struct decoding_context_GG *dec_ctx, struct running_matrix *matrix, uint64_t *vector, GF_ELEMENT *syms, int from)
+{
+    static char fname[] = "process_bitvector_GG";
+    int gensize = dec_ctx->sc->params.size_g;
+    int pktsize = dec_ctx->sc->params.size_p;
+    int i;
+    for (i=bitrow_next(vector, from, gensize); i>=0; i=bitrow_next(vector, i+1, gensize)) {
+        if (matrix->row[i] == NULL)
+            break;
+        bitrow_xor(vector, (uint64_t *) matrix->row[i]->elem, i, matrix->row[i]->len);
+        galois_multiply_add_region(dec_ctx->sc->gf, syms, matrix->message[i], 1, pktsize);
+        dec_ctx->operations += 1 + matrix->row[i]->len + pktsize;
+        dec_ctx->ops1 += 1 + matrix->row[i]->len + pktsize;
+    }
+    if (i < 0)
+        return;
+    // i is the pivot
+    matrix->row[i] = malloc(sizeof(struct row_vector));
+    if (matrix->row[i] == NULL)
+        fprintf(stderr, "%s: malloc matrix->row[%d] failed\n", fname, i);
+    matrix->row[i]->len = gensize - i;
+    matrix->row[i]->elem = (GF_ELEMENT *) bitrow_extract(vector, i, gensize - i);
+    if (matrix->row[i]->elem == NULL)
+        fprintf(stderr, "%s: malloc matrix->row[%d]->elem failed\n", fname, i);
+    memcpy(matrix->message[i], syms, pktsize*sizeof(GF_ELEMENT));
+    matrix->DoF_miss -= 1;
+}
+
 // decode packets of a generation via Gaussion elimination
 static void decode_generation(struct decoding_context_GG *dec_ctx, int gid)
 {
@@ -325,23 +400,24 @@ static void decode_generation(struct decoding_context_GG *dec_ctx, int gid)
         if (get_bit_in_array(matrix->erased, i) == 1)
             continue;
         /* eliminate all nonzeros above diagonal elements from right to left*/
+        GF_WORD diag = row_element(dec_ctx, matrix, i, i);
         for (j=0; j<i; j++) {
             int len = matrix->row[j]->len;
-            if (j+len <= i || matrix->row[j]->elem[i-j] == 0)
+            if (j+len <= i || row_element(dec_ctx, matrix, j, i) == 0)
                 continue;
-            assert(matrix->row[i]->elem[0]);
-            quotient = galois_divide(matrix->row[j]->elem[i-j], matrix->row[i]->elem[0]);
-            galois_multiply_add_region(matrix->message[j], matrix->message[i], quotient, pktsize);
+            assert(diag);
+            quotient = galois_divide(dec_ctx->sc->gf, row_element(dec_ctx, matrix, j, i), diag);
+            galois_multiply_add_region(dec_ctx->sc->gf, matrix->message[j], matrix->message[i], quotient, pktsize);
             dec_ctx->operations += (pktsize + 1);
             dec_ctx->ops1 += (pktsize + 1);
-            matrix->row[j]->elem[i-j] = 0;
+            set_row_element(dec_ctx, matrix, j, i, 0);
         }
         // transform diagonals to 1
-        if (matrix->row[i]->elem[0] != 1) {
-            galois_multiply_region(matrix->message[i], galois_divide(1, matrix->row[i]->elem[0]), pktsize);
+        if (diag != 1) {
+            galois_multiply_region(dec_ctx->sc->gf, matrix->message[i], galois_divide(dec_ctx->sc->gf, 1, diag), pktsize);
             dec_ctx->operations += (pktsize + 1);
             dec_ctx->ops1 += (pktsize + 1);
-            matrix->row[i]->elem[0] = 1;
+            set_row_element(dec_ctx, matrix, i, i, 1);
         }
         set_bit_in_array(matrix->erased, i);
     }
@@ -350,13 +426,13 @@ static void decode_generation(struct decoding_context_GG *dec_ctx, int gid)
     int c = 0;                                              // record number of decoded pacekts
     int src_id;
     for (i=0; i<gensize; i++) {
-        src_id = dec_ctx->sc->gene[gid]->pktid[i];
+        src_id = get_subgeneration(dec_ctx->sc, gid)->pktid[i];
         if (dec_ctx->sc->pp[src_id] != NULL) {
             if (get_loglevel() == TRACE)
                 printf("%s: packet %d in subgeneration %d is already decoded.\n", fname, src_id, gid);
             continue;
         } else {
-            if ( (dec_ctx->sc->pp[src_id] = calloc(pktsize, sizeof(GF_ELEMENT))) == NULL )
+            if ( (dec_ctx->sc->pp[src_id] = calloc_payload(pktsize)) == NULL )
                 fprintf(stderr, "%s: calloc sc->pp[%d]\n", fname, src_id);
             memcpy(dec_ctx->sc->pp[src_id], matrix->message[i], sizeof(GF_ELEMENT)*pktsize);
             if (get_loglevel() == TRACE)
@@ -382,7 +458,7 @@ static void decode_generation(struct decoding_context_GG *dec_ctx, int gid)
     dec_ctx->newgpos++;
     dec_ctx->grcount++;
 
-    g_decoded += c;
+    dec_ctx->g_decoded += c;
 }
 
 // This function performs iterative decoding on the precode and GNC code,
@@ -436,12 +512,12 @@ static void new_decoded_source_packet(struct decoding_context_GG *dec_ctx, int p
         // If the corresponding check packet is not yet decoded, the evolving packet area
         // and the corresponding degree can be used to record the evolution of the packet.
         if (dec_ctx->evolving_checks[check_id] == NULL) {
-            dec_ctx->evolving_checks[check_id] = calloc(dec_ctx->sc->params.size_p, sizeof(GF_ELEMENT));
+            dec_ctx->evolving_checks[check_id] = calloc_payload(dec_ctx->sc->params.size_p);
             if (dec_ctx->evolving_checks[check_id] == NULL)
                 fprintf(stderr, "%s: calloc evolving_checks[%d]\n", fname, check_id);
         }
         // mask information bits
-        galois_multiply_add_region(dec_ctx->evolving_checks[check_id], dec_ctx->sc->pp[pkt_id], nb->ce, dec_ctx->sc->params.size_p);
+        galois_multiply_add_region(dec_ctx->sc->gf, dec_ctx->evolving_checks[check_id], dec_ctx->sc->pp[pkt_id], nb->ce, dec_ctx->sc->params.size_p);
         dec_ctx->operations += dec_ctx->sc->params.size_p;
         dec_ctx->ops2 += dec_ctx->sc->params.size_p;
         dec_ctx->check_degrees[check_id] -= 1;    // reduce check packet's unknown degree
@@ -467,14 +543,14 @@ static void new_decoded_check_packet(struct decoding_context_GG *dec_ctx, int pk
     if (dec_ctx->evolving_checks[check_id] == NULL) {
         // Evolving area is empty, meaning that no source neighbors of the check packet
         // has been decoded yet. So make a copy of the decoded check packet for later evolving
-        dec_ctx->evolving_checks[check_id] = calloc(dec_ctx->sc->params.size_p, sizeof(GF_ELEMENT));
+        dec_ctx->evolving_checks[check_id] = calloc_payload(dec_ctx->sc->params.size_p);
         if (dec_ctx->evolving_checks[check_id] == NULL)
             fprintf(stderr, "%s: calloc evolving_checks[%d]\n", fname, check_id);
         memcpy(dec_ctx->evolving_checks[check_id], dec_ctx->sc->pp[pkt_id], sizeof(GF_ELEMENT)*dec_ctx->sc->params.size_p);
     } else {
         // Some source neighbors have been decoded and therefore updated the evolving area,
         // we need to mask the actual check packet content against the evolving area.
-        galois_multiply_add_region(dec_ctx->evolving_checks[check_id], dec_ctx->sc->pp[pkt_id], 1, dec_ctx->sc->params.size_p);
+        galois_multiply_add_region(dec_ctx->sc->gf, dec_ctx->evolving_checks[check_id], dec_ctx->sc->pp[pkt_id], 1, dec_ctx->sc->params.size_p);
         dec_ctx->operations += dec_ctx->sc->params.size_p;
         dec_ctx->ops2 += dec_ctx->sc->params.size_p;
     }
@@ -511,13 +587,13 @@ static int check_for_new_recoverables(struct decoding_context_GG *dec_ctx)
                 GF_ELEMENT ce = nb->ce;
                 if (get_loglevel() == TRACE)
                     printf("%s: source packet %d is recovered from check %d\n", fname, pktid, i+snum);
-                dec_ctx->sc->pp[pktid] = calloc(dec_ctx->sc->params.size_p, sizeof(GF_ELEMENT));
+                dec_ctx->sc->pp[pktid] = calloc_payload(dec_ctx->sc->params.size_p);
                 if (dec_ctx->sc->pp[pktid] == NULL)
                     fprintf(stderr, "%s: calloc sc->pp[%d]\n", fname, pktid);
                 if (ce == 1)
                     memcpy(dec_ctx->sc->pp[pktid], dec_ctx->evolving_checks[i], sizeof(GF_ELEMENT)*dec_ctx->sc->params.size_p);
                 else {
-                    galois_multiply_add_region(dec_ctx->sc->pp[pktid], dec_ctx->evolving_checks[i], galois_divide(1, ce), dec_ctx->sc->params.size_p);
+                    galois_multiply_add_region(dec_ctx->sc->gf, dec_ctx->sc->pp[pktid], dec_ctx->evolving_checks[i], galois_divide(dec_ctx->sc->gf, 1, ce), dec_ctx->sc->params.size_p);
                     dec_ctx->operations += dec_ctx->sc->params.size_p + 1;
                     dec_ctx->ops2 += dec_ctx->sc->params.size_p + 1;
                 }
@@ -529,7 +605,7 @@ static int check_for_new_recoverables(struct decoding_context_GG *dec_ctx)
                 new_id->next = NULL;
                 append_to_list(dec_ctx->recent, new_id);
 
-                c_decoded += 1;
+                dec_ctx->c_decoded += 1;
             }
             dec_ctx->check_degrees[i] = 0;
         }
@@ -537,7 +613,7 @@ static int check_for_new_recoverables(struct decoding_context_GG *dec_ctx)
             // The check packet is recovered because all of its source neighbors are known, so it is recoverable
             if (get_loglevel() == TRACE)
                 printf("%s: check packet %d is recoverable after all the connecting source neighbors are known\n", fname, i+snum);
-            dec_ctx->sc->pp[i+snum] = calloc(dec_ctx->sc->params.size_p, sizeof(GF_ELEMENT));
+            dec_ctx->sc->pp[i+snum] = calloc_payload(dec_ctx->sc->params.size_p);
             if (dec_ctx->sc->pp[i+snum] == NULL)
                 fprintf(stderr, "%s: calloc sc->pp[%d]", fname, i+snum);
             memcpy(dec_ctx->sc->pp[i+snum], dec_ctx->evolving_checks[i], sizeof(GF_ELEMENT)*dec_ctx->sc->params.size_p);
@@ -550,7 +626,7 @@ static int check_for_new_recoverables(struct decoding_context_GG *dec_ctx)
             new_id->next = NULL;
             append_to_list(dec_ctx->recent, new_id);
 
-            c_decoded += 1;
+            dec_ctx->c_decoded += 1;
         }
 
     }
@@ -566,13 +642,13 @@ static void update_generations(struct decoding_context_GG *dec_ctx)
     while (precent != NULL) {
         int src_id = precent->data;
         // Check all generations that contain this source packet
-        ID *item = gene_nbr[src_id]->first;
+        ID *item = dec_ctx->gene_nbr[src_id]->first;
         while (item != NULL) {
             int gid = item->data;
             item = item->next;
             if (dec_ctx->Matrices[gid] == NULL || dec_ctx->Matrices[gid]->DoF_miss == 0)
                 continue;
-            int pos = has_item(dec_ctx->sc->gene[gid]->pktid, src_id, dec_ctx->sc->params.size_g);
+            int pos = has_item(get_subgeneration(dec_ctx->sc, gid)->pktid, src_id, dec_ctx->sc->params.size_g);
             if (pos != -1
                 && get_bit_in_array(dec_ctx->Matrices[gid]->erased, pos) == 0) {
                 // The recently decoded packet is also in this generation
@@ -611,16 +687,17 @@ static long update_running_matrix(struct decoding_context_GG *dec_ctx, int gid,
     for (i=0; i<index; i++) {
         if (matrix->row[i] != NULL 
             && matrix->row[i]->len > (index-i)
-            && matrix->row[i]->elem[index-i] !=0) {
-            ce = matrix->row[i]->elem[index-i];
-            galois_multiply_add_region(matrix->message[i], dec_ctx->sc->pp[sid], ce, pktsize);
-            matrix->row[i]->elem[index-i] = 0;
+            && row_element(dec_ctx, matrix, i, index) !=0) {
+            ce = row_element(dec_ctx, matrix, i, index);
+            galois_multiply_add_region(dec_ctx->sc->gf, matrix->message[i], dec_ctx->sc->pp[sid], ce, pktsize);
+            set_row_element(dec_ctx, matrix, i, index, 0);
         }
     }
     
     // 2) Place singleton vector to the index's row
-    GF_ELEMENT *coes = calloc(gensize, sizeof(GF_ELEMENT));
-    GF_ELEMENT *syms = calloc(pktsize, sizeof(GF_ELEMENT));
+    int binary = (dec_ctx->sc->params.gfpower == 1);
+    GF_ELEMENT *coes = binary ? calloc(ALIGN(gensize, 64), sizeof(uint64_t)) : calloc(gensize, sizeof(GF_ELEMENT));
+    GF_ELEMENT *syms = calloc_payload(pktsize);
     // Process the packet just as a normal received packet of the matrix
     if (matrix->row[index] == NULL) {
         // Just fill in the row with a singleton row and the decoded packet
@@ -628,12 +705,22 @@ static long update_running_matrix(struct decoding_context_GG *dec_ctx, int gid,
         if (matrix->row[index] == NULL)
             fprintf(stderr, "%s: malloc dec_ctx->row[%d] failed\n", fname, index);
         matrix->row[index]->len = 1;
-        matrix->row[index]->elem = (GF_ELEMENT *) calloc(matrix->row[index]->len, sizeof(GF_ELEMENT));
+        matrix->row[index]->elem = (GF_ELEMENT *) calloc(binary ? sizeof(uint64_t) : 1, sizeof(GF_ELEMENT));
         if (matrix->row[index]->elem == NULL)
             fprintf(stderr, "%s: calloc matrix->row[%d]->elem failed\n", fname, index);
-        matrix->row[index]->elem[0] = 1;
+        set_row_element(dec_ctx, matrix, index, index, 1);
         memcpy(matrix->message[index], dec_ctx->sc->pp[sid],  pktsize*sizeof(GF_ELEMENT));
         matrix->DoF_miss -= 1;
+    } else if (binary) {
+        // Same as below on bit-packed rows
+        int nwords = BITROW_WORDS(index, matrix->row[index]->len);
+        memcpy((uint64_t *) coes + (index >> 6), matrix->row[index]->elem, sizeof(uint64_t) * nwords);
+        memset(matrix->row[index]->elem, 0, sizeof(uint64_t) * nwords);
+        matrix->row[index]->len = 1;
+        set_row_element(dec_ctx, matrix, index, index, 1);
+        memcpy(syms, matrix->message[index], sizeof(GF_ELEMENT)*pktsize);
+        memcpy(matrix->message[index], dec_ctx->sc->pp[sid], sizeof(GF_ELEMENT)*pktsize);
+        process_bitvector_GG(dec_ctx, matrix, (uint64_t *) coes, syms, index);
     } else {
         // Let's do swap first, and leave a singleton vector at the row 
         memcpy(coes+index, matrix->row[index]->elem, sizeof(GF_ELEMENT)*(gensize-index));
@@ -650,9 +737,9 @@ static long update_running_matrix(struct decoding_context_GG *dec_ctx, int gid,
         for (i=index; i<gensize; i++) {
             if (coes[i] != 0) {
                 if (matrix->row[i] != NULL) {
-                    quotient = galois_divide(coes[i], matrix->row[i]->elem[0]);
-                    galois_multiply_add_region(&(coes[i]), matrix->row[i]->elem, quotient, matrix->row[i]->len);
-                    galois_multiply_add_region(syms, matrix->message[i], quotient, pktsize);
+                    quotient = galois_divide(dec_ctx->sc->gf, coes[i], matrix->row[i]->elem[0]);
+                    galois_multiply_add_region(dec_ctx->sc->gf, &(coes[i]), matrix->row[i]->elem, quotient, matrix->row[i]->len);
+                    galois_multiply_add_region(dec_ctx->sc->gf, syms, matrix->message[i], quotient, pktsize);
                     dec_ctx->operations += 1 + matrix->row[i]->len + pktsize;
                     dec_ctx->ops1 += 1 + matrix->row[i]->len + pktsize;
                 } else {
@@ -698,6 +785,14 @@ static int check_for_new_decodables(struct decoding_context_GG *dec_ctx)
 }
 
 
+// Missing DoF of subgeneration gid, 0 once it is decoded
+int missing_dof_GG(struct decoding_context_GG *dec_ctx, int gid)
+{
+    if (dec_ctx->finished || dec_ctx->Matrices[gid] == NULL)
+        return 0;
+    return dec_ctx->Matrices[gid]->DoF_miss;
+}
+
 /**
  * Save a decoding context to a file
  * Return values:
@@ -764,7 +859,7 @@ long save_dec_context_GG(struct decoding_context_GG *dec_ctx, const char *filepa
             int rowlen = dec_ctx->Matrices[i]->row[j] == NULL ? 0 : dec_ctx->Matrices[i]->row[j]->len;
             filesize += fwrite(&rowlen, sizeof(int), 1, fp);
             if (rowlen != 0) {
-                filesize += fwrite(dec_ctx->Matrices[i]->row[j]->elem, sizeof(GF_ELEMENT), rowlen, fp);
+                filesize += fwrite(dec_ctx->Matrices[i]->row[j]->elem, sizeof(GF_ELEMENT), row_bytes(dec_ctx, dec_ctx->Matrices[i], j), fp);
                 filesize += fwrite(dec_ctx->Matrices[i]->message[j], sizeof(GF_ELEMENT), pktsize, fp);
             }
         }
@@ -802,13 +897,11 @@ struct decoding_context_GG *restore_dec_context_GG(const char *filepath)
     struct snc_parameters sp;
     fread(&sp, sizeof(struct snc_parameters), 1, fp);
     // Create a fresh decoding context
-    struct decoding_context_GG *dec_ctx = create_dec_context_GG(&sp);
+    struct decoding_context_GG *dec_ctx = create_dec_context_GG(&sp, NULL);
     if (dec_ctx == NULL) {
         fprintf(stderr, "malloc decoding_context_GG failed\n");
         return NULL;
     }
-    
-    build_subgen_nbr_list(dec_ctx->sc);
 
     // Restore decoding context from file
     fseek(fp, sizeof(int), SEEK_CUR);  // skip decoding_type field
@@ -818,7 +911,7 @@ struct decoding_context_GG *restore_dec_context_GG(const char *filepath)
     for (i=0; i<dec_ctx->decoded; i++) {
         int pktid;
         fread(&pktid, sizeof(int), 1, fp);
-        dec_ctx->sc->pp[pktid] = calloc(sp.size_p, sizeof(GF_ELEMENT));
+        dec_ctx->sc->pp[pktid] = calloc_payload(sp.size_p);
         fread(dec_ctx->sc->pp[pktid], sizeof(GF_ELEMENT), sp.size_p, fp);
     }
     // Restore evolving packets
@@ -827,7 +920,7 @@ struct decoding_context_GG *restore_dec_context_GG(const char *filepath)
     for (i=0; i<count; i++) {
         int evoid;
         fread(&evoid, sizeof(int), 1, fp);
-        dec_ctx->evolving_checks[evoid] = calloc(sp.size_p, sizeof(GF_ELEMENT));
+        dec_ctx->evolving_checks[evoid] = calloc_payload(sp.size_p);
         fread(dec_ctx->evolving_checks[evoid], sizeof(GF_ELEMENT), sp.size_p, fp);
     }
     // Restore check degrees
@@ -856,9 +949,10 @@ struct decoding_context_GG *restore_dec_context_GG(const char *filepath)
             if (rowlen != 0) {
                 dec_ctx->Matrices[i]->row[j] = malloc(sizeof(struct row_vector));
                 dec_ctx->Matrices[i]->row[j]->len = rowlen;
-                dec_ctx->Matrices[i]->row[j]->elem = (GF_ELEMENT *) malloc(rowlen * sizeof(GF_ELEMENT));
-                fread(dec_ctx->Matrices[i]->row[j]->elem, sizeof(GF_ELEMENT), rowlen, fp);
-                dec_ctx->Matrices[i]->message[j] = (GF_ELEMENT *) malloc(sp.size_p * sizeof(GF_ELEMENT));
+                int nbytes = row_bytes(dec_ctx, dec_ctx->Matrices[i], j);
+                dec_ctx->Matrices[i]->row[j]->elem = (GF_ELEMENT *) malloc(nbytes * sizeof(GF_ELEMENT));
+                fread(dec_ctx->Matrices[i]->row[j]->elem, sizeof(GF_ELEMENT), nbytes, fp);
+                dec_ctx->Matrices[i]->message[j] = calloc_payload(sp.size_p);
                 fread(dec_ctx->Matrices[i]->message[j], sizeof(GF_ELEMENT), sp.size_p, fp);
             }
         }
@@ -27,6 +27,7 @@ struct decoding_context_GG {
     int originals;                      // record how many source packets are decoded
     struct running_matrix **Matrices;   // record running matrices of each class
     ID_list *recent;                    // record most recently decoded packets IDs
+    ID_list **gene_nbr;                 // lists of subgeneration neighbors of each packet
     /*******************************************
      * Used if feedback to encoder is allowed
      ******************************************/
@@ -42,6 +43,8 @@ struct decoding_context_GG {
     long long ops1, ops2;               // splitted decoding operations
                                         // ops1 - operations invoked by Gaussian elimination
                                         // ops2 - operations invoked by substitutions
+    int g_decoded;                      // decoded from subgen
+    int c_decoded;                      // recovered from precode decoding
 };
 
 /**
@@ -50,9 +53,10 @@ struct decoding_context_GG {
  *   On success - return 0
  *   Otherwise  - return -1
  */
-struct decoding_context_GG *create_dec_context_GG(struct snc_parameters *sp);
+struct decoding_context_GG *create_dec_context_GG(struct snc_parameters *sp, const struct snc_options *opt);
 void free_dec_context_GG(struct decoding_context_GG *dec_ctx);
 void process_packet_GG(struct decoding_context_GG *dec_ctx, struct snc_packet *pkt);
+int missing_dof_GG(struct decoding_context_GG *dec_ctx, int gid);
 
 /**
  * File format to store ongoing decoding context
@@ -6,8 +6,6 @@
 #include "decoderOA.h"
 
 extern int BALLOC;     // Number of batch/matrix pointers allocated in one shot
-static int maxseen = -1;     // The maximum seen batch ID 
-static int nrealloc = 0;      // Number of realloc() called for reallocating batch/matrix pointers
 
 struct running_matrix
 {
@@ -47,19 +45,18 @@ static void diagonalize_GDM(struct decoding_context_OA *dec_ctx);
 /* Free running matrix */
 static void free_running_matrix(struct running_matrix *mat, int rows);
 
-extern long long forward_substitute(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B);
-extern long long back_substitute(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B);
-extern long pivot_matrix_oneround(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B, int **ctoo_r, int **ctoo_c, int *inactives);
-extern long pivot_matrix_tworound(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B, int **ctoo_r, int **ctoo_c, int *inactives);
+extern long long forward_substitute(const struct gf_field *gf, struct gauss_scratch *gs, int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B);
+extern long long back_substitute(const struct gf_field *gf, struct gauss_scratch *gs, int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B);
+extern long pivot_matrix_oneround(const struct gf_field *gf, struct gauss_scratch *gs, int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B, int **ctoo_r, int **ctoo_c, int *inactives);
+extern long pivot_matrix_tworound(const struct gf_field *gf, struct gauss_scratch *gs, int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B, int **ctoo_r, int **ctoo_c, int *inactives);
 
-static clock_t l_proc_start = 0;   // local processing start
 
 /*
  * snc_create_dec_context_OA
  * Create context for overlap-aware (OA) decoding
  *  aoh - allowed overhead >=0
  */
-struct decoding_context_OA *create_dec_context_OA(struct snc_parameters *sp, int aoh)
+struct decoding_context_OA *create_dec_context_OA(struct snc_parameters *sp, int aoh, const struct snc_options *opt)
 {
     static char fname[] = "snc_create_dec_context_OA";
     int i, j, k;
@@ -67,12 +64,13 @@ struct decoding_context_OA *create_dec_context_OA(struct snc_parameters *sp, int
     struct decoding_context_OA *dec_ctx;
     if ((dec_ctx = malloc(sizeof(struct decoding_context_OA))) == NULL)
         return NULL;
+    memset(&dec_ctx->gs, 0, sizeof(struct gauss_scratch));
 
     // GNC code context
     // Since this is decoding, we construct GNC context without data
     // sc->pp will be filled by decoded packets
     struct snc_context *sc;
-    if ((sc = snc_create_enc_context(NULL, sp)) == NULL) {
+    if ((sc = snc_create_enc_context_opt(NULL, sp, opt)) == NULL) {
         fprintf(stderr, "%s: create decoding context failed", fname);
         goto AllocError;
     }
@@ -84,6 +82,9 @@ struct decoding_context_OA *create_dec_context_OA(struct snc_parameters *sp, int
     dec_ctx->OA_ready   = 0;
     dec_ctx->local_DoF  = 0;
     dec_ctx->global_DoF = 0;
+    dec_ctx->maxseen    = -1;
+    dec_ctx->nrealloc   = 0;
+    dec_ctx->proc_start = 0;
 
     int gensize = dec_ctx->sc->params.size_g;
     int pktsize = dec_ctx->sc->params.size_p;
@@ -124,6 +125,10 @@ struct decoding_context_OA *create_dec_context_OA(struct snc_parameters *sp, int
      * We don't allocate memory for global decoding (ie GDM) here. We only allocate
      * when OA ready. This avoids occupying a big amount of memory for a long time.
      */
+    if (alloc_gauss_scratch(&dec_ctx->gs, sc->gf, numpp) != 0) {
+        fprintf(stderr, "%s: malloc dec_ctx->gs\n", fname);
+        goto AllocError;
+    }
 
     // performance indices
     dec_ctx->operations = 0;
@@ -140,39 +145,32 @@ AllocError:
 void process_packet_OA(struct decoding_context_OA *dec_ctx, struct snc_packet *pkt)
 {
     static char fname[] = "process_packet_OA";
-    if (l_proc_start == 0) {
-        l_proc_start = clock();  // initialize timer
+    if (dec_ctx->proc_start == 0) {
+        dec_ctx->proc_start = clock();  // initialize timer
     }
     dec_ctx->overhead += 1;
 
     int i, j, k;
-    GF_ELEMENT quotient;
+    GF_WORD quotient;
 
     int gensize = dec_ctx->sc->params.size_g;
     int pktsize = dec_ctx->sc->params.size_p;
     int numpp   = dec_ctx->sc->snum + dec_ctx->sc->cnum;
+    int esize   = gf_field_esize(dec_ctx->sc->gf);    // bytes per element of coefficient rows
 
     // start processing
     int gid = pkt->gid;
     int pivotfound = 0;
     int pivot;
 
-    // Reconstruct the batch information (packet id's of the batch content)
-    if (dec_ctx->sc->params.type == BATS_SNC && gid > maxseen) {
-        maxseen = gid;
-        if (maxseen >= BALLOC*(1+nrealloc)) {
-            // realloc batch pointers
-            int lb = BALLOC * (1 + nrealloc);
-            int ub = (maxseen / BALLOC + 1) * BALLOC;
-
-            dec_ctx->sc->gene = realloc(dec_ctx->sc->gene, sizeof(struct subgeneration*) * ub);
-            for (i=lb; i<ub; i++) {
-                dec_ctx->sc->gene[i] = malloc(sizeof(struct subgeneration));
-                dec_ctx->sc->gene[i]->gid = i;
-                dec_ctx->sc->gene[i]->pktid = malloc(sizeof(int)*dec_ctx->sc->params.size_g);       // Use malloc because pktid needs to be initialized as -1's later
-                memset(dec_ctx->sc->gene[i]->pktid, -1, sizeof(int)*dec_ctx->sc->params.size_g);
-                get_random_unique_numbers(dec_ctx->sc->gene[i]->pktid, dec_ctx->sc->params.size_g, dec_ctx->sc->snum+dec_ctx->sc->cnum);   // obtain packet IDs of the new batch
-            }
+    // Allocate running matrices of new batches (packet id's of a batch are derived on demand, see get_subgeneration())
+    if (dec_ctx->sc->params.type == BATS_SNC && gid > dec_ctx->maxseen) {
+        dec_ctx->maxseen = gid;
+        dec_ctx->sc->currbid = dec_ctx->maxseen;     // latest batch seen, reported as gnum by print_code_summary
+        if (dec_ctx->maxseen >= BALLOC*(1+dec_ctx->nrealloc)) {
+            // realloc running matrix pointers
+            int lb = BALLOC * (1 + dec_ctx->nrealloc);
+            int ub = (dec_ctx->maxseen / BALLOC + 1) * BALLOC;
 
             dec_ctx->Matrices = realloc(dec_ctx->Matrices, sizeof(struct running_matrix*) * ub);
             for (i=lb; i<ub; i++) {
@@ -185,7 +183,7 @@ void process_packet_OA(struct decoding_context_OA *dec_ctx, struct snc_packet *p
                 dec_ctx->Matrices[i]->row = calloc(gensize, sizeof(struct row_vector *));
                 dec_ctx->Matrices[i]->message = calloc(gensize, sizeof(GF_ELEMENT*));
             }
-            nrealloc += (ub - lb) / BALLOC;
+            dec_ctx->nrealloc += (ub - lb) / BALLOC;
         }
 
     }
@@ -194,7 +192,7 @@ void process_packet_OA(struct decoding_context_OA *dec_ctx, struct snc_packet *p
      * If decoder is not OA ready, process the packet within the generation.
      */
     if (dec_ctx->OA_ready != 1) {
-        GF_ELEMENT *pkt_coes = calloc(gensize, sizeof(GF_ELEMENT));
+        GF_ELEMENT *pkt_coes = calloc(gensize, sizeof(GF_ELEMENT)*esize);
 
         // Need to pay extra attention to systematic packets
         if (pkt->gid == -1 && pkt->ucid == -1) {
@@ -203,14 +201,14 @@ void process_packet_OA(struct decoding_context_OA *dec_ctx, struct snc_packet *p
             // systematic packet
             gid = pkt->ucid / dec_ctx->sc->params.size_b;   // process it as a packet belonging to its base subgeneration;
             int local_pos = pkt->ucid % dec_ctx->sc->params.size_b;
-            pkt_coes[local_pos] = 1;
+            gf_set_element(pkt_coes, local_pos, 1, esize);
         } else {
             // normal GNC packets
             if (dec_ctx->sc->params.gfpower == 1) {
                 for (i=0; i<gensize; i++)
                     pkt_coes[i] = get_bit_in_array(pkt->coes, i);
             } else {
-                memcpy(pkt_coes, pkt->coes, gensize*sizeof(GF_ELEMENT));
+                memcpy(pkt_coes, pkt->coes, gensize*sizeof(GF_ELEMENT)*esize);
             }
         }
         // Translate the encoding vector to the sorted form as in the generation
@@ -221,11 +219,12 @@ void process_packet_OA(struct decoding_context_OA *dec_ctx, struct snc_packet *p
             return;
         }
         for (i=0; i<gensize; i++) {
-            if (pkt_coes[i] != 0) {
+            GF_WORD co = gf_get_element(pkt_coes, i, esize);
+            if (co != 0) {
                 if (matrix->row[i] != NULL) {
-                    quotient = galois_divide(pkt_coes[i], matrix->row[i]->elem[0]);
-                    galois_multiply_add_region(&(pkt_coes[i]), matrix->row[i]->elem, quotient, matrix->row[i]->len);
-                    galois_multiply_add_region(pkt->syms, matrix->message[i], quotient, pktsize);
+                    quotient = galois_divide(dec_ctx->sc->gf, co, gf_get_element(matrix->row[i]->elem, 0, esize));
+                    galois_multiply_add_region(dec_ctx->sc->gf, &(pkt_coes[i*esize]), matrix->row[i]->elem, quotient, matrix->row[i]->len*esize);
+                    galois_multiply_add_region(dec_ctx->sc->gf, pkt->syms, matrix->message[i], quotient, pktsize);
                     dec_ctx->operations += 1 + matrix->row[i]->len + pktsize;
                     dec_ctx->ops1 += 1 + matrix->row[i]->len + pktsize;
                 } else {
@@ -239,9 +238,9 @@ void process_packet_OA(struct decoding_context_OA *dec_ctx, struct snc_packet *p
         if (pivotfound == 1) {
             matrix->row[pivot] = malloc(sizeof(struct row_vector));
             matrix->row[pivot]->len = gensize - pivot;
-            matrix->row[pivot]->elem = malloc(sizeof(GF_ELEMENT) * matrix->row[pivot]->len);
-            memcpy(matrix->row[pivot]->elem, &(pkt_coes[pivot]), sizeof(GF_ELEMENT)*matrix->row[pivot]->len);
-            matrix->message[pivot] = malloc(sizeof(GF_ELEMENT) * pktsize);
+            matrix->row[pivot]->elem = malloc(sizeof(GF_ELEMENT) * matrix->row[pivot]->len * esize);
+            memcpy(matrix->row[pivot]->elem, &(pkt_coes[pivot*esize]), sizeof(GF_ELEMENT)*matrix->row[pivot]->len*esize);
+            matrix->message[pivot] = calloc_payload(pktsize);
             memcpy(matrix->message[pivot], pkt->syms, pktsize*sizeof(GF_ELEMENT));
             matrix->dof += 1;
             dec_ctx->local_DoF += 1;
@@ -256,7 +255,7 @@ void process_packet_OA(struct decoding_context_OA *dec_ctx, struct snc_packet *p
             dec_ctx->ops1 += ops;
             // Record time used between processing the first received packet and OA ready
             if (get_loglevel() == TRACE) {
-                printf("Local processing took %.6f seconds\n", ((double) (clock()-l_proc_start))/CLOCKS_PER_SEC);
+                printf("Local processing took %.6f seconds\n", ((double) (clock()-dec_ctx->proc_start))/CLOCKS_PER_SEC);
             }
             // Combine LDMs to GDM and apply inactivation pivoting
             clock_t start, stop;
@@ -285,14 +284,15 @@ void process_packet_OA(struct decoding_context_OA *dec_ctx, struct snc_packet *p
          * to global encoding vector (GEV). Since the GDM was probably pivoted, need
          * to transform the GEV according to the pivoting order.
          */
-        GF_ELEMENT *re_ordered = calloc(numpp, sizeof(GF_ELEMENT));
+        GF_ELEMENT *re_ordered = calloc(numpp, sizeof(GF_ELEMENT)*esize);
+        struct subgeneration *subgen = get_subgeneration(dec_ctx->sc, gid);
         for (i=0; i<gensize; i++) {
             /* obtain index position of pktid in the full-length vector */
-            int curr_pos = dec_ctx->sc->gene[gid]->pktid[i];
+            int curr_pos = subgen->pktid[i];
             if (dec_ctx->sc->params.gfpower == 1) {
                 re_ordered[curr_pos] = get_bit_in_array(pkt->coes, i);
             } else {
-                re_ordered[curr_pos] = pkt->coes[i];
+                gf_set_element(re_ordered, curr_pos, gf_get_element(pkt->coes, i, esize), esize);
             }
         }
 
@@ -301,16 +301,19 @@ void process_packet_OA(struct decoding_context_OA *dec_ctx, struct snc_packet *p
          */
         pivot = -1;
         for (int m=0; m<numpp; m++) {
-            if (re_ordered[dec_ctx->ctoo_c[m]] != 0) {
-                if (dec_ctx->JMBcoefficient[dec_ctx->ctoo_r[m]][dec_ctx->ctoo_c[m]] != 0) {
+            GF_WORD co = gf_get_element(re_ordered, dec_ctx->ctoo_c[m], esize);
+            if (co != 0) {
+                GF_ELEMENT *jmbrow = dec_ctx->JMBcoefficient[dec_ctx->ctoo_r[m]];
+                if (gf_get_element(jmbrow, dec_ctx->ctoo_c[m], esize) != 0) {
                     // mask the encoding vector and message over the JMB decoding matrix
-                    GF_ELEMENT quotient = galois_divide(re_ordered[dec_ctx->ctoo_c[m]], dec_ctx->JMBcoefficient[dec_ctx->ctoo_r[m]][dec_ctx->ctoo_c[m]]);
+                    GF_WORD quotient = galois_divide(dec_ctx->sc->gf, co, gf_get_element(jmbrow, dec_ctx->ctoo_c[m], esize));
                     dec_ctx->operations += 1;
                     dec_ctx->ops3 += 1;
                     for (j=m; j<numpp; j++) {
-                        re_ordered[dec_ctx->ctoo_c[j]] = galois_add(re_ordered[dec_ctx->ctoo_c[j]], galois_multiply(dec_ctx->JMBcoefficient[dec_ctx->ctoo_r[m]][dec_ctx->ctoo_c[j]], quotient));
+                        int c = dec_ctx->ctoo_c[j];
+                        gf_set_element(re_ordered, c, galois_add(gf_get_element(re_ordered, c, esize), galois_multiply(dec_ctx->sc->gf, gf_get_element(jmbrow, c, esize), quotient)), esize);
                     }
-                    galois_multiply_add_region(pkt->syms, dec_ctx->JMBmessage[dec_ctx->ctoo_r[m]], quotient, pktsize);
+                    galois_multiply_add_region(dec_ctx->sc->gf, pkt->syms, dec_ctx->JMBmessage[dec_ctx->ctoo_r[m]], quotient, pktsize);
                     dec_ctx->operations += pktsize;
                     dec_ctx->ops3 += pktsize;
                 } else {
@@ -322,7 +325,7 @@ void process_packet_OA(struct decoding_context_OA *dec_ctx, struct snc_packet *p
         }
 
         if (pivotfound == 1) {
-            memcpy(dec_ctx->JMBcoefficient[dec_ctx->ctoo_r[pivot]], re_ordered, numpp*sizeof(GF_ELEMENT));
+            memcpy(dec_ctx->JMBcoefficient[dec_ctx->ctoo_r[pivot]], re_ordered, numpp*sizeof(GF_ELEMENT)*esize);
             memcpy(dec_ctx->JMBmessage[dec_ctx->ctoo_r[pivot]], pkt->syms,  pktsize*sizeof(GF_ELEMENT));
             dec_ctx->global_DoF += 1;
 
@@ -354,7 +357,8 @@ void free_dec_context_OA(struct decoding_context_OA *dec_ctx)
         return;
     int i, j, k;
     if (dec_ctx->Matrices != NULL) {
-        for (i=0; i<dec_ctx->sc->gnum; i++){
+        int nummat = dec_ctx->sc->gnum > 0 ? dec_ctx->sc->gnum : BALLOC * (1 + dec_ctx->nrealloc);
+        for (i=0; i<nummat; i++){
             // Free each decoding matrix
             if (dec_ctx->Matrices[i] != NULL)
                 free_running_matrix(dec_ctx->Matrices[i], dec_ctx->sc->params.size_g);
@@ -385,6 +389,7 @@ void free_dec_context_OA(struct decoding_context_OA *dec_ctx)
         free(dec_ctx->ctoo_r);
     if (dec_ctx->ctoo_c != NULL)
         free(dec_ctx->ctoo_c);
+    free_gauss_scratch(&dec_ctx->gs);
     free(dec_ctx);
     dec_ctx = NULL;
     return;
@@ -425,6 +430,7 @@ static void diagonalize_GDM(struct decoding_context_OA *dec_ctx)
     int gensize = dec_ctx->sc->params.size_g;
     int pktsize = dec_ctx->sc->params.size_p;
     int numpp   = dec_ctx->sc->snum + dec_ctx->sc->cnum;
+    int esize   = gf_field_esize(dec_ctx->sc->gf);
 
     // Recover inactivated packets
     if (get_loglevel() == TRACE) {
@@ -435,15 +441,15 @@ static void diagonalize_GDM(struct decoding_context_OA *dec_ctx)
     GF_ELEMENT **ces_submatrix = calloc(ias, sizeof(GF_ELEMENT*));
     GF_ELEMENT **msg_submatrix = calloc(ias, sizeof(GF_ELEMENT*));
     for (i=0; i<ias; i++) {
-        ces_submatrix[i] = calloc(ias, sizeof(GF_ELEMENT));
-        msg_submatrix[i] = calloc(pktsize, sizeof(GF_ELEMENT));
+        ces_submatrix[i] = calloc(ias, sizeof(GF_ELEMENT)*esize);
+        msg_submatrix[i] = calloc_payload(pktsize);
         for (j=0; j<ias; j++)
-            ces_submatrix[i][j] = dec_ctx->JMBcoefficient[dec_ctx->ctoo_r[numpp-ias+i]][dec_ctx->ctoo_c[numpp-ias+j]];
+            gf_set_element(ces_submatrix[i], j, gf_get_element(dec_ctx->JMBcoefficient[dec_ctx->ctoo_r[numpp-ias+i]], dec_ctx->ctoo_c[numpp-ias+j], esize), esize);
         memcpy(msg_submatrix[i], dec_ctx->JMBmessage[dec_ctx->ctoo_r[numpp-ias+i]], pktsize*sizeof(GF_ELEMENT));
     }
 
     /* Perform back substitution to reduce the "ias x ias" matrix to identity matrix */
-    long long ops = back_substitute(ias, ias, pktsize, ces_submatrix, msg_submatrix);
+    long long ops = back_substitute(dec_ctx->sc->gf, &dec_ctx->gs, ias, ias, pktsize, ces_submatrix, msg_submatrix);
     dec_ctx->operations += ops;
     dec_ctx->ops4 += ops;
 
@@ -452,7 +458,7 @@ static void diagonalize_GDM(struct decoding_context_OA *dec_ctx)
         // get original pktid at column (numpp-ias+i0
         pktid = dec_ctx->ctoo_c[numpp-ias+i];
         // Construct decoded packets
-        if ( (dec_ctx->sc->pp[pktid] = calloc(pktsize, sizeof(GF_ELEMENT))) == NULL )
+        if ( (dec_ctx->sc->pp[pktid] = calloc_payload(pktsize)) == NULL )
             fprintf(stderr, "%s: calloc sc->pp[%d]\n", fname, pktid);
         memcpy(dec_ctx->sc->pp[pktid], msg_submatrix[i], sizeof(GF_ELEMENT)*pktsize);
     }
@@ -471,41 +477,55 @@ static void diagonalize_GDM(struct decoding_context_OA *dec_ctx)
     // Recover active packets
     if (get_loglevel() == TRACE)
         printf("Recovering \"active\" packets...\n");
-    GF_ELEMENT quotient;
+    GF_WORD quotient;
+    // decoded inactive packets and their coefficients in the current row
+    GF_ELEMENT **srcs = malloc(sizeof(GF_ELEMENT*) * (ias > 0 ? ias : 1));
+    GF_ELEMENT *quotients = malloc(sizeof(GF_ELEMENT) * (ias > 0 ? ias : 1) * esize);
+    if (srcs == NULL || quotients == NULL) {
+        fprintf(stderr, "%s: malloc inactive packet list failed\n", fname);
+        free(srcs);
+        free(quotients);
+        return;
+    }
     for (i=0; i<numpp-ias; i++) {
         /*
          * Clean up the inactive part of the upper half of GDM by
-         * masking non-zero element aginst already decoded inactive packets
-         *
+         * masking non-zero element aginst already decoded inactive packets,
+         * accumulating all of them into the message in one pass
          */
+        GF_ELEMENT *jmbrow = dec_ctx->JMBcoefficient[dec_ctx->ctoo_r[i]];
+        k = 0;
         for (j=numpp-ias; j<numpp; j++) {
-            if (dec_ctx->JMBcoefficient[dec_ctx->ctoo_r[i]][dec_ctx->ctoo_c[j]] != 0) {
-                quotient = dec_ctx->JMBcoefficient[dec_ctx->ctoo_r[i]][dec_ctx->ctoo_c[j]];
+            if (gf_get_element(jmbrow, dec_ctx->ctoo_c[j], esize) != 0) {
+                gf_set_element(quotients, k, gf_get_element(jmbrow, dec_ctx->ctoo_c[j], esize), esize);
                 pktid = dec_ctx->ctoo_c[j];
-                galois_multiply_add_region(dec_ctx->JMBmessage[dec_ctx->ctoo_r[i]], dec_ctx->sc->pp[pktid], quotient, pktsize);
-                dec_ctx->JMBcoefficient[dec_ctx->ctoo_r[i]][dec_ctx->ctoo_c[j]] = 0;
+                srcs[k++] = dec_ctx->sc->pp[pktid];
+                gf_set_element(jmbrow, dec_ctx->ctoo_c[j], 0, esize);
                 dec_ctx->operations += pktsize;
                 dec_ctx->ops4 += pktsize;
             }
         }
+        galois_multiply_add_region_multi(dec_ctx->sc->gf, dec_ctx->JMBmessage[dec_ctx->ctoo_r[i]], srcs, quotients, k, PADDED(pktsize));
 
         // Convert diagonal elements of top-left part of T to 1
-        quotient = dec_ctx->JMBcoefficient[dec_ctx->ctoo_r[i]][dec_ctx->ctoo_c[i]];
+        quotient = gf_get_element(jmbrow, dec_ctx->ctoo_c[i], esize);
         if (quotient != 1) {
-            galois_multiply_region(dec_ctx->JMBmessage[dec_ctx->ctoo_r[i]], galois_divide(1, quotient), pktsize);
+            galois_multiply_region(dec_ctx->sc->gf, dec_ctx->JMBmessage[dec_ctx->ctoo_r[i]], galois_divide(dec_ctx->sc->gf, 1, quotient), PADDED(pktsize));
             dec_ctx->operations += pktsize;
             dec_ctx->ops4 += pktsize;
-            dec_ctx->JMBcoefficient[dec_ctx->ctoo_r[i]][dec_ctx->ctoo_c[i]] = 1;
+            gf_set_element(jmbrow, dec_ctx->ctoo_c[i], 1, esize);
         }
 
         // Save the decoded packet
         pktid = dec_ctx->ctoo_c[i];
         if ( dec_ctx->sc->pp[pktid] != NULL )
             fprintf(stderr, "%s：warning: packet %d is already recovered.\n", fname, pktid);
-        if ( (dec_ctx->sc->pp[pktid] = calloc(pktsize, sizeof(GF_ELEMENT))) == NULL )
+        if ( (dec_ctx->sc->pp[pktid] = calloc_payload(pktsize)) == NULL )
             fprintf(stderr, "%s: calloc sc->pp[%d]\n", fname, pktid);
         memcpy(dec_ctx->sc->pp[pktid], dec_ctx->JMBmessage[dec_ctx->ctoo_r[i]], sizeof(GF_ELEMENT)*pktsize);
     }
+    free(srcs);
+    free(quotients);
 
     dec_ctx->finished = 1;
 }
@@ -516,15 +536,16 @@ static long running_matrix_to_REF(struct decoding_context_OA *dec_ctx)
 {
     long long operations = 0;
     int i, j, k, l;
-    GF_ELEMENT quotient;
+    GF_WORD quotient;
 
     int gensize = dec_ctx->sc->params.size_g;
     int pktsize = dec_ctx->sc->params.size_p;
     int numpp   = dec_ctx->sc->snum + dec_ctx->sc->cnum;
+    int esize   = gf_field_esize(dec_ctx->sc->gf);
 
 
     #pragma omp parallel for private(i)
-    int numgen = dec_ctx->sc->gnum == -1 ? maxseen : dec_ctx->sc->gnum;
+    int numgen = dec_ctx->sc->gnum == -1 ? dec_ctx->maxseen : dec_ctx->sc->gnum;
     for (i=0; i<numgen; i++) {
         struct running_matrix *matrix = dec_ctx->Matrices[i];
 
@@ -538,20 +559,21 @@ static long running_matrix_to_REF(struct decoding_context_OA *dec_ctx)
 
             // eliminate elements above the nonzero diagonal elements
             for (l=0; l<k; l++) {
-                if (matrix->row[l] == NULL || matrix->row[l]->elem[k-l] == 0)
+                if (matrix->row[l] == NULL || gf_get_element(matrix->row[l]->elem, k-l, esize) == 0)
                     continue;
 
-                quotient = galois_divide(matrix->row[l]->elem[k-l], matrix->row[k]->elem[0]);
+                quotient = galois_divide(dec_ctx->sc->gf, gf_get_element(matrix->row[l]->elem, k-l, esize), gf_get_element(matrix->row[k]->elem, 0, esize));
                 operations += 1;
-                matrix->row[l]->elem[k-l] = 0;
+                gf_set_element(matrix->row[l]->elem, k-l, 0, esize);
                 // Note that columns behind the current column could be nonzero because of their zero diagonal.
                 for (int m=k+1; m<gensize; m++) {
                     if (matrix->row[m] == NULL) {
-                        matrix->row[l]->elem[m-l] = galois_add(matrix->row[l]->elem[m-l], galois_multiply(matrix->row[k]->elem[m-k], quotient));
+                        GF_WORD prod = galois_multiply(dec_ctx->sc->gf, gf_get_element(matrix->row[k]->elem, m-k, esize), quotient);
+                        gf_set_element(matrix->row[l]->elem, m-l, galois_add(gf_get_element(matrix->row[l]->elem, m-l, esize), prod), esize);
                         operations += 1;
                     }
                 }
-                galois_multiply_add_region(matrix->message[l], matrix->message[k], quotient, pktsize);
+                galois_multiply_add_region(dec_ctx->sc->gf, matrix->message[l], matrix->message[k], quotient, PADDED(pktsize));
                 operations += pktsize;
             }
         }
@@ -571,6 +593,7 @@ static void construct_GDM(struct decoding_context_OA *dec_ctx)
     int gensize = dec_ctx->sc->params.size_g;
     int pktsize = dec_ctx->sc->params.size_p;
     int numpp   = dec_ctx->sc->snum + dec_ctx->sc->cnum;
+    int esize   = gf_field_esize(dec_ctx->sc->gf);
 
     //Allocate GDM to snc_dec_context, apply precoding matrix
     dec_ctx->JMBcoefficient = calloc(numpp+dec_ctx->aoh, sizeof(GF_ELEMENT*));
@@ -581,39 +604,40 @@ static void construct_GDM(struct decoding_context_OA *dec_ctx)
         fprintf(stderr, "%s: calloc dec_ctx->JMBmessage\n", fname);
 
     for (i=0; i<numpp+dec_ctx->aoh; i++) {
-        dec_ctx->JMBcoefficient[i] = calloc(numpp, sizeof(GF_ELEMENT));
-        dec_ctx->JMBmessage[i]     = calloc(pktsize, sizeof(GF_ELEMENT));
+        dec_ctx->JMBcoefficient[i] = calloc(numpp, sizeof(GF_ELEMENT)*esize);
+        dec_ctx->JMBmessage[i]     = calloc_payload(pktsize);
     }
     dec_ctx->inactives   = 0;
     dec_ctx->ctoo_r = malloc(sizeof(int) * numpp);
     dec_ctx->ctoo_c = malloc(sizeof(int) * numpp);
     // Apply precoding matrix
     for (i=0; i<dec_ctx->sc->cnum; i++) {
-        dec_ctx->JMBcoefficient[dec_ctx->sc->snum+dec_ctx->aoh+i][dec_ctx->sc->snum+i] = 1;
+        gf_set_element(dec_ctx->JMBcoefficient[dec_ctx->sc->snum+dec_ctx->aoh+i], dec_ctx->sc->snum+i, 1, esize);
 
         NBR_node *variable_node = dec_ctx->sc->graph->l_nbrs_of_r[i]->first;        //ldpc_graph->nbrs_of_right[i];
         while (variable_node != NULL) {
             // 标记与该check packet连结的所有source packet node
             int src_pktid = variable_node->data;                        //variable_node->nb_index;
-            dec_ctx->JMBcoefficient[dec_ctx->sc->snum+dec_ctx->aoh+i][src_pktid] = variable_node->ce;
+            gf_set_element(dec_ctx->JMBcoefficient[dec_ctx->sc->snum+dec_ctx->aoh+i], src_pktid, variable_node->ce, esize);
             variable_node = variable_node->next;
         }
     }
 
     // Step 1, translate LEVs to GEV and move them to GDM
-    int numgen = dec_ctx->sc->gnum == -1 ? maxseen : dec_ctx->sc->gnum;
-    GF_ELEMENT *global_ces = calloc(numpp, sizeof(GF_ELEMENT));
+    int numgen = dec_ctx->sc->gnum == -1 ? dec_ctx->maxseen : dec_ctx->sc->gnum;
+    GF_ELEMENT *global_ces = calloc(numpp, sizeof(GF_ELEMENT)*esize);
     int p_copy = 0;                             // 拷贝到JMBcofficient的行指针
     for (i=0; i<numgen; i++) {
         matrix = dec_ctx->Matrices[i];
+        struct subgeneration *subgen = get_subgeneration(dec_ctx->sc, i);
         for (j=0; j<gensize; j++) {
             if (matrix->row[j] == NULL)
                 continue;                       // there is no local DoF here
             else {
-                memset(global_ces, 0, numpp*sizeof(GF_ELEMENT));    /* Reset before reuse */
+                memset(global_ces, 0, numpp*sizeof(GF_ELEMENT)*esize);    /* Reset before reuse */
                 for (k=j; k<gensize; k++)
-                    global_ces[dec_ctx->sc->gene[i]->pktid[k]] = matrix->row[j]->elem[k-j];
-                memcpy(dec_ctx->JMBcoefficient[p_copy], global_ces, numpp*sizeof(GF_ELEMENT));
+                    gf_set_element(global_ces, subgen->pktid[k], gf_get_element(matrix->row[j]->elem, k-j, esize), esize);
+                memcpy(dec_ctx->JMBcoefficient[p_copy], global_ces, numpp*sizeof(GF_ELEMENT)*esize);
                 memcpy(dec_ctx->JMBmessage[p_copy], matrix->message[j], pktsize*sizeof(GF_ELEMENT));
                 p_copy += 1;
             }
@@ -634,18 +658,17 @@ static void construct_GDM(struct decoding_context_OA *dec_ctx)
     clock_t start_pivoting, stop_pivoting;
     start_pivoting = clock();
     long long ops;
-    if (getenv("SNC_OA_ONEROUND") != NULL
-         && atoi(getenv("SNC_OA_ONEROUND")) == 1) {
-        ops = pivot_matrix_oneround(numpp+dec_ctx->aoh, numpp, pktsize, dec_ctx->JMBcoefficient, dec_ctx->JMBmessage, &dec_ctx->ctoo_r, &dec_ctx->ctoo_c, &(dec_ctx->inactives));
+    if (dec_ctx->sc->opts.oa_oneround) {
+        ops = pivot_matrix_oneround(dec_ctx->sc->gf, &dec_ctx->gs, numpp+dec_ctx->aoh, numpp, pktsize, dec_ctx->JMBcoefficient, dec_ctx->JMBmessage, &dec_ctx->ctoo_r, &dec_ctx->ctoo_c, &(dec_ctx->inactives));
     } else {
-        ops = pivot_matrix_tworound(numpp+dec_ctx->aoh, numpp, pktsize, dec_ctx->JMBcoefficient, dec_ctx->JMBmessage, &dec_ctx->ctoo_r, &dec_ctx->ctoo_c, &(dec_ctx->inactives));
+        ops = pivot_matrix_tworound(dec_ctx->sc->gf, &dec_ctx->gs, numpp+dec_ctx->aoh, numpp, pktsize, dec_ctx->JMBcoefficient, dec_ctx->JMBmessage, &dec_ctx->ctoo_r, &dec_ctx->ctoo_c, &(dec_ctx->inactives));
     }
     stop_pivoting = clock();
     dec_ctx->operations += ops;
     dec_ctx->ops2 += ops;
     // Count available degree of freedom
     for (i=0; i<numpp; i++) {
-        if (dec_ctx->JMBcoefficient[dec_ctx->ctoo_r[i]][dec_ctx->ctoo_c[i]] != 0)
+        if (gf_get_element(dec_ctx->JMBcoefficient[dec_ctx->ctoo_r[i]], dec_ctx->ctoo_c[i], esize) != 0)
             dec_ctx->global_DoF++;
     }
     double pivot_time = ((double) (stop_pivoting - start_pivoting)) / CLOCKS_PER_SEC;
@@ -655,6 +678,20 @@ static void construct_GDM(struct decoding_context_OA *dec_ctx)
     }
 }
 
+/*
+ * Missing DoF of subgeneration gid. Local matrices are merged into the
+ * GDM once OA ready, after which packets of any subgeneration may fill
+ * in the missing pivots, so each unfinished subgeneration reports 1.
+ */
+int missing_dof_OA(struct decoding_context_OA *dec_ctx, int gid)
+{
+    if (dec_ctx->finished)
+        return 0;
+    if (dec_ctx->OA_ready)
+        return 1;
+    return dec_ctx->sc->params.size_g - dec_ctx->Matrices[gid]->dof;
+}
+
 /**
  * Save a decoding context to a file
  * Return values:
@@ -690,7 +727,7 @@ long save_dec_context_OA(struct decoding_context_OA *dec_ctx, const char *filepa
             int rowlen = dec_ctx->Matrices[i]->row[j] == NULL ? 0 : dec_ctx->Matrices[i]->row[j]->len;
             filesize += fwrite(&rowlen, sizeof(int), 1, fp);
             if (rowlen != 0) {
-                filesize += fwrite(dec_ctx->Matrices[i]->row[j]->elem, sizeof(GF_ELEMENT), rowlen, fp);
+                filesize += fwrite(dec_ctx->Matrices[i]->row[j]->elem, sizeof(GF_ELEMENT)*gf_field_esize(dec_ctx->sc->gf), rowlen, fp);
                 filesize += fwrite(dec_ctx->Matrices[i]->message[j], sizeof(GF_ELEMENT), pktsize, fp);
             }
         }
@@ -701,7 +738,7 @@ long save_dec_context_OA(struct decoding_context_OA *dec_ctx, const char *filepa
     // of the matrix. For example, save [row, col, value] for nonzero elements.
     if (dec_ctx->OA_ready == 1) {
         for (i=0; i<numpp + dec_ctx->aoh; i++) {
-            filesize += fwrite(dec_ctx->JMBcoefficient[i], sizeof(GF_ELEMENT), numpp, fp);
+            filesize += fwrite(dec_ctx->JMBcoefficient[i], sizeof(GF_ELEMENT)*gf_field_esize(dec_ctx->sc->gf), numpp, fp);
             filesize += fwrite(dec_ctx->JMBmessage[i], sizeof(GF_ELEMENT), pktsize, fp);
         }
         filesize += fwrite(dec_ctx->ctoo_r, sizeof(int), numpp, fp);
@@ -732,13 +769,14 @@ struct decoding_context_OA *restore_dec_context_OA(const char *filepath)
     int aoh;
     fread(&aoh, sizeof(int), 1, fp);
     // Create a fresh decoding context
-    struct decoding_context_OA *dec_ctx = create_dec_context_OA(&sp, aoh);
+    struct decoding_context_OA *dec_ctx = create_dec_context_OA(&sp, aoh, NULL);
     if (dec_ctx == NULL) {
         fprintf(stderr, "malloc decoding_context_GG failed\n");
         return NULL;
     }
     // Restore decoding context from file
     int i, j;
+    int esize = gf_field_esize(dec_ctx->sc->gf);
     fread(&dec_ctx->finished, sizeof(int), 1, fp);
     fread(&dec_ctx->OA_ready, sizeof(int), 1, fp);
     fread(&dec_ctx->local_DoF, sizeof(int), 1, fp);
@@ -752,9 +790,9 @@ struct decoding_context_OA *restore_dec_context_OA(const char *filepath)
             if (rowlen != 0) {
                 dec_ctx->Matrices[i]->row[j] = malloc(sizeof(struct row_vector));
                 dec_ctx->Matrices[i]->row[j]->len = rowlen;
-                dec_ctx->Matrices[i]->row[j]->elem = (GF_ELEMENT *) malloc(rowlen * sizeof(GF_ELEMENT));
-                fread(dec_ctx->Matrices[i]->row[j]->elem, sizeof(GF_ELEMENT), rowlen, fp);
-                dec_ctx->Matrices[i]->message[j] = (GF_ELEMENT *) malloc(sp.size_p * sizeof(GF_ELEMENT));
+                dec_ctx->Matrices[i]->row[j]->elem = (GF_ELEMENT *) malloc(rowlen * sizeof(GF_ELEMENT) * esize);
+                fread(dec_ctx->Matrices[i]->row[j]->elem, sizeof(GF_ELEMENT)*esize, rowlen, fp);
+                dec_ctx->Matrices[i]->message[j] = calloc_payload(sp.size_p);
                 fread(dec_ctx->Matrices[i]->message[j], sizeof(GF_ELEMENT), sp.size_p, fp);
             }
         }
@@ -765,9 +803,9 @@ struct decoding_context_OA *restore_dec_context_OA(const char *filepath)
         dec_ctx->JMBcoefficient = calloc(numpp+aoh, sizeof(GF_ELEMENT*));
         dec_ctx->JMBmessage = calloc(numpp+aoh, sizeof(GF_ELEMENT*));
         for (i=0; i<numpp+aoh; i++) {
-            dec_ctx->JMBcoefficient[i] = calloc(numpp, sizeof(GF_ELEMENT));
-            fread(dec_ctx->JMBcoefficient[i], sizeof(GF_ELEMENT), numpp, fp);
-            dec_ctx->JMBmessage[i] = calloc(sp.size_p, sizeof(GF_ELEMENT));
+            dec_ctx->JMBcoefficient[i] = calloc(numpp, sizeof(GF_ELEMENT)*esize);
+            fread(dec_ctx->JMBcoefficient[i], sizeof(GF_ELEMENT)*esize, numpp, fp);
+            dec_ctx->JMBmessage[i] = calloc_payload(sp.size_p);
             fread(dec_ctx->JMBmessage[i], sizeof(GF_ELEMENT), sp.size_p, fp);
         }
         dec_ctx->ctoo_r = calloc(numpp, sizeof(int));
@@ -1,5 +1,6 @@
 #ifndef OA_DECODER_H
 #define OA_DECODER_H
+#include <time.h>
 #include "sparsenc.h"
 
 // To store matrices in processing (needed by the decoder)
@@ -20,6 +21,8 @@ struct decoding_context_OA
     int OA_ready;                       // the decoder has reached the necessary condition for OA decoding
     int local_DoF;                      // total DOF that have been received within generations, total_DoF==NUM_SRC, then decodable
     int global_DoF;                     // total true DoF that the receiver has received
+    int maxseen;                        // the maximum seen batch ID (BATS)
+    int nrealloc;                       // number of BALLOC blocks of running matrices added beyond the first
 
     // Local decoding matrices
     struct running_matrix **Matrices;   //[CLASS_NUM] record running matrices of each class
@@ -31,8 +34,10 @@ struct decoding_context_OA
     int *ctoo_r;                        // record the mapping from current row id to original row id
     int *ctoo_c;                        // record the mapping from current col id to original col id
     int inactives;                      // total number of inactivated packets among overlapping packets
+    struct gauss_scratch gs;            // scratch of Gaussian elimination of pivoting and back substitution
 
     int overhead;                       // record how many packets have been received
+    clock_t proc_start;                 // start of local processing
     long long operations;               // record the number of computations used
     long long ops1, ops2, ops3, ops4;   // splitted operations of different stages
                                         // ops1 - operations of "local" Gaussian elimination
@@ -41,8 +46,9 @@ struct decoding_context_OA
                                         // ops4 - back substitution solving all packets
 };
 
-struct decoding_context_OA *create_dec_context_OA(struct snc_parameters *sp, int aoh);
+struct decoding_context_OA *create_dec_context_OA(struct snc_parameters *sp, int aoh, const struct snc_options *opt);
 void process_packet_OA(struct decoding_context_OA *dec_ctx, struct snc_packet *pkt);
+int missing_dof_OA(struct decoding_context_OA *dec_ctx, int gid);
 void free_dec_context_OA(struct decoding_context_OA *dec_ctx);
 
 /**
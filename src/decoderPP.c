@@ -11,7 +11,7 @@ static int process_vector_PP(struct decoding_context_PP *dec_ctx, GF_ELEMENT *ve
 static void finish_recovering_PP(struct decoding_context_PP *dec_ctx);
 
 // create decoding context for perpetual decoder
-struct decoding_context_PP *create_dec_context_PP(struct snc_parameters *sp)
+struct decoding_context_PP *create_dec_context_PP(struct snc_parameters *sp, const struct snc_options *opt)
 {
     static char fname[] = "snc_create_dec_context_CBD";
     int i, j, k;
@@ -20,6 +20,10 @@ struct decoding_context_PP *create_dec_context_PP(struct snc_parameters *sp)
         fprintf(stdout, "WARNING: PP decoder only applies to perpetual codes.\n");
         exit(1);
     }
+    if (sp->gfpower == 16) {
+        fprintf(stderr, "%s: GF(2^16) is only supported by the CBD and OA decoders\n", fname);
+        return NULL;
+    }
 
     struct decoding_context_PP *dec_ctx = malloc(sizeof(struct decoding_context_PP));
     if (dec_ctx == NULL) {
@@ -28,7 +32,7 @@ struct decoding_context_PP *create_dec_context_PP(struct snc_parameters *sp)
     }
 
     struct snc_context *sc;
-    if ((sc = snc_create_enc_context(NULL, sp)) == NULL) {
+    if ((sc = snc_create_enc_context_opt(NULL, sp, opt)) == NULL) {
         fprintf(stderr, "%s: create decoding context failed", fname);
         goto AllocError;
     }
@@ -54,7 +58,7 @@ struct decoding_context_PP *create_dec_context_PP(struct snc_parameters *sp)
         goto AllocError;
     }
     for (i=0; i<numpp; i++) {
-        dec_ctx->message[i] = calloc(pktsize, sizeof(GF_ELEMENT));
+        dec_ctx->message[i] = calloc_payload(pktsize);
         if (dec_ctx->message[i] == NULL) {
             fprintf(stderr, "%s: calloc dec_ctx->message[%d] failed\n", fname, i);
             goto AllocError;
@@ -97,7 +101,7 @@ void process_packet_PP(struct decoding_context_PP *dec_ctx, struct snc_packet *p
             for (i=0; i<gensize; i++)
                 ces0[i] = read_bits_from_byte_array(pkt->coes, dec_ctx->sc->params.size_g, dec_ctx->sc->params.gfpower, i);
         }
-        int pivot = dec_ctx->sc->gene[pkt->gid]->pktid[0];// By default, the coding coefficient of the pivot candidate is pkt->coes[0]
+        int pivot = get_subgeneration(dec_ctx->sc, pkt->gid)->pktid[0];// By default, the coding coefficient of the pivot candidate is pkt->coes[0]
         int shift = 0;
         while (ces0[shift] == 0) {
             shift += 1;
@@ -112,9 +116,9 @@ void process_packet_PP(struct decoding_context_PP *dec_ctx, struct snc_packet *p
         // There is already a row with the same pivot in decoding matrix
         int rowlen = gensize - shift;
         while (dec_ctx->row[pivot] != NULL) {
-            quotient = galois_divide(ces_tmp[0], dec_ctx->row[pivot]->elem[0]);
-            galois_multiply_add_region(ces_tmp, dec_ctx->row[pivot]->elem, quotient, dec_ctx->row[pivot]->len);
-            galois_multiply_add_region(pkt->syms, dec_ctx->message[pivot], quotient, pktsize);
+            quotient = galois_divide(dec_ctx->sc->gf, ces_tmp[0], dec_ctx->row[pivot]->elem[0]);
+            galois_multiply_add_region(dec_ctx->sc->gf, ces_tmp, dec_ctx->row[pivot]->elem, quotient, dec_ctx->row[pivot]->len);
+            galois_multiply_add_region(dec_ctx->sc->gf, pkt->syms, dec_ctx->message[pivot], quotient, pktsize);
             int newlen = rowlen > dec_ctx->row[pivot]->len ? rowlen : dec_ctx->row[pivot]->len;  // new length of the vector after processed
             rowlen = newlen - 1;   // the first element has been reduced to 0, so omit it
             memset(ces0, 0, sizeof(GF_ELEMENT)*gensize);
@@ -157,8 +161,9 @@ void process_packet_PP(struct decoding_context_PP *dec_ctx, struct snc_packet *p
         GF_ELEMENT *ces1 = calloc(numpp, sizeof(GF_ELEMENT));
         if (ces1 == NULL)
             fprintf(stderr, "%s: calloc ces1 failed\n", fname);
+        int *pktid = get_subgeneration(dec_ctx->sc, pkt->gid)->pktid;
         for (i=0; i<gensize; i++) {
-            int index = dec_ctx->sc->gene[pkt->gid]->pktid[i];
+            int index = pktid[i];
             if (dec_ctx->sc->params.gfpower == 1) {
                 ces1[index] = get_bit_in_array(pkt->coes, i);
             } else if (dec_ctx->sc->params.gfpower == 8) {
@@ -172,9 +177,9 @@ void process_packet_PP(struct decoding_context_PP *dec_ctx, struct snc_packet *p
             if (ces1[k] != 0) {
                 if (dec_ctx->row[k] != NULL) {
                     assert(dec_ctx->row[k]->elem[0]);
-                    quotient = galois_divide(ces1[k], dec_ctx->row[k]->elem[0]);
-                    galois_multiply_add_region(&(ces1[k]), dec_ctx->row[k]->elem, quotient, dec_ctx->row[k]->len);
-                    galois_multiply_add_region(pkt->syms, dec_ctx->message[k], quotient, pktsize);
+                    quotient = galois_divide(dec_ctx->sc->gf, ces1[k], dec_ctx->row[k]->elem[0]);
+                    galois_multiply_add_region(dec_ctx->sc->gf, &(ces1[k]), dec_ctx->row[k]->elem, quotient, dec_ctx->row[k]->len);
+                    galois_multiply_add_region(dec_ctx->sc->gf, pkt->syms, dec_ctx->message[k], quotient, pktsize);
                     dec_ctx->operations += 1 + dec_ctx->row[k]->len + pktsize;
                 } else {
                     // a valid pivot found, store it back to decoding matrix
@@ -218,7 +223,7 @@ void process_packet_PP(struct decoding_context_PP *dec_ctx, struct snc_packet *p
                 int index = (numpp - gensize + i + j) % numpp;
                 ces[i][index] = dec_ctx->row[numpp-gensize+i]->elem[j];
             }
-            message[i] = calloc(pktsize, sizeof(GF_ELEMENT));
+            message[i] = calloc_payload(pktsize);
             memcpy(message[i], dec_ctx->message[numpp-gensize+i], pktsize*sizeof(GF_ELEMENT));
             // free the rows in dec_ctx->row, and message
             free(dec_ctx->row[numpp-gensize+i]->elem);
@@ -233,9 +238,9 @@ void process_packet_PP(struct decoding_context_PP *dec_ctx, struct snc_packet *p
                 if (ces[i][k] != 0) {
                     if (dec_ctx->row[k] != NULL) {
                         assert(dec_ctx->row[k]->elem[0]);
-                        quotient = galois_divide(ces[i][k], dec_ctx->row[k]->elem[0]);
-                        galois_multiply_add_region(&(ces[i][k]), dec_ctx->row[k]->elem, quotient, dec_ctx->row[k]->len);
-                        galois_multiply_add_region(message[i], dec_ctx->message[k], quotient, pktsize);
+                        quotient = galois_divide(dec_ctx->sc->gf, ces[i][k], dec_ctx->row[k]->elem[0]);
+                        galois_multiply_add_region(dec_ctx->sc->gf, &(ces[i][k]), dec_ctx->row[k]->elem, quotient, dec_ctx->row[k]->len);
+                        galois_multiply_add_region(dec_ctx->sc->gf, message[i], dec_ctx->message[k], quotient, pktsize);
                         dec_ctx->operations += 1 + dec_ctx->row[k]->len + pktsize;
                     } else {
                         // a valid pivot found, store it back to decoding matrix
@@ -279,33 +284,45 @@ static void finish_recovering_PP(struct decoding_context_PP *dec_ctx)
     int gensize = dec_ctx->sc->params.size_g;
     int pktsize = dec_ctx->sc->params.size_p;
     int numpp = dec_ctx->sc->snum;
-    int i, j;
+    int i, j, n;
     int len;
-    GF_ELEMENT quotient;
+    // messages to be eliminated by message[i] and the quotients
+    GF_ELEMENT **dsts = malloc(sizeof(GF_ELEMENT*) * numpp);
+    GF_ELEMENT *quotients = malloc(sizeof(GF_ELEMENT) * numpp);
+    if (dsts == NULL || quotients == NULL) {
+        fprintf(stderr, "finish_recovering_PP: malloc elimination list failed\n");
+        free(dsts);
+        free(quotients);
+        return;
+    }
     // eliminate all nonzeros of the upper-triangular, examining columns from right to left
     for (i=numpp-1; i>=0; i--) {
         // examine rows from top to bottom
         // FIXME: j=0 is overkill, maybe j=max(0, i-gensize)?
+        n = 0;
         for (j=0; j<i; j++) {
             len = dec_ctx->row[j]->len;
             if (j+len <= i || dec_ctx->row[j]->elem[i-j] == 0)
                 continue;
             assert(dec_ctx->row[i]->elem[0]);
-            quotient = galois_divide(dec_ctx->row[j]->elem[i-j], dec_ctx->row[i]->elem[0]);
-            galois_multiply_add_region(dec_ctx->message[j], dec_ctx->message[i], quotient, pktsize);
+            quotients[n] = galois_divide(dec_ctx->sc->gf, dec_ctx->row[j]->elem[i-j], dec_ctx->row[i]->elem[0]);
+            dsts[n++] = dec_ctx->message[j];
             dec_ctx->operations += (pktsize + 1);
             dec_ctx->row[j]->elem[i-j] = 0;
         }
+        galois_multiply_add_region_scatter(dec_ctx->sc->gf, dsts, dec_ctx->message[i], quotients, n, pktsize);
         /* convert diagonal to 1*/
         if (dec_ctx->row[i]->elem[0] != 1) {
-            galois_multiply_region(dec_ctx->message[i], galois_divide(1, dec_ctx->row[i]->elem[0]), pktsize);
+            galois_multiply_region(dec_ctx->sc->gf, dec_ctx->message[i], galois_divide(dec_ctx->sc->gf, 1, dec_ctx->row[i]->elem[0]), pktsize);
             dec_ctx->operations += (pktsize + 1);
             dec_ctx->row[i]->elem[0] = 1;
         }
         /* save decoded packet */
-        dec_ctx->sc->pp[i] = calloc(pktsize, sizeof(GF_ELEMENT));
+        dec_ctx->sc->pp[i] = calloc_payload(pktsize);
         memcpy(dec_ctx->sc->pp[i], dec_ctx->message[i], pktsize*sizeof(GF_ELEMENT));
     }
+    free(dsts);
+    free(quotients);
     dec_ctx->finished = 1;
 }
 
@@ -337,6 +354,20 @@ void free_dec_context_PP(struct decoding_context_PP *dec_ctx)
     return;
 }
 
+// Missing DoF of subgeneration gid, i.e., its packets having no pivot row yet
+int missing_dof_PP(struct decoding_context_PP *dec_ctx, int gid)
+{
+    if (dec_ctx->finished)
+        return 0;
+    int *pktid = get_subgeneration(dec_ctx->sc, gid)->pktid;
+    int missing = 0;
+    for (int i=0; i<dec_ctx->sc->params.size_g; i++) {
+        if (dec_ctx->row[pktid[i]] == NULL)
+            missing += 1;
+    }
+    return missing;
+}
+
 /**
  * Save a decoding context to a file
  * Return values:
@@ -393,7 +424,7 @@ struct decoding_context_PP *restore_dec_context_PP(const char *filepath)
     struct snc_parameters sp;
     fread(&sp, sizeof(struct snc_parameters), 1, fp);
     // Create a fresh decoding context
-    struct decoding_context_PP *dec_ctx = create_dec_context_PP(&sp);
+    struct decoding_context_PP *dec_ctx = create_dec_context_PP(&sp, NULL);
     if (dec_ctx == NULL) {
         fprintf(stderr, "malloc decoding_context_CBD failed\n");
         return NULL;
@@ -27,8 +27,9 @@ struct decoding_context_PP
     long long operations;       // record the number of computations used
 };
 
-struct decoding_context_PP *create_dec_context_PP(struct snc_parameters *sp);
+struct decoding_context_PP *create_dec_context_PP(struct snc_parameters *sp, const struct snc_options *opt);
 void process_packet_PP(struct decoding_context_PP *dec_ctx, struct snc_packet *pkt);
+int missing_dof_PP(struct decoding_context_PP *dec_ctx, int gid);
 void free_dec_context_PP(struct decoding_context_PP *dec_ctx);
 
 /**
@@ -0,0 +1,593 @@
+/*-----------------------decoderRP.c----------------------
+ * Implementation of the Raptor decoder. Received packets are
+ * stored as sparse rows over the precoded packets. Once there
+ * are enough of them, the rows and the parity-checks of the
+ * precode are solved by peeling with inactivation: singleton
+ * rows are peeled off, and when none is left the active column
+ * with the most nonzeros is inactivated, as the inactivation
+ * pivoting of pivoting.c does. The dense system left over the
+ * inactivated columns is solved by Gaussian elimination, then
+ * the peeled columns are recovered in peeling order.
+ *------------------------------------------------------------*/
+#include "common.h"
+#include "galois.h"
+#include "decoderRP.h"
+
+#define COL_ACTIVE      0
+#define COL_INACTIVE    1
+#define COL_PEELED      2
+
+static int grow_rows(struct decoding_context_RP *dec_ctx);
+static int store_row(struct decoding_context_RP *dec_ctx, struct snc_packet *pkt);
+static int try_decoding(struct decoding_context_RP *dec_ctx);
+static int dense_rank(const struct gf_field *gf, int nrow, int ncol, GF_ELEMENT **A, long long *ops);
+
+extern long long forward_substitute(const struct gf_field *gf, struct gauss_scratch *gs, int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B);
+extern long long back_substitute(const struct gf_field *gf, struct gauss_scratch *gs, int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B);
+
+// create decoding context for Raptor decoder
+struct decoding_context_RP *create_dec_context_RP(struct snc_parameters *sp, const struct snc_options *opt)
+{
+    static char fname[] = "snc_create_dec_context_RP";
+    if (sp->type != RAPTOR_SNC) {
+        fprintf(stderr, "%s: RP decoder only applies to RAPTOR code.\n", fname);
+        return NULL;
+    }
+    struct decoding_context_RP *dec_ctx;
+    if ((dec_ctx = calloc(1, sizeof(struct decoding_context_RP))) == NULL) {
+        fprintf(stderr, "%s: calloc decoding_context_RP failed\n", fname);
+        return NULL;
+    }
+    struct snc_context *sc;
+    if ((sc = snc_create_enc_context_opt(NULL, sp, opt)) == NULL) {
+        fprintf(stderr, "%s: create decoding context failed", fname);
+        goto AllocError;
+    }
+    dec_ctx->sc = sc;
+
+    int gensize = sc->params.size_g;
+    int esize   = gf_field_esize(sc->gf);
+    dec_ctx->capacity = sc->snum + sc->cnum;
+    dec_ctx->degree  = malloc(sizeof(int) * dec_ctx->capacity);
+    dec_ctx->cols    = malloc(sizeof(int) * dec_ctx->capacity * gensize);
+    dec_ctx->ces     = malloc(sizeof(GF_ELEMENT) * dec_ctx->capacity * gensize * esize);
+    dec_ctx->message = calloc(dec_ctx->capacity, sizeof(GF_ELEMENT*));
+    dec_ctx->pktid   = malloc(sizeof(int) * gensize);
+    if (dec_ctx->degree == NULL || dec_ctx->cols == NULL || dec_ctx->ces == NULL
+            || dec_ctx->message == NULL || dec_ctx->pktid == NULL
+            || alloc_gauss_scratch(&dec_ctx->gs, sc->gf, dec_ctx->capacity + sc->cnum) != 0) {
+        fprintf(stderr, "%s: malloc rows failed\n", fname);
+        goto AllocError;
+    }
+    return dec_ctx;
+
+AllocError:
+    free_dec_context_RP(dec_ctx);
+    return NULL;
+}
+
+void process_packet_RP(struct decoding_context_RP *dec_ctx, struct snc_packet *pkt)
+{
+    if (dec_ctx->finished)
+        return;
+    dec_ctx->overhead += 1;
+    if (store_row(dec_ctx, pkt) != 0)
+        return;
+    // parity-checks supply cnum equations, so snum packets are necessary;
+    // after a failed attempt, wait for as many packets as the rank missing
+    if (dec_ctx->nrow < dec_ctx->sc->snum || --dec_ctx->pending > 0)
+        return;
+    try_decoding(dec_ctx);
+}
+
+/*
+ * Double the number of rows that can be stored
+ */
+static int grow_rows(struct decoding_context_RP *dec_ctx)
+{
+    int gensize  = dec_ctx->sc->params.size_g;
+    int esize    = gf_field_esize(dec_ctx->sc->gf);
+    int capacity = dec_ctx->capacity * 2;
+    int *degree = realloc(dec_ctx->degree, sizeof(int) * capacity);
+    if (degree != NULL)
+        dec_ctx->degree = degree;
+    int *cols = realloc(dec_ctx->cols, sizeof(int) * capacity * gensize);
+    if (cols != NULL)
+        dec_ctx->cols = cols;
+    GF_ELEMENT *ces = realloc(dec_ctx->ces, sizeof(GF_ELEMENT) * capacity * gensize * esize);
+    if (ces != NULL)
+        dec_ctx->ces = ces;
+    GF_ELEMENT **message = realloc(dec_ctx->message, sizeof(GF_ELEMENT*) * capacity);
+    if (message != NULL)
+        dec_ctx->message = message;
+    if (degree == NULL || cols == NULL || ces == NULL || message == NULL)
+        return (-1);
+    if (alloc_gauss_scratch(&dec_ctx->gs, dec_ctx->sc->gf, capacity + dec_ctx->sc->cnum) != 0)
+        return (-1);
+    dec_ctx->capacity = capacity;
+    return (0);
+}
+
+/*
+ * Store a packet as a sparse row. Coded packets are over the subset
+ * regenerated from their gid; systematic packets are singleton rows.
+ */
+static int store_row(struct decoding_context_RP *dec_ctx, struct snc_packet *pkt)
+{
+    static char fname[] = "process_packet_RP";
+    struct snc_context *sc = dec_ctx->sc;
+    int gensize = sc->params.size_g;
+    int esize   = gf_field_esize(sc->gf);
+    int numpp   = sc->snum + sc->cnum;
+    if (pkt->gid == -1 && pkt->ucid == -1) {
+        fprintf(stderr, "%s: pkt's gid is -1 but ucid is not valid\n", fname);
+        return (-1);
+    }
+    if (dec_ctx->nrow == dec_ctx->capacity && grow_rows(dec_ctx) != 0) {
+        fprintf(stderr, "%s: realloc rows failed\n", fname);
+        return (-1);
+    }
+    int r = dec_ctx->nrow;
+    int *cols = &dec_ctx->cols[r * gensize];
+    GF_ELEMENT *ces = &dec_ctx->ces[r * gensize * esize];
+    int d = 0;
+    if (pkt->gid == -1) {
+        cols[0] = pkt->ucid;
+        gf_set_element(ces, 0, 1, esize);
+        d = 1;
+    } else {
+        int n = raptor_subset(sc->params.seed, pkt->gid, numpp, gensize, dec_ctx->pktid);
+        for (int i=0; i<n; i++) {
+            GF_WORD co;
+            if (sc->params.gfpower == 1)
+                co = get_bit_in_array(pkt->coes, i);
+            else
+                co = gf_get_element(pkt->coes, i, esize);
+            if (co == 0)
+                continue;
+            cols[d] = dec_ctx->pktid[i];
+            gf_set_element(ces, d++, co, esize);
+        }
+    }
+    if ((dec_ctx->message[r] = calloc_payload(sc->params.size_p)) == NULL) {
+        fprintf(stderr, "%s: calloc_payload message failed\n", fname);
+        return (-1);
+    }
+    memcpy(dec_ctx->message[r], pkt->syms, sc->params.size_p);
+    dec_ctx->degree[r] = d;
+    dec_ctx->nrow += 1;
+    return (0);
+}
+
+/*
+ * Try to solve the stored rows together with the parity-checks. On
+ * success, the precoded packets are stored in sc->pp and the decoder
+ * finishes; otherwise more packets are needed and the rows are kept.
+ */
+static int try_decoding(struct decoding_context_RP *dec_ctx)
+{
+    static char fname[] = "try_decoding_RP";
+    struct snc_context *sc = dec_ctx->sc;
+    struct gf_field *gf = sc->gf;
+    int gensize = sc->params.size_g;
+    int pktsize = sc->params.size_p;
+    int esize   = gf_field_esize(gf);
+    int numpp   = sc->snum + sc->cnum;
+    int nrecv   = dec_ctx->nrow;
+    int nrow    = nrecv + sc->cnum;
+    long long ops = 0;
+    int i, k, m, r, c, t;
+    int success = 0;
+    dec_ctx->attempts += 1;
+
+    // 1, Rows of received packets followed by parity-checks, in CSR form
+    int *rowptr = malloc(sizeof(int) * (nrow + 1));
+    rowptr[0] = 0;
+    for (r=0; r<nrow; r++) {
+        int n = 0;
+        if (r < nrecv) {
+            n = dec_ctx->degree[r];
+        } else {
+            for (NBR_node *nb=sc->graph->l_nbrs_of_r[r-nrecv]->first; nb!=NULL; nb=nb->next)
+                n++;
+            n += 1;     // the check packet itself
+        }
+        rowptr[r+1] = rowptr[r] + n;
+    }
+    int nnz = rowptr[nrow];
+    int *colidx = malloc(sizeof(int) * (nnz > 0 ? nnz : 1));
+    GF_WORD *ce = malloc(sizeof(GF_WORD) * (nnz > 0 ? nnz : 1));
+    for (r=0; r<nrow; r++) {
+        k = rowptr[r];
+        if (r < nrecv) {
+            for (i=0; i<dec_ctx->degree[r]; i++) {
+                colidx[k] = dec_ctx->cols[r*gensize+i];
+                ce[k++] = gf_get_element(&dec_ctx->ces[r*gensize*esize], i, esize);
+            }
+        } else {
+            for (NBR_node *nb=sc->graph->l_nbrs_of_r[r-nrecv]->first; nb!=NULL; nb=nb->next) {
+                colidx[k] = nb->data;
+                ce[k++] = nb->ce;
+            }
+            colidx[k] = sc->snum + (r - nrecv);
+            ce[k++] = 1;
+        }
+    }
+
+    // 2, Rows containing each column
+    int *colptr = calloc(numpp + 1, sizeof(int));
+    int *rowidx = malloc(sizeof(int) * (nnz > 0 ? nnz : 1));
+    for (k=0; k<nnz; k++)
+        colptr[colidx[k]+1] += 1;
+    for (c=0; c<numpp; c++)
+        colptr[c+1] += colptr[c];
+    int *fill = malloc(sizeof(int) * numpp);
+    memcpy(fill, colptr, sizeof(int) * numpp);
+    for (r=0; r<nrow; r++) {
+        for (k=rowptr[r]; k<rowptr[r+1]; k++)
+            rowidx[fill[colidx[k]]++] = r;
+    }
+
+    // Columns in the order of inactivation, most nonzeros first (counting sort)
+    int maxcnt = 0;
+    for (c=0; c<numpp; c++) {
+        if (colptr[c+1] - colptr[c] > maxcnt)
+            maxcnt = colptr[c+1] - colptr[c];
+    }
+    int *bucket = calloc(maxcnt + 2, sizeof(int));
+    for (c=0; c<numpp; c++)
+        bucket[maxcnt - (colptr[c+1] - colptr[c]) + 1] += 1;
+    for (i=0; i<=maxcnt; i++)
+        bucket[i+1] += bucket[i];
+    int *bycount = malloc(sizeof(int) * numpp);
+    for (c=0; c<numpp; c++)
+        bycount[bucket[maxcnt - (colptr[c+1] - colptr[c])]++] = c;
+    free(bucket);
+
+    // 3, Peeling with inactivation
+    int *active_deg = malloc(sizeof(int) * nrow);
+    char *row_used  = calloc(nrow, sizeof(char));
+    char *col_state = calloc(numpp, sizeof(char));
+    int *prow   = malloc(sizeof(int) * numpp);     // row peeled at a column
+    int *colpos = malloc(sizeof(int) * numpp);     // position among peeled or inactivated columns
+    int *order  = malloc(sizeof(int) * numpp);     // peeled columns in peeling order
+    int *queue  = malloc(sizeof(int) * (nrow + nnz));
+    int head = 0, tail = 0;
+    for (r=0; r<nrow; r++) {
+        active_deg[r] = rowptr[r+1] - rowptr[r];
+        if (active_deg[r] == 1)
+            queue[tail++] = r;
+    }
+    int npeeled = 0, ias = 0, next_ia = 0;
+    int active = numpp;
+    while (active > 0) {
+        if (head < tail) {
+            r = queue[head++];
+            if (row_used[r] || active_deg[r] != 1)
+                continue;
+            for (k=rowptr[r]; k<rowptr[r+1]; k++) {
+                if (col_state[colidx[k]] == COL_ACTIVE)
+                    break;
+            }
+            c = colidx[k];
+            col_state[c] = COL_PEELED;
+            prow[c] = r;
+            colpos[c] = npeeled;
+            order[npeeled++] = c;
+            row_used[r] = 1;
+        } else {
+            // no singleton row is left, inactivate the active column with the most nonzeros
+            while (col_state[bycount[next_ia]] != COL_ACTIVE)
+                next_ia++;
+            c = bycount[next_ia++];
+            col_state[c] = COL_INACTIVE;
+            colpos[c] = ias++;
+        }
+        active -= 1;
+        for (k=colptr[c]; k<colptr[c+1]; k++) {
+            int r2 = rowidx[k];
+            if (!row_used[r2] && --active_deg[r2] == 1)
+                queue[tail++] = r2;
+        }
+    }
+    dec_ctx->inactivated = ias;
+    if (get_loglevel() == TRACE)
+        printf("%s: attempt %d with %d rows, %d/%d columns are inactivated.\n", fname, dec_ctx->attempts, nrow, ias, numpp);
+
+    // 4, Express each peeled column in the inactivated ones: x_c = P_c + V_c * x_I.
+    //    Other columns of the row of a peeled column were peeled earlier or
+    //    inactivated. Coefficients V_c come first, payloads P_c only when the
+    //    inactivated columns turn out solvable.
+    int vlen = ias * esize;
+    GF_ELEMENT *V = calloc((size_t) npeeled * vlen + 1, sizeof(GF_ELEMENT));
+    GF_WORD *pivinv = malloc(sizeof(GF_WORD) * (npeeled > 0 ? npeeled : 1));
+    for (t=0; t<npeeled; t++) {
+        c = order[t];
+        r = prow[c];
+        GF_ELEMENT *Vc = V + (size_t) t * vlen;
+        for (k=rowptr[r]; k<rowptr[r+1]; k++) {
+            int col = colidx[k];
+            if (col == c) {
+                pivinv[t] = galois_divide(gf, 1, ce[k]);
+            } else if (col_state[col] == COL_PEELED) {
+                galois_multiply_add_region(gf, Vc, V + (size_t) colpos[col] * vlen, ce[k], vlen);
+                ops += ias;
+            } else {
+                gf_set_element(Vc, colpos[col], galois_add(gf_get_element(Vc, colpos[col], esize), ce[k]), esize);
+            }
+        }
+        galois_multiply_region(gf, Vc, pivinv[t], vlen);
+    }
+
+    // 5, The rows left give the dense system of the inactivated columns.
+    //    Its rank is checked on a copy of the coefficients, without payloads.
+    int nrem = nrow - npeeled;
+    int rank = 0;
+    GF_ELEMENT **A = calloc(nrem > 0 ? nrem : 1, sizeof(GF_ELEMENT*));
+    GF_ELEMENT **B = calloc(nrem > 0 ? nrem : 1, sizeof(GF_ELEMENT*));
+    int *arow = malloc(sizeof(int) * (nrem > 0 ? nrem : 1));
+    if (nrem >= ias) {
+        GF_ELEMENT **A2 = malloc(sizeof(GF_ELEMENT*) * (nrem > 0 ? nrem : 1));
+        int m = 0;
+        for (r=0; r<nrow; r++) {
+            if (row_used[r])
+                continue;
+            A[m] = calloc(vlen + 1, sizeof(GF_ELEMENT));
+            for (k=rowptr[r]; k<rowptr[r+1]; k++) {
+                int col = colidx[k];
+                if (col_state[col] == COL_PEELED) {
+                    galois_multiply_add_region(gf, A[m], V + (size_t) colpos[col] * vlen, ce[k], vlen);
+                    ops += ias;
+                } else {
+                    gf_set_element(A[m], colpos[col], galois_add(gf_get_element(A[m], colpos[col], esize), ce[k]), esize);
+                }
+            }
+            A2[m] = malloc(vlen + 1);
+            memcpy(A2[m], A[m], vlen);
+            arow[m++] = r;
+        }
+        rank = dense_rank(gf, nrem, ias, A2, &ops);
+        for (i=0; i<nrem; i++)
+            free(A2[i]);
+        free(A2);
+    }
+
+    // 6, Compute the payloads, solve the inactivated columns, then recover
+    //    the peeled ones in peeling order from their rows
+    if (nrem >= ias && rank == ias) {
+        for (c=0; c<numpp; c++) {
+            if (sc->pp[c] == NULL)
+                sc->pp[c] = calloc_payload(pktsize);
+        }
+        for (t=0; t<npeeled; t++) {
+            c = order[t];
+            r = prow[c];
+            if (r < nrecv)
+                memcpy(sc->pp[c], dec_ctx->message[r], pktsize);
+            else
+                memset(sc->pp[c], 0, pktsize);
+            for (k=rowptr[r]; k<rowptr[r+1]; k++) {
+                if (colidx[k] != c && col_state[colidx[k]] == COL_PEELED) {
+                    galois_multiply_add_region(gf, sc->pp[c], sc->pp[colidx[k]], ce[k], pktsize);
+                    ops += pktsize;
+                }
+            }
+            if (pivinv[t] != 1) {
+                galois_multiply_region(gf, sc->pp[c], pivinv[t], pktsize);
+                ops += pktsize;
+            }
+        }
+        for (m=0; m<nrem; m++) {
+            r = arow[m];
+            B[m] = calloc_payload(pktsize);
+            if (r < nrecv)
+                memcpy(B[m], dec_ctx->message[r], pktsize);
+            for (k=rowptr[r]; k<rowptr[r+1]; k++) {
+                if (col_state[colidx[k]] == COL_PEELED) {
+                    galois_multiply_add_region(gf, B[m], sc->pp[colidx[k]], ce[k], pktsize);
+                    ops += pktsize;
+                }
+            }
+        }
+        ops += forward_substitute(gf, &dec_ctx->gs, nrem, ias, pktsize, A, B);
+        ops += back_substitute(gf, &dec_ctx->gs, ias, ias, pktsize, A, B);
+        for (c=0; c<numpp; c++) {
+            if (col_state[c] == COL_INACTIVE)
+                memcpy(sc->pp[c], B[colpos[c]], pktsize);
+        }
+        for (t=0; t<npeeled; t++) {
+            c = order[t];
+            r = prow[c];
+            if (r < nrecv)
+                memcpy(sc->pp[c], dec_ctx->message[r], pktsize);
+            else
+                memset(sc->pp[c], 0, pktsize);
+            for (k=rowptr[r]; k<rowptr[r+1]; k++) {
+                if (colidx[k] != c) {
+                    galois_multiply_add_region(gf, sc->pp[c], sc->pp[colidx[k]], ce[k], pktsize);
+                    ops += pktsize;
+                }
+            }
+            if (pivinv[t] != 1) {
+                galois_multiply_region(gf, sc->pp[c], pivinv[t], pktsize);
+                ops += pktsize;
+            }
+        }
+        dec_ctx->finished = 1;
+        success = 1;
+    } else {
+        // each missing rank takes at least one more packet
+        dec_ctx->pending = nrem >= ias ? ias - rank : ias - nrem;
+        if (get_loglevel() == TRACE)
+            printf("%s: attempt %d failed, rank %d of %d inactivated columns.\n", fname, dec_ctx->attempts, rank, ias);
+    }
+    dec_ctx->operations += ops;
+
+    for (i=0; i<nrem; i++) {
+        free(A[i]);
+        free(B[i]);
+    }
+    free(A);
+    free(B);
+    free(V);
+    free(pivinv);
+    free(arow);
+    free(rowptr);
+    free(colidx);
+    free(ce);
+    free(colptr);
+    free(rowidx);
+    free(fill);
+    free(bycount);
+    free(active_deg);
+    free(row_used);
+    free(col_state);
+    free(prow);
+    free(colpos);
+    free(order);
+    free(queue);
+    return success;
+}
+
+/*
+ * Rank of a dense nrow x ncol matrix, whose rows are reduced in place.
+ * Unlike forward_substitute(), a zero column does not use up a row.
+ */
+static int dense_rank(const struct gf_field *gf, int nrow, int ncol, GF_ELEMENT **A, long long *ops)
+{
+    int esize = gf_field_esize(gf);
+    int rank = 0;
+    for (int j=0; j<ncol && rank<nrow; j++) {
+        int pivot;
+        for (pivot=rank; pivot<nrow; pivot++) {
+            if (gf_get_element(A[pivot], j, esize) != 0)
+                break;
+        }
+        if (pivot == nrow)
+            continue;
+        GF_ELEMENT *tmp = A[rank];
+        A[rank] = A[pivot];
+        A[pivot] = tmp;
+        GF_WORD inv = galois_divide(gf, 1, gf_get_element(A[rank], j, esize));
+        for (int i=rank+1; i<nrow; i++) {
+            GF_WORD e = gf_get_element(A[i], j, esize);
+            if (e == 0)
+                continue;
+            galois_multiply_add_region(gf, &A[i][j*esize], &A[rank][j*esize], galois_multiply(gf, e, inv), (ncol-j)*esize);
+            *ops += ncol - j;
+        }
+        rank++;
+    }
+    return rank;
+}
+
+void free_dec_context_RP(struct decoding_context_RP *dec_ctx)
+{
+    if (dec_ctx == NULL)
+        return;
+    if (dec_ctx->message != NULL) {
+        for (int i=0; i<dec_ctx->nrow; i++)
+            free(dec_ctx->message[i]);
+        free(dec_ctx->message);
+    }
+    free(dec_ctx->degree);
+    free(dec_ctx->cols);
+    free(dec_ctx->ces);
+    free(dec_ctx->pktid);
+    free_gauss_scratch(&dec_ctx->gs);
+    if (dec_ctx->sc != NULL)
+        snc_free_enc_context(dec_ctx->sc);
+    free(dec_ctx);
+}
+
+/**
+ * Save a decoding context to a file
+ * Return values:
+ *   On success: bytes written
+ *   On error: -1
+ */
+long save_dec_context_RP(struct decoding_context_RP *dec_ctx, const char *filepath)
+{
+    long filesize = 0;
+    int d_type = RP_DECODER;
+    FILE *fp;
+    if ((fp = fopen(filepath, "w")) == NULL) {
+        fprintf(stderr, "Cannot open %s to save decoding context\n", filepath);
+        return (-1);
+    }
+    int gensize = dec_ctx->sc->params.size_g;
+    int pktsize = dec_ctx->sc->params.size_p;
+    int esize   = gf_field_esize(dec_ctx->sc->gf);
+    // Write snc params
+    filesize += fwrite(&dec_ctx->sc->params, sizeof(struct snc_parameters), 1, fp);
+    // Write decoder type
+    filesize += fwrite(&(d_type), sizeof(int), 1, fp);
+    filesize += fwrite(&dec_ctx->finished, sizeof(int), 1, fp);
+    filesize += fwrite(&dec_ctx->nrow, sizeof(int), 1, fp);
+    // Save stored rows
+    for (int i=0; i<dec_ctx->nrow; i++) {
+        filesize += fwrite(&dec_ctx->degree[i], sizeof(int), 1, fp);
+        filesize += fwrite(&dec_ctx->cols[i*gensize], sizeof(int), dec_ctx->degree[i], fp);
+        filesize += fwrite(&dec_ctx->ces[i*gensize*esize], sizeof(GF_ELEMENT), dec_ctx->degree[i]*esize, fp);
+        filesize += fwrite(dec_ctx->message[i], sizeof(GF_ELEMENT), pktsize, fp);
+    }
+    // Save performance index
+    filesize += fwrite(&dec_ctx->attempts, sizeof(int), 1, fp);
+    filesize += fwrite(&dec_ctx->overhead, sizeof(int), 1, fp);
+    filesize += fwrite(&dec_ctx->operations, sizeof(long long), 1, fp);
+    fclose(fp);
+    return filesize;
+}
+
+struct decoding_context_RP *restore_dec_context_RP(const char *filepath)
+{
+    FILE *fp;
+    if ((fp = fopen(filepath, "r")) == NULL) {
+        fprintf(stderr, "Cannot open %s to load decoding context\n", filepath);
+        return NULL;
+    }
+    struct snc_parameters sp;
+    fread(&sp, sizeof(struct snc_parameters), 1, fp);
+    fseek(fp, sizeof(int), SEEK_CUR);  // skip decoding_type field
+    // Create a fresh decoding context
+    struct decoding_context_RP *dec_ctx = create_dec_context_RP(&sp, NULL);
+    if (dec_ctx == NULL) {
+        fprintf(stderr, "malloc decoding_context_RP failed\n");
+        fclose(fp);
+        return NULL;
+    }
+    int finished, nrow;
+    fread(&finished, sizeof(int), 1, fp);
+    fread(&nrow, sizeof(int), 1, fp);
+    // Restore stored rows
+    int gensize = sp.size_g;
+    int esize   = gf_field_esize(dec_ctx->sc->gf);
+    for (int i=0; i<nrow; i++) {
+        if (dec_ctx->nrow == dec_ctx->capacity && grow_rows(dec_ctx) != 0) {
+            fprintf(stderr, "realloc rows of decoding_context_RP failed\n");
+            fclose(fp);
+            free_dec_context_RP(dec_ctx);
+            return NULL;
+        }
+        int r = dec_ctx->nrow;
+        dec_ctx->message[r] = calloc_payload(sp.size_p);
+        fread(&dec_ctx->degree[r], sizeof(int), 1, fp);
+        fread(&dec_ctx->cols[r*gensize], sizeof(int), dec_ctx->degree[r], fp);
+        fread(&dec_ctx->ces[r*gensize*esize], sizeof(GF_ELEMENT), dec_ctx->degree[r]*esize, fp);
+        fread(dec_ctx->message[r], sizeof(GF_ELEMENT), sp.size_p, fp);
+        dec_ctx->nrow += 1;
+    }
+    // Restore performance index
+    fread(&dec_ctx->attempts, sizeof(int), 1, fp);
+    fread(&dec_ctx->overhead, sizeof(int), 1, fp);
+    fread(&dec_ctx->operations, sizeof(long long), 1, fp);
+    fclose(fp);
+    // Recover the decoded packets of a finished decoder
+    if (finished) {
+        long long operations = dec_ctx->operations;
+        try_decoding(dec_ctx);
+        dec_ctx->operations = operations;
+        dec_ctx->attempts -= 1;
+    }
+    return dec_ctx;
+}
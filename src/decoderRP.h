@@ -0,0 +1,47 @@
+#ifndef RP_DECODER_H
+#define RP_DECODER_H
+#include "sparsenc.h"
+/*
+ * RP (Raptor code) DECODING CONTEXT
+ */
+struct decoding_context_RP
+{
+    // GNC context
+    struct snc_context *sc;
+
+    int finished;               // an indicator tracking the finish of decoding
+    int inactivated;            // number of inactivated columns in the last decoding attempt
+    int attempts;               // number of decoding attempts
+    int pending;                // packets to receive before the next attempt
+
+    // received packets, stored as sparse rows over the precoded packets
+    int nrow;                   // number of stored rows
+    int capacity;               // number of rows allocated
+    int *degree;                // number of nonzeros of each row
+    int *cols;                  // column indices of nonzeros, SIZE_G per row
+    GF_ELEMENT *ces;            // nonzeros, SIZE_G per row
+    GF_ELEMENT **message;       // payloads of the rows
+
+    int *pktid;                 // scratch of regenerated subsets
+    struct gauss_scratch gs;    // scratch of Gaussian elimination, capacity+cnum rows
+
+    /*performance index*/
+    int overhead;               // record how many packets have been received
+    long long operations;       // record the number of computations used
+};
+
+struct decoding_context_RP *create_dec_context_RP(struct snc_parameters *sp, const struct snc_options *opt);
+void process_packet_RP(struct decoding_context_RP *dec_ctx, struct snc_packet *pkt);
+void free_dec_context_RP(struct decoding_context_RP *dec_ctx);
+
+/**
+ * File format to store ongoing decoding context
+ *
+ * snc_parameter
+ * decoder_type
+ * decoding_context_RP (stored rows, excluding snc_context)
+ *
+ */
+long save_dec_context_RP(struct decoding_context_RP *dec_ctx, const char *filepath);
+struct decoding_context_RP *restore_dec_context_RP(const char *filepath);
+#endif
@@ -1,35 +1,188 @@
 /************************************************************************
  * galois.c
  * Functions of Galois field arithmetic.
- * Supports GF(2), GF(4), ..., GF(256)
+ * Supports GF(2), GF(4), ..., GF(256), and GF(2^16)
  ************************************************************************/
 #include <stdlib.h>
 #include <string.h>
-#if defined(INTEL_SSSE3)
-#include <tmmintrin.h>
-#endif
-#if defined(INTEL_AVX2)
+#if defined(__x86_64__) || defined(__i386__)
+#define GALOIS_X86
 #include <immintrin.h>
+#define TARGET_SSSE3    __attribute__((target("ssse3")))
+#define TARGET_AVX2     __attribute__((target("avx2")))
+#define TARGET_AVX512BW __attribute__((target("avx512f,avx512bw")))
+#define TARGET_GFNI_AVX2    __attribute__((target("gfni,avx2")))
+#define TARGET_GFNI_AVX512  __attribute__((target("gfni,avx512f,avx512bw")))
 #endif
+#include <pthread.h>
 #include "galois.h"
-static int constructed = 0;
-//static GF_ELEMENT galois_log_table[1<<GF_POWER];
-//static GF_ELEMENT galois_ilog_table[(1<<GF_POWER)];
-//static GF_ELEMENT galois_mult_table[(1<<GF_POWER)*(1<<GF_POWER)];
-//static GF_ELEMENT galois_divi_table[(1<<GF_POWER)*(1<<GF_POWER)];
-static int GF_POWER;
-static GF_ELEMENT *galois_log_table;
-static GF_ELEMENT *galois_ilog_table;
-static GF_ELEMENT *galois_mult_table;
-static GF_ELEMENT *galois_divi_table;
-
-
-// Two half tables are used for SSE multiply_add_region, used only by GF(2) and GF(2^8)
-#if defined(INTEL_SSSE3)
-static uint8_t galois_half_mult_table_high[(1<<8)][(1<<4)];
-static uint8_t galois_half_mult_table_low[(1<<8)][(1<<4)];
+
+/*
+ * Multiplying by a constant is linear over GF(2), so the product of a byte
+ * is the XOR of the products of its low and high nibbles, and can also be
+ * written as an 8x8 bit matrix. Each element has
+ *   lo[x]  - product with byte x (x < 16)
+ *   hi[x]  - product with byte (x << 4)
+ *   affine - the bit matrix in the layout of gf2p8affineqb
+ * These are looked up 16 bytes at a time with pshufb, or 8 bytes with GFNI.
+ * The tables are built by galois_create_mult_const(). gf->mult_const is for
+ * bytes holding one element each, which is also how decoders store
+ * GF(4),...,GF(128) elements. gf->packed_mult_const is for bytes packed with
+ * four GF(4) or two GF(16) elements, as used by the *_packed region functions.
+ */
+struct gf_mult_const {
+    uint8_t  lo[16];
+    uint8_t  hi[16];
+    uint64_t affine;
+};
+
+/*
+ * GF(2^16) elements are stored as two bytes, most significant first. A
+ * product is the XOR of the products of the four nibbles of the element,
+ * and the low/high bytes of the product of nibble k are lo[k]/hi[k]. There
+ * are too many multipliers to keep the tables of all of them, so they are
+ * built for each region operation.
+ */
+struct gf_mult_const16 {
+    uint8_t  lo[4][16];
+    uint8_t  hi[4][16];
+};
+
+/*
+ * A Galois field GF(2^power). Fields are shared: gf_field_get() creates a
+ * field on its first use and hands out references to it afterwards, and
+ * the field is destroyed when the last reference is put. The tables are
+ * read-only once the field is created, so a field can be used by several
+ * contexts (and threads) at the same time.
+ */
+struct gf_field {
+    int         power;          // GF(2) uses GF(256) arithmetic, so power is 2,...,8 or 16
+    int         refcount;
+    GF_WORD    *log_table;
+    GF_WORD    *ilog_table;
+    GF_ELEMENT *mult_table;     // full multiplication/division tables, not used by GF(2^16)
+    GF_ELEMENT *divi_table;
+    struct gf_mult_const mult_const[(1<<8)];
+    struct gf_mult_const packed_mult_const[(1<<8)];
+};
+static struct gf_field *gf_fields[16+1];        // shared fields indexed by power
+static pthread_mutex_t gf_fields_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Region kernels are selected at run time (when the first field is created)
+ * according to what the CPU supports, so that one binary runs on any x86
+ * host. The table is indexed by GF_SIMD_xxx; entries not compiled for the target are NULL.
+ */
+struct gf_region_kernels {
+    const char *name;
+    void (*add_region)(uint8_t *dst, uint8_t *src, int bytes);
+    void (*multiply_add_region)(uint8_t *dst, uint8_t *src, const struct gf_mult_const *mc, int bytes);
+    void (*multiply_region)(uint8_t *src, const struct gf_mult_const *mc, int bytes);
+    // dst += sum(mcs[k] * srcs[k]), where mcs[k] == NULL stands for multiplier 1
+    void (*multiply_add_region_multi)(uint8_t *dst, uint8_t **srcs, const struct gf_mult_const **mcs, int n, int bytes);
+    // dsts[k] += mcs[k] * src, where mcs[k] == NULL stands for multiplier 1
+    void (*multiply_add_region_scatter)(uint8_t **dsts, uint8_t *src, const struct gf_mult_const **mcs, int n, int bytes);
+    // regions of GF(2^16) elements
+    void (*multiply_add_region16)(uint8_t *dst, uint8_t *src, const struct gf_mult_const16 *mc, int bytes);
+    void (*multiply_region16)(uint8_t *src, const struct gf_mult_const16 *mc, int bytes);
+    // dst and src are REGION_ALIGN-aligned and bytes is a multiple of
+    // REGION_ALIGN (padded payload buffers): aligned loads and no tail
+    void (*add_region_aligned)(uint8_t *dst, uint8_t *src, int bytes);
+    void (*multiply_add_region_aligned)(uint8_t *dst, uint8_t *src, const struct gf_mult_const *mc, int bytes);
+};
+#define REGION_ALIGN    64
+#define REGION_IS_ALIGNED(dst, src, bytes) \
+    ((((uintptr_t) (dst) | (uintptr_t) (src) | (uintptr_t) (bytes)) & (REGION_ALIGN - 1)) == 0)
+static void add_region_scalar(uint8_t *dst, uint8_t *src, int bytes);
+static void multiply_add_region_scalar(uint8_t *dst, uint8_t *src, const struct gf_mult_const *mc, int bytes);
+static void multiply_region_scalar(uint8_t *src, const struct gf_mult_const *mc, int bytes);
+static void multiply_add_region_multi_scalar(uint8_t *dst, uint8_t **srcs, const struct gf_mult_const **mcs, int n, int bytes);
+static void multiply_add_region_scatter_scalar(uint8_t **dsts, uint8_t *src, const struct gf_mult_const **mcs, int n, int bytes);
+static void multiply_add_region16_scalar(uint8_t *dst, uint8_t *src, const struct gf_mult_const16 *mc, int bytes);
+static void multiply_region16_scalar(uint8_t *src, const struct gf_mult_const16 *mc, int bytes);
+#if defined(GALOIS_X86)
+static void add_region_ssse3(uint8_t *dst, uint8_t *src, int bytes);
+static void multiply_add_region_ssse3(uint8_t *dst, uint8_t *src, const struct gf_mult_const *mc, int bytes);
+static void multiply_region_ssse3(uint8_t *src, const struct gf_mult_const *mc, int bytes);
+static void multiply_add_region_multi_ssse3(uint8_t *dst, uint8_t **srcs, const struct gf_mult_const **mcs, int n, int bytes);
+static void multiply_add_region_scatter_ssse3(uint8_t **dsts, uint8_t *src, const struct gf_mult_const **mcs, int n, int bytes);
+static void multiply_add_region16_ssse3(uint8_t *dst, uint8_t *src, const struct gf_mult_const16 *mc, int bytes);
+static void multiply_region16_ssse3(uint8_t *src, const struct gf_mult_const16 *mc, int bytes);
+static void add_region_avx2(uint8_t *dst, uint8_t *src, int bytes);
+static void multiply_add_region_avx2(uint8_t *dst, uint8_t *src, const struct gf_mult_const *mc, int bytes);
+static void multiply_region_avx2(uint8_t *src, const struct gf_mult_const *mc, int bytes);
+static void multiply_add_region_multi_avx2(uint8_t *dst, uint8_t **srcs, const struct gf_mult_const **mcs, int n, int bytes);
+static void multiply_add_region_scatter_avx2(uint8_t **dsts, uint8_t *src, const struct gf_mult_const **mcs, int n, int bytes);
+static void multiply_add_region16_avx2(uint8_t *dst, uint8_t *src, const struct gf_mult_const16 *mc, int bytes);
+static void multiply_region16_avx2(uint8_t *src, const struct gf_mult_const16 *mc, int bytes);
+static void add_region_aligned_avx2(uint8_t *dst, uint8_t *src, int bytes);
+static void multiply_add_region_aligned_avx2(uint8_t *dst, uint8_t *src, const struct gf_mult_const *mc, int bytes);
+static void add_region_avx512bw(uint8_t *dst, uint8_t *src, int bytes);
+static void multiply_add_region_avx512bw(uint8_t *dst, uint8_t *src, const struct gf_mult_const *mc, int bytes);
+static void multiply_region_avx512bw(uint8_t *src, const struct gf_mult_const *mc, int bytes);
+static void multiply_add_region_multi_avx512bw(uint8_t *dst, uint8_t **srcs, const struct gf_mult_const **mcs, int n, int bytes);
+static void multiply_add_region_scatter_avx512bw(uint8_t **dsts, uint8_t *src, const struct gf_mult_const **mcs, int n, int bytes);
+static void multiply_add_region16_avx512bw(uint8_t *dst, uint8_t *src, const struct gf_mult_const16 *mc, int bytes);
+static void multiply_region16_avx512bw(uint8_t *src, const struct gf_mult_const16 *mc, int bytes);
+static void add_region_aligned_avx512bw(uint8_t *dst, uint8_t *src, int bytes);
+static void multiply_add_region_aligned_avx512bw(uint8_t *dst, uint8_t *src, const struct gf_mult_const *mc, int bytes);
+static void multiply_add_region_gfni_avx2(uint8_t *dst, uint8_t *src, const struct gf_mult_const *mc, int bytes);
+static void multiply_region_gfni_avx2(uint8_t *src, const struct gf_mult_const *mc, int bytes);
+static void multiply_add_region_multi_gfni_avx2(uint8_t *dst, uint8_t **srcs, const struct gf_mult_const **mcs, int n, int bytes);
+static void multiply_add_region_scatter_gfni_avx2(uint8_t **dsts, uint8_t *src, const struct gf_mult_const **mcs, int n, int bytes);
+static void multiply_add_region_aligned_gfni_avx2(uint8_t *dst, uint8_t *src, const struct gf_mult_const *mc, int bytes);
+static void multiply_add_region_gfni_avx512(uint8_t *dst, uint8_t *src, const struct gf_mult_const *mc, int bytes);
+static void multiply_region_gfni_avx512(uint8_t *src, const struct gf_mult_const *mc, int bytes);
+static void multiply_add_region_multi_gfni_avx512(uint8_t *dst, uint8_t **srcs, const struct gf_mult_const **mcs, int n, int bytes);
+static void multiply_add_region_scatter_gfni_avx512(uint8_t **dsts, uint8_t *src, const struct gf_mult_const **mcs, int n, int bytes);
+static void multiply_add_region_aligned_gfni_avx512(uint8_t *dst, uint8_t *src, const struct gf_mult_const *mc, int bytes);
 #endif
 
+static const struct gf_region_kernels region_kernels[GF_SIMD_NUM] = {
+    {"scalar",
+     add_region_scalar, multiply_add_region_scalar, multiply_region_scalar,
+     multiply_add_region_multi_scalar, multiply_add_region_scatter_scalar,
+     multiply_add_region16_scalar, multiply_region16_scalar,
+     add_region_scalar, multiply_add_region_scalar},
+#if defined(GALOIS_X86)
+    {"ssse3",
+     add_region_ssse3, multiply_add_region_ssse3, multiply_region_ssse3,
+     multiply_add_region_multi_ssse3, multiply_add_region_scatter_ssse3,
+     multiply_add_region16_ssse3, multiply_region16_ssse3,
+     add_region_ssse3, multiply_add_region_ssse3},
+    {"avx2",
+     add_region_avx2, multiply_add_region_avx2, multiply_region_avx2,
+     multiply_add_region_multi_avx2, multiply_add_region_scatter_avx2,
+     multiply_add_region16_avx2, multiply_region16_avx2,
+     add_region_aligned_avx2, multiply_add_region_aligned_avx2},
+    {"avx512bw",
+     add_region_avx512bw, multiply_add_region_avx512bw, multiply_region_avx512bw,
+     multiply_add_region_multi_avx512bw, multiply_add_region_scatter_avx512bw,
+     multiply_add_region16_avx512bw, multiply_region16_avx512bw,
+     add_region_aligned_avx512bw, multiply_add_region_aligned_avx512bw},
+    {"gfni-avx2",
+     add_region_avx2, multiply_add_region_gfni_avx2, multiply_region_gfni_avx2,
+     multiply_add_region_multi_gfni_avx2, multiply_add_region_scatter_gfni_avx2,
+     multiply_add_region16_avx2, multiply_region16_avx2,
+     add_region_aligned_avx2, multiply_add_region_aligned_gfni_avx2},
+    {"gfni-avx512",
+     add_region_avx512bw, multiply_add_region_gfni_avx512, multiply_region_gfni_avx512,
+     multiply_add_region_multi_gfni_avx512, multiply_add_region_scatter_gfni_avx512,
+     multiply_add_region16_avx512bw, multiply_region16_avx512bw,
+     add_region_aligned_avx512bw, multiply_add_region_aligned_gfni_avx512},
+#else
+    {"ssse3"},
+    {"avx2"},
+    {"avx512bw"},
+    {"gfni-avx2"},
+    {"gfni-avx512"},
+#endif
+};
+static int gf_simd = GF_SIMD_SCALAR;            // currently selected kernel
+static int gf_simd_pinned = GF_SIMD_AUTO;       // set by galois_set_simd() before the first field is created
+static int gf_simd_selected = 0;
+static int select_simd(int requested);
+
 static int primitive_poly_2  = 07;      // 111: x^2 + x + 1
 static int primitive_poly_3  = 013;     // 001 011: x^3 + x + 1 
 static int primitive_poly_4  = 023;     // 010 011: x^4 + x + 1
@@ -37,89 +190,243 @@ static int primitive_poly_5  = 045;     // 100 101: x^5 + x^2 + 1
 static int primitive_poly_6  = 0103;    // 001 000 011: x^6 + x + 1
 static int primitive_poly_7  = 0203;    // 010 000 011: x^7 + x + 1
 static int primitive_poly_8  = 0435;    // 100 011 101: x^8 + x^4 + x^3 + x^2 + 1
-static int galois_create_log_table();
-static int galois_create_mult_table();
+static int primitive_poly_16 = 0210013; // x^16 + x^12 + x^3 + x + 1
+static int galois_create_log_table(struct gf_field *gf);
+static int galois_create_mult_table(struct gf_field *gf);
+static void galois_create_mult_const(struct gf_field *gf, struct gf_mult_const *mc, int packed);
 
-int GFConstructed() {
-    return constructed;
+static void free_field(struct gf_field *gf)
+{
+    free(gf->log_table);
+    free(gf->ilog_table);
+    free(gf->mult_table);
+    free(gf->divi_table);
+    free(gf);
 }
 
-int constructField(int gf_power)
+static struct gf_field *create_field(int power)
 {
-    if (constructed) {
-        // printf("Galois field GF(2^%d) exists.\n", GF_POWER);
-        return 0;
-    } else {
-        if (gf_power==1)
-            GF_POWER = 8;           // Use GF(256) for GF(2)
-        else
-            GF_POWER = gf_power;
-        // Allocate memory for GF lookup tables
-        galois_log_table = calloc((1<<GF_POWER), sizeof(GF_ELEMENT));
-        galois_ilog_table = calloc((1<<GF_POWER), sizeof(GF_ELEMENT));
-        galois_mult_table = calloc((1<<GF_POWER)*(1<<GF_POWER), sizeof(GF_ELEMENT));
-        galois_divi_table = calloc((1<<GF_POWER)*(1<<GF_POWER), sizeof(GF_ELEMENT));
-        if (galois_create_mult_table() < 0) {
-            perror("constructField");
-            exit(1);
+    struct gf_field *gf = calloc(1, sizeof(struct gf_field));
+    if (gf == NULL)
+        return NULL;
+    gf->power = power;
+    // Allocate memory for GF lookup tables
+    gf->log_table  = calloc((1<<power), sizeof(GF_WORD));
+    gf->ilog_table = calloc((1<<power), sizeof(GF_WORD));
+    if (gf->log_table == NULL || gf->ilog_table == NULL) {
+        free_field(gf);
+        return NULL;
+    }
+    if (power == 16) {
+        // GF(2^16) multiplies through the log tables
+        if (galois_create_log_table(gf) < 0) {
+            free_field(gf);
+            return NULL;
         }
+        return gf;
+    }
+    gf->mult_table = calloc((1<<power)*(1<<power), sizeof(GF_ELEMENT));
+    gf->divi_table = calloc((1<<power)*(1<<power), sizeof(GF_ELEMENT));
+    if (gf->mult_table == NULL || gf->divi_table == NULL
+            || galois_create_mult_table(gf) < 0) {
+        free_field(gf);
+        return NULL;
+    }
+    galois_create_mult_const(gf, gf->mult_const, 0);
+    if (power == 2 || power == 4)
+        galois_create_mult_const(gf, gf->packed_mult_const, 1);
+    return gf;
+}
 
-#if defined(INTEL_SSSE3)
-        /*
-        * Create half tables for SSE multiply_add_region:
-        * low table contains the products of an element with all 4-bit words;
-        * high table contains the products of an element with all 8-bit words
-        * whose last 4 bits are all zero. So each half table contains 256 rows
-        * and 16 columns.
-        */
-       if (GF_POWER == 8) {
-            int a, b, c, d;
-            int pp = primitive_poly_8;
-            for (a = 1; a < (1<<4) ; a++) {
-                b = 1;
-                c = a;
-                d = (a << 4);
-                do {
-                    galois_half_mult_table_low[b][a] = c;
-                    galois_half_mult_table_high[b][a] = d;
-                    b <<= 1;
-                    if (b & (1<<8)) b ^= pp;
-                    c <<= 1;
-                    if (c & (1<<8)) c ^= pp;
-                    d <<= 1;
-                    if (d & (1<<8)) d ^= pp;
-                } while (c != a);
-            }
-        }
-#endif  // ifdef(INTEL_SSSE3)
-        constructed = 1;
+/*
+ * Get a reference to GF(2^gf_power), creating the field if it does not
+ * exist yet. GF(2) shares the field of GF(256). Returns NULL if gf_power
+ * is not supported or memory runs out.
+ */
+struct gf_field *gf_field_get(int gf_power)
+{
+    int power = gf_power == 1 ? 8 : gf_power;   // Use GF(256) for GF(2)
+    if (power < 2 || (power > 8 && power != 16)) {
+        fprintf(stderr, "gf_field_get: GF(2^%d) is not supported\n", gf_power);
+        return NULL;
+    }
+    pthread_mutex_lock(&gf_fields_lock);
+    if (!gf_simd_selected) {
+        select_simd(gf_simd_pinned);
+        gf_simd_selected = 1;
+    }
+    struct gf_field *gf = gf_fields[power];
+    if (gf == NULL) {
+        if ((gf = create_field(power)) == NULL)
+            fprintf(stderr, "gf_field_get: create GF(2^%d) failed\n", power);
+        gf_fields[power] = gf;
+    }
+    if (gf != NULL)
+        gf->refcount++;
+    pthread_mutex_unlock(&gf_fields_lock);
+    return gf;
+}
+
+/*
+ * Drop a reference to a field obtained by gf_field_get(). The field is
+ * freed when no reference is left.
+ */
+void gf_field_put(struct gf_field *gf)
+{
+    if (gf == NULL)
+        return;
+    pthread_mutex_lock(&gf_fields_lock);
+    if (--gf->refcount == 0) {
+        gf_fields[gf->power] = NULL;
+        free_field(gf);
+    }
+    pthread_mutex_unlock(&gf_fields_lock);
+}
+
+int gf_field_power(const struct gf_field *gf)
+{
+    return gf->power;
+}
+
+/*
+ * Number of bytes an element takes in element arrays (coefficient vectors
+ * and rows of decoding matrices).
+ */
+int gf_field_esize(const struct gf_field *gf)
+{
+    return gf->power == 16 ? 2 : 1;
+}
+
+/*
+ * Whether the CPU we are running on can execute kernels of a SIMD level.
+ */
+static int simd_supported(int simd)
+{
+#if defined(GALOIS_X86)
+    __builtin_cpu_init();
+    switch (simd) {
+    case GF_SIMD_SCALAR:
+        return 1;
+    case GF_SIMD_SSSE3:
+        return __builtin_cpu_supports("ssse3");
+    case GF_SIMD_AVX2:
+        return __builtin_cpu_supports("avx2");
+    case GF_SIMD_AVX512BW:
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+    case GF_SIMD_GFNI_AVX2:
+        return __builtin_cpu_supports("gfni") && __builtin_cpu_supports("avx2");
+    case GF_SIMD_GFNI_AVX512:
+        return __builtin_cpu_supports("gfni") && __builtin_cpu_supports("avx512f")
+                && __builtin_cpu_supports("avx512bw");
+    }
+    return 0;
+#else
+    return simd == GF_SIMD_SCALAR;
+#endif
+}
+
+/*
+ * Best SIMD level the CPU supports (levels are numbered from slowest to
+ * fastest).
+ */
+int galois_cpu_simd()
+{
+    int simd = GF_SIMD_NUM - 1;
+    while (simd > GF_SIMD_SCALAR && !simd_supported(simd))
+        simd--;
+    return simd;
+}
+
+static int simd_from_env()
+{
+    char *s = getenv("SNC_GF_SIMD");
+    if (s == NULL)
+        return GF_SIMD_AUTO;
+    for (int i=0; i<GF_SIMD_NUM; i++) {
+        if (strcmp(s, region_kernels[i].name) == 0)
+            return i;
+    }
+    fprintf(stderr, "SNC_GF_SIMD=%s is unknown, ignored\n", s);
+    return GF_SIMD_AUTO;
+}
+
+/*
+ * Pick the region kernels. The SNC_GF_SIMD environment variable takes
+ * precedence over the requested level; a level not supported by the CPU
+ * falls back to the best supported one.
+ */
+static int select_simd(int requested)
+{
+    int best = galois_cpu_simd();
+    int env  = simd_from_env();
+    if (env != GF_SIMD_AUTO)
+        requested = env;
+    if (requested == GF_SIMD_AUTO || !simd_supported(requested)) {
+        if (requested != GF_SIMD_AUTO)
+            fprintf(stderr, "GF region kernel %s is not supported by the CPU, use %s\n",
+                    region_kernels[requested].name, region_kernels[best].name);
+        requested = best;
     }
+    gf_simd = requested;
+    return gf_simd;
+}
+
+/*
+ * Pin the region kernels to a SIMD level (GF_SIMD_xxx), e.g. for benchmarking.
+ * GF_SIMD_AUTO restores automatic selection. May be called before or after
+ * fields are created; use galois_get_simd() to see which level is in use.
+ */
+int galois_set_simd(int simd)
+{
+    if (simd < GF_SIMD_AUTO || simd >= GF_SIMD_NUM)
+        return -1;
+    pthread_mutex_lock(&gf_fields_lock);
+    gf_simd_pinned = simd;
+    select_simd(simd);
+    gf_simd_selected = 1;
+    pthread_mutex_unlock(&gf_fields_lock);
     return 0;
 }
 
-static int galois_create_log_table()
+int galois_get_simd()
+{
+    return gf_simd;
+}
+
+const char *galois_simd_name(int simd)
+{
+    if (simd < 0 || simd >= GF_SIMD_NUM)
+        return "auto";
+    return region_kernels[simd].name;
+}
+
+static int galois_create_log_table(struct gf_field *gf)
 {
     int j, b;
-    int m = GF_POWER;
+    int m = gf->power;
+    GF_WORD *galois_log_table  = gf->log_table;
+    GF_WORD *galois_ilog_table = gf->ilog_table;
 
     int gf_poly;
-    if (GF_POWER==2)
+    if (m==2)
         gf_poly = primitive_poly_2;
-    if (GF_POWER==3)
+    if (m==3)
         gf_poly = primitive_poly_3;
-    if (GF_POWER==4)
+    if (m==4)
         gf_poly = primitive_poly_4;
-    if (GF_POWER==5)
+    if (m==5)
         gf_poly = primitive_poly_5;
-    if (GF_POWER==6)
+    if (m==6)
         gf_poly = primitive_poly_6;
-    if (GF_POWER==7)
+    if (m==7)
         gf_poly = primitive_poly_7;
-    if (GF_POWER==8)
+    if (m==8)
         gf_poly = primitive_poly_8;
+    if (m==16)
+        gf_poly = primitive_poly_16;
 
-    int nw      =  1 << GF_POWER;
-    int nwml    = (1 << GF_POWER) - 1;
+    int nw      =  1 << m;
+    int nwml    = (1 << m) - 1;
 
     for (j=0; j<nw; j++) {
         galois_log_table[j] = nwml;
@@ -142,13 +449,18 @@ static int galois_create_log_table()
     return 0;
 }
 
-static int galois_create_mult_table()
+static int galois_create_mult_table(struct gf_field *gf)
 {
     int j, x, y, logx;
-    int nw = (1<<GF_POWER);
+    int m = gf->power;
+    int nw = (1<<m);
+    GF_WORD    *galois_log_table  = gf->log_table;
+    GF_WORD    *galois_ilog_table = gf->ilog_table;
+    GF_ELEMENT *galois_mult_table = gf->mult_table;
+    GF_ELEMENT *galois_divi_table = gf->divi_table;
 
     // create tables
-    if (galois_create_log_table() < 0) {
+    if (galois_create_log_table(gf) < 0) {
         fprintf(stderr, "create log/ilog tables failed\n");
         return -1;
     }
@@ -173,13 +485,13 @@ static int galois_create_mult_table()
         for (y=1; y<nw; y++) {  /* y > 0 */
             int tmp;
             tmp = logx + galois_log_table[y];
-            if (tmp >= ((1<<GF_POWER) - 1))
-                tmp -= ((1<<GF_POWER) - 1);             // avoid cross the boundary of log/ilog tables
+            if (tmp >= ((1<<m) - 1))
+                tmp -= ((1<<m) - 1);             // avoid cross the boundary of log/ilog tables
             galois_mult_table[j] = galois_ilog_table[tmp];
 
             tmp = logx - galois_log_table[y];
             while (tmp < 0)
-                tmp += ((1<<GF_POWER) - 1);
+                tmp += ((1<<m) - 1);
             galois_divi_table[j] = galois_ilog_table[tmp];
 
             j++;
@@ -189,18 +501,58 @@ static int galois_create_mult_table()
     return 0;
 }
 
+/*
+ * Product of multiplier c with a byte b. If packed, b holds 8/power
+ * elements (power = 2 or 4), otherwise b is one element.
+ */
+static uint8_t byte_product(const struct gf_field *gf, int c, int b, int packed)
+{
+    int m = gf->power;
+    if (!packed)
+        return b < (1<<m) ? gf->mult_table[(b<<m) | c] : 0;
+    int mask = (1<<m) - 1;
+    uint8_t r = 0;
+    for (int h=0; h<8; h+=m)
+        r |= gf->mult_table[(((b>>h) & mask)<<m) | c] << h;
+    return r;
+}
+
+static void galois_create_mult_const(struct gf_field *gf, struct gf_mult_const *mc, int packed)
+{
+    int c, x, i, k;
+    for (c=0; c<(1<<gf->power); c++) {
+        for (x=0; x<16; x++) {
+            mc[c].lo[x] = byte_product(gf, c, x, packed);
+            mc[c].hi[x] = byte_product(gf, c, x<<4, packed);
+        }
+        /*
+         * gf2p8affineqb computes bit i of the product as parity(b & A.byte[7-i]),
+         * so byte 7-i of A collects bit i of the products of the unit bytes 1<<k.
+         */
+        uint64_t A = 0;
+        for (k=0; k<8; k++) {
+            uint8_t col = byte_product(gf, c, 1<<k, packed);
+            for (i=0; i<8; i++) {
+                if (col & (1<<i))
+                    A |= (uint64_t) 1 << ((7-i)*8 + k);
+            }
+        }
+        mc[c].affine = A;
+    }
+}
+
 // add operation over GF(2^m)
-inline GF_ELEMENT galois_add(GF_ELEMENT a, GF_ELEMENT b)
+inline GF_WORD galois_add(GF_WORD a, GF_WORD b)
 {
     return a ^ b;
 }
 
-inline GF_ELEMENT galois_sub(GF_ELEMENT a, GF_ELEMENT b)
+inline GF_WORD galois_sub(GF_WORD a, GF_WORD b)
 {
     return a ^ b;
 }
 
-inline GF_ELEMENT galois_multiply(GF_ELEMENT a, GF_ELEMENT b)
+inline GF_WORD galois_multiply(const struct gf_field *gf, GF_WORD a, GF_WORD b)
 {
     if (a ==0 || b== 0)
         return 0;
@@ -210,12 +562,16 @@ inline GF_ELEMENT galois_multiply(GF_ELEMENT a, GF_ELEMENT b)
     else if (b == 1)
         return a;
 
-    GF_ELEMENT result = galois_mult_table[(a<<GF_POWER) | b];
+    if (gf->power == 16) {
+        int l = gf->log_table[a] + gf->log_table[b];
+        return gf->ilog_table[l >= 0xffff ? l - 0xffff : l];
+    }
+    GF_ELEMENT result = gf->mult_table[(a<<gf->power) | b];
     return result;
 }
 
 // return a/b
-inline GF_ELEMENT galois_divide(GF_ELEMENT a, GF_ELEMENT b)
+inline GF_WORD galois_divide(const struct gf_field *gf, GF_WORD a, GF_WORD b)
 {
     if (b == 0) {
         fprintf(stderr, "ERROR! Divide by ZERO!\n");
@@ -228,260 +584,1365 @@ inline GF_ELEMENT galois_divide(GF_ELEMENT a, GF_ELEMENT b)
     if (b == 1)
         return a;
 
-    GF_ELEMENT result =  galois_divi_table[(a<<GF_POWER) | b];
+    if (gf->power == 16) {
+        int l = gf->log_table[a] - gf->log_table[b];
+        return gf->ilog_table[l < 0 ? l + 0xffff : l];
+    }
+    GF_ELEMENT result =  gf->divi_table[(a<<gf->power) | b];
     return result;
 }
 
 /*
- * When SSE is enabled, use SSE instructions to do multiply_add_region
+ * The products of c and the bits x^0,...,x^15 are obtained by shifting
+ * and reducing c, and the product of a nibble is the XOR of those of its
+ * bits.
  */
-void galois_multiply_add_region(uint8_t *dst, uint8_t *src, uint8_t multiplier, int bytes)
+static void create_mult_const16(GF_WORD c, struct gf_mult_const16 *mc)
+{
+    GF_WORD cb[16];
+    GF_WORD r[16];
+    int b, k, x;
+    cb[0] = c;
+    for (b=1; b<16; b++)
+        cb[b] = (cb[b-1] & 0x8000) ? ((cb[b-1] << 1) ^ primitive_poly_16) & 0xffff : cb[b-1] << 1;
+    for (k=0; k<4; k++) {
+        r[0] = 0;
+        for (b=0; b<4; b++) {
+            for (x=0; x<(1<<b); x++)
+                r[x | (1<<b)] = r[x] ^ cb[4*k+b];
+        }
+        for (x=0; x<16; x++) {
+            mc->lo[k][x] = r[x] & 0xff;
+            mc->hi[k][x] = r[x] >> 8;
+        }
+    }
+}
+
+void galois_multiply_add_region(const struct gf_field *gf, uint8_t *dst, uint8_t *src, GF_WORD multiplier, int bytes)
 {
     if (multiplier == 0) {
         // add nothing to bytes starting from *dst, just return
         return;
     }
-    int i;
-#if defined(INTEL_SSSE3)
-    // if gf_power is 1 or 8, use SIMD to accelerate table look-up
-    if (GF_POWER == 1 || GF_POWER == 8) {
-        uint8_t *sptr, *dptr, *top;
-        sptr = src;
-        dptr = dst;
-        top  = src + bytes;
-
-        uint8_t *bh, *bl;
-        __m128i mth, mtl, loset;
-#if defined(INTEL_AVX2)
-        __m256i mth2, mtl2, loset2;
-#endif  // ifdef(INTEL_AVX2)
-        if (multiplier != 1) {
-            /* half tables only needed for multiplier != 1 */
-            bh = (uint8_t*) galois_half_mult_table_high;
-            bh += (multiplier << 4);
-            bl = (uint8_t*) galois_half_mult_table_low;
-            bl += (multiplier << 4);
-            // read split tables as 128-bit values
-            mth = _mm_loadu_si128((__m128i *)(bh));
-            mtl = _mm_loadu_si128((__m128i *)(bl));
-#if defined(INTEL_AVX2)
-            mtl2 = _mm256_broadcastsi128_si256 (mtl);
-            mth2 = _mm256_broadcastsi128_si256 (mth);
-            loset2 = _mm256_set1_epi8 (0x0f);
-#else
-            loset = _mm_set1_epi8(0x0f);
-#endif  // ifdef(INTEL_AVX2)
+    int aligned = REGION_IS_ALIGNED(dst, src, bytes);
+    if (multiplier == 1) {
+        if (aligned)
+            region_kernels[gf_simd].add_region_aligned(dst, src, bytes);
+        else
+            region_kernels[gf_simd].add_region(dst, src, bytes);
+    } else if (gf->power == 16) {
+        struct gf_mult_const16 mc;
+        create_mult_const16(multiplier, &mc);
+        region_kernels[gf_simd].multiply_add_region16(dst, src, &mc, bytes);
+    } else if (aligned) {
+        region_kernels[gf_simd].multiply_add_region_aligned(dst, src, &gf->mult_const[multiplier], bytes);
+    } else {
+        region_kernels[gf_simd].multiply_add_region(dst, src, &gf->mult_const[multiplier], bytes);
+    }
+}
+
+/*
+ * Muliply a region of elements with multiplier.
+ */
+void galois_multiply_region(const struct gf_field *gf, uint8_t *src, GF_WORD multiplier, int bytes)
+{
+    if (multiplier == 0) {
+        memset(src, 0, sizeof(uint8_t)*bytes);
+        return;
+    } else if (multiplier == 1) {
+        return;
+    }
+    if (gf->power == 16) {
+        struct gf_mult_const16 mc;
+        create_mult_const16(multiplier, &mc);
+        region_kernels[gf_simd].multiply_region16(src, &mc, bytes);
+        return;
+    }
+    region_kernels[gf_simd].multiply_region(src, &gf->mult_const[multiplier], bytes);
+}
+
+/*
+ * dst += sum(coefs[i] * srcs[i]) for i=0,...,n-1. Instead of calling
+ * multiply_add_region n times, the kernels go through the region tile by
+ * tile and accumulate the products of all sources in registers, so that
+ * dst is loaded and stored only once. Zero coefficients are skipped.
+ * coefs is an element array of the field (see gf_get_element()).
+ */
+#define GF_MULTI_CHUNK  64
+static void multiply_add_region_multi(uint8_t *dst, uint8_t **srcs, uint8_t *coefs, int n, int bytes, const struct gf_mult_const *mct)
+{
+    uint8_t *s[GF_MULTI_CHUNK];
+    const struct gf_mult_const *mc[GF_MULTI_CHUNK];
+    int i, k = 0;
+    for (i=0; i<n; i++) {
+        if (coefs[i] == 0)
+            continue;
+        s[k]  = srcs[i];
+        mc[k] = coefs[i] == 1 ? NULL : &mct[coefs[i]];
+        if (++k == GF_MULTI_CHUNK) {
+            region_kernels[gf_simd].multiply_add_region_multi(dst, s, mc, k, bytes);
+            k = 0;
         }
+    }
+    if (k > 0)
+        region_kernels[gf_simd].multiply_add_region_multi(dst, s, mc, k, bytes);
+}
 
-        __m128i va, vb, r, t1, r2;
-        while (sptr < top)
-        {
-#if defined(INTEL_AVX2)
-            if (sptr + 32 > top) {
-                /* remaining data doesn't fit into __m256i, do not use AVX2 */
-                for (i=0; i<top-sptr; i++) {
-                    if (multiplier == 1)
-                        *(dptr+i) ^= *(sptr+i);
-                    else
-                        *(dptr+i) ^= galois_mult_table[((*(sptr+i))<<GF_POWER) | multiplier];
-                }
-                break;
-            }
-#else
-            if (sptr + 16 > top) {
-                /* remaining data doesn't fit into __m128i, do not use SSE */
-                for (i=0; i<top-sptr; i++) {
-                    if (multiplier == 1)
-                        *(dptr+i) ^= *(sptr+i);
-                    else
-                        *(dptr+i) ^= galois_mult_table[((*(sptr+i))<<GF_POWER) | multiplier];
-                }
-                break;
-            }
-#endif  // ifdef(INTEL_AVX2)
-#if defined(INTEL_AVX2)
-            __m256i vaa, vbb, rr, tt1, rr2;
-            vaa = _mm256_loadu_si256 ((__m256i *)(sptr));
-            if (multiplier == 1) {
-                vbb = _mm256_loadu_si256 ((__m256i *)(dptr));
-                vbb = _mm256_xor_si256(vaa, vbb);
-                _mm256_storeu_si256 ((__m256i *)(dptr), vbb);
-            } else {
-                // use half tables
-                tt1 = _mm256_and_si256 (loset2, vaa);
-                rr  = _mm256_shuffle_epi8 (mtl2, tt1);
-                vaa = _mm256_srli_epi64 (vaa, 4);
-                tt1 = _mm256_and_si256 (loset2, vaa);
-                rr2 = _mm256_shuffle_epi8 (mth2, tt1);
-                rr  = _mm256_xor_si256 (rr, rr2);
-                vaa = _mm256_loadu_si256 ((__m256i *)(dptr));
-                rr  = _mm256_xor_si256 (rr, vaa);
-                _mm256_storeu_si256 ((__m256i *)(dptr), rr);
-            }
-            dptr += 32;
-            sptr += 32;
-#else
-            va = _mm_loadu_si128 ((__m128i *)(sptr));
-            if (multiplier == 1) {
-                /* just XOR */
-                vb = _mm_loadu_si128 ((__m128i *)(dptr));
-                vb = _mm_xor_si128(va, vb);
-                _mm_storeu_si128 ((__m128i *)(dptr), vb);
-            } else {
-                /* use half tables */
-                t1 = _mm_and_si128 (loset, va);    // obtain lower 4-bit of the 16 src elements
-                r  = _mm_shuffle_epi8 (mtl, t1);    // obtain products of the lower 4-bit 
-                va = _mm_srli_epi64 (va, 4);       // shift the bits of the 16 src elements to right
-                t1 = _mm_and_si128 (loset, va);    // obtain higher 4-bit of the src elements
-                r2 = _mm_shuffle_epi8 (mth, t1);   // obtain products of the higher 4-bit
-                r  = _mm_xor_si128 (r, r2);         // obtain final result of src * multiplier
-                //r = _mm_xor_si128 (r, _mm_shuffle_epi8 (mth, t1));
-                va = _mm_loadu_si128 ((__m128i *)(dptr));
-                r = _mm_xor_si128 (r, va);
-                _mm_storeu_si128 ((__m128i *)(dptr), r);
-            }
-            dptr += 16;
-            sptr += 16;
-#endif  // ifdef(INTEL_AVX2)
+/*
+ * d[k] += c[k] * s[k] for k=0,...,n-1 over GF(2^16), tile by tile, so that
+ * a tile shared by all of them (dst of multi, src of scatter) stays in L1.
+ */
+#define GF_MULTI16_TILE 4096
+static void multiply_add_region16_tiled(uint8_t **d, uint8_t **s, const GF_WORD *c, const struct gf_mult_const16 *mc, int n, int bytes)
+{
+    int pos, len, k;
+    for (pos=0; pos<bytes; pos+=len) {
+        len = bytes - pos < GF_MULTI16_TILE ? bytes - pos : GF_MULTI16_TILE;
+        for (k=0; k<n; k++) {
+            if (c[k] == 1)
+                region_kernels[gf_simd].add_region(d[k]+pos, s[k]+pos, len);
+            else
+                region_kernels[gf_simd].multiply_add_region16(d[k]+pos, s[k]+pos, &mc[k], len);
         }
-        return;
-    } else {
-            // SSE is supported, but the Galois field power is not 1 or 8. SIMD is not supported for other GF sizes right now.
-        if (multiplier == 1) {
-            for (i=0; i<bytes; i++)
-                dst[i] ^= src[i];
-            return;
+    }
+}
+
+/*
+ * GF(2^16) multi (dsts == NULL) and scatter (srcs == NULL) regions. The
+ * tables of a chunk of coefficients are built once per call.
+ */
+static void multiply_add_region16_multi(uint8_t *dst, uint8_t **dsts, uint8_t *src, uint8_t **srcs, uint8_t *coefs, int n, int bytes)
+{
+    uint8_t *d[GF_MULTI_CHUNK];
+    uint8_t *s[GF_MULTI_CHUNK];
+    GF_WORD c[GF_MULTI_CHUNK];
+    struct gf_mult_const16 mc[GF_MULTI_CHUNK];
+    int i, k = 0;
+    for (i=0; i<n; i++) {
+        if ((c[k] = gf_get_element(coefs, i, 2)) == 0)
+            continue;
+        d[k] = dsts != NULL ? dsts[i] : dst;
+        s[k] = srcs != NULL ? srcs[i] : src;
+        if (c[k] != 1)
+            create_mult_const16(c[k], &mc[k]);
+        if (++k == GF_MULTI_CHUNK) {
+            multiply_add_region16_tiled(d, s, c, mc, k, bytes);
+            k = 0;
         }
+    }
+    if (k > 0)
+        multiply_add_region16_tiled(d, s, c, mc, k, bytes);
+}
 
-        for (i = 0; i < bytes; i++)
-            dst[i] ^= galois_mult_table[(src[i]<<GF_POWER) | multiplier];
+void galois_multiply_add_region_multi(const struct gf_field *gf, uint8_t *dst, uint8_t **srcs, uint8_t *coefs, int n, int bytes)
+{
+    if (gf->power == 16) {
+        multiply_add_region16_multi(dst, NULL, NULL, srcs, coefs, n, bytes);
         return;
     }
-#else  // if not defined INTEL_SSSE3
-    if (multiplier == 1) {
-        for (i=0; i<bytes; i++)
-            dst[i] ^= src[i];
+    multiply_add_region_multi(dst, srcs, coefs, n, bytes, gf->mult_const);
+}
+
+/*
+ * dsts[i] += coefs[i] * src for i=0,...,n-1, e.g., eliminating a pivot row
+ * from the rows above it. The kernels read a tile of src into registers
+ * (and split it into nibbles) once, then update the tile of every dst.
+ */
+void galois_multiply_add_region_scatter(const struct gf_field *gf, uint8_t **dsts, uint8_t *src, uint8_t *coefs, int n, int bytes)
+{
+    uint8_t *d[GF_MULTI_CHUNK];
+    const struct gf_mult_const *mc[GF_MULTI_CHUNK];
+    int i, k = 0;
+    if (gf->power == 16) {
+        multiply_add_region16_multi(NULL, dsts, src, NULL, coefs, n, bytes);
         return;
     }
+    for (i=0; i<n; i++) {
+        if (coefs[i] == 0)
+            continue;
+        d[k]  = dsts[i];
+        mc[k] = coefs[i] == 1 ? NULL : &gf->mult_const[coefs[i]];
+        if (++k == GF_MULTI_CHUNK) {
+            region_kernels[gf_simd].multiply_add_region_scatter(d, src, mc, k, bytes);
+            k = 0;
+        }
+    }
+    if (k > 0)
+        region_kernels[gf_simd].multiply_add_region_scatter(d, src, mc, k, bytes);
+}
+
+static inline uint64_t load_be64(const uint8_t *p)
+{
+    uint64_t w = 0;
+    for (int i=0; i<8; i++)
+        w = (w << 8) | p[i];
+    return w;
+}
 
-    for (i = 0; i < bytes; i++)
-        dst[i] ^= galois_mult_table[(src[i]<<GF_POWER) | multiplier];
-    return;
-#endif  // ifdef(INTEL_SSSE3)
+static inline void store_be64(uint8_t *p, uint64_t w)
+{
+    for (int i=7; i>=0; i--) {
+        p[i] = w & 0xff;
+        w >>= 8;
+    }
 }
 
 /*
- * Muliply a region of elements with multiplier. When SSE is available, use it
+ * Bit-sliced multiply-add for GF(8), GF(32), GF(64), GF(128) elements packed
+ * in a bit stream (MSB first). A block of m 64-bit words holds exactly
+ * 64 elements. Bit k of an input element contributes to bit i of the product
+ * iff bit i of c*2^k is set, which moves the bit by s=k-i positions in the
+ * stream. For each shift s a mask selects the input bits that move by s, so
+ * a block costs 2*m-1 masked funnel shifts per word.
  */
-void galois_multiply_region(uint8_t *src, uint8_t multiplier, int bytes)
+static void multiply_add_region_bitsliced(const struct gf_field *gf, uint8_t *dst, uint8_t *src, uint8_t multiplier, int bytes)
 {
-    if (multiplier == 0) {
-        memset(src, 0, sizeof(uint8_t)*bytes);
-        return;
-    } else if (multiplier == 1) {
-        return;
+    int m = gf->power;
+    int nshift = 2 * m - 1;
+    uint64_t mask[2*8-1][8];
+    uint8_t col[8];
+    int i, k, s, w, p;
+
+    for (k=0; k<m; k++)
+        col[k] = gf->mult_table[((1<<k)<<m) | multiplier];
+    memset(mask, 0, sizeof(mask));
+    for (p=0; p<64*m; p++) {
+        k = m - 1 - p % m;              // bit position of stream bit p in its element (0 is LSB)
+        for (i=0; i<m; i++) {
+            if (col[k] & (1<<i))
+                mask[k-i+m-1][p/64] |= (uint64_t) 1 << (63 - p % 64);
+        }
     }
-#if defined(INTEL_SSSE3)
-    if (GF_POWER == 1 || GF_POWER == 8) {
-        uint8_t *sptr, *top;
-        sptr = src;
-        top  = src + bytes;
-
-        uint8_t *bh, *bl;
-        /* half tables only needed for multiplier != 1 */
-        bh = (uint8_t*) galois_half_mult_table_high;
-        bh += (multiplier << 4);
-        bl = (uint8_t*) galois_half_mult_table_low;
-        bl += (multiplier << 4);
-        // read split tables as 128-bit values
-        __m128i mth = _mm_loadu_si128((__m128i *)(bh));
-        __m128i mtl = _mm_loadu_si128((__m128i *)(bl));
-        __m128i loset = _mm_set1_epi8(0x0f);
-#if defined(INTEL_AVX2)
-        __m256i mtl2 = _mm256_broadcastsi128_si256 (mtl);
-        __m256i mth2 = _mm256_broadcastsi128_si256 (mth);
-        __m256i loset2 = _mm256_set1_epi8 (0x0f);
-        __m256i vaa, rr, tt1, rr2;
-#endif
 
-        __m128i va, r, t1;
-        while (sptr < top)
-        {
-#if defined(INTEL_AVX2)
-            if (sptr + 32 > top) {
-                /* remaining data doesn't fit into __m128i, do not use SSE */
-                for (int i=0; i<top-sptr; i++)
-                    *(sptr+i) = galois_mult_table[((*(sptr+i))<<GF_POWER) | multiplier];
-                break;
-            }
-            vaa = _mm256_loadu_si256 ((__m256i *)(sptr));
-            tt1 = _mm256_and_si256 (loset2, vaa);
-            rr  = _mm256_shuffle_epi8 (mtl2, tt1);
-            vaa = _mm256_srli_epi64 (vaa, 4);
-            tt1 = _mm256_and_si256 (loset2, vaa);
-            rr2 = _mm256_shuffle_epi8 (mth2, tt1);
-            rr  = _mm256_xor_si256 (rr, rr2);
-            _mm256_storeu_si256 ((__m256i *)(sptr), rr);
-            sptr += 32;
-#else
-            if (sptr + 16 > top) {
-                /* remaining data doesn't fit into __m128i, do not use SSE */
-                for (int i=0; i<top-sptr; i++)
-                    *(sptr+i) = galois_mult_table[((*(sptr+i))<<GF_POWER) | multiplier];
-                break;
+    int blksize = 8 * m;
+    uint8_t sbuf[64], dbuf[64];
+    uint64_t x[8], y[8], r[8];
+    for (int pos=0; pos<bytes; pos+=blksize) {
+        uint8_t *sp = src + pos;
+        uint8_t *dp = dst + pos;
+        int len = bytes - pos < blksize ? bytes - pos : blksize;
+        if (len < blksize) {
+            // Left-over bytes are zero-padded to a full block
+            memset(sbuf, 0, blksize);
+            memset(dbuf, 0, blksize);
+            memcpy(sbuf, sp, len);
+            memcpy(dbuf, dp, len);
+            sp = sbuf;
+            dp = dbuf;
+        }
+        for (w=0; w<m; w++) {
+            x[w] = load_be64(sp + 8*w);
+            r[w] = load_be64(dp + 8*w);
+        }
+        for (s=0; s<nshift; s++) {
+            int d = s - (m - 1);
+            for (w=0; w<m; w++)
+                y[w] = x[w] & mask[s][w];
+            if (d == 0) {
+                for (w=0; w<m; w++)
+                    r[w] ^= y[w];
+            } else if (d > 0) {
+                r[0] ^= y[0] >> d;
+                for (w=1; w<m; w++)
+                    r[w] ^= (y[w] >> d) | (y[w-1] << (64 - d));
+            } else {
+                for (w=0; w<m-1; w++)
+                    r[w] ^= (y[w] << -d) | (y[w+1] >> (64 + d));
+                r[m-1] ^= y[m-1] << -d;
             }
-            va = _mm_loadu_si128 ((__m128i *)(sptr));
-            t1 = _mm_and_si128 (loset, va);
-            r = _mm_shuffle_epi8 (mtl, t1);
-            va = _mm_srli_epi64 (va, 4);
-            t1 = _mm_and_si128 (loset, va);
-            r = _mm_xor_si128 (r, _mm_shuffle_epi8 (mth, t1));
-            _mm_storeu_si128 ((__m128i *)(sptr), r);
-            sptr += 16;
-#endif
         }
+        for (w=0; w<m; w++)
+            store_be64(dp + 8*w, r[w]);
+        if (len < blksize)
+            memcpy(dst + pos, dbuf, len);
+    }
+}
+
+/*
+ * Multiply-add a region of bytes packed with GF(2^m) elements, i.e., 8/m
+ * elements per byte if m divides 8, or a bit stream of elements otherwise.
+ * A partial element at the end of the region is treated as if its missing
+ * lower bits were zeros.
+ */
+void galois_multiply_add_region_packed(const struct gf_field *gf, uint8_t *dst, uint8_t *src, GF_WORD multiplier, int bytes)
+{
+    if (multiplier == 0)
         return;
-    } else {
-        for (int i=0; i<bytes; i++)
-            src[i] = galois_mult_table[((src[i])<<GF_POWER) | multiplier];
+    if (multiplier == 1) {
+        region_kernels[gf_simd].add_region(dst, src, bytes);
         return;
     }
-#else
+    switch (gf->power) {
+    case 8:
+    case 16:
+        galois_multiply_add_region(gf, dst, src, multiplier, bytes);
+        break;
+    case 2:
+    case 4:
+        region_kernels[gf_simd].multiply_add_region(dst, src, &gf->packed_mult_const[multiplier], bytes);
+        break;
+    default:
+        multiply_add_region_bitsliced(gf, dst, src, multiplier, bytes);
+        break;
+    }
+}
+
+void galois_multiply_add_region_multi_packed(const struct gf_field *gf, uint8_t *dst, uint8_t **srcs, uint8_t *coefs, int n, int bytes)
+{
+    switch (gf->power) {
+    case 1:
+    case 8:
+    case 16:
+        galois_multiply_add_region_multi(gf, dst, srcs, coefs, n, bytes);
+        break;
+    case 2:
+    case 4:
+        multiply_add_region_multi(dst, srcs, coefs, n, bytes, gf->packed_mult_const);
+        break;
+    default:
+        for (int i=0; i<n; i++)
+            galois_multiply_add_region_packed(gf, dst, srcs[i], coefs[i], bytes);
+        break;
+    }
+}
+
+static void add_region_scalar(uint8_t *dst, uint8_t *src, int bytes)
+{
     for (int i=0; i<bytes; i++)
-        src[i] = galois_mult_table[((src[i])<<GF_POWER) | multiplier];
-    return;
-#endif
+        dst[i] ^= src[i];
+}
+
+static void multiply_add_region_scalar(uint8_t *dst, uint8_t *src, const struct gf_mult_const *mc, int bytes)
+{
+    for (int i=0; i<bytes; i++)
+        dst[i] ^= mc->lo[src[i] & 0x0f] ^ mc->hi[src[i] >> 4];
+}
+
+static void multiply_region_scalar(uint8_t *src, const struct gf_mult_const *mc, int bytes)
+{
+    for (int i=0; i<bytes; i++)
+        src[i] = mc->lo[src[i] & 0x0f] ^ mc->hi[src[i] >> 4];
+}
+
+static inline GF_WORD mult16_scalar(const struct gf_mult_const16 *mc, int v)
+{
+    int lo = mc->lo[0][v & 0x0f] ^ mc->lo[1][(v >> 4) & 0x0f] ^ mc->lo[2][(v >> 8) & 0x0f] ^ mc->lo[3][v >> 12];
+    int hi = mc->hi[0][v & 0x0f] ^ mc->hi[1][(v >> 4) & 0x0f] ^ mc->hi[2][(v >> 8) & 0x0f] ^ mc->hi[3][v >> 12];
+    return hi << 8 | lo;
 }
 
 /*
-void galois_multiply_add_region(GF_ELEMENT *dst, GF_ELEMENT *src, GF_ELEMENT multiplier, int bytes)
+ * An odd byte at the end of a GF(2^16) region is the high byte of an element
+ * whose low byte is zero.
+ */
+static void multiply_add_region16_scalar(uint8_t *dst, uint8_t *src, const struct gf_mult_const16 *mc, int bytes)
 {
-    if (multiplier == 0) {
-        // add nothing to bytes starting from *dst, just return
-        return;
+    int i;
+    for (i=0; i+2<=bytes; i+=2) {
+        GF_WORD r = mult16_scalar(mc, src[i] << 8 | src[i+1]);
+        dst[i]   ^= r >> 8;
+        dst[i+1] ^= r & 0xff;
     }
+    if (i < bytes)
+        dst[i] ^= mult16_scalar(mc, src[i] << 8) >> 8;
+}
+
+static void multiply_region16_scalar(uint8_t *src, const struct gf_mult_const16 *mc, int bytes)
+{
     int i;
-    if (multiplier == 1) {
-        for (i=0; i<bytes; i++)
-            dst[i] ^= src[i];
-        return;
+    for (i=0; i+2<=bytes; i+=2) {
+        GF_WORD r = mult16_scalar(mc, src[i] << 8 | src[i+1]);
+        src[i]   = r >> 8;
+        src[i+1] = r & 0xff;
     }
+    if (i < bytes)
+        src[i] = mult16_scalar(mc, src[i] << 8) >> 8;
+}
 
-    for (i = 0; i < bytes; i++)
-        dst[i] ^= galois_mult_table[(src[i]<<GF_POWER) | multiplier];
-    return;
+static void multiply_add_region_multi_scalar(uint8_t *dst, uint8_t **srcs, const struct gf_mult_const **mcs, int n, int bytes)
+{
+    uint8_t acc[64];
+    int pos, len, i, k;
+    for (pos=0; pos<bytes; pos+=len) {
+        len = bytes - pos < 64 ? bytes - pos : 64;
+        memcpy(acc, dst+pos, len);
+        for (k=0; k<n; k++) {
+            uint8_t *sp = srcs[k] + pos;
+            const struct gf_mult_const *mc = mcs[k];
+            if (mc == NULL) {
+                for (i=0; i<len; i++)
+                    acc[i] ^= sp[i];
+            } else {
+                for (i=0; i<len; i++)
+                    acc[i] ^= mc->lo[sp[i] & 0x0f] ^ mc->hi[sp[i] >> 4];
+            }
+        }
+        memcpy(dst+pos, acc, len);
+    }
 }
 
-void galois_multiply_region(GF_ELEMENT *src, GF_ELEMENT multiplier, int bytes)
+/*
+ * The scalar kernel keeps a cache-sized tile of src hot while it goes
+ * through the destinations.
+ */
+#define GF_SCATTER_TILE 4096
+static void multiply_add_region_scatter_scalar(uint8_t **dsts, uint8_t *src, const struct gf_mult_const **mcs, int n, int bytes)
 {
-    if (multiplier == 0) {
-        memset(src, 0, sizeof(GF_ELEMENT)*bytes);
+    int pos, len, k;
+    for (pos=0; pos<bytes; pos+=len) {
+        len = bytes - pos < GF_SCATTER_TILE ? bytes - pos : GF_SCATTER_TILE;
+        for (k=0; k<n; k++) {
+            if (mcs[k] == NULL)
+                add_region_scalar(dsts[k]+pos, src+pos, len);
+            else
+                multiply_add_region_scalar(dsts[k]+pos, src+pos, mcs[k], len);
+        }
+    }
+}
+
+/*
+ * Bytes of a multi-source region after the last full tile of a SIMD kernel
+ */
+static void multiply_add_region_multi_tail(const struct gf_region_kernels *kn, uint8_t *dst, uint8_t **srcs, const struct gf_mult_const **mcs, int n, int pos, int bytes)
+{
+    if (pos >= bytes)
         return;
-    } else if (multiplier == 1) {
+    for (int k=0; k<n; k++) {
+        if (mcs[k] == NULL)
+            kn->add_region(dst+pos, srcs[k]+pos, bytes-pos);
+        else
+            kn->multiply_add_region(dst+pos, srcs[k]+pos, mcs[k], bytes-pos);
+    }
+}
+
+static void multiply_add_region_scatter_tail(const struct gf_region_kernels *kn, uint8_t **dsts, uint8_t *src, const struct gf_mult_const **mcs, int n, int pos, int bytes)
+{
+    if (pos >= bytes)
         return;
+    for (int k=0; k<n; k++) {
+        if (mcs[k] == NULL)
+            kn->add_region(dsts[k]+pos, src+pos, bytes-pos);
+        else
+            kn->multiply_add_region(dsts[k]+pos, src+pos, mcs[k], bytes-pos);
     }
-    for (int i=0; i<bytes; i++)
-        src[i] = galois_mult_table[((src[i])<<GF_POWER) | multiplier];
-    return;
 }
-*/
+
+#if defined(GALOIS_X86)
+/*
+ * Products are looked up 16 elements at a time from the two nibble tables
+ * via pshufb; the remaining data not filling a vector register goes to the
+ * scalar kernel.
+ */
+TARGET_SSSE3
+static void add_region_ssse3(uint8_t *dst, uint8_t *src, int bytes)
+{
+    uint8_t *sptr = src;
+    uint8_t *dptr = dst;
+    uint8_t *top  = src + bytes;
+    __m128i va, vb;
+    for (; sptr + 16 <= top; sptr += 16, dptr += 16) {
+        va = _mm_loadu_si128 ((__m128i *)(sptr));
+        vb = _mm_loadu_si128 ((__m128i *)(dptr));
+        vb = _mm_xor_si128(va, vb);
+        _mm_storeu_si128 ((__m128i *)(dptr), vb);
+    }
+    add_region_scalar(dptr, sptr, top - sptr);
+}
+
+TARGET_SSSE3
+static void multiply_add_region_ssse3(uint8_t *dst, uint8_t *src, const struct gf_mult_const *mc, int bytes)
+{
+    uint8_t *sptr = src;
+    uint8_t *dptr = dst;
+    uint8_t *top  = src + bytes;
+    // read split tables as 128-bit values
+    __m128i mth   = _mm_loadu_si128((__m128i *)(mc->hi));
+    __m128i mtl   = _mm_loadu_si128((__m128i *)(mc->lo));
+    __m128i loset = _mm_set1_epi8(0x0f);
+    __m128i va, r, t1, r2;
+    for (; sptr + 16 <= top; sptr += 16, dptr += 16) {
+        va = _mm_loadu_si128 ((__m128i *)(sptr));
+        t1 = _mm_and_si128 (loset, va);    // obtain lower 4-bit of the 16 src elements
+        r  = _mm_shuffle_epi8 (mtl, t1);   // obtain products of the lower 4-bit
+        va = _mm_srli_epi64 (va, 4);       // shift the bits of the 16 src elements to right
+        t1 = _mm_and_si128 (loset, va);    // obtain higher 4-bit of the src elements
+        r2 = _mm_shuffle_epi8 (mth, t1);   // obtain products of the higher 4-bit
+        r  = _mm_xor_si128 (r, r2);        // obtain final result of src * multiplier
+        va = _mm_loadu_si128 ((__m128i *)(dptr));
+        r  = _mm_xor_si128 (r, va);
+        _mm_storeu_si128 ((__m128i *)(dptr), r);
+    }
+    multiply_add_region_scalar(dptr, sptr, mc, top - sptr);
+}
+
+TARGET_SSSE3
+static void multiply_region_ssse3(uint8_t *src, const struct gf_mult_const *mc, int bytes)
+{
+    uint8_t *sptr = src;
+    uint8_t *top  = src + bytes;
+    __m128i mth   = _mm_loadu_si128((__m128i *)(mc->hi));
+    __m128i mtl   = _mm_loadu_si128((__m128i *)(mc->lo));
+    __m128i loset = _mm_set1_epi8(0x0f);
+    __m128i va, r, t1;
+    for (; sptr + 16 <= top; sptr += 16) {
+        va = _mm_loadu_si128 ((__m128i *)(sptr));
+        t1 = _mm_and_si128 (loset, va);
+        r  = _mm_shuffle_epi8 (mtl, t1);
+        va = _mm_srli_epi64 (va, 4);
+        t1 = _mm_and_si128 (loset, va);
+        r  = _mm_xor_si128 (r, _mm_shuffle_epi8 (mth, t1));
+        _mm_storeu_si128 ((__m128i *)(sptr), r);
+    }
+    multiply_region_scalar(sptr, mc, top - sptr);
+}
+
+TARGET_AVX2
+static void add_region_avx2(uint8_t *dst, uint8_t *src, int bytes)
+{
+    uint8_t *sptr = src;
+    uint8_t *dptr = dst;
+    uint8_t *top  = src + bytes;
+    __m256i vaa, vbb;
+    for (; sptr + 32 <= top; sptr += 32, dptr += 32) {
+        vaa = _mm256_loadu_si256 ((__m256i *)(sptr));
+        vbb = _mm256_loadu_si256 ((__m256i *)(dptr));
+        vbb = _mm256_xor_si256(vaa, vbb);
+        _mm256_storeu_si256 ((__m256i *)(dptr), vbb);
+    }
+    add_region_scalar(dptr, sptr, top - sptr);
+}
+
+TARGET_AVX2
+static void multiply_add_region_avx2(uint8_t *dst, uint8_t *src, const struct gf_mult_const *mc, int bytes)
+{
+    uint8_t *sptr = src;
+    uint8_t *dptr = dst;
+    uint8_t *top  = src + bytes;
+    __m256i mth2   = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i *)(mc->hi)));
+    __m256i mtl2   = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i *)(mc->lo)));
+    __m256i loset2 = _mm256_set1_epi8 (0x0f);
+    __m256i vaa, rr, tt1, rr2;
+    for (; sptr + 32 <= top; sptr += 32, dptr += 32) {
+        vaa = _mm256_loadu_si256 ((__m256i *)(sptr));
+        tt1 = _mm256_and_si256 (loset2, vaa);
+        rr  = _mm256_shuffle_epi8 (mtl2, tt1);
+        vaa = _mm256_srli_epi64 (vaa, 4);
+        tt1 = _mm256_and_si256 (loset2, vaa);
+        rr2 = _mm256_shuffle_epi8 (mth2, tt1);
+        rr  = _mm256_xor_si256 (rr, rr2);
+        vaa = _mm256_loadu_si256 ((__m256i *)(dptr));
+        rr  = _mm256_xor_si256 (rr, vaa);
+        _mm256_storeu_si256 ((__m256i *)(dptr), rr);
+    }
+    multiply_add_region_scalar(dptr, sptr, mc, top - sptr);
+}
+
+TARGET_AVX2
+static void add_region_aligned_avx2(uint8_t *dst, uint8_t *src, int bytes)
+{
+    uint8_t *sptr = src;
+    uint8_t *dptr = dst;
+    uint8_t *top  = src + bytes;
+    __m256i vaa, vbb;
+    for (; sptr < top; sptr += 32, dptr += 32) {
+        vaa = _mm256_load_si256 ((__m256i *)(sptr));
+        vbb = _mm256_load_si256 ((__m256i *)(dptr));
+        _mm256_store_si256 ((__m256i *)(dptr), _mm256_xor_si256(vaa, vbb));
+    }
+}
+
+TARGET_AVX2
+static void multiply_add_region_aligned_avx2(uint8_t *dst, uint8_t *src, const struct gf_mult_const *mc, int bytes)
+{
+    uint8_t *sptr = src;
+    uint8_t *dptr = dst;
+    uint8_t *top  = src + bytes;
+    __m256i mth2   = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i *)(mc->hi)));
+    __m256i mtl2   = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i *)(mc->lo)));
+    __m256i loset2 = _mm256_set1_epi8 (0x0f);
+    __m256i vaa, rr, tt1, rr2;
+    for (; sptr < top; sptr += 32, dptr += 32) {
+        vaa = _mm256_load_si256 ((__m256i *)(sptr));
+        tt1 = _mm256_and_si256 (loset2, vaa);
+        rr  = _mm256_shuffle_epi8 (mtl2, tt1);
+        vaa = _mm256_srli_epi64 (vaa, 4);
+        tt1 = _mm256_and_si256 (loset2, vaa);
+        rr2 = _mm256_shuffle_epi8 (mth2, tt1);
+        rr  = _mm256_xor_si256 (rr, rr2);
+        vaa = _mm256_load_si256 ((__m256i *)(dptr));
+        _mm256_store_si256 ((__m256i *)(dptr), _mm256_xor_si256 (rr, vaa));
+    }
+}
+
+TARGET_AVX2
+static void multiply_region_avx2(uint8_t *src, const struct gf_mult_const *mc, int bytes)
+{
+    uint8_t *sptr = src;
+    uint8_t *top  = src + bytes;
+    __m256i mth2   = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i *)(mc->hi)));
+    __m256i mtl2   = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i *)(mc->lo)));
+    __m256i loset2 = _mm256_set1_epi8 (0x0f);
+    __m256i vaa, rr, tt1, rr2;
+    for (; sptr + 32 <= top; sptr += 32) {
+        vaa = _mm256_loadu_si256 ((__m256i *)(sptr));
+        tt1 = _mm256_and_si256 (loset2, vaa);
+        rr  = _mm256_shuffle_epi8 (mtl2, tt1);
+        vaa = _mm256_srli_epi64 (vaa, 4);
+        tt1 = _mm256_and_si256 (loset2, vaa);
+        rr2 = _mm256_shuffle_epi8 (mth2, tt1);
+        rr  = _mm256_xor_si256 (rr, rr2);
+        _mm256_storeu_si256 ((__m256i *)(sptr), rr);
+    }
+    multiply_region_scalar(sptr, mc, top - sptr);
+}
+
+TARGET_SSSE3
+static inline __m128i nibble_mul_ssse3(__m128i v, __m128i mtl, __m128i mth, __m128i loset)
+{
+    __m128i lo = _mm_shuffle_epi8 (mtl, _mm_and_si128 (loset, v));
+    __m128i hi = _mm_shuffle_epi8 (mth, _mm_and_si128 (loset, _mm_srli_epi64 (v, 4)));
+    return _mm_xor_si128 (lo, hi);
+}
+
+// Tile of 64 bytes in four 128-bit accumulators
+TARGET_SSSE3
+static void multiply_add_region_multi_ssse3(uint8_t *dst, uint8_t **srcs, const struct gf_mult_const **mcs, int n, int bytes)
+{
+    __m128i loset = _mm_set1_epi8(0x0f);
+    __m128i r0, r1, r2, r3, mtl, mth;
+    int pos, k;
+    for (pos=0; pos+64<=bytes; pos+=64) {
+        r0 = _mm_loadu_si128 ((__m128i *)(dst+pos));
+        r1 = _mm_loadu_si128 ((__m128i *)(dst+pos+16));
+        r2 = _mm_loadu_si128 ((__m128i *)(dst+pos+32));
+        r3 = _mm_loadu_si128 ((__m128i *)(dst+pos+48));
+        for (k=0; k<n; k++) {
+            uint8_t *sp = srcs[k] + pos;
+            __m128i v0 = _mm_loadu_si128 ((__m128i *)(sp));
+            __m128i v1 = _mm_loadu_si128 ((__m128i *)(sp+16));
+            __m128i v2 = _mm_loadu_si128 ((__m128i *)(sp+32));
+            __m128i v3 = _mm_loadu_si128 ((__m128i *)(sp+48));
+            if (mcs[k] != NULL) {
+                mtl = _mm_loadu_si128 ((__m128i *)(mcs[k]->lo));
+                mth = _mm_loadu_si128 ((__m128i *)(mcs[k]->hi));
+                v0 = nibble_mul_ssse3(v0, mtl, mth, loset);
+                v1 = nibble_mul_ssse3(v1, mtl, mth, loset);
+                v2 = nibble_mul_ssse3(v2, mtl, mth, loset);
+                v3 = nibble_mul_ssse3(v3, mtl, mth, loset);
+            }
+            r0 = _mm_xor_si128 (r0, v0);
+            r1 = _mm_xor_si128 (r1, v1);
+            r2 = _mm_xor_si128 (r2, v2);
+            r3 = _mm_xor_si128 (r3, v3);
+        }
+        _mm_storeu_si128 ((__m128i *)(dst+pos), r0);
+        _mm_storeu_si128 ((__m128i *)(dst+pos+16), r1);
+        _mm_storeu_si128 ((__m128i *)(dst+pos+32), r2);
+        _mm_storeu_si128 ((__m128i *)(dst+pos+48), r3);
+    }
+    multiply_add_region_multi_tail(&region_kernels[GF_SIMD_SSSE3], dst, srcs, mcs, n, pos, bytes);
+}
+
+TARGET_SSSE3
+static void multiply_add_region_scatter_ssse3(uint8_t **dsts, uint8_t *src, const struct gf_mult_const **mcs, int n, int bytes)
+{
+    __m128i loset = _mm_set1_epi8(0x0f);
+    __m128i v[4], lo[4], hi[4], r;
+    __m128i mtl = _mm_setzero_si128(), mth = _mm_setzero_si128();
+    int pos, k, t;
+    for (pos=0; pos+64<=bytes; pos+=64) {
+        for (t=0; t<4; t++) {
+            v[t]  = _mm_loadu_si128 ((__m128i *)(src+pos+16*t));
+            lo[t] = _mm_and_si128 (loset, v[t]);
+            hi[t] = _mm_and_si128 (loset, _mm_srli_epi64 (v[t], 4));
+        }
+        for (k=0; k<n; k++) {
+            uint8_t *dp = dsts[k] + pos;
+            if (mcs[k] != NULL) {
+                mtl = _mm_loadu_si128 ((__m128i *)(mcs[k]->lo));
+                mth = _mm_loadu_si128 ((__m128i *)(mcs[k]->hi));
+            }
+            for (t=0; t<4; t++) {
+                r = mcs[k] == NULL ? v[t] : _mm_xor_si128 (_mm_shuffle_epi8 (mtl, lo[t]), _mm_shuffle_epi8 (mth, hi[t]));
+                r = _mm_xor_si128 (r, _mm_loadu_si128 ((__m128i *)(dp+16*t)));
+                _mm_storeu_si128 ((__m128i *)(dp+16*t), r);
+            }
+        }
+    }
+    multiply_add_region_scatter_tail(&region_kernels[GF_SIMD_SSSE3], dsts, src, mcs, n, pos, bytes);
+}
+
+TARGET_AVX2
+static inline __m256i nibble_mul_avx2(__m256i v, __m256i mtl, __m256i mth, __m256i loset)
+{
+    __m256i lo = _mm256_shuffle_epi8 (mtl, _mm256_and_si256 (loset, v));
+    __m256i hi = _mm256_shuffle_epi8 (mth, _mm256_and_si256 (loset, _mm256_srli_epi64 (v, 4)));
+    return _mm256_xor_si256 (lo, hi);
+}
+
+// Tile of 128 bytes in four 256-bit accumulators
+TARGET_AVX2
+static void multiply_add_region_multi_avx2(uint8_t *dst, uint8_t **srcs, const struct gf_mult_const **mcs, int n, int bytes)
+{
+    __m256i loset = _mm256_set1_epi8(0x0f);
+    __m256i r0, r1, r2, r3, mtl, mth;
+    int pos, k;
+    for (pos=0; pos+128<=bytes; pos+=128) {
+        r0 = _mm256_loadu_si256 ((__m256i *)(dst+pos));
+        r1 = _mm256_loadu_si256 ((__m256i *)(dst+pos+32));
+        r2 = _mm256_loadu_si256 ((__m256i *)(dst+pos+64));
+        r3 = _mm256_loadu_si256 ((__m256i *)(dst+pos+96));
+        for (k=0; k<n; k++) {
+            uint8_t *sp = srcs[k] + pos;
+            __m256i v0 = _mm256_loadu_si256 ((__m256i *)(sp));
+            __m256i v1 = _mm256_loadu_si256 ((__m256i *)(sp+32));
+            __m256i v2 = _mm256_loadu_si256 ((__m256i *)(sp+64));
+            __m256i v3 = _mm256_loadu_si256 ((__m256i *)(sp+96));
+            if (mcs[k] != NULL) {
+                mtl = _mm256_broadcastsi128_si256(_mm_loadu_si128 ((__m128i *)(mcs[k]->lo)));
+                mth = _mm256_broadcastsi128_si256(_mm_loadu_si128 ((__m128i *)(mcs[k]->hi)));
+                v0 = nibble_mul_avx2(v0, mtl, mth, loset);
+                v1 = nibble_mul_avx2(v1, mtl, mth, loset);
+                v2 = nibble_mul_avx2(v2, mtl, mth, loset);
+                v3 = nibble_mul_avx2(v3, mtl, mth, loset);
+            }
+            r0 = _mm256_xor_si256 (r0, v0);
+            r1 = _mm256_xor_si256 (r1, v1);
+            r2 = _mm256_xor_si256 (r2, v2);
+            r3 = _mm256_xor_si256 (r3, v3);
+        }
+        _mm256_storeu_si256 ((__m256i *)(dst+pos), r0);
+        _mm256_storeu_si256 ((__m256i *)(dst+pos+32), r1);
+        _mm256_storeu_si256 ((__m256i *)(dst+pos+64), r2);
+        _mm256_storeu_si256 ((__m256i *)(dst+pos+96), r3);
+    }
+    multiply_add_region_multi_tail(&region_kernels[GF_SIMD_AVX2], dst, srcs, mcs, n, pos, bytes);
+}
+
+TARGET_AVX2
+static void multiply_add_region_scatter_avx2(uint8_t **dsts, uint8_t *src, const struct gf_mult_const **mcs, int n, int bytes)
+{
+    __m256i loset = _mm256_set1_epi8(0x0f);
+    __m256i v[4], lo[4], hi[4], r;
+    __m256i mtl = _mm256_setzero_si256(), mth = _mm256_setzero_si256();
+    int pos, k, t;
+    for (pos=0; pos+128<=bytes; pos+=128) {
+        for (t=0; t<4; t++) {
+            v[t]  = _mm256_loadu_si256 ((__m256i *)(src+pos+32*t));
+            lo[t] = _mm256_and_si256 (loset, v[t]);
+            hi[t] = _mm256_and_si256 (loset, _mm256_srli_epi64 (v[t], 4));
+        }
+        for (k=0; k<n; k++) {
+            uint8_t *dp = dsts[k] + pos;
+            if (mcs[k] != NULL) {
+                mtl = _mm256_broadcastsi128_si256(_mm_loadu_si128 ((__m128i *)(mcs[k]->lo)));
+                mth = _mm256_broadcastsi128_si256(_mm_loadu_si128 ((__m128i *)(mcs[k]->hi)));
+            }
+            for (t=0; t<4; t++) {
+                r = mcs[k] == NULL ? v[t] : _mm256_xor_si256 (_mm256_shuffle_epi8 (mtl, lo[t]), _mm256_shuffle_epi8 (mth, hi[t]));
+                r = _mm256_xor_si256 (r, _mm256_loadu_si256 ((__m256i *)(dp+32*t)));
+                _mm256_storeu_si256 ((__m256i *)(dp+32*t), r);
+            }
+        }
+    }
+    multiply_add_region_scatter_tail(&region_kernels[GF_SIMD_AVX2], dsts, src, mcs, n, pos, bytes);
+}
+
+/*
+ * AVX-512BW handles the tail with masked loads/stores instead of scalar code.
+ */
+#define TAIL_MASK64(n)  ((n) % 64 ? ((__mmask64) 1 << ((n) % 64)) - 1 : 0)
+
+TARGET_AVX512BW
+static void add_region_avx512bw(uint8_t *dst, uint8_t *src, int bytes)
+{
+    uint8_t *sptr = src;
+    uint8_t *dptr = dst;
+    uint8_t *top  = src + bytes;
+    __mmask64 tail = TAIL_MASK64(bytes);
+    __m512i va, vb;
+    for (; sptr + 64 <= top; sptr += 64, dptr += 64) {
+        va = _mm512_loadu_si512 ((void *)(sptr));
+        vb = _mm512_loadu_si512 ((void *)(dptr));
+        _mm512_storeu_si512 ((void *)(dptr), _mm512_xor_si512(va, vb));
+    }
+    if (tail) {
+        va = _mm512_maskz_loadu_epi8 (tail, sptr);
+        vb = _mm512_maskz_loadu_epi8 (tail, dptr);
+        _mm512_mask_storeu_epi8 (dptr, tail, _mm512_xor_si512(va, vb));
+    }
+}
+
+TARGET_AVX512BW
+static void multiply_add_region_avx512bw(uint8_t *dst, uint8_t *src, const struct gf_mult_const *mc, int bytes)
+{
+    uint8_t *sptr = src;
+    uint8_t *dptr = dst;
+    uint8_t *top  = src + bytes;
+    __mmask64 tail = TAIL_MASK64(bytes);
+    __m512i mth   = _mm512_broadcast_i32x4(_mm_loadu_si128((__m128i *)(mc->hi)));
+    __m512i mtl   = _mm512_broadcast_i32x4(_mm_loadu_si128((__m128i *)(mc->lo)));
+    __m512i loset = _mm512_set1_epi8 (0x0f);
+    __m512i va, vb, r, t1, r2;
+    for (; sptr + 64 <= top; sptr += 64, dptr += 64) {
+        va = _mm512_loadu_si512 ((void *)(sptr));
+        t1 = _mm512_and_si512 (loset, va);
+        r  = _mm512_shuffle_epi8 (mtl, t1);
+        va = _mm512_srli_epi64 (va, 4);
+        t1 = _mm512_and_si512 (loset, va);
+        r2 = _mm512_shuffle_epi8 (mth, t1);
+        r  = _mm512_xor_si512 (r, r2);
+        vb = _mm512_loadu_si512 ((void *)(dptr));
+        _mm512_storeu_si512 ((void *)(dptr), _mm512_xor_si512(r, vb));
+    }
+    if (tail) {
+        va = _mm512_maskz_loadu_epi8 (tail, sptr);
+        t1 = _mm512_and_si512 (loset, va);
+        r  = _mm512_shuffle_epi8 (mtl, t1);
+        va = _mm512_srli_epi64 (va, 4);
+        t1 = _mm512_and_si512 (loset, va);
+        r2 = _mm512_shuffle_epi8 (mth, t1);
+        r  = _mm512_xor_si512 (r, r2);
+        vb = _mm512_maskz_loadu_epi8 (tail, dptr);
+        _mm512_mask_storeu_epi8 (dptr, tail, _mm512_xor_si512(r, vb));
+    }
+}
+
+TARGET_AVX512BW
+static void add_region_aligned_avx512bw(uint8_t *dst, uint8_t *src, int bytes)
+{
+    uint8_t *sptr = src;
+    uint8_t *dptr = dst;
+    uint8_t *top  = src + bytes;
+    __m512i va, vb;
+    for (; sptr < top; sptr += 64, dptr += 64) {
+        va = _mm512_load_si512 ((void *)(sptr));
+        vb = _mm512_load_si512 ((void *)(dptr));
+        _mm512_store_si512 ((void *)(dptr), _mm512_xor_si512(va, vb));
+    }
+}
+
+TARGET_AVX512BW
+static void multiply_add_region_aligned_avx512bw(uint8_t *dst, uint8_t *src, const struct gf_mult_const *mc, int bytes)
+{
+    uint8_t *sptr = src;
+    uint8_t *dptr = dst;
+    uint8_t *top  = src + bytes;
+    __m512i mth   = _mm512_broadcast_i32x4(_mm_loadu_si128((__m128i *)(mc->hi)));
+    __m512i mtl   = _mm512_broadcast_i32x4(_mm_loadu_si128((__m128i *)(mc->lo)));
+    __m512i loset = _mm512_set1_epi8 (0x0f);
+    __m512i va, vb, r, t1, r2;
+    for (; sptr < top; sptr += 64, dptr += 64) {
+        va = _mm512_load_si512 ((void *)(sptr));
+        t1 = _mm512_and_si512 (loset, va);
+        r  = _mm512_shuffle_epi8 (mtl, t1);
+        va = _mm512_srli_epi64 (va, 4);
+        t1 = _mm512_and_si512 (loset, va);
+        r2 = _mm512_shuffle_epi8 (mth, t1);
+        r  = _mm512_xor_si512 (r, r2);
+        vb = _mm512_load_si512 ((void *)(dptr));
+        _mm512_store_si512 ((void *)(dptr), _mm512_xor_si512(r, vb));
+    }
+}
+
+TARGET_AVX512BW
+static void multiply_region_avx512bw(uint8_t *src, const struct gf_mult_const *mc, int bytes)
+{
+    uint8_t *sptr = src;
+    uint8_t *top  = src + bytes;
+    __mmask64 tail = TAIL_MASK64(bytes);
+    __m512i mth   = _mm512_broadcast_i32x4(_mm_loadu_si128((__m128i *)(mc->hi)));
+    __m512i mtl   = _mm512_broadcast_i32x4(_mm_loadu_si128((__m128i *)(mc->lo)));
+    __m512i loset = _mm512_set1_epi8 (0x0f);
+    __m512i va, r, t1;
+    for (; sptr + 64 <= top; sptr += 64) {
+        va = _mm512_loadu_si512 ((void *)(sptr));
+        t1 = _mm512_and_si512 (loset, va);
+        r  = _mm512_shuffle_epi8 (mtl, t1);
+        va = _mm512_srli_epi64 (va, 4);
+        t1 = _mm512_and_si512 (loset, va);
+        r  = _mm512_xor_si512 (r, _mm512_shuffle_epi8 (mth, t1));
+        _mm512_storeu_si512 ((void *)(sptr), r);
+    }
+    if (tail) {
+        va = _mm512_maskz_loadu_epi8 (tail, sptr);
+        t1 = _mm512_and_si512 (loset, va);
+        r  = _mm512_shuffle_epi8 (mtl, t1);
+        va = _mm512_srli_epi64 (va, 4);
+        t1 = _mm512_and_si512 (loset, va);
+        r  = _mm512_xor_si512 (r, _mm512_shuffle_epi8 (mth, t1));
+        _mm512_mask_storeu_epi8 (sptr, tail, r);
+    }
+}
+
+TARGET_AVX512BW
+static inline __m512i nibble_mul_avx512bw(__m512i v, __m512i mtl, __m512i mth, __m512i loset)
+{
+    __m512i lo = _mm512_shuffle_epi8 (mtl, _mm512_and_si512 (loset, v));
+    __m512i hi = _mm512_shuffle_epi8 (mth, _mm512_and_si512 (loset, _mm512_srli_epi64 (v, 4)));
+    return _mm512_xor_si512 (lo, hi);
+}
+
+// Tile of 256 bytes in four 512-bit accumulators
+TARGET_AVX512BW
+static void multiply_add_region_multi_avx512bw(uint8_t *dst, uint8_t **srcs, const struct gf_mult_const **mcs, int n, int bytes)
+{
+    __m512i loset = _mm512_set1_epi8(0x0f);
+    __m512i r0, r1, r2, r3, mtl, mth;
+    int pos, k;
+    for (pos=0; pos+256<=bytes; pos+=256) {
+        r0 = _mm512_loadu_si512 ((void *)(dst+pos));
+        r1 = _mm512_loadu_si512 ((void *)(dst+pos+64));
+        r2 = _mm512_loadu_si512 ((void *)(dst+pos+128));
+        r3 = _mm512_loadu_si512 ((void *)(dst+pos+192));
+        for (k=0; k<n; k++) {
+            uint8_t *sp = srcs[k] + pos;
+            __m512i v0 = _mm512_loadu_si512 ((void *)(sp));
+            __m512i v1 = _mm512_loadu_si512 ((void *)(sp+64));
+            __m512i v2 = _mm512_loadu_si512 ((void *)(sp+128));
+            __m512i v3 = _mm512_loadu_si512 ((void *)(sp+192));
+            if (mcs[k] != NULL) {
+                mtl = _mm512_broadcast_i32x4(_mm_loadu_si128 ((__m128i *)(mcs[k]->lo)));
+                mth = _mm512_broadcast_i32x4(_mm_loadu_si128 ((__m128i *)(mcs[k]->hi)));
+                v0 = nibble_mul_avx512bw(v0, mtl, mth, loset);
+                v1 = nibble_mul_avx512bw(v1, mtl, mth, loset);
+                v2 = nibble_mul_avx512bw(v2, mtl, mth, loset);
+                v3 = nibble_mul_avx512bw(v3, mtl, mth, loset);
+            }
+            r0 = _mm512_xor_si512 (r0, v0);
+            r1 = _mm512_xor_si512 (r1, v1);
+            r2 = _mm512_xor_si512 (r2, v2);
+            r3 = _mm512_xor_si512 (r3, v3);
+        }
+        _mm512_storeu_si512 ((void *)(dst+pos), r0);
+        _mm512_storeu_si512 ((void *)(dst+pos+64), r1);
+        _mm512_storeu_si512 ((void *)(dst+pos+128), r2);
+        _mm512_storeu_si512 ((void *)(dst+pos+192), r3);
+    }
+    multiply_add_region_multi_tail(&region_kernels[GF_SIMD_AVX512BW], dst, srcs, mcs, n, pos, bytes);
+}
+
+TARGET_AVX512BW
+static void multiply_add_region_scatter_avx512bw(uint8_t **dsts, uint8_t *src, const struct gf_mult_const **mcs, int n, int bytes)
+{
+    __m512i loset = _mm512_set1_epi8(0x0f);
+    __m512i v[4], lo[4], hi[4], r;
+    __m512i mtl = _mm512_setzero_si512(), mth = _mm512_setzero_si512();
+    int pos, k, t;
+    for (pos=0; pos+256<=bytes; pos+=256) {
+        for (t=0; t<4; t++) {
+            v[t]  = _mm512_loadu_si512 ((void *)(src+pos+64*t));
+            lo[t] = _mm512_and_si512 (loset, v[t]);
+            hi[t] = _mm512_and_si512 (loset, _mm512_srli_epi64 (v[t], 4));
+        }
+        for (k=0; k<n; k++) {
+            uint8_t *dp = dsts[k] + pos;
+            if (mcs[k] != NULL) {
+                mtl = _mm512_broadcast_i32x4(_mm_loadu_si128 ((__m128i *)(mcs[k]->lo)));
+                mth = _mm512_broadcast_i32x4(_mm_loadu_si128 ((__m128i *)(mcs[k]->hi)));
+            }
+            for (t=0; t<4; t++) {
+                r = mcs[k] == NULL ? v[t] : _mm512_xor_si512 (_mm512_shuffle_epi8 (mtl, lo[t]), _mm512_shuffle_epi8 (mth, hi[t]));
+                r = _mm512_xor_si512 (r, _mm512_loadu_si512 ((void *)(dp+64*t)));
+                _mm512_storeu_si512 ((void *)(dp+64*t), r);
+            }
+        }
+    }
+    multiply_add_region_scatter_tail(&region_kernels[GF_SIMD_AVX512BW], dsts, src, mcs, n, pos, bytes);
+}
+
+/*
+ * GFNI kernels multiply 32/64 elements at once with gf2p8affineqb, using
+ * the affine matrix of the multiplier instead of the two nibble tables.
+ */
+TARGET_GFNI_AVX2
+static void multiply_add_region_gfni_avx2(uint8_t *dst, uint8_t *src, const struct gf_mult_const *mc, int bytes)
+{
+    uint8_t *sptr = src;
+    uint8_t *dptr = dst;
+    uint8_t *top  = src + bytes;
+    __m256i A = _mm256_set1_epi64x((long long) mc->affine);
+    __m256i va, vb;
+    for (; sptr + 32 <= top; sptr += 32, dptr += 32) {
+        va = _mm256_loadu_si256 ((__m256i *)(sptr));
+        va = _mm256_gf2p8affine_epi64_epi8 (va, A, 0);
+        vb = _mm256_loadu_si256 ((__m256i *)(dptr));
+        _mm256_storeu_si256 ((__m256i *)(dptr), _mm256_xor_si256(va, vb));
+    }
+    multiply_add_region_scalar(dptr, sptr, mc, top - sptr);
+}
+
+TARGET_GFNI_AVX2
+static void multiply_add_region_aligned_gfni_avx2(uint8_t *dst, uint8_t *src, const struct gf_mult_const *mc, int bytes)
+{
+    uint8_t *sptr = src;
+    uint8_t *dptr = dst;
+    uint8_t *top  = src + bytes;
+    __m256i A = _mm256_set1_epi64x((long long) mc->affine);
+    __m256i va, vb;
+    for (; sptr < top; sptr += 32, dptr += 32) {
+        va = _mm256_load_si256 ((__m256i *)(sptr));
+        va = _mm256_gf2p8affine_epi64_epi8 (va, A, 0);
+        vb = _mm256_load_si256 ((__m256i *)(dptr));
+        _mm256_store_si256 ((__m256i *)(dptr), _mm256_xor_si256(va, vb));
+    }
+}
+
+TARGET_GFNI_AVX2
+static void multiply_region_gfni_avx2(uint8_t *src, const struct gf_mult_const *mc, int bytes)
+{
+    uint8_t *sptr = src;
+    uint8_t *top  = src + bytes;
+    __m256i A = _mm256_set1_epi64x((long long) mc->affine);
+    __m256i va;
+    for (; sptr + 32 <= top; sptr += 32) {
+        va = _mm256_loadu_si256 ((__m256i *)(sptr));
+        _mm256_storeu_si256 ((__m256i *)(sptr), _mm256_gf2p8affine_epi64_epi8 (va, A, 0));
+    }
+    multiply_region_scalar(sptr, mc, top - sptr);
+}
+
+TARGET_GFNI_AVX512
+static void multiply_add_region_gfni_avx512(uint8_t *dst, uint8_t *src, const struct gf_mult_const *mc, int bytes)
+{
+    uint8_t *sptr = src;
+    uint8_t *dptr = dst;
+    uint8_t *top  = src + bytes;
+    __mmask64 tail = TAIL_MASK64(bytes);
+    __m512i A = _mm512_set1_epi64((long long) mc->affine);
+    __m512i va, vb;
+    for (; sptr + 64 <= top; sptr += 64, dptr += 64) {
+        va = _mm512_loadu_si512 ((void *)(sptr));
+        va = _mm512_gf2p8affine_epi64_epi8 (va, A, 0);
+        vb = _mm512_loadu_si512 ((void *)(dptr));
+        _mm512_storeu_si512 ((void *)(dptr), _mm512_xor_si512(va, vb));
+    }
+    if (tail) {
+        va = _mm512_maskz_loadu_epi8 (tail, sptr);
+        va = _mm512_gf2p8affine_epi64_epi8 (va, A, 0);
+        vb = _mm512_maskz_loadu_epi8 (tail, dptr);
+        _mm512_mask_storeu_epi8 (dptr, tail, _mm512_xor_si512(va, vb));
+    }
+}
+
+TARGET_GFNI_AVX512
+static void multiply_add_region_aligned_gfni_avx512(uint8_t *dst, uint8_t *src, const struct gf_mult_const *mc, int bytes)
+{
+    uint8_t *sptr = src;
+    uint8_t *dptr = dst;
+    uint8_t *top  = src + bytes;
+    __m512i A = _mm512_set1_epi64((long long) mc->affine);
+    __m512i va, vb;
+    for (; sptr < top; sptr += 64, dptr += 64) {
+        va = _mm512_load_si512 ((void *)(sptr));
+        va = _mm512_gf2p8affine_epi64_epi8 (va, A, 0);
+        vb = _mm512_load_si512 ((void *)(dptr));
+        _mm512_store_si512 ((void *)(dptr), _mm512_xor_si512(va, vb));
+    }
+}
+
+TARGET_GFNI_AVX512
+static void multiply_region_gfni_avx512(uint8_t *src, const struct gf_mult_const *mc, int bytes)
+{
+    uint8_t *sptr = src;
+    uint8_t *top  = src + bytes;
+    __mmask64 tail = TAIL_MASK64(bytes);
+    __m512i A = _mm512_set1_epi64((long long) mc->affine);
+    __m512i va;
+    for (; sptr + 64 <= top; sptr += 64) {
+        va = _mm512_loadu_si512 ((void *)(sptr));
+        _mm512_storeu_si512 ((void *)(sptr), _mm512_gf2p8affine_epi64_epi8 (va, A, 0));
+    }
+    if (tail) {
+        va = _mm512_maskz_loadu_epi8 (tail, sptr);
+        _mm512_mask_storeu_epi8 (sptr, tail, _mm512_gf2p8affine_epi64_epi8 (va, A, 0));
+    }
+}
+// Tile of 128 bytes in four 256-bit accumulators
+TARGET_GFNI_AVX2
+static void multiply_add_region_multi_gfni_avx2(uint8_t *dst, uint8_t **srcs, const struct gf_mult_const **mcs, int n, int bytes)
+{
+    __m256i r0, r1, r2, r3, A;
+    int pos, k;
+    for (pos=0; pos+128<=bytes; pos+=128) {
+        r0 = _mm256_loadu_si256 ((__m256i *)(dst+pos));
+        r1 = _mm256_loadu_si256 ((__m256i *)(dst+pos+32));
+        r2 = _mm256_loadu_si256 ((__m256i *)(dst+pos+64));
+        r3 = _mm256_loadu_si256 ((__m256i *)(dst+pos+96));
+        for (k=0; k<n; k++) {
+            uint8_t *sp = srcs[k] + pos;
+            __m256i v0 = _mm256_loadu_si256 ((__m256i *)(sp));
+            __m256i v1 = _mm256_loadu_si256 ((__m256i *)(sp+32));
+            __m256i v2 = _mm256_loadu_si256 ((__m256i *)(sp+64));
+            __m256i v3 = _mm256_loadu_si256 ((__m256i *)(sp+96));
+            if (mcs[k] != NULL) {
+                A  = _mm256_set1_epi64x((long long) mcs[k]->affine);
+                v0 = _mm256_gf2p8affine_epi64_epi8 (v0, A, 0);
+                v1 = _mm256_gf2p8affine_epi64_epi8 (v1, A, 0);
+                v2 = _mm256_gf2p8affine_epi64_epi8 (v2, A, 0);
+                v3 = _mm256_gf2p8affine_epi64_epi8 (v3, A, 0);
+            }
+            r0 = _mm256_xor_si256 (r0, v0);
+            r1 = _mm256_xor_si256 (r1, v1);
+            r2 = _mm256_xor_si256 (r2, v2);
+            r3 = _mm256_xor_si256 (r3, v3);
+        }
+        _mm256_storeu_si256 ((__m256i *)(dst+pos), r0);
+        _mm256_storeu_si256 ((__m256i *)(dst+pos+32), r1);
+        _mm256_storeu_si256 ((__m256i *)(dst+pos+64), r2);
+        _mm256_storeu_si256 ((__m256i *)(dst+pos+96), r3);
+    }
+    multiply_add_region_multi_tail(&region_kernels[GF_SIMD_GFNI_AVX2], dst, srcs, mcs, n, pos, bytes);
+}
+
+// Tile of 256 bytes in four 512-bit accumulators
+TARGET_GFNI_AVX512
+static void multiply_add_region_multi_gfni_avx512(uint8_t *dst, uint8_t **srcs, const struct gf_mult_const **mcs, int n, int bytes)
+{
+    __m512i r0, r1, r2, r3, A;
+    int pos, k;
+    for (pos=0; pos+256<=bytes; pos+=256) {
+        r0 = _mm512_loadu_si512 ((void *)(dst+pos));
+        r1 = _mm512_loadu_si512 ((void *)(dst+pos+64));
+        r2 = _mm512_loadu_si512 ((void *)(dst+pos+128));
+        r3 = _mm512_loadu_si512 ((void *)(dst+pos+192));
+        for (k=0; k<n; k++) {
+            uint8_t *sp = srcs[k] + pos;
+            __m512i v0 = _mm512_loadu_si512 ((void *)(sp));
+            __m512i v1 = _mm512_loadu_si512 ((void *)(sp+64));
+            __m512i v2 = _mm512_loadu_si512 ((void *)(sp+128));
+            __m512i v3 = _mm512_loadu_si512 ((void *)(sp+192));
+            if (mcs[k] != NULL) {
+                A  = _mm512_set1_epi64((long long) mcs[k]->affine);
+                v0 = _mm512_gf2p8affine_epi64_epi8 (v0, A, 0);
+                v1 = _mm512_gf2p8affine_epi64_epi8 (v1, A, 0);
+                v2 = _mm512_gf2p8affine_epi64_epi8 (v2, A, 0);
+                v3 = _mm512_gf2p8affine_epi64_epi8 (v3, A, 0);
+            }
+            r0 = _mm512_xor_si512 (r0, v0);
+            r1 = _mm512_xor_si512 (r1, v1);
+            r2 = _mm512_xor_si512 (r2, v2);
+            r3 = _mm512_xor_si512 (r3, v3);
+        }
+        _mm512_storeu_si512 ((void *)(dst+pos), r0);
+        _mm512_storeu_si512 ((void *)(dst+pos+64), r1);
+        _mm512_storeu_si512 ((void *)(dst+pos+128), r2);
+        _mm512_storeu_si512 ((void *)(dst+pos+192), r3);
+    }
+    multiply_add_region_multi_tail(&region_kernels[GF_SIMD_GFNI_AVX512], dst, srcs, mcs, n, pos, bytes);
+}
+
+TARGET_GFNI_AVX2
+static void multiply_add_region_scatter_gfni_avx2(uint8_t **dsts, uint8_t *src, const struct gf_mult_const **mcs, int n, int bytes)
+{
+    __m256i v[4], r, A = _mm256_setzero_si256();
+    int pos, k, t;
+    for (pos=0; pos+128<=bytes; pos+=128) {
+        for (t=0; t<4; t++)
+            v[t] = _mm256_loadu_si256 ((__m256i *)(src+pos+32*t));
+        for (k=0; k<n; k++) {
+            uint8_t *dp = dsts[k] + pos;
+            if (mcs[k] != NULL)
+                A = _mm256_set1_epi64x((long long) mcs[k]->affine);
+            for (t=0; t<4; t++) {
+                r = mcs[k] == NULL ? v[t] : _mm256_gf2p8affine_epi64_epi8 (v[t], A, 0);
+                r = _mm256_xor_si256 (r, _mm256_loadu_si256 ((__m256i *)(dp+32*t)));
+                _mm256_storeu_si256 ((__m256i *)(dp+32*t), r);
+            }
+        }
+    }
+    multiply_add_region_scatter_tail(&region_kernels[GF_SIMD_GFNI_AVX2], dsts, src, mcs, n, pos, bytes);
+}
+
+TARGET_GFNI_AVX512
+static void multiply_add_region_scatter_gfni_avx512(uint8_t **dsts, uint8_t *src, const struct gf_mult_const **mcs, int n, int bytes)
+{
+    __m512i v[4], r, A = _mm512_setzero_si512();
+    int pos, k, t;
+    for (pos=0; pos+256<=bytes; pos+=256) {
+        for (t=0; t<4; t++)
+            v[t] = _mm512_loadu_si512 ((void *)(src+pos+64*t));
+        for (k=0; k<n; k++) {
+            uint8_t *dp = dsts[k] + pos;
+            if (mcs[k] != NULL)
+                A = _mm512_set1_epi64((long long) mcs[k]->affine);
+            for (t=0; t<4; t++) {
+                r = mcs[k] == NULL ? v[t] : _mm512_gf2p8affine_epi64_epi8 (v[t], A, 0);
+                r = _mm512_xor_si512 (r, _mm512_loadu_si512 ((void *)(dp+64*t)));
+                _mm512_storeu_si512 ((void *)(dp+64*t), r);
+            }
+        }
+    }
+    multiply_add_region_scatter_tail(&region_kernels[GF_SIMD_GFNI_AVX512], dsts, src, mcs, n, pos, bytes);
+}
+/*
+ * GF(2^16) kernels split the big-endian elements of two vectors into a vector
+ * of high bytes and a vector of low bytes (packus), look up the products of
+ * the four nibbles, and interleave the product bytes back (unpack). Both pack
+ * and unpack work within 128-bit lanes, so they undo each other.
+ */
+TARGET_SSSE3
+static inline void mult16_ssse3(__m128i x0, __m128i x1, const __m128i *tl, const __m128i *th, __m128i *y0, __m128i *y1)
+{
+    __m128i loset = _mm_set1_epi8(0x0f);
+    __m128i bmask = _mm_set1_epi16(0x00ff);
+    __m128i eh = _mm_packus_epi16 (_mm_and_si128 (x0, bmask), _mm_and_si128 (x1, bmask));
+    __m128i el = _mm_packus_epi16 (_mm_srli_epi16 (x0, 8), _mm_srli_epi16 (x1, 8));
+    __m128i n[4];
+    n[0] = _mm_and_si128 (el, loset);
+    n[1] = _mm_and_si128 (_mm_srli_epi64 (el, 4), loset);
+    n[2] = _mm_and_si128 (eh, loset);
+    n[3] = _mm_and_si128 (_mm_srli_epi64 (eh, 4), loset);
+    __m128i rl = _mm_setzero_si128(), rh = _mm_setzero_si128();
+    for (int k=0; k<4; k++) {
+        rl = _mm_xor_si128 (rl, _mm_shuffle_epi8 (tl[k], n[k]));
+        rh = _mm_xor_si128 (rh, _mm_shuffle_epi8 (th[k], n[k]));
+    }
+    *y0 = _mm_unpacklo_epi8 (rh, rl);
+    *y1 = _mm_unpackhi_epi8 (rh, rl);
+}
+
+TARGET_SSSE3
+static void multiply_add_region16_ssse3(uint8_t *dst, uint8_t *src, const struct gf_mult_const16 *mc, int bytes)
+{
+    __m128i tl[4], th[4], y0, y1;
+    int i;
+    for (int k=0; k<4; k++) {
+        tl[k] = _mm_loadu_si128 ((__m128i *)(mc->lo[k]));
+        th[k] = _mm_loadu_si128 ((__m128i *)(mc->hi[k]));
+    }
+    for (i=0; i+32<=bytes; i+=32) {
+        mult16_ssse3(_mm_loadu_si128 ((__m128i *)(src+i)), _mm_loadu_si128 ((__m128i *)(src+i+16)), tl, th, &y0, &y1);
+        _mm_storeu_si128 ((__m128i *)(dst+i), _mm_xor_si128 (y0, _mm_loadu_si128 ((__m128i *)(dst+i))));
+        _mm_storeu_si128 ((__m128i *)(dst+i+16), _mm_xor_si128 (y1, _mm_loadu_si128 ((__m128i *)(dst+i+16))));
+    }
+    multiply_add_region16_scalar(dst+i, src+i, mc, bytes-i);
+}
+
+TARGET_SSSE3
+static void multiply_region16_ssse3(uint8_t *src, const struct gf_mult_const16 *mc, int bytes)
+{
+    __m128i tl[4], th[4], y0, y1;
+    int i;
+    for (int k=0; k<4; k++) {
+        tl[k] = _mm_loadu_si128 ((__m128i *)(mc->lo[k]));
+        th[k] = _mm_loadu_si128 ((__m128i *)(mc->hi[k]));
+    }
+    for (i=0; i+32<=bytes; i+=32) {
+        mult16_ssse3(_mm_loadu_si128 ((__m128i *)(src+i)), _mm_loadu_si128 ((__m128i *)(src+i+16)), tl, th, &y0, &y1);
+        _mm_storeu_si128 ((__m128i *)(src+i), y0);
+        _mm_storeu_si128 ((__m128i *)(src+i+16), y1);
+    }
+    multiply_region16_scalar(src+i, mc, bytes-i);
+}
+
+TARGET_AVX2
+static inline void mult16_avx2(__m256i x0, __m256i x1, const __m256i *tl, const __m256i *th, __m256i *y0, __m256i *y1)
+{
+    __m256i loset = _mm256_set1_epi8(0x0f);
+    __m256i bmask = _mm256_set1_epi16(0x00ff);
+    __m256i eh = _mm256_packus_epi16 (_mm256_and_si256 (x0, bmask), _mm256_and_si256 (x1, bmask));
+    __m256i el = _mm256_packus_epi16 (_mm256_srli_epi16 (x0, 8), _mm256_srli_epi16 (x1, 8));
+    __m256i n[4];
+    n[0] = _mm256_and_si256 (el, loset);
+    n[1] = _mm256_and_si256 (_mm256_srli_epi64 (el, 4), loset);
+    n[2] = _mm256_and_si256 (eh, loset);
+    n[3] = _mm256_and_si256 (_mm256_srli_epi64 (eh, 4), loset);
+    __m256i rl = _mm256_setzero_si256(), rh = _mm256_setzero_si256();
+    for (int k=0; k<4; k++) {
+        rl = _mm256_xor_si256 (rl, _mm256_shuffle_epi8 (tl[k], n[k]));
+        rh = _mm256_xor_si256 (rh, _mm256_shuffle_epi8 (th[k], n[k]));
+    }
+    *y0 = _mm256_unpacklo_epi8 (rh, rl);
+    *y1 = _mm256_unpackhi_epi8 (rh, rl);
+}
+
+TARGET_AVX2
+static void multiply_add_region16_avx2(uint8_t *dst, uint8_t *src, const struct gf_mult_const16 *mc, int bytes)
+{
+    __m256i tl[4], th[4], y0, y1;
+    int i;
+    for (int k=0; k<4; k++) {
+        tl[k] = _mm256_broadcastsi128_si256(_mm_loadu_si128 ((__m128i *)(mc->lo[k])));
+        th[k] = _mm256_broadcastsi128_si256(_mm_loadu_si128 ((__m128i *)(mc->hi[k])));
+    }
+    for (i=0; i+64<=bytes; i+=64) {
+        mult16_avx2(_mm256_loadu_si256 ((__m256i *)(src+i)), _mm256_loadu_si256 ((__m256i *)(src+i+32)), tl, th, &y0, &y1);
+        _mm256_storeu_si256 ((__m256i *)(dst+i), _mm256_xor_si256 (y0, _mm256_loadu_si256 ((__m256i *)(dst+i))));
+        _mm256_storeu_si256 ((__m256i *)(dst+i+32), _mm256_xor_si256 (y1, _mm256_loadu_si256 ((__m256i *)(dst+i+32))));
+    }
+    multiply_add_region16_scalar(dst+i, src+i, mc, bytes-i);
+}
+
+TARGET_AVX2
+static void multiply_region16_avx2(uint8_t *src, const struct gf_mult_const16 *mc, int bytes)
+{
+    __m256i tl[4], th[4], y0, y1;
+    int i;
+    for (int k=0; k<4; k++) {
+        tl[k] = _mm256_broadcastsi128_si256(_mm_loadu_si128 ((__m128i *)(mc->lo[k])));
+        th[k] = _mm256_broadcastsi128_si256(_mm_loadu_si128 ((__m128i *)(mc->hi[k])));
+    }
+    for (i=0; i+64<=bytes; i+=64) {
+        mult16_avx2(_mm256_loadu_si256 ((__m256i *)(src+i)), _mm256_loadu_si256 ((__m256i *)(src+i+32)), tl, th, &y0, &y1);
+        _mm256_storeu_si256 ((__m256i *)(src+i), y0);
+        _mm256_storeu_si256 ((__m256i *)(src+i+32), y1);
+    }
+    multiply_region16_scalar(src+i, mc, bytes-i);
+}
+
+TARGET_AVX512BW
+static inline void mult16_avx512bw(__m512i x0, __m512i x1, const __m512i *tl, const __m512i *th, __m512i *y0, __m512i *y1)
+{
+    __m512i loset = _mm512_set1_epi8(0x0f);
+    __m512i bmask = _mm512_set1_epi16(0x00ff);
+    __m512i eh = _mm512_packus_epi16 (_mm512_and_si512 (x0, bmask), _mm512_and_si512 (x1, bmask));
+    __m512i el = _mm512_packus_epi16 (_mm512_srli_epi16 (x0, 8), _mm512_srli_epi16 (x1, 8));
+    __m512i n[4];
+    n[0] = _mm512_and_si512 (el, loset);
+    n[1] = _mm512_and_si512 (_mm512_srli_epi64 (el, 4), loset);
+    n[2] = _mm512_and_si512 (eh, loset);
+    n[3] = _mm512_and_si512 (_mm512_srli_epi64 (eh, 4), loset);
+    __m512i rl = _mm512_setzero_si512(), rh = _mm512_setzero_si512();
+    for (int k=0; k<4; k++) {
+        rl = _mm512_xor_si512 (rl, _mm512_shuffle_epi8 (tl[k], n[k]));
+        rh = _mm512_xor_si512 (rh, _mm512_shuffle_epi8 (th[k], n[k]));
+    }
+    *y0 = _mm512_unpacklo_epi8 (rh, rl);
+    *y1 = _mm512_unpackhi_epi8 (rh, rl);
+}
+
+TARGET_AVX512BW
+static void multiply_add_region16_avx512bw(uint8_t *dst, uint8_t *src, const struct gf_mult_const16 *mc, int bytes)
+{
+    __m512i tl[4], th[4], y0, y1;
+    int i;
+    for (int k=0; k<4; k++) {
+        tl[k] = _mm512_broadcast_i32x4(_mm_loadu_si128 ((__m128i *)(mc->lo[k])));
+        th[k] = _mm512_broadcast_i32x4(_mm_loadu_si128 ((__m128i *)(mc->hi[k])));
+    }
+    for (i=0; i+128<=bytes; i+=128) {
+        mult16_avx512bw(_mm512_loadu_si512 ((void *)(src+i)), _mm512_loadu_si512 ((void *)(src+i+64)), tl, th, &y0, &y1);
+        _mm512_storeu_si512 ((void *)(dst+i), _mm512_xor_si512 (y0, _mm512_loadu_si512 ((void *)(dst+i))));
+        _mm512_storeu_si512 ((void *)(dst+i+64), _mm512_xor_si512 (y1, _mm512_loadu_si512 ((void *)(dst+i+64))));
+    }
+    multiply_add_region16_avx2(dst+i, src+i, mc, bytes-i);
+}
+
+TARGET_AVX512BW
+static void multiply_region16_avx512bw(uint8_t *src, const struct gf_mult_const16 *mc, int bytes)
+{
+    __m512i tl[4], th[4], y0, y1;
+    int i;
+    for (int k=0; k<4; k++) {
+        tl[k] = _mm512_broadcast_i32x4(_mm_loadu_si128 ((__m128i *)(mc->lo[k])));
+        th[k] = _mm512_broadcast_i32x4(_mm_loadu_si128 ((__m128i *)(mc->hi[k])));
+    }
+    for (i=0; i+128<=bytes; i+=128) {
+        mult16_avx512bw(_mm512_loadu_si512 ((void *)(src+i)), _mm512_loadu_si512 ((void *)(src+i+64)), tl, th, &y0, &y1);
+        _mm512_storeu_si512 ((void *)(src+i), y0);
+        _mm512_storeu_si512 ((void *)(src+i+64), y1);
+    }
+    multiply_region16_avx2(src+i, mc, bytes-i);
+}
+#endif  // ifdef(GALOIS_X86)
@@ -1,8 +1,9 @@
 /*-------------------- galois.h ---------------------------------
  * Internal header file of Galois field implementation. 
  *
- * Targeting on byte-based computation systems, we only implement 
- * GF(2^8). GF(2) is naturally included.
+ * Targeting on byte-based computation systems, we implement GF(2^m)
+ * for m=2,...,8 (GF(2) uses GF(2^8)), and GF(2^16) for large
+ * generations.
  *--------------------------------------------------------------*/
 #ifndef GALOIS_H
 #define GALOIS_H
@@ -13,12 +14,54 @@
 #define GALOIS
 typedef unsigned char GF_ELEMENT;
 #endif
+typedef uint16_t GF_WORD;           // value of an element of any supported field
+// SIMD levels of the region kernels, chosen at run time when the first field is created
+#define GF_SIMD_AUTO        -1
+#define GF_SIMD_SCALAR      0
+#define GF_SIMD_SSSE3       1
+#define GF_SIMD_AVX2        2
+#define GF_SIMD_AVX512BW    3
+#define GF_SIMD_GFNI_AVX2   4
+#define GF_SIMD_GFNI_AVX512 5
+#define GF_SIMD_NUM         6
+// Galois field objects, shared and reference-counted per field size
+struct gf_field;
+struct gf_field *gf_field_get(int gf_power);
+void gf_field_put(struct gf_field *gf);
+int gf_field_power(const struct gf_field *gf);
+int gf_field_esize(const struct gf_field *gf);
+/*
+ * Element arrays (coefficient vectors, rows of decoding matrices) take one
+ * byte per element, except GF(2^16) elements which take two bytes, most
+ * significant first. esize is gf_field_esize() of the field.
+ */
+static inline GF_WORD gf_get_element(const GF_ELEMENT *a, int i, int esize)
+{
+    return esize == 1 ? a[i] : (GF_WORD) (a[2*i] << 8 | a[2*i+1]);
+}
+
+static inline void gf_set_element(GF_ELEMENT *a, int i, GF_WORD v, int esize)
+{
+    if (esize == 1) {
+        a[i] = v;
+    } else {
+        a[2*i]   = v >> 8;
+        a[2*i+1] = v & 0xff;
+    }
+}
 // Galois field arithmetic routines
-int constructField(int gf_power);
-uint8_t galois_add(uint8_t a, uint8_t b);
-uint8_t galois_sub(uint8_t a, uint8_t b);
-uint8_t galois_multiply(uint8_t a, uint8_t b);
-uint8_t galois_divide(uint8_t a, uint8_t b);
-void galois_multiply_region(uint8_t *src, uint8_t multiplier, int bytes);
-void galois_multiply_add_region(uint8_t *dst, uint8_t *src, uint8_t multiplier, int bytes);
+int galois_cpu_simd(void);                  // best SIMD level supported by the CPU
+int galois_set_simd(int simd);              // pin region kernels (also via env SNC_GF_SIMD)
+int galois_get_simd(void);
+const char *galois_simd_name(int simd);
+GF_WORD galois_add(GF_WORD a, GF_WORD b);
+GF_WORD galois_sub(GF_WORD a, GF_WORD b);
+GF_WORD galois_multiply(const struct gf_field *gf, GF_WORD a, GF_WORD b);
+GF_WORD galois_divide(const struct gf_field *gf, GF_WORD a, GF_WORD b);
+void galois_multiply_region(const struct gf_field *gf, uint8_t *src, GF_WORD multiplier, int bytes);
+void galois_multiply_add_region(const struct gf_field *gf, uint8_t *dst, uint8_t *src, GF_WORD multiplier, int bytes);
+void galois_multiply_add_region_packed(const struct gf_field *gf, uint8_t *dst, uint8_t *src, GF_WORD multiplier, int bytes);
+void galois_multiply_add_region_multi(const struct gf_field *gf, uint8_t *dst, uint8_t **srcs, uint8_t *coefs, int n, int bytes);
+void galois_multiply_add_region_multi_packed(const struct gf_field *gf, uint8_t *dst, uint8_t **srcs, uint8_t *coefs, int n, int bytes);
+void galois_multiply_add_region_scatter(const struct gf_field *gf, uint8_t **dsts, uint8_t *src, uint8_t *coefs, int n, int bytes);
 #endif
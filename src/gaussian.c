@@ -6,32 +6,79 @@
  *      A x = B
  *
  * No specific form of A and B is assumed. Operations on A and B are
- * performed simultaneously.
+ * performed simultaneously. Rows of A are element arrays of the field
+ * (see gf_get_element()), rows of B are regions of bytes allocated by
+ * calloc_payload(), so B is operated over its padded length.
  -------------------------------------------------------------------*/
+#include <stdlib.h>
+#include "common.h"
 #include "galois.h"
 
+/*
+ * Make gs hold matrices of up to rows rows and columns, keeping it if it
+ * is large enough. Return 0 on success, -1 on error (gs is unchanged).
+ */
+int alloc_gauss_scratch(struct gauss_scratch *gs, const struct gf_field *gf, int rows)
+{
+    if (rows <= gs->rows)
+        return (0);
+    GF_ELEMENT **dstA = malloc(sizeof(GF_ELEMENT*) * rows);
+    GF_ELEMENT **dstB = malloc(sizeof(GF_ELEMENT*) * rows);
+    GF_ELEMENT *quotients = malloc(sizeof(GF_ELEMENT) * rows * gf_field_esize(gf));
+    if (dstA == NULL || dstB == NULL || quotients == NULL) {
+        free(dstA);
+        free(dstB);
+        free(quotients);
+        return (-1);
+    }
+    free_gauss_scratch(gs);
+    gs->rows      = rows;
+    gs->dstA      = dstA;
+    gs->dstB      = dstB;
+    gs->quotients = quotients;
+    return (0);
+}
+
+void free_gauss_scratch(struct gauss_scratch *gs)
+{
+    free(gs->dstA);
+    free(gs->dstB);
+    free(gs->quotients);
+    gs->rows      = 0;
+    gs->dstA      = NULL;
+    gs->dstB      = NULL;
+    gs->quotients = NULL;
+}
+
 // perform forward substitution on a matrix to transform it to a upper triangular structure
 //static long long forward_substitute(int nrow, int ncolA, int ncolB, GF_ELEMENT A[][ncolA], GF_ELEMENT B[][ncolB])
-long long forward_substitute(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B)
+// gs must hold nrow rows
+long long forward_substitute(const struct gf_field *gf, struct gauss_scratch *gs, int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B)
 {
     //printf("entering foward_substitute()...\n");
     long operations = 0;
     int i, j, k, m, n, p;
     int pivot;
-    GF_ELEMENT quotient;
+    GF_WORD quotient;
+    int esize = gf_field_esize(gf);
 
     // transform A into upper triangular structure by row operation
     int boundary = nrow >= ncolA ? ncolA : nrow;
 
+    // rows to be eliminated by the current pivot row and their quotients
+    GF_ELEMENT **dstA = gs->dstA;
+    GF_ELEMENT **dstB = gs->dstB;
+    GF_ELEMENT *quotients = gs->quotients;
+
     int has_a_dimension;
     for (i=0; i<boundary; i++) {
         has_a_dimension = 1;            // whether this column is all-zero
 
-        if (A[i][i] == 0) {
+        if (gf_get_element(A[i], i, esize) == 0) {
             has_a_dimension = 0;
             /* Look for nonzero element below diagonal */
             for (pivot=i+1; pivot<nrow; pivot++) {
-                if (A[pivot][i] != 0) {
+                if (gf_get_element(A[pivot], i, esize) != 0) {
                     has_a_dimension = 1;
                     break;
                 }
@@ -42,7 +89,7 @@ long long forward_substitute(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_
             else {
                 // swap row
                 GF_ELEMENT tmp2;
-                for (m=0; m<ncolA; m++) {
+                for (m=0; m<ncolA*esize; m++) {
                     tmp2 = A[i][m];
                     A[i][m] = A[pivot][m];
                     A[pivot][m] = tmp2;
@@ -56,47 +103,58 @@ long long forward_substitute(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_
             }
         }
         // Eliminate nonzero elements beow diagonal
+        n = 0;
         for (j=i+1; j<nrow; j++) {
-            if (A[j][i] == 0)
+            if (gf_get_element(A[j], i, esize) == 0)
                 continue;   // skip zeros
-            quotient = galois_divide(A[j][i], A[i][i]);
+            quotient = galois_divide(gf, gf_get_element(A[j], i, esize), gf_get_element(A[i], i, esize));
             operations += 1;
-            // eliminate the items under row i at col i
-            galois_multiply_add_region(&(A[j][i]), &(A[i][i]), quotient, ncolA-i);
-            operations += (ncolA-i);
-            // simultaneously do the same thing on right matrix B
-            galois_multiply_add_region(B[j], B[i], quotient, ncolB);
-            operations += ncolB;
+            operations += (ncolA-i) + ncolB;
+            dstA[n] = &(A[j][i*esize]);
+            dstB[n] = B[j];
+            gf_set_element(quotients, n++, quotient, esize);
         }
+        // eliminate the items under row i at col i, and simultaneously
+        // do the same thing on right matrix B
+        galois_multiply_add_region_scatter(gf, dstA, &(A[i][i*esize]), quotients, n, (ncolA-i)*esize);
+        galois_multiply_add_region_scatter(gf, dstB, B[i], quotients, n, PADDED(ncolB));
     }
     return operations;
 }
 
 // perform back-substitution on full-rank upper trianguler matrix A
-long long back_substitute(int nrow, int ncolA, int ncolB, GF_ELEMENT *A[], GF_ELEMENT *B[])
+// gs must hold ncolA rows
+long long back_substitute(const struct gf_field *gf, struct gauss_scratch *gs, int nrow, int ncolA, int ncolB, GF_ELEMENT *A[], GF_ELEMENT *B[])
 {
     //printf("entering back_substitute()...\n");
     long operations = 0;
 
     // Transform the upper triangular matrix A into diagonal.
-    int i, j, k, l;
+    int i, j, n;
+    int esize = gf_field_esize(gf);
+    GF_ELEMENT **dstB = gs->dstB;
+    GF_ELEMENT *quotients = gs->quotients;
     for (i=ncolA-1; i>=0; i--) {
+        GF_WORD diag = gf_get_element(A[i], i, esize);
         // eliminate all items above A[i][i]
+        n = 0;
         for (j=0; j<i; j++) {
-            if (A[j][i] == 0)
+            if (gf_get_element(A[j], i, esize) == 0)
                 continue;       // skip zeros
-            GF_ELEMENT quotient = galois_divide(A[j][i], A[i][i]);
+            GF_WORD quotient = galois_divide(gf, gf_get_element(A[j], i, esize), diag);
             operations += 1;
-            A[j][i] = 0;
-            // doing accordingly to B
-            galois_multiply_add_region(B[j], B[i], quotient, ncolB);
+            gf_set_element(A[j], i, 0, esize);
             operations += ncolB;
+            gf_set_element(quotients, n, quotient, esize);
+            dstB[n++] = B[j];
         }
+        // doing accordingly to B, one pass over B[i] for all rows above
+        galois_multiply_add_region_scatter(gf, dstB, B[i], quotients, n, PADDED(ncolB));
         // diagonalize diagonal element
-        if (A[i][i] != 1) {
-            galois_multiply_region(B[i], galois_divide(1, A[i][i]), ncolB);
+        if (diag != 1) {
+            galois_multiply_region(gf, B[i], galois_divide(gf, 1, diag), PADDED(ncolB));
             operations += ncolB;
-            A[i][i] = 1;
+            gf_set_element(A[i], i, 1, esize);
         }
 
     }
@@ -43,8 +43,8 @@ struct subscripts
 /*
  * Procedures to pivot matrix.
  */
-static int inactivation_pivoting(int nrow, int ncolA, GF_ELEMENT **A, ssList *RowPivots, ssList *ColPivots);
-static int zlatev_pivoting(int nrow, int ncolA, GF_ELEMENT **A, ssList *RowPivots, ssList *ColPivots);
+static int inactivation_pivoting(int nrow, int ncolA, int esize, GF_ELEMENT **A, ssList *RowPivots, ssList *ColPivots);
+static int zlatev_pivoting(int nrow, int ncolA, int esize, GF_ELEMENT **A, ssList *RowPivots, ssList *ColPivots);
 
 /*
  * Reshape matrix A and B of Ax=B according to pivot sequence in (RowPivots, ColPivots)
@@ -65,8 +65,8 @@ static void insertSubAtEnd(ssList *sub_list, Subscript *sub);
 static void removeSubscript(ssList *sub_list, Subscript *sub);
 static void free_subscriptList(ssList *sub_list);
 
-extern long long forward_substitute(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B);
-extern long long back_substitute(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B);
+extern long long forward_substitute(const struct gf_field *gf, struct gauss_scratch *gs, int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B);
+extern long long back_substitute(const struct gf_field *gf, struct gauss_scratch *gs, int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B);
 
 /**********************************************************************************
  * pivot_matrix_x()
@@ -82,7 +82,7 @@ extern long long back_substitute(int nrow, int ncolA, int ncolB, GF_ELEMENT **A,
  * Parameters:
  *  nrow  - number of rows of A and B
  *  ncolA - number of columns of A
- *  ncolB - number of columns of B
+ *  ncolB - number of columns of B (rows of B are from calloc_payload())
  *
  * Return:
  *  number of Galois field operations consumed
@@ -107,9 +107,10 @@ extern long long back_substitute(int nrow, int ncolA, int ncolB, GF_ELEMENT **A,
  *
  **********************************************************************************/
 
-long pivot_matrix_oneround(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B, int **ptr_ctoo_r, int **ptr_ctoo_c, int *inactives)
+long pivot_matrix_oneround(const struct gf_field *gf, struct gauss_scratch *gs, int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B, int **ptr_ctoo_r, int **ptr_ctoo_c, int *inactives)
 {
     int i, j, k;
+    int esize = gf_field_esize(gf);
     long operations = 0;
     ssList *row_pivots = malloc(sizeof(ssList));
     ssList *col_pivots = malloc(sizeof(ssList));
@@ -124,7 +125,7 @@ long pivot_matrix_oneround(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_EL
         printf("Inactivation pivoting... IA_INIT: %d, IA_STEP: %d.\n", IA_INIT, IA_STEP);
         start_pivoting = clock();
     }
-    int ias = inactivation_pivoting(nrow, ncolA, A, row_pivots, col_pivots);
+    int ias = inactivation_pivoting(nrow, ncolA, esize, A, row_pivots, col_pivots);
     *inactives = ias;
     if (get_loglevel() == TRACE) {
         printf("A total of %d/%d columns are inactivated.\n", ias, ncolA);
@@ -154,45 +155,45 @@ long pivot_matrix_oneround(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_EL
     // To save random access time, we still need to make a copy of the top-right (nColA-ias) x ias matrix U.
     GF_ELEMENT **U = calloc(ncolA-ias, sizeof(GF_ELEMENT*));
     for (i=0; i<ncolA-ias; i++) {
-        U[i] = calloc(ias, sizeof(GF_ELEMENT));
+        U[i] = calloc(ias, sizeof(GF_ELEMENT)*esize);
         for (j=0; j<ias; j++)
-            U[i][j] = A[ctoo_r[i]][ctoo_c[ncolA-ias+j]];
+            gf_set_element(U[i], j, gf_get_element(A[ctoo_r[i]], ctoo_c[ncolA-ias+j], esize), esize);
     }
     // And also make a copy of the bottom-right (ias x ias) matrix T.
     // This kind of copy is a tradeoff between memory usage and access time. 
     GF_ELEMENT **T = calloc(ias, sizeof(GF_ELEMENT*));
     for (i=0; i<ias; i++){
-        T[i] = calloc(ias, sizeof(GF_ELEMENT));
+        T[i] = calloc(ias, sizeof(GF_ELEMENT)*esize);
         for (j=0; j<ias; j++)
-            T[i][j] = A[ctoo_r[ncolA-ias+i]][ctoo_c[ncolA-ias+j]];
+            gf_set_element(T[i], j, gf_get_element(A[ctoo_r[ncolA-ias+i]], ctoo_c[ncolA-ias+j], esize), esize);
     }
     // Start to diagonalize
     clock_t start_p, stop_p;
     start_p = clock();
     long long ops1=0;
-    GF_ELEMENT quotient;
+    GF_WORD quotient;
     nonzeros = 0;
     for (i=0; i<ncolA-ias; i++) {
         for (j=i+1; j<ncolA; j++) {
-            if (A[ctoo_r[i]][ctoo_c[i]] == 0 && get_loglevel() == TRACE)
+            if (gf_get_element(A[ctoo_r[i]], ctoo_c[i], esize) == 0 && get_loglevel() == TRACE)
                 printf("The diagonal element after re-ordering is nonzero.\n");
             // process the item on (j, i)
-            if (A[ctoo_r[j]][ctoo_c[i]] != 0) {
-                quotient = galois_divide(A[ctoo_r[j]][ctoo_c[i]], A[ctoo_r[i]][ctoo_c[i]]);
+            if (gf_get_element(A[ctoo_r[j]], ctoo_c[i], esize) != 0) {
+                quotient = galois_divide(gf, gf_get_element(A[ctoo_r[j]], ctoo_c[i], esize), gf_get_element(A[ctoo_r[i]], ctoo_c[i], esize));
                 ops1 += 1;
                 // multiply-and-add the corresponding part in the inactive part
                 if (j < ncolA-ias) {
                     // eliminating nonzeros in the first ncolA-ias rows (but below diagonal)
-                    galois_multiply_add_region(U[j], U[i], quotient, ias);
+                    galois_multiply_add_region(gf, U[j], U[i], quotient, ias*esize);
                 } else {
                     // eliminating nonzeros in the last ias rows
-                    galois_multiply_add_region(T[j-(ncolA-ias)], U[i], quotient, ias);
+                    galois_multiply_add_region(gf, T[j-(ncolA-ias)], U[i], quotient, ias*esize);
                 }
                 ops1 += ias;    // This part of matrix in processing is lower triangular in part, so operations only needed in the back half (i.e., inactiavted part)
                 // simultaneously do the same thing on right matrix B
-                galois_multiply_add_region(B[ctoo_r[j]], B[ctoo_r[i]], quotient, ncolB);
+                galois_multiply_add_region(gf, B[ctoo_r[j]], B[ctoo_r[i]], quotient, PADDED(ncolB));
                 ops1 += ncolB;
-                A[ctoo_r[j]][ctoo_c[i]] = 0;            // eliminate the item
+                gf_set_element(A[ctoo_r[j]], ctoo_c[i], 0, esize);            // eliminate the item
                 nonzeros += 1;
             }
         }
@@ -206,13 +207,13 @@ long pivot_matrix_oneround(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_EL
     // Copy U and T back, free U but keep T for forward substitution
     for (i=0; i<ncolA-ias; i++) {
         for (j=0; j<ias; j++)
-            A[ctoo_r[i]][ctoo_c[ncolA-ias+j]] = U[i][j];
+            gf_set_element(A[ctoo_r[i]], ctoo_c[ncolA-ias+j], gf_get_element(U[i], j, esize), esize);
         free(U[i]);
     }
     free(U);
     for (i=0; i<ias; i++) {
         for (j=0; j<ias; j++)
-            A[ctoo_r[ncolA-ias+i]][ctoo_c[ncolA-ias+j]] = T[i][j];
+            gf_set_element(A[ctoo_r[ncolA-ias+i]], ctoo_c[ncolA-ias+j], gf_get_element(T[i], j, esize), esize);
     }
 
     /* Perform forward substitution on the ias x ias dense inactivated matrix. */
@@ -224,7 +225,7 @@ long pivot_matrix_oneround(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_EL
         for (i=0; i<ias; i++) {
             for (j=0; j<ias; j++) {
                 total++;
-                if (T[i][j] != 0)
+                if (gf_get_element(T[i], j, esize) != 0)
                     nonzeros++;
             }
         }
@@ -235,16 +236,16 @@ long pivot_matrix_oneround(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_EL
     // Make a copy of the corresponding msg matrices of T before performing forward substitution. 
     GF_ELEMENT **msg_submatrix = calloc(ias, sizeof(GF_ELEMENT*));
     for (i=0; i<ias; i++){
-        msg_submatrix[i] = calloc(ncolB, sizeof(GF_ELEMENT));
+        msg_submatrix[i] = calloc_payload(ncolB);
         memcpy(msg_submatrix[i], B[ctoo_r[ncolA-ias+i]], ncolB*sizeof(GF_ELEMENT));
     }
 
-    long long ops = forward_substitute(ias, ias, ncolB, T, msg_submatrix);
+    long long ops = forward_substitute(gf, gs, ias, ias, ncolB, T, msg_submatrix);
     operations += ops;
     // Save the processed inactivated part back to A
     for (i=0; i<ias; i++) {
         for (j=0; j<ias; j++)
-            A[ctoo_r[ncolA-ias+i]][ctoo_c[ncolA-ias+j]] = T[i][j];
+            gf_set_element(A[ctoo_r[ncolA-ias+i]], ctoo_c[ncolA-ias+j], gf_get_element(T[i], j, esize), esize);
         memcpy(B[ctoo_r[ncolA-ias+i]], msg_submatrix[i], ncolB*sizeof(GF_ELEMENT));
     }
 
@@ -264,7 +265,7 @@ long pivot_matrix_oneround(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_EL
     if (get_loglevel() == TRACE) {
         int missing_pivots = 0;
         for (i=0; i<ncolA; i++) {
-            if (A[ctoo_r[i]][ctoo_c[i]] == 0)
+            if (gf_get_element(A[ctoo_r[i]], ctoo_c[i], esize) == 0)
                 missing_pivots += 1;
         }
         printf("There are %d pivots missing after forward substitution\n", missing_pivots);
@@ -283,9 +284,10 @@ long pivot_matrix_oneround(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_EL
  *
  ********************************************************************************/
 
-long pivot_matrix_tworound(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B, int **ptr_ctoo_r, int **ptr_ctoo_c, int *inactives)
+long pivot_matrix_tworound(const struct gf_field *gf, struct gauss_scratch *gs, int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_ELEMENT **B, int **ptr_ctoo_r, int **ptr_ctoo_c, int *inactives)
 {
     int i, j, k;
+    int esize = gf_field_esize(gf);
     long operations = 0;
     // First pivoting: inactivation
     ssList *row_pivots = malloc(sizeof(ssList));
@@ -301,7 +303,7 @@ long pivot_matrix_tworound(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_EL
         printf("Inactivation pivoting... IA_INIT: %d, IA_STEP: %d.\n", IA_INIT, IA_STEP);
         start_pivoting = clock();
     }
-    int ias = inactivation_pivoting(nrow, ncolA, A, row_pivots, col_pivots);
+    int ias = inactivation_pivoting(nrow, ncolA, esize, A, row_pivots, col_pivots);
     *inactives = ias;
     if (get_loglevel() == TRACE) {
         printf("A total of %d/%d columns are inactivated.\n", ias, ncolA);
@@ -331,45 +333,45 @@ long pivot_matrix_tworound(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_EL
     // To save random access time, we still need to make a copy of the top-right (nColA-ias) x ias matrix U.
     GF_ELEMENT **U = calloc(ncolA-ias, sizeof(GF_ELEMENT*));
     for (i=0; i<ncolA-ias; i++) {
-        U[i] = calloc(ias, sizeof(GF_ELEMENT));
+        U[i] = calloc(ias, sizeof(GF_ELEMENT)*esize);
         for (j=0; j<ias; j++)
-            U[i][j] = A[ctoo_r[i]][ctoo_c[ncolA-ias+j]];
+            gf_set_element(U[i], j, gf_get_element(A[ctoo_r[i]], ctoo_c[ncolA-ias+j], esize), esize);
     }
     // And also make a copy of the bottom-right (ias x ias) matrix T.
     // This kind of copy is a tradeoff between memory usage and access time. 
     GF_ELEMENT **T = calloc(ias, sizeof(GF_ELEMENT*));
     for (i=0; i<ias; i++){
-        T[i] = calloc(ias, sizeof(GF_ELEMENT));
+        T[i] = calloc(ias, sizeof(GF_ELEMENT)*esize);
         for (j=0; j<ias; j++)
-            T[i][j] = A[ctoo_r[ncolA-ias+i]][ctoo_c[ncolA-ias+j]];
+            gf_set_element(T[i], j, gf_get_element(A[ctoo_r[ncolA-ias+i]], ctoo_c[ncolA-ias+j], esize), esize);
     }
     // Start to diagonalize
     clock_t start_p, stop_p;
     start_p = clock();
     long long ops1=0;
-    GF_ELEMENT quotient;
+    GF_WORD quotient;
     nonzeros = 0;
     for (i=0; i<ncolA-ias; i++) {
         for (j=i+1; j<ncolA; j++) {
-            if (A[ctoo_r[i]][ctoo_c[i]] == 0 && get_loglevel() == TRACE)
+            if (gf_get_element(A[ctoo_r[i]], ctoo_c[i], esize) == 0 && get_loglevel() == TRACE)
                 printf("The diagonal element after re-ordering is nonzero.\n");
             // process the item on (j, i)
-            if (A[ctoo_r[j]][ctoo_c[i]] != 0) {
-                quotient = galois_divide(A[ctoo_r[j]][ctoo_c[i]], A[ctoo_r[i]][ctoo_c[i]]);
+            if (gf_get_element(A[ctoo_r[j]], ctoo_c[i], esize) != 0) {
+                quotient = galois_divide(gf, gf_get_element(A[ctoo_r[j]], ctoo_c[i], esize), gf_get_element(A[ctoo_r[i]], ctoo_c[i], esize));
                 ops1 += 1;
                 // multiply-and-add the corresponding part in the inactive part
                 if (j < ncolA-ias) {
                     // eliminating nonzeros in the first ncolA-ias rows (but below diagonal)
-                    galois_multiply_add_region(U[j], U[i], quotient, ias);
+                    galois_multiply_add_region(gf, U[j], U[i], quotient, ias*esize);
                 } else {
                     // eliminating nonzeros in the last ias rows
-                    galois_multiply_add_region(T[j-(ncolA-ias)], U[i], quotient, ias);
+                    galois_multiply_add_region(gf, T[j-(ncolA-ias)], U[i], quotient, ias*esize);
                 }
                 ops1 += ias;    // This part of matrix in processing is lower triangular in part, so operations only needed in the back half (i.e., inactiavted part)
                 // simultaneously do the same thing on right matrix B
-                galois_multiply_add_region(B[ctoo_r[j]], B[ctoo_r[i]], quotient, ncolB);
+                galois_multiply_add_region(gf, B[ctoo_r[j]], B[ctoo_r[i]], quotient, PADDED(ncolB));
                 ops1 += ncolB;
-                A[ctoo_r[j]][ctoo_c[i]] = 0;            // eliminate the item
+                gf_set_element(A[ctoo_r[j]], ctoo_c[i], 0, esize);            // eliminate the item
                 nonzeros += 1;
             }
         }
@@ -383,13 +385,13 @@ long pivot_matrix_tworound(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_EL
     // Copy U and T back, free U but keep T as it is still needed for further pivoting
     for (i=0; i<ncolA-ias; i++) {
         for (j=0; j<ias; j++)
-            A[ctoo_r[i]][ctoo_c[ncolA-ias+j]] = U[i][j];
+            gf_set_element(A[ctoo_r[i]], ctoo_c[ncolA-ias+j], gf_get_element(U[i], j, esize), esize);
         free(U[i]);
     }
     free(U);
     for (i=0; i<ias; i++) {
         for (j=0; j<ias; j++)
-            A[ctoo_r[ncolA-ias+i]][ctoo_c[ncolA-ias+j]] = T[i][j];
+            gf_set_element(A[ctoo_r[ncolA-ias+i]], ctoo_c[ncolA-ias+j], gf_get_element(T[i], j, esize), esize);
     }
 
     // Second round of pivoting
@@ -402,7 +404,7 @@ long pivot_matrix_tworound(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_EL
         printf("Zlatev pivoting...\n");
         start_pivoting = clock();
     }
-    int ias_2nd = zlatev_pivoting(ias, ias, T, row_pivots_2nd, col_pivots_2nd);
+    int ias_2nd = zlatev_pivoting(ias, ias, esize, T, row_pivots_2nd, col_pivots_2nd);
     if (get_loglevel() == TRACE) {
         stop_pivoting = clock();
         pivoting_time = ((double) (stop_pivoting - start_pivoting)) / CLOCKS_PER_SEC;
@@ -435,7 +437,7 @@ long pivot_matrix_tworound(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_EL
         for (i=0; i<ias; i++) {
             for (j=0; j<ias; j++) {
                 total++;
-                if (T[i][j] != 0)
+                if (gf_get_element(T[i], j, esize) != 0)
                     nonzeros++;
             }
         }
@@ -446,18 +448,18 @@ long pivot_matrix_tworound(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_EL
     // Make a copy of the corresponding msg matrices of T before performing forward substitution. 
     GF_ELEMENT **msg_submatrix = calloc(ias, sizeof(GF_ELEMENT*));
     for (i=0; i<ias; i++){
-        msg_submatrix[i] = calloc(ncolB, sizeof(GF_ELEMENT));
+        msg_submatrix[i] = calloc_payload(ncolB);
         for (j=0; j<ias; j++)
-            T[i][j] = A[ctoo_r[ncolA-ias+i]][ctoo_c[ncolA-ias+j]];  // reuse allocated memory, but data needs refresh because ctoo_r/ctoo_c were updated
+            gf_set_element(T[i], j, gf_get_element(A[ctoo_r[ncolA-ias+i]], ctoo_c[ncolA-ias+j], esize), esize);  // reuse allocated memory, but data needs refresh because ctoo_r/ctoo_c were updated
         memcpy(msg_submatrix[i], B[ctoo_r[ncolA-ias+i]], ncolB*sizeof(GF_ELEMENT));
     }
 
-    long long ops = forward_substitute(ias, ias, ncolB, T, msg_submatrix);
+    long long ops = forward_substitute(gf, gs, ias, ias, ncolB, T, msg_submatrix);
     operations += ops;
     // Save the processed inactivated part back to A
     for (i=0; i<ias; i++) {
         for (j=0; j<ias; j++)
-            A[ctoo_r[ncolA-ias+i]][ctoo_c[ncolA-ias+j]] = T[i][j];
+            gf_set_element(A[ctoo_r[ncolA-ias+i]], ctoo_c[ncolA-ias+j], gf_get_element(T[i], j, esize), esize);
         memcpy(B[ctoo_r[ncolA-ias+i]], msg_submatrix[i], ncolB*sizeof(GF_ELEMENT));
     }
 
@@ -477,7 +479,7 @@ long pivot_matrix_tworound(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_EL
     if (get_loglevel() == TRACE) {
         int missing_pivots = 0;
         for (i=0; i<ncolA; i++) {
-            if (A[ctoo_r[i]][ctoo_c[i]] == 0)
+            if (gf_get_element(A[ctoo_r[i]], ctoo_c[i], esize) == 0)
                 missing_pivots += 1;
         }
         printf("There are %d pivots missing after forward substitution\n", missing_pivots);
@@ -493,7 +495,7 @@ long pivot_matrix_tworound(int nrow, int ncolA, int ncolB, GF_ELEMENT **A, GF_EL
  * A special kind of Markowitz pivoting in which pivots are selected from 3
  * candidates who have the smallest nonzeros.
  ******************************************************************************/
-static int zlatev_pivoting(int nrow, int ncolA, GF_ELEMENT **A, ssList *RowPivots, ssList *ColPivots)
+static int zlatev_pivoting(int nrow, int ncolA, int esize, GF_ELEMENT **A, ssList *RowPivots, ssList *ColPivots)
 {
     // Nonzeros of each rows and cols
     int *row_counts = (int *) calloc(nrow, sizeof(int));
@@ -504,7 +506,7 @@ static int zlatev_pivoting(int nrow, int ncolA, GF_ELEMENT **A, ssList *RowPivot
     int max_col1s = 0;          // Max number of nonzeros in a column
     for (i=0; i<nrow; i++) {
         for (j=0; j<ncolA; j++) {
-            if (A[i][j] != 0) {
+            if (gf_get_element(A[i], j, esize) != 0) {
                 row_counts[i] += 1;
                 if (row_counts[i] > max_row1s)
                     max_row1s = row_counts[i];
@@ -597,7 +599,7 @@ static int zlatev_pivoting(int nrow, int ncolA, GF_ELEMENT **A, ssList *RowPivot
                     cols_inchecking = ColID_lists[j]->ssFirst;
                     while (cols_inchecking != NULL) {
                         col_id = cols_inchecking->index;
-                        if (A[row_id][col_id] != 0) {
+                        if (gf_get_element(A[row_id], col_id, esize) != 0) {
                             // we have found an entry in (row_id)-th row
                             current_mc = (i-1) * (j-1);
                             if (current_mc == 0) {
@@ -684,7 +686,7 @@ found:
         for (i=1; i<=max_col1s; i++) {
             ss_pt = ColID_lists[i]->ssFirst;
             while (ss_pt != NULL) {
-                if (A[p_r][ss_pt->index] != 0) {
+                if (gf_get_element(A[p_r], ss_pt->index, esize) != 0) {
                     // 该subscript对象将要被更新处理，因此要记下当前遍历的位置
                     ss_pt_next = ss_pt->next;
                     if (ss_pt->index == p_c) {
@@ -710,7 +712,7 @@ found:
         for (j=1; j<=max_row1s; j++) {
             ss_pt = RowID_lists[j]->ssFirst;
             while (ss_pt != NULL) {
-                if (A[ss_pt->index][p_c] != 0) {
+                if (gf_get_element(A[ss_pt->index], p_c, esize) != 0) {
                     // 该subscript对象将要被更新处理，因此要记下当前遍历的位置
                     ss_pt_next = ss_pt->next;
                     if (ss_pt->index == p_r) {
@@ -759,7 +761,7 @@ found:
  *  2) if singleton row cannot be found in the middle of pivoting, declare more inactive columns
  *  3) given the structure (heavier columns are in the back), declare inactive columns from the back
  *********************************************************************************************************/
-static int inactivation_pivoting(int nrow, int ncolA, GF_ELEMENT **A, ssList *RowPivots, ssList *ColPivots)
+static int inactivation_pivoting(int nrow, int ncolA, int esize, GF_ELEMENT **A, ssList *RowPivots, ssList *ColPivots)
 {
     if (get_loglevel() == TRACE)
         printf("Pivoting matrix of size %d x %d via inactivation.\n", nrow, ncolA);
@@ -773,7 +775,7 @@ static int inactivation_pivoting(int nrow, int ncolA, GF_ELEMENT **A, ssList *Ro
     int max_col1s = 0;                  // 记录初始矩阵里列中非零元素数目的最大值
     for (i=0; i<nrow; i++) {
         for (j=0; j<ncolA; j++) {
-            if (A[i][j] != 0) {
+            if (gf_get_element(A[i], j, esize) != 0) {
                 row_counts[i] += 1;
                 if (row_counts[i] > max_row1s)
                     max_row1s = row_counts[i];
@@ -832,7 +834,7 @@ static int inactivation_pivoting(int nrow, int ncolA, GF_ELEMENT **A, ssList *Ro
         if (singleton_r_found == 1) {
             // a singleton row is found, store the pivot
             for (j=0; j<ncolA; j++) {
-                if ((col_state[j]==0) && (A[p_r][j]!=0)) {
+                if ((col_state[j]==0) && (gf_get_element(A[p_r], j, esize)!=0)) {
                     p_c = j;
                     break;
                 }
@@ -857,7 +859,7 @@ static int inactivation_pivoting(int nrow, int ncolA, GF_ELEMENT **A, ssList *Ro
             // 更新row_counts
             row_counts[p_r] = -1;           // use -1 to indicate the row has an elelemnt was chosen as pivot
             for (i=0; i<nrow; i++) {
-                if ( (row_counts[i] != -1) && (A[i][p_c] != 0) ) {
+                if ( (row_counts[i] != -1) && (gf_get_element(A[i], p_c, esize) != 0) ) {
                     row_counts[i] -= 1;
                 }
             }
@@ -889,7 +891,7 @@ static int inactivation_pivoting(int nrow, int ncolA, GF_ELEMENT **A, ssList *Ro
                     inactivated += 1;
                     active -= 1;
                     for (k=0; k<nrow; k++) {
-                        if ((A[k][ss_pt->index] != 0) && (row_counts[k] != -1))
+                        if ((gf_get_element(A[k], ss_pt->index, esize) != 0) && (row_counts[k] != -1))
                             row_counts[k] -= 1;
                     }
 
@@ -912,7 +914,7 @@ static int inactivation_pivoting(int nrow, int ncolA, GF_ELEMENT **A, ssList *Ro
             for (j=0; j<nrow; j++) {
                 if (row_counts[j] != -1) {
                     j_candidate = j;
-                    if (A[j][i] != 0)
+                    if (gf_get_element(A[j], i, esize) != 0)
                         break;
                 }
             }
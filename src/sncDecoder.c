@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include "common.h"
 #include "decoderGG.h"
@@ -7,6 +8,7 @@
 #include "decoderBD.h"
 #include "decoderCBD.h"
 #include "decoderPP.h"
+#include "decoderRP.h"
 #include "sparsenc.h"
 
 /* Definition of SNC decoder
@@ -22,42 +24,58 @@ struct snc_decoder {
 
 struct snc_decoder *snc_create_decoder(struct snc_parameters *sp, int d_type)
 {
+    return snc_create_decoder_opt(sp, d_type, NULL);
+}
+
+struct snc_decoder *snc_create_decoder_opt(struct snc_parameters *sp, int d_type, const struct snc_options *opt)
+{
+    if (opt == NULL)
+        opt = default_options();
     struct snc_decoder *decoder = malloc(sizeof(struct snc_decoder));
     if (decoder == NULL)
         return NULL;
 
+    // RAPTOR code is decoded by the RP decoder only, which decodes nothing else
+    if ((sp->type == RAPTOR_SNC) != (d_type == RP_DECODER)) {
+        fprintf(stderr, "snc_create_decoder: RAPTOR code needs the RP decoder and vice versa\n");
+        free(decoder);
+        return NULL;
+    }
     decoder->d_type = d_type;
 
     int allowed_oh = 0;  // allowed overhead of OA decoder
-    char *aoh;
     switch (decoder->d_type) {
     case GG_DECODER:
-        decoder->dec_ctx = create_dec_context_GG(sp);
+        decoder->dec_ctx = create_dec_context_GG(sp, opt);
         if (decoder->dec_ctx == NULL)
             goto failure;
         break;
     case OA_DECODER:
-        // Use environment variable to pass in allowed overhead for OA
-        if ( (aoh = getenv("SNC_OA_AOH")) != NULL) {
-            allowed_oh = ceil(atof(aoh) * ceil(sp->datasize / sp->size_p));
+        if (opt->oa_aoh != 0) {
+            allowed_oh = ceil(opt->oa_aoh * ceil(sp->datasize / sp->size_p));
             printf("Allowed overhead for OA decoder: %d\n", allowed_oh);
         }
-        decoder->dec_ctx = create_dec_context_OA(sp, allowed_oh);
+        decoder->dec_ctx = create_dec_context_OA(sp, allowed_oh, opt);
         if (decoder->dec_ctx == NULL)
             goto failure;
         break;
     case BD_DECODER:
-        decoder->dec_ctx = create_dec_context_BD(sp);
+        decoder->dec_ctx = create_dec_context_BD(sp, opt);
         if (decoder->dec_ctx == NULL)
             goto failure;
         break;
     case CBD_DECODER:
-        decoder->dec_ctx = create_dec_context_CBD(sp);
+        decoder->dec_ctx = create_dec_context_CBD(sp, opt);
         if (decoder->dec_ctx == NULL)
             goto failure;
         break;
     case PP_DECODER:
-        decoder->dec_ctx = create_dec_context_PP(sp);
+        decoder->dec_ctx = create_dec_context_PP(sp, opt);
+        if (decoder->dec_ctx == NULL)
+            goto failure;
+        break;
+    case RP_DECODER:
+        decoder->dec_ctx = create_dec_context_RP(sp, opt);
         if (decoder->dec_ctx == NULL)
             goto failure;
         break;
@@ -86,6 +104,9 @@ void snc_process_packet(struct snc_decoder *decoder, struct snc_packet *pkt)
     case PP_DECODER:
         process_packet_PP(((struct decoding_context_PP *) decoder->dec_ctx), pkt);
         break;
+    case RP_DECODER:
+        process_packet_RP(((struct decoding_context_RP *) decoder->dec_ctx), pkt);
+        break;
     }
     return;
 }
@@ -103,6 +124,8 @@ int snc_decoder_finished(struct snc_decoder *decoder)
         return ((struct decoding_context_CBD *) decoder->dec_ctx)->finished;
     case PP_DECODER:
         return ((struct decoding_context_PP *) decoder->dec_ctx)->finished;
+    case RP_DECODER:
+        return ((struct decoding_context_RP *) decoder->dec_ctx)->finished;
     }
     return 0;
 }
@@ -129,6 +152,8 @@ struct snc_context *snc_get_enc_context(struct snc_decoder *decoder)
         return ((struct decoding_context_CBD *) decoder->dec_ctx)->sc;
     case PP_DECODER:
         return ((struct decoding_context_PP *) decoder->dec_ctx)->sc;
+    case RP_DECODER:
+        return ((struct decoding_context_RP *) decoder->dec_ctx)->sc;
     }
     return 0;
 }
@@ -157,6 +182,9 @@ double snc_decode_overhead(struct snc_decoder *decoder)
     case PP_DECODER:
         ohs = ((struct decoding_context_PP *) decoder->dec_ctx)->overhead;
         break;
+    case RP_DECODER:
+        ohs = ((struct decoding_context_RP *) decoder->dec_ctx)->overhead;
+        break;
     }
     return ((double) ohs / snum);
 }
@@ -187,6 +215,9 @@ double snc_decode_cost(struct snc_decoder *decoder)
     case PP_DECODER:
         ops = ((struct decoding_context_PP *) decoder->dec_ctx)->operations;
         break;
+    case RP_DECODER:
+        ops = ((struct decoding_context_RP *) decoder->dec_ctx)->operations;
+        break;
     }
     return ((double) ops/snum/pktsize);
 }
@@ -211,6 +242,9 @@ void snc_free_decoder(struct snc_decoder *decoder)
     case PP_DECODER:
         free_dec_context_PP(((struct decoding_context_PP *) decoder->dec_ctx));
         break;
+    case RP_DECODER:
+        free_dec_context_RP(((struct decoding_context_RP *) decoder->dec_ctx));
+        break;
     }
     decoder->dec_ctx = NULL;
     free(decoder);
@@ -232,6 +266,8 @@ long snc_save_decoder_context(struct snc_decoder *decoder, const char *filepath)
         return save_dec_context_CBD((struct decoding_context_CBD *) decoder->dec_ctx, filepath);
     case PP_DECODER:
         return save_dec_context_PP((struct decoding_context_PP *) decoder->dec_ctx, filepath);
+    case RP_DECODER:
+        return save_dec_context_RP((struct decoding_context_RP *) decoder->dec_ctx, filepath);
     }
 }
 
@@ -271,5 +307,136 @@ struct snc_decoder *snc_restore_decoder(const char *filepath)
         decoder->dec_ctx = restore_dec_context_PP(filepath);
         decoder->d_type = PP_DECODER;
         return decoder;
+    case RP_DECODER:
+        decoder->dec_ctx = restore_dec_context_RP(filepath);
+        decoder->d_type = RP_DECODER;
+        return decoder;
+    }
+}
+
+/*
+ * Generate feedback of the subgenerations, the missing DoF of each being
+ * reported by the decoder from the pivots it holds.
+ */
+struct snc_feedback *snc_generate_feedback(struct snc_decoder *decoder)
+{
+    static char fname[] = "snc_generate_feedback";
+    struct snc_context *sc = snc_get_enc_context(decoder);
+    if (sc->gnum <= 0 || decoder->d_type == RP_DECODER)
+        return NULL;
+    struct snc_feedback *fb = malloc(sizeof(struct snc_feedback));
+    if (fb == NULL) {
+        fprintf(stderr, "%s: malloc feedback failed\n", fname);
+        return NULL;
+    }
+    fb->gnum      = sc->gnum;
+    fb->completed = calloc(ALIGN(sc->gnum, 8), sizeof(unsigned char));
+    fb->missing   = calloc(sc->gnum, sizeof(int));
+    if (fb->completed == NULL || fb->missing == NULL) {
+        fprintf(stderr, "%s: calloc feedback bitmap/missing failed\n", fname);
+        snc_free_feedback(fb);
+        return NULL;
+    }
+    for (int i=0; i<sc->gnum; i++) {
+        switch (decoder->d_type) {
+        case GG_DECODER:
+            fb->missing[i] = missing_dof_GG(decoder->dec_ctx, i);
+            break;
+        case OA_DECODER:
+            fb->missing[i] = missing_dof_OA(decoder->dec_ctx, i);
+            break;
+        case BD_DECODER:
+            fb->missing[i] = missing_dof_BD(decoder->dec_ctx, i);
+            break;
+        case CBD_DECODER:
+            fb->missing[i] = missing_dof_CBD(decoder->dec_ctx, i);
+            break;
+        case PP_DECODER:
+            fb->missing[i] = missing_dof_PP(decoder->dec_ctx, i);
+            break;
+        }
+        if (fb->missing[i] == 0)
+            set_bit_in_array(fb->completed, i);
     }
+    // generations decoded by GG are counted from the last feedback
+    if (decoder->d_type == GG_DECODER)
+        ((struct decoding_context_GG *) decoder->dec_ctx)->grcount = 0;
+    return fb;
+}
+
+/*
+ * Serialized feedback consists of the 4-byte number of subgenerations, the
+ * bitmap of completed subgenerations, and the 2-byte missing DoF of each of
+ * the unfinished ones (saturated at 65535).
+ */
+int snc_feedback_length(struct snc_feedback *fb)
+{
+    int unfinished = 0;
+    for (int i=0; i<fb->gnum; i++) {
+        if (!get_bit_in_array(fb->completed, i))
+            unfinished += 1;
+    }
+    return 4 + ALIGN(fb->gnum, 8) + 2 * unfinished;
+}
+
+unsigned char *snc_serialize_feedback(struct snc_feedback *fb)
+{
+    if (fb == NULL)
+        return NULL;
+    unsigned char *fbstr = calloc(snc_feedback_length(fb), sizeof(unsigned char));
+    if (fbstr == NULL)
+        return NULL;
+    int maplen = ALIGN(fb->gnum, 8);
+    memcpy(fbstr, &fb->gnum, 4);
+    memcpy(fbstr+4, fb->completed, maplen);
+    unsigned char *p = fbstr + 4 + maplen;
+    for (int i=0; i<fb->gnum; i++) {
+        if (get_bit_in_array(fb->completed, i))
+            continue;
+        uint16_t missing = fb->missing[i] > 0xffff ? 0xffff : fb->missing[i];
+        memcpy(p, &missing, 2);
+        p += 2;
+    }
+    return fbstr;
+}
+
+struct snc_feedback *snc_deserialize_feedback(unsigned char *fbstr)
+{
+    static char fname[] = "snc_deserialize_feedback";
+    if (fbstr == NULL)
+        return NULL;
+    struct snc_feedback *fb = malloc(sizeof(struct snc_feedback));
+    if (fb == NULL) {
+        fprintf(stderr, "%s: malloc feedback failed\n", fname);
+        return NULL;
+    }
+    memcpy(&fb->gnum, fbstr, 4);
+    int maplen = ALIGN(fb->gnum, 8);
+    fb->completed = malloc(maplen);
+    fb->missing   = calloc(fb->gnum, sizeof(int));
+    if (fb->completed == NULL || fb->missing == NULL) {
+        fprintf(stderr, "%s: malloc feedback bitmap/missing failed\n", fname);
+        snc_free_feedback(fb);
+        return NULL;
+    }
+    memcpy(fb->completed, fbstr+4, maplen);
+    unsigned char *p = fbstr + 4 + maplen;
+    for (int i=0; i<fb->gnum; i++) {
+        if (get_bit_in_array(fb->completed, i))
+            continue;
+        uint16_t missing;
+        memcpy(&missing, p, 2);
+        fb->missing[i] = missing;
+        p += 2;
+    }
+    return fb;
+}
+
+void snc_free_feedback(struct snc_feedback *fb)
+{
+    if (fb == NULL)
+        return;
+    free(fb->completed);
+    free(fb->missing);
+    free(fb);
 }
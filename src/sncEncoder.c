@@ -4,28 +4,38 @@
  * Functions for SNC encoding. Coded packets can be generated
  * from memory buffer or files.
  **************************************************************/
+#define _XOPEN_SOURCE 600    // mmap(), posix_madvise(), gettimeofday()
 #include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/time.h>
+#include <pthread.h>
 #include "common.h"
 #include "galois.h"
 #include "sparsenc.h"
 
-static int GFpower;  // GF power of encoding
-
-extern int BALLOC; // number of batch pointers allocation in one shot
-static int currbid = -1;   // used by BATS-like codes, ID of the current sending batch
-static int batsent = 0;    // used by BATS-like codes, number of sent packets from the current batch
 
 static int create_context_from_params(struct snc_context *sc);
 static int verify_code_parameter(struct snc_parameters *sp);
-static void perform_precoding(struct snc_context *sc);
+static int perform_precoding(struct snc_context *sc);
+static int alloc_packet_slab(struct snc_context *sc);
+static void drop_borrowed_packets(struct snc_context *sc);
 static int group_packets_rand(struct snc_context *sc);
 static int group_packets_pseudorand(struct snc_context *sc);
 static int group_packets_band(struct snc_context *sc);
 static int group_packets_windwrap(struct snc_context *sc);
 static void encode_packet(struct snc_context *sc, struct subgeneration *subgen, struct snc_packet *pkt);
-static int schedule_generation(struct snc_context *sc);
-static int banded_nonuniform_sched(struct snc_context *sc);
+static int draw_packet(struct snc_context *sc, struct subgeneration *subgen, struct snc_packet *pkt, GF_ELEMENT **srcs, GF_ELEMENT *cos);
+static int draw_coded_packet(struct snc_context *sc, struct snc_rng *rng, unsigned int ctr, struct subgeneration *subgen,
+                             struct snc_packet *pkt, GF_ELEMENT **srcs, GF_ELEMENT *cos);
+static void draw_sparse_coes(unsigned char *coes, int size_g, int nnz, int GFpower,
+                             struct snc_rng *rng, int seed, int gid, unsigned int ctr);
+static struct subgeneration *next_subgeneration(struct snc_context *sc);
+static int schedule_generation(struct snc_context *sc, struct snc_rng *rng);
+static int banded_nonuniform_sched(struct snc_context *sc, struct snc_rng *rng);
+static inline GF_WORD coefficient_from_word(uint32_t r, int GFpower, int nonzero);
 /*
  * Create a GNC context containing meta information about the data to be encoded.
  *   buf      - Buffer containing bytes of data to be encoded
@@ -37,12 +47,38 @@ static int banded_nonuniform_sched(struct snc_context *sc);
  *   -1 - Create failed
  */
 struct snc_context *snc_create_enc_context(unsigned char *buf, struct snc_parameters *sp)
+{
+    return create_enc_context(buf, sp, 0, NULL);
+}
+
+/*
+ * Create a GNC context with options. opt is copied; NULL stands for the
+ * default options (see snc_default_options()).
+ */
+struct snc_context *snc_create_enc_context_opt(unsigned char *buf, struct snc_parameters *sp, const struct snc_options *opt)
+{
+    return create_enc_context(buf, sp, 0, opt);
+}
+
+/*
+ * Create a GNC context whose source packets point into buf instead of
+ * copies of it. Only the parity-check packets and a final partial source
+ * packet are allocated. buf is not modified and must outlive the context.
+ */
+struct snc_context *snc_create_enc_context_borrowed(unsigned char *buf, struct snc_parameters *sp)
+{
+    if (buf == NULL)
+        return NULL;
+    return create_enc_context(buf, sp, 1, NULL);
+}
+
+struct snc_context *create_enc_context(unsigned char *buf, struct snc_parameters *sp, int borrow, const struct snc_options *opt)
 {
     static char fname[] = "snc_create_enc_context";
+    if (opt == NULL)
+        opt = default_options();
     // Set log level
-    char *loglevel = getenv("SNC_LOG_LEVEL");
-    if (loglevel != NULL)
-        set_loglevel(loglevel);
+    set_loglevel(opt->loglevel);
 
     // Allocate file_context
     struct snc_context *sc;
@@ -50,6 +86,10 @@ struct snc_context *snc_create_enc_context(unsigned char *buf, struct snc_parame
         fprintf(stderr, "%s: calloc file_context\n", fname);
         return NULL;
     }
+    sc->opts = *opt;
+    // GF_POWER option (for research) overwrites params, also in the passed-in argument
+    if (opt->gfpower != 0)
+        sp->gfpower = opt->gfpower;
     sc->params.datasize = sp->datasize;
     sc->params.size_p   = sp->size_p;
     sc->params.size_c   = sp->size_c;
@@ -60,6 +100,8 @@ struct snc_context *snc_create_enc_context(unsigned char *buf, struct snc_parame
     sc->params.gfpower  = sp->gfpower;
     sc->params.sys      = sp->sys;
     sc->params.seed     = sp->seed;
+    sc->params.nnz      = sp->nnz;
+    sc->params.seeded   = sp->seeded;
     /* Seed local random number generator for precoding and/or random grouping
      *
      *   If creating a completely new snc context, seed is -1 by default. We
@@ -74,7 +116,9 @@ struct snc_context *snc_create_enc_context(unsigned char *buf, struct snc_parame
         gettimeofday(&tv, NULL);
         sc->params.seed = tv.tv_sec * 1000 + tv.tv_usec / 1000; // seed use microsec
     }
-    init_genrand(sc->params.seed);
+    snc_rng_seed(&sc->rng, sc->params.seed, 0);
+    snc_rng_seed(&sc->crng, sc->params.seed, 1);
+    sc->currbid = -1;
     sp->seed = sc->params.seed;  // set seed in the passed-in argument as well
     // Determine packet and generation numbers
     int num_src = ALIGN(sc->params.datasize, sc->params.size_p);
@@ -114,27 +158,68 @@ struct snc_context *snc_create_enc_context(unsigned char *buf, struct snc_parame
         return NULL;
     }
 
-    constructField(sc->params.gfpower);   // Construct Galois Field
-    GFpower = snc_get_GF_power(&sc->params);
+    // Galois field of the code, shared with other contexts of the same field size
+    if ((sc->gf = gf_field_get(sc->params.gfpower)) == NULL) {
+        fprintf(stderr, "%s: gf_field_get\n", fname);
+        snc_free_enc_context(sc);
+        return NULL;
+    }
+    sc->srcs = malloc(sizeof(GF_ELEMENT*) * sc->params.size_g);
+    sc->cos  = malloc(sizeof(GF_ELEMENT) * sc->params.size_g * gf_field_esize(sc->gf));
+    if (sc->srcs == NULL || sc->cos == NULL) {
+        fprintf(stderr, "%s: malloc sc->srcs/sc->cos\n", fname);
+        snc_free_enc_context(sc);
+        return NULL;
+    }
     if (buf != NULL) {
         int alread = 0;
         int i;
+        if (borrow) {
+            // full source packets stay in the caller's buffer
+            sc->borrowed = sc->params.datasize / sc->params.size_p;
+            for (i=0; i<sc->borrowed; i++)
+                sc->pp[i] = buf + (size_t) i * sc->params.size_p;
+            alread = sc->borrowed * sc->params.size_p;
+        }
+        if (alloc_packet_slab(sc) != 0) {
+            fprintf(stderr, "%s: calloc_payload_slab\n", fname);
+            snc_free_enc_context(sc);
+            return NULL;
+        }
         // Load source packets
-        for (i=0; i<sc->snum; i++) {
-            sc->pp[i] = calloc(sc->params.size_p, sizeof(GF_ELEMENT));
+        for (i=sc->borrowed; i<sc->snum; i++) {
             int toread = (alread+sc->params.size_p) <= sc->params.datasize ? sc->params.size_p : sc->params.datasize-alread;
             memcpy(sc->pp[i], buf+alread, toread*sizeof(GF_ELEMENT));
             alread += toread;
         }
-        // Allocate parity-check packet space
-        for (i=0; i<sc->cnum; i++)
-            sc->pp[sc->snum+i] = calloc(sc->params.size_p, sizeof(GF_ELEMENT));
-        perform_precoding(sc);
+        if (perform_precoding(sc) != 0) {
+            fprintf(stderr, "%s: perform_precoding\n", fname);
+            snc_free_enc_context(sc);
+            return NULL;
+        }
     }
 
     return sc;
 }
 
+/*
+ * Store all source and parity-check packets, except the first sc->borrowed
+ * source packets that point into the caller's buffer, in one slab.
+ */
+static int alloc_packet_slab(struct snc_context *sc)
+{
+    int numpp = sc->snum + sc->cnum - sc->borrowed;
+    if (sc->slab == NULL) {
+        if ((sc->slab = calloc_payload_slab(numpp, sc->params.size_p)) == NULL)
+            return (-1);
+    } else {
+        memset(sc->slab, 0, (size_t) numpp * PADDED(sc->params.size_p));
+    }
+    for (int i=0; i<numpp; i++)
+        sc->pp[sc->borrowed+i] = sc->slab + (size_t) i * PADDED(sc->params.size_p);
+    return (0);
+}
+
 inline struct snc_parameters *snc_get_parameters(struct snc_context *sc)
 {
     if (sc == NULL) {
@@ -159,34 +244,148 @@ int snc_load_file_to_context(const char *filepath, long start, struct snc_contex
         return (-1);
     fseek(fp, 0, SEEK_END);
     if ((ftell(fp) - start) < sc->params.datasize) {
+        fclose(fp);
         return (-1);
     }
     fseek(fp, start, SEEK_SET);  // seek to position start
+    drop_borrowed_packets(sc);
+    if (alloc_packet_slab(sc) != 0) {
+        fprintf(stderr, "%s: calloc_payload_slab\n", fname);
+        fclose(fp);
+        return (-1);
+    }
     int alread = 0;
     int i;
     for (i=0; i<sc->snum; i++) {
-        sc->pp[i] = calloc(sc->params.size_p, sizeof(GF_ELEMENT));
         int toread = (alread+sc->params.size_p) <= sc->params.datasize ? sc->params.size_p : sc->params.datasize-alread;
         if (fread(sc->pp[i], sizeof(GF_ELEMENT), toread, fp) != toread) {
             fprintf(stderr, "%s: fread sc->pp[%d]\n", fname, i);
+            fclose(fp);
             return (-1);
         }
         alread += toread;
     }
     fclose(fp);
-    // Allocate parity-check packet space
-    for (i=0; i<sc->cnum; i++)
-        sc->pp[sc->snum+i] = calloc(sc->params.size_p, sizeof(GF_ELEMENT));
-    perform_precoding(sc);
+    if (perform_precoding(sc) != 0)
+        return (-1);
+    return (0);
+}
+
+/*
+ * Map file content into encode context. Same as snc_load_file_to_context(),
+ * except that the file range is mmap()ed and the source packets point into
+ * the mapping, so pages are read on demand and pages of packets that are
+ * never encoded from are never read. Only the parity-check packets and a
+ * final partial source packet are allocated. The file must not be
+ * truncated while the context is in use.
+ */
+int snc_map_file_to_context(const char *filepath, long start, struct snc_context *sc)
+{
+    static char fname[] = "snc_map_file_to_context";
+
+    int fd;
+    if ((fd = open(filepath, O_RDONLY)) == -1)
+        return (-1);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (st.st_size - start) < sc->params.datasize) {
+        close(fd);
+        return (-1);
+    }
+    // mmap() offsets must be page-aligned
+    long pagesize = sysconf(_SC_PAGESIZE);
+    off_t offset = start - start % pagesize;
+    size_t maplen = (start - offset) + sc->params.datasize;
+    void *map = mmap(NULL, maplen, PROT_READ, MAP_PRIVATE, fd, offset);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "%s: mmap %s\n", fname, filepath);
+        return (-1);
+    }
+    // Subgenerations are encoded in random order; read-ahead would mostly
+    // page in packets that are not needed yet
+    posix_madvise(map, maplen, POSIX_MADV_RANDOM);
+
+    drop_borrowed_packets(sc);
+    if (sc->slab != NULL) {
+        free(sc->slab);
+        sc->slab = NULL;
+    }
+    sc->map = map;
+    sc->maplen = maplen;
+    unsigned char *buf = (unsigned char *) map + (start - offset);
+    int i;
+    sc->borrowed = sc->params.datasize / sc->params.size_p;
+    for (i=0; i<sc->borrowed; i++)
+        sc->pp[i] = buf + (size_t) i * sc->params.size_p;
+    if (alloc_packet_slab(sc) != 0) {
+        fprintf(stderr, "%s: calloc_payload_slab\n", fname);
+        drop_borrowed_packets(sc);
+        return (-1);
+    }
+    // Copy the final partial source packet, if any
+    int alread = sc->borrowed * sc->params.size_p;
+    if (alread < sc->params.datasize)
+        memcpy(sc->pp[sc->borrowed], buf+alread, (sc->params.datasize-alread)*sizeof(GF_ELEMENT));
+    if (perform_precoding(sc) != 0)
+        return (-1);
     return (0);
 }
 
+/*
+ * Release the source packets of the context that are borrowed from a
+ * caller's buffer or a file mapping, as well as the slab sized for them.
+ */
+static void drop_borrowed_packets(struct snc_context *sc)
+{
+    if (sc->borrowed != 0) {
+        free(sc->slab);
+        sc->slab = NULL;
+        memset(sc->pp, 0, sizeof(GF_ELEMENT*) * (sc->snum+sc->cnum));
+        sc->borrowed = 0;
+    }
+    if (sc->map != NULL) {
+        munmap(sc->map, sc->maplen);
+        sc->map = NULL;
+        sc->maplen = 0;
+    }
+}
+
 static int verify_code_parameter(struct snc_parameters *sp)
 {
     if (sp->type != BATS_SNC && sp->type != RAPTOR_SNC && sp->size_b > sp->size_g) {
         fprintf(stderr, "code parameter error: size_b > size_g\n");
         return(-1);
     }
+    if ((sp->gfpower < 1 || sp->gfpower > 8) && sp->gfpower != 16) {
+        fprintf(stderr, "code parameter error: unsupported gfpower %d\n", sp->gfpower);
+        return(-1);
+    }
+    if (sp->type == RAPTOR_SNC && sp->gfpower != 1 && sp->gfpower != 8 && sp->gfpower != 16) {
+        fprintf(stderr, "code parameter error: RAPTOR code supports GF(2), GF(2^8) and GF(2^16) only\n");
+        return(-1);
+    }
+    if (sp->gfpower == 16 && sp->size_p % 2 != 0) {
+        fprintf(stderr, "code parameter error: size_p must be even in GF(2^16)\n");
+        return(-1);
+    }
+    if (sp->nnz < 0 || sp->nnz > sp->size_g || (sp->nnz > 0 && sp->size_g > 0xffff)) {
+        fprintf(stderr, "code parameter error: nnz must be in [0, size_g], and size_g < 65536 if nnz > 0\n");
+        return(-1);
+    }
+    // In GF(2) packets of even weight only span the even-weight subspace of
+    // a subgeneration, and packets of weight size_g are all identical
+    if (sp->gfpower == 1 && sp->nnz > 0 && (sp->nnz % 2 == 0 || sp->nnz == sp->size_g)) {
+        fprintf(stderr, "code parameter error: nnz must be odd and less than size_g in GF(2)\n");
+        return(-1);
+    }
+    if (sp->seeded != 0 && sp->seeded != 1) {
+        fprintf(stderr, "code parameter error: seeded must be 0 or 1\n");
+        return(-1);
+    }
+    if (sp->type == RAPTOR_SNC && sp->nnz != 0) {
+        fprintf(stderr, "code parameter error: RAPTOR code draws its own degrees, nnz must be 0\n");
+        return(-1);
+    }
     /*
     if (sp->size_g*sp->size_p < sp->datasize) {
         fprintf(stderr, "code parameter error: size_g X size_p < datasize\n");
@@ -209,7 +408,9 @@ static int create_context_from_params(struct snc_context *sc)
             return (-1);
         }
         sc->graph->binaryce = sc->params.bpc;     // Note: if precode in GF(2), edges use 1 as coefficient
-        if (create_bipartite_graph(sc->graph, sc->snum, sc->cnum) < 0)
+        sc->graph->gfpower  = sc->params.gfpower;
+        sc->graph->hdpc     = sc->opts.hdpc;
+        if (create_bipartite_graph(sc->graph, sc->snum, sc->cnum, &sc->rng) < 0)
             return (-1);
     }
     // Inintialize generation structures (applied to fixed-number subsets codes)
@@ -253,21 +454,35 @@ static int create_context_from_params(struct snc_context *sc)
                 fprintf(stderr, "%s: unknown code type\n", fname);
                 break;
         }
+    } else if (sc->params.type == RAPTOR_SNC) {
+        // Every coded packet has its own subset, drawn into the only subgeneration when it is sent
+        sc->gene = calloc(1, sizeof(struct subgeneration*));
+        if (sc->gene == NULL || (sc->gene[0] = malloc(sizeof(struct subgeneration))) == NULL) {
+            fprintf(stderr, "%s: malloc sc->gene\n", fname);
+            return(-1);
+        }
+        sc->gene[0]->gid = -1;
+        sc->gene[0]->pktid = malloc(sizeof(int)*sc->params.size_g);
+        if (sc->gene[0]->pktid == NULL) {
+            fprintf(stderr, "%s: malloc sc->gene[0]->pktid\n", fname);
+            return(-1);
+        }
+        memset(sc->gene[0]->pktid, -1, sizeof(int)*sc->params.size_g);
     } else {
-        // Potentially unlimited number of batches
-        // In the first time, only allocate BALLOC batches. If more is needed, realloc() will be called.
-        sc->gene  = calloc(BALLOC, sizeof(struct subgeneration*));
+        // Potentially unlimited number of batches, derived on demand into a cache of BCACHE batches
+        sc->gene  = calloc(BCACHE, sizeof(struct subgeneration*));
         if ( sc->gene == NULL ) {
             fprintf(stderr, "%s: malloc sc->gene\n", fname);
             return(-1);
         }
-        // Construct the batches
-        for (int i=0; i<BALLOC; i++) {
+        for (int i=0; i<BCACHE; i++) {
             sc->gene[i] = malloc(sizeof(struct subgeneration));
-            sc->gene[i]->gid = i;
-            sc->gene[i]->pktid = malloc(sizeof(int)*sc->params.size_g);       // Use malloc because pktid needs to be initialized as -1's later
+            if (sc->gene[i] == NULL || (sc->gene[i]->pktid = malloc(sizeof(int)*sc->params.size_g)) == NULL) {
+                fprintf(stderr, "%s: malloc sc->gene[%d]\n", fname, i);
+                return(-1);
+            }
+            sc->gene[i]->gid = -1;      // empty slot
             memset(sc->gene[i]->pktid, -1, sizeof(int)*sc->params.size_g);
-            get_random_unique_numbers(sc->gene[i]->pktid, sc->params.size_g, sc->snum+sc->cnum);   // obtain packet IDs of the new batch
         }
     }
     sc->count = 0;
@@ -280,17 +495,30 @@ void snc_free_enc_context(struct snc_context *sc)
     if (sc == NULL)
         return;
     int i;
-    if (sc->pp != NULL) {
+    if (sc->map != NULL)
+        munmap(sc->map, sc->maplen);
+    if (sc->slab != NULL) {
+        free(sc->slab);
+        sc->slab = NULL;
+    } else if (sc->pp != NULL) {
         for (i=sc->snum+sc->cnum-1; i>=0; i--) {
             if (sc->pp[i] != NULL) {
                 free(sc->pp[i]);
                 sc->pp[i] = NULL;
             }
         }
-        free(sc->pp);
     }
+    if (sc->pp != NULL)
+        free(sc->pp);
     if (sc->gene != NULL) {
-        for (i=sc->gnum-1; i>=0; i--) {
+        int ngene = sc->gnum;
+        if (sc->params.type == RAPTOR_SNC)
+            ngene = 1;
+        else if (sc->params.type == BATS_SNC)
+            ngene = BCACHE;
+        for (i=ngene-1; i>=0; i--) {
+            if (sc->gene[i] == NULL)
+                continue;
             free(sc->gene[i]->pktid);  // free packet IDs
             free(sc->gene[i]);         // free generation itself
             sc->gene[i] = NULL;
@@ -301,6 +529,11 @@ void snc_free_enc_context(struct snc_context *sc)
         free_bipartite_graph(sc->graph);
     if (sc->nccount != NULL)
         free(sc->nccount);
+    if (sc->fbgids != NULL)
+        free(sc->fbgids);
+    free(sc->srcs);
+    free(sc->cos);
+    gf_field_put(sc->gf);
     free(sc);
     sc = NULL;
     return;
@@ -366,22 +599,174 @@ long snc_recover_to_file(const char *filepath, struct snc_context *sc)
 }
 
 // perform systematic LDPC precoding against SRC pkt list and results in a LDPC pkt list
-static void perform_precoding(struct snc_context *sc)
+/*
+ * Checks of the precode in compressed sparse row form: the source packets
+ * of check i are colidx[rowptr[i]],...,colidx[rowptr[i+1]-1], with the
+ * coefficients (esize bytes each) at the same positions of ces.
+ */
+struct precode_job {
+    struct snc_context *sc;
+    int        *rowptr;
+    int        *colidx;
+    GF_ELEMENT *ces;
+    GF_ELEMENT **srcs;      // scratch for the source packets of a check
+    int         first;      // checks [first, last) of the job
+    int         last;
+    int         len;        // bytes of each packet to encode
+    int         tile;       // bytes per payload tile
+};
+
+#define PRECODE_TILE_CACHE      (256 * 1024)    // bytes of packets touched per tile (fits L2)
+#define PRECODE_THREAD_BYTES    (4 << 20)       // minimum bytes of check packets per thread
+#define PRECODE_MIN_TILE        2048            // minimum bytes per payload tile
+
+/*
+ * Encode checks [first, last) tile by tile over the payload, so that the
+ * tiles of the source packets shared by these checks are reused from cache.
+ */
+static void *precode_checks(void *arg)
+{
+    struct precode_job *job = arg;
+    struct snc_context *sc = job->sc;
+    int esize = gf_field_esize(sc->gf);
+    GF_ELEMENT **srcs = job->srcs;
+    for (int off=0; off<job->len; off+=job->tile) {
+        int len = (job->len - off) < job->tile ? (job->len - off) : job->tile;
+        for (int i=job->first; i<job->last; i++) {
+            int n = job->rowptr[i+1] - job->rowptr[i];
+            for (int k=0; k<n; k++)
+                srcs[k] = sc->pp[job->colidx[job->rowptr[i]+k]] + off;
+            galois_multiply_add_region_multi_packed(sc->gf, sc->pp[i+sc->snum]+off, srcs, &job->ces[job->rowptr[i]*esize], n, len);
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Compute the parity-check packets from the source packets.
+ * Return 0 on success, -1 if the scratch cannot be allocated.
+ */
+static int perform_precoding(struct snc_context *sc)
 {
     static char fname[] = "perform_precoding";
 
-    int i, j;
+    int i, t;
+    int esize = gf_field_esize(sc->gf);
+    int *rowptr = NULL, *colidx = NULL;
+    GF_ELEMENT *ces = NULL;
+    GF_ELEMENT **srcs = NULL;
+    struct precode_job *jobs = NULL;
+    pthread_t *tids = NULL;
+    int *started = NULL;
+    if (sc->cnum == 0)
+        return (0);
+    // Flatten the neighbour lists of checks
+    if ((rowptr = malloc(sizeof(int) * (sc->cnum + 1))) == NULL) {
+        fprintf(stderr, "%s: malloc rowptr failed\n", fname);
+        goto AllocError;
+    }
+    int maxdeg = 0;
+    rowptr[0] = 0;
+    for (i=0; i<sc->cnum; i++) {
+        int n = 0;
+        for (NBR_node *nb=sc->graph->l_nbrs_of_r[i]->first; nb!=NULL; nb=nb->next)
+            n++;
+        rowptr[i+1] = rowptr[i] + n;
+        if (n > maxdeg)
+            maxdeg = n;
+    }
+    colidx = malloc(sizeof(int) * (rowptr[sc->cnum] > 0 ? rowptr[sc->cnum] : 1));
+    ces = malloc(sizeof(GF_ELEMENT) * (rowptr[sc->cnum] > 0 ? rowptr[sc->cnum] : 1) * esize);
+    if (colidx == NULL || ces == NULL) {
+        fprintf(stderr, "%s: malloc colidx/ces failed\n", fname);
+        goto AllocError;
+    }
     for (i=0; i<sc->cnum; i++) {
-        // Encoding check packet according to the LDPC graph
-        NBR_node *nb = sc->graph->l_nbrs_of_r[i]->first;
-        while(nb != NULL) {
-            int sid = nb->data;  // index of source packet
-            // XOR information content
-            galois_multiply_add_region(sc->pp[i+sc->snum], sc->pp[sid], nb->ce, sc->params.size_p);
-            // move to next possible neighbour node of current check
-            nb = nb->next;
+        int k = rowptr[i];
+        for (NBR_node *nb=sc->graph->l_nbrs_of_r[i]->first; nb!=NULL; nb=nb->next) {
+            colidx[k] = nb->data;
+            gf_set_element(ces, k, nb->ce, esize);
+            k++;
         }
     }
+
+    // All operands are padded payload buffers unless some source packets are
+    // borrowed from the caller, so run over the padded length if possible
+    int len = sc->borrowed ? sc->params.size_p : PADDED(sc->params.size_p);
+
+    // Split checks evenly across threads, each with enough bytes to encode
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int nt = sc->opts.precode_threads;
+    int nthreads = nt > 0 ? nt : (int) (ncpu > 0 ? ncpu : 1);
+    long maxthreads = (long) sc->cnum * len / PRECODE_THREAD_BYTES;
+    if (nt == 0 && nthreads > maxthreads)
+        nthreads = (int) maxthreads;
+    if (nthreads > sc->cnum)
+        nthreads = sc->cnum;
+    if (nthreads < 1)
+        nthreads = 1;
+
+    // Tiles are multiples of 64 bytes, and of the 8*GFpower-byte blocks of
+    // the bit-sliced GF(2^3),...,GF(2^7) kernels
+    int GFpower = gf_field_power(sc->gf);
+    int unit = (GFpower > 1 && GFpower < 8) ? 64 * GFpower : 64;
+    int per_thread = ALIGN(sc->cnum, nthreads);
+    long touched = (long) per_thread * (ALIGN(rowptr[sc->cnum], sc->cnum) + 1);   // packets touched per tile
+    int tile = (int) (PRECODE_TILE_CACHE / touched) / unit * unit;
+    if (tile < PRECODE_MIN_TILE)
+        tile = ALIGN(PRECODE_MIN_TILE, unit) * unit;    // shorter tiles cost more in calls than they save
+    if (tile > len)
+        tile = len;
+
+    if (maxdeg < 1)
+        maxdeg = 1;
+    jobs = calloc(nthreads, sizeof(struct precode_job));
+    tids = calloc(nthreads, sizeof(pthread_t));
+    started = calloc(nthreads, sizeof(int));
+    srcs = malloc(sizeof(GF_ELEMENT*) * nthreads * maxdeg);
+    if (jobs == NULL || tids == NULL || started == NULL || srcs == NULL) {
+        fprintf(stderr, "%s: calloc jobs failed\n", fname);
+        goto AllocError;
+    }
+    for (t=0; t<nthreads; t++) {
+        jobs[t].sc     = sc;
+        jobs[t].rowptr = rowptr;
+        jobs[t].colidx = colidx;
+        jobs[t].ces    = ces;
+        jobs[t].srcs   = srcs + (size_t) t * maxdeg;
+        jobs[t].first  = t * per_thread < sc->cnum ? t * per_thread : sc->cnum;
+        jobs[t].last   = (t + 1) * per_thread < sc->cnum ? (t + 1) * per_thread : sc->cnum;
+        jobs[t].len    = len;
+        jobs[t].tile   = tile;
+    }
+    // The calling thread takes the first job; run a job here if its thread cannot be created
+    for (t=1; t<nthreads; t++)
+        started[t] = (pthread_create(&tids[t], NULL, precode_checks, &jobs[t]) == 0);
+    precode_checks(&jobs[0]);
+    for (t=1; t<nthreads; t++) {
+        if (started[t])
+            pthread_join(tids[t], NULL);
+        else
+            precode_checks(&jobs[t]);
+    }
+    free(jobs);
+    free(tids);
+    free(started);
+    free(srcs);
+    free(rowptr);
+    free(colidx);
+    free(ces);
+    return (0);
+
+AllocError:
+    free(jobs);
+    free(tids);
+    free(started);
+    free(srcs);
+    free(rowptr);
+    free(colidx);
+    free(ces);
+    return (-1);
 }
 
 /*
@@ -457,16 +842,16 @@ static int group_packets_rand(struct snc_context *sc)
             index = (i * sc->params.size_b + j) % num_p;  // source packet index
 
             while (has_item(sc->gene[i]->pktid, index, j) != -1)
-                index = genrand_int32() % num_p;
+                index = snc_rng_next(&sc->rng) % num_p;
             sc->gene[i]->pktid[j] = index;
             selected[index] += 1;
         }
 
         // fill in the rest of the generation with packets from other generations
         for (j=sc->params.size_b; j<sc->params.size_g; j++) {
-            index = genrand_int32() % num_p;
+            index = snc_rng_next(&sc->rng) % num_p;
             while (has_item(sc->gene[i]->pktid, index, j) != -1) {
-                index = genrand_int32() % num_p;
+                index = snc_rng_next(&sc->rng) % num_p;
             }
             sc->gene[i]->pktid[j] = index;
             selected[index] += 1;
@@ -563,7 +948,7 @@ struct snc_packet *snc_alloc_empty_packet(struct snc_parameters *sp)
 
     if (pkt->coes == NULL)
         goto AllocErr;
-    pkt->syms = calloc(sp->size_p, sizeof(GF_ELEMENT));
+    pkt->syms = calloc_payload(sp->size_p);
     if (pkt->syms == NULL)
         goto AllocErr;
 
@@ -574,17 +959,116 @@ AllocErr:
     return NULL;
 }
 
+/*
+ * With param->seeded, a 4-byte coefficient counter (snc_packet.ctr)
+ * follows the gid/ucid header, and the coefficient vector is only packed
+ * after it if the counter is 0, e.g., for recoded packets. Otherwise the
+ * receiver regenerates the vector from the code seed, gid and counter.
+ */
+#define CTR_LEN     4
+
+/*
+ * With nnz > 0, an explicit coefficient vector is serialized as a 2-byte
+ * count c of its non-zero coefficients, their 2-byte positions and the c
+ * coefficients packed as in snc_packet.coes. A vector that is not shorter
+ * this way, e.g., of a recoded packet, is packed as is after a count of
+ * size_g.
+ */
+#define NNZ_LEN     2
+
+static int nonzero_coes(struct snc_packet *pkt, struct snc_parameters *param)
+{
+    int c = 0;
+    for (int i=0; i<param->size_g; i++)
+        c += (read_coefficient(pkt->coes, param->size_g, param->gfpower, i) != 0);
+    return c;
+}
+
+// Serialized length of explicit coefficients with c non-zeros
+static int coes_length(struct snc_parameters *param, int c)
+{
+    int dense = ALIGN(param->size_g * param->gfpower, 8);
+    if (param->nnz == 0)
+        return dense;
+    int sparse = NNZ_LEN * c + ALIGN(c * param->gfpower, 8);
+    return NNZ_LEN + (sparse < dense ? sparse : dense);
+}
+
+static void pack_coes(unsigned char *dst, struct snc_packet *pkt, struct snc_parameters *param, int c)
+{
+    int dense = ALIGN(param->size_g * param->gfpower, 8);
+    if (param->nnz == 0) {
+        memcpy(dst, pkt->coes, dense);
+        return;
+    }
+    if (coes_length(param, c) == NNZ_LEN + dense) {
+        uint16_t all = param->size_g;
+        memcpy(dst, &all, NNZ_LEN);
+        memcpy(dst+NNZ_LEN, pkt->coes, dense);
+        return;
+    }
+    uint16_t cnt = c, pos;
+    unsigned char *ces = dst + NNZ_LEN + NNZ_LEN * c;     // packed non-zeros after the positions
+    memcpy(dst, &cnt, NNZ_LEN);
+    for (int i=0, k=0; i<param->size_g; i++) {
+        int co = read_coefficient(pkt->coes, param->size_g, param->gfpower, i);
+        if (co == 0)
+            continue;
+        pos = i;
+        memcpy(dst+NNZ_LEN+NNZ_LEN*k, &pos, NNZ_LEN);
+        pack_coefficient(ces, c, co, param->gfpower, k);
+        k++;
+    }
+}
+
+// Unpack serialized explicit coefficients to pkt->coes (zero); return the bytes read
+static int unpack_coes(struct snc_packet *pkt, unsigned char *src, struct snc_parameters *param)
+{
+    int dense = ALIGN(param->size_g * param->gfpower, 8);
+    if (param->nnz == 0) {
+        memcpy(pkt->coes, src, dense);
+        return dense;
+    }
+    uint16_t cnt, pos;
+    memcpy(&cnt, src, NNZ_LEN);
+    if (cnt == param->size_g) {
+        memcpy(pkt->coes, src+NNZ_LEN, dense);
+        return NNZ_LEN + dense;
+    }
+    unsigned char *ces = src + NNZ_LEN + NNZ_LEN * cnt;
+    for (int k=0; k<cnt; k++) {
+        memcpy(&pos, src+NNZ_LEN+NNZ_LEN*k, NNZ_LEN);
+        if (pos < param->size_g)
+            pack_coefficient(pkt->coes, param->size_g, read_coefficient(ces, cnt, param->gfpower, k), param->gfpower, pos);
+    }
+    return NNZ_LEN + NNZ_LEN * cnt + ALIGN(cnt * param->gfpower, 8);
+}
+
 // Length of serialized snc_packet (unit: bytes)
 int snc_packet_length(struct snc_parameters *param)
 {
     int gid_len  = 4;      // use 4 bytes to store gid (signed int)
     int ucid_len = 4;      // use 4 bytes to store ucid (signed int)
-    int ces_len  = ALIGN(param->size_g * param->gfpower, 8);
+    int ctr_len  = param->seeded ? CTR_LEN : 0;
+    int ces_len  = coes_length(param, param->size_g);
     int sym_len  = param->size_p;
-    int strlen = gid_len + ucid_len + ces_len + sym_len;
+    int strlen = gid_len + ucid_len + ctr_len + ces_len + sym_len;
     return strlen;
 }
 
+// Length of a given serialized snc_packet
+int snc_serialized_length(struct snc_packet *pkt, struct snc_parameters *param)
+{
+    int pktnum = ALIGN(param->datasize, param->size_p) + param->size_c;
+    int gid_len = (param->size_g == pktnum && param->size_b == param->size_g && param->sys !=1) ? 0 : 4;
+    int ucid_len = (param->sys == 1) ? 4 : 0;
+    int seeded   = param->seeded;
+    int ctr_len  = seeded ? CTR_LEN : 0;
+    int ces_len  = (seeded && pkt->ctr != 0) ? 0 : coes_length(param, param->nnz ? nonzero_coes(pkt, param) : 0);
+    int sym_len  = param->size_p;
+    return gid_len + ucid_len + ctr_len + ces_len + sym_len;
+}
+
 // Serialize snc_packet to a byte buffer
 unsigned char *snc_serialize_packet(struct snc_packet *pkt, struct snc_parameters *param)
 {
@@ -594,14 +1078,20 @@ unsigned char *snc_serialize_packet(struct snc_packet *pkt, struct snc_parameter
     int pktnum = ALIGN(param->datasize, param->size_p) + param->size_c;
     int gid_len = (param->size_g == pktnum && param->size_b == param->size_g && param->sys !=1) ? 0 : 4;  // don't pack gid if it's non-systematic RLNC
     int ucid_len = (param->sys == 1) ? 4 : 0;  // pack ucid using 4 bytes only if the code is systematic
-    int ces_len  = ALIGN(param->size_g * param->gfpower, 8);
+    int seeded   = param->seeded;
+    int ctr_len  = seeded ? CTR_LEN : 0;
+    int explicit = !(seeded && pkt->ctr != 0);
+    int nonzeros = (explicit && param->nnz) ? nonzero_coes(pkt, param) : 0;
+    int ces_len  = explicit ? coes_length(param, nonzeros) : 0;
     int sym_len  = param->size_p;
-    int strlen = gid_len + ucid_len + ces_len + sym_len;
+    int strlen = gid_len + ucid_len + ctr_len + ces_len + sym_len;
     unsigned char *pktstr = calloc(strlen, sizeof(unsigned char));
     memcpy(pktstr, &pkt->gid, gid_len);
     memcpy(pktstr+gid_len, &pkt->ucid, ucid_len);
-    memcpy(pktstr+gid_len+ucid_len, pkt->coes, ces_len);
-    memcpy(pktstr+gid_len+ucid_len+ces_len, pkt->syms, sym_len);
+    memcpy(pktstr+gid_len+ucid_len, &pkt->ctr, ctr_len);
+    if (explicit)
+        pack_coes(pktstr+gid_len+ucid_len+ctr_len, pkt, param, nonzeros);
+    memcpy(pktstr+gid_len+ucid_len+ctr_len+ces_len, pkt->syms, sym_len);
     return pktstr;
 }
 
@@ -614,13 +1104,35 @@ struct snc_packet *snc_deserialize_packet(unsigned char *pktstr, struct snc_para
     int pktnum = ALIGN(param->datasize, param->size_p) + param->size_c;
     int gid_len = (param->size_g == pktnum && param->size_b == param->size_g && param->sys !=1) ? 0 : 4;
     int ucid_len = param->sys == 1 ? 4 : 0;
-    int ces_len  = ALIGN(param->size_g * param->gfpower, 8);
+    int seeded   = param->seeded;
+    int ctr_len  = seeded ? CTR_LEN : 0;
+    int ces_len  = 0;
     int sym_len  = param->size_p;
     struct snc_packet *pkt = snc_alloc_empty_packet(param);
     memcpy(&pkt->gid, pktstr, gid_len);
     memcpy(&pkt->ucid, pktstr+gid_len, ucid_len);
-    memcpy(pkt->coes, pktstr+gid_len+ucid_len, ces_len);
-    memcpy(pkt->syms, pktstr+gid_len+ucid_len+ces_len, sym_len);
+    memcpy(&pkt->ctr, pktstr+gid_len+ucid_len, ctr_len);
+    if (seeded && pkt->ctr != 0 && param->nnz > 0) {
+        draw_sparse_coes(pkt->coes, param->size_g, param->nnz, param->gfpower, NULL, param->seed, pkt->gid, pkt->ctr);
+    } else if (seeded && pkt->ctr != 0) {
+        // regenerate the seeded coefficient vector
+        uint32_t r[4];
+        int nonzero = param->type == RAPTOR_SNC;
+        int degree = param->size_g;
+        if (nonzero) {
+            int *pktid = malloc(sizeof(int) * param->size_g);
+            degree = raptor_subset(param->seed, pkt->gid, pktnum, param->size_g, pktid);
+            free(pktid);
+        }
+        for (int i=0; i<degree; i++) {
+            if (i % 4 == 0)
+                seeded_coefficient_block(r, param->seed, pkt->gid, pkt->ctr, i / 4);
+            pack_coefficient(pkt->coes, param->size_g, coefficient_from_word(r[i % 4], param->gfpower, nonzero), param->gfpower, i);
+        }
+    } else {
+        ces_len = unpack_coes(pkt, pktstr+gid_len+ucid_len+ctr_len, param);
+    }
+    memcpy(pkt->syms, pktstr+gid_len+ucid_len+ctr_len+ces_len, sym_len);
     return pkt;
 }
 
@@ -643,9 +1155,10 @@ struct snc_packet *snc_duplicate_packet(struct snc_packet *pkt, struct snc_param
     struct snc_packet *dup_pkt = malloc(sizeof(struct snc_packet));
     dup_pkt->gid = pkt->gid;
     dup_pkt->ucid = pkt->ucid;
+    dup_pkt->ctr = pkt->ctr;
     dup_pkt->coes = calloc(ALIGN(param->size_g * param->gfpower, 8), sizeof(GF_ELEMENT));
     memcpy(dup_pkt->coes, pkt->coes, sizeof(GF_ELEMENT)*ALIGN(param->size_g*param->gfpower,8));
-    dup_pkt->syms = malloc(sizeof(GF_ELEMENT) * param->size_p);
+    dup_pkt->syms = calloc_payload(param->size_p);
     memcpy(dup_pkt->syms, pkt->syms, sizeof(GF_ELEMENT)*param->size_p);
     return dup_pkt;
 }
@@ -667,41 +1180,141 @@ int snc_generate_packet_im(struct snc_context *sc, struct snc_packet *pkt)
     }
     */
     memset(pkt->syms, 0, sc->params.size_p*sizeof(GF_ELEMENT));
-    if (sc->params.type == RAND_SNC || sc->params.type == BAND_SNC || sc->params.type == WINDWRAP_SNC) {
-        int gid = schedule_generation(sc);
-        encode_packet(sc, sc->gene[gid], pkt);
-    } else {
-        // encode from a dynamically constructed subset
-        if (sc->params.type == RAPTOR_SNC) {
-            // Always construct a new subset and generate a coded packet from it
-        }
-        if (sc->params.type == BATS_SNC) {
-            if (batsent >= sc->params.size_b && (currbid+1) % BALLOC == 0 ) {
-                // Time to switch a batch, but the allocated batch pointers have been used out. realloc()
-                // We need to allocate more memory for batch pointers
-                // TODO: we might want to just discard the previous batches, and replace them with new ones.
-                int bid = currbid + 1;
-                printf("Need to allocate more batch pointers, calling realloc()...\n");
-                sc->gene = realloc(sc->gene, sizeof(struct subgeneration*)*(bid+BALLOC));
-                for (int i=bid; i<bid+BALLOC; i++) {
-                    sc->gene[i] = malloc(sizeof(struct subgeneration));
-                    sc->gene[i]->gid = i;
-                    sc->gene[i]->pktid = malloc(sizeof(int)*sc->params.size_g);       // Use malloc because pktid needs to be initialized as -1's later
-                    memset(sc->gene[i]->pktid, -1, sizeof(int)*sc->params.size_g);
-                    get_random_unique_numbers(sc->gene[i]->pktid, sc->params.size_g, sc->snum+sc->cnum);   // obtain packet IDs of the new batch
-                }
-            }
-            if (currbid == -1 || batsent >= sc->params.size_b) {
-                // Switch batch
-                currbid = currbid + 1;
-                batsent = 0;
+    pkt->ctr = 0;
+    struct subgeneration *subgen = next_subgeneration(sc);
+    if (subgen != NULL)
+        encode_packet(sc, subgen, pkt);
+    return (0);
+}
+
+#define BATCH_TILE_BYTES    (128 * 1024)    // source bytes of a generation touched per tile
+
+/*
+ * Generate n GNC coded packets in the memory areas of pkts[]. The packets are
+ * identical to those of n successive snc_generate_packet_im() calls. Coded
+ * packets of the same subgeneration are encoded together, tile by tile over
+ * the payload, so that each tile of the source packets stays in cache while
+ * it is accumulated into all of them.
+ */
+int snc_generate_packets(struct snc_context *sc, struct snc_packet *pkts[], int n)
+{
+    static char fname[] = "snc_generate_packets";
+    int i, j, c;
+    for (i=0; i<n; i++) {
+        if (pkts[i] == NULL || pkts[i]->coes == NULL || pkts[i]->syms == NULL)
+            return -1;
+    }
+    if (n <= 0)
+        return 0;
+    int size_g = sc->params.size_g;
+    int size_p = sc->params.size_p;
+    int esize  = gf_field_esize(sc->gf);
+    GF_ELEMENT **srcs  = malloc(sizeof(GF_ELEMENT*) * size_g * n);
+    GF_ELEMENT **tsrcs = malloc(sizeof(GF_ELEMENT*) * size_g);
+    GF_ELEMENT *cos    = malloc(sizeof(GF_ELEMENT) * size_g * esize * n);
+    int *coded = malloc(sizeof(int) * n);       // packet index of each coded slot
+    int *order = malloc(sizeof(int) * n);       // coded slots sorted by gid
+    int *gids  = malloc(sizeof(int) * n);
+    int *nsrc  = malloc(sizeof(int) * n);       // source packets of each coded slot
+    if (srcs == NULL || tsrcs == NULL || cos == NULL || coded == NULL || order == NULL || gids == NULL || nsrc == NULL) {
+        fprintf(stderr, "%s: malloc failed\n", fname);
+        free(srcs);
+        free(tsrcs);
+        free(cos);
+        free(coded);
+        free(order);
+        free(gids);
+        free(nsrc);
+        return -1;
+    }
+
+    // Schedule and draw coefficients in the same order as single calls
+    int ncoded = 0;
+    for (i=0; i<n; i++) {
+        memset(pkts[i]->coes, 0, ALIGN(size_g*sc->params.gfpower,8) * sizeof(GF_ELEMENT));
+        memset(pkts[i]->syms, 0, size_p*sizeof(GF_ELEMENT));
+        pkts[i]->ctr = 0;
+        struct subgeneration *subgen = next_subgeneration(sc);
+        if (subgen == NULL)
+            continue;
+        if ((nsrc[ncoded] = draw_packet(sc, subgen, pkts[i], &srcs[ncoded*size_g], &cos[ncoded*size_g*esize])) == 0)
+            continue;       // systematic packet
+        coded[ncoded] = i;
+        // stable insertion sort of the slot by gid
+        for (j=ncoded; j>0 && gids[j-1]>subgen->gid; j--) {
+            gids[j]  = gids[j-1];
+            order[j] = order[j-1];
+        }
+        gids[j]  = subgen->gid;
+        order[j] = ncoded;
+        ncoded++;
+    }
+
+    // Tiles are multiples of 64 bytes, and of the 8*GFpower-byte blocks of
+    // the bit-sliced GF(2^3),...,GF(2^7) kernels, so that splitting a
+    // payload does not split a field element.
+    int GFpower = gf_field_power(sc->gf);
+    int unit = (GFpower > 1 && GFpower < 8) ? 64 * GFpower : 64;
+    int tile = BATCH_TILE_BYTES / size_g / unit * unit;
+    if (tile < unit)
+        tile = unit;
+    if (tile > size_p)
+        tile = size_p;
+
+    int start, end;
+    for (start=0; start<ncoded; start=end) {
+        for (end=start+1; end<ncoded && gids[end]==gids[start]; end++)
+            ;
+        for (int off=0; off<size_p; off+=tile) {
+            int len = (size_p - off) < tile ? (size_p - off) : tile;
+            for (c=start; c<end; c++) {
+                int slot = order[c];
+                for (j=0; j<nsrc[slot]; j++)
+                    tsrcs[j] = srcs[slot*size_g+j] + off;
+                galois_multiply_add_region_multi_packed(sc->gf, pkts[coded[slot]]->syms+off, tsrcs,
+                                                        &cos[slot*size_g*esize], nsrc[slot], len);
             }
-            // Generate a coded packet from the current batch
-            encode_packet(sc, sc->gene[currbid], pkt);
-            batsent += 1;
         }
     }
-    return (0);
+    free(srcs);
+    free(tsrcs);
+    free(cos);
+    free(coded);
+    free(order);
+    free(gids);
+    free(nsrc);
+    return 0;
+}
+
+/*
+ * Select the subgeneration from which the next coded packet is generated.
+ * Return NULL if the code type constructs no subgeneration.
+ */
+static struct subgeneration *next_subgeneration(struct snc_context *sc)
+{
+    if (sc->params.type == RAND_SNC || sc->params.type == BAND_SNC || sc->params.type == WINDWRAP_SNC) {
+        int gid = schedule_generation(sc, &sc->crng);
+        return sc->gene[gid];
+    }
+    // encode from a dynamically constructed subset
+    if (sc->params.type == RAPTOR_SNC) {
+        // Always construct a new subset and generate a coded packet from it
+        struct subgeneration *subgen = sc->gene[0];
+        subgen->gid = ++sc->currbid;
+        raptor_subset(sc->params.seed, subgen->gid, sc->snum+sc->cnum, sc->params.size_g, subgen->pktid);
+        return subgen;
+    }
+    if (sc->params.type == BATS_SNC) {
+        if (sc->currbid == -1 || sc->batsent >= sc->params.size_b) {
+            // Switch batch
+            sc->currbid = sc->currbid + 1;
+            sc->batsent = 0;
+        }
+        // Generate a coded packet from the current batch
+        sc->batsent += 1;
+        return get_subgeneration(sc, sc->currbid);
+    }
+    return NULL;
 }
 
 void snc_free_packet(struct snc_packet *pkt)
@@ -718,8 +1331,25 @@ void snc_free_packet(struct snc_packet *pkt)
 
 static void encode_packet(struct snc_context *sc, struct subgeneration *subgen, struct snc_packet *pkt)
 {
-    int gid = subgen->gid;
-    pkt->gid = gid;
+    int nsrc = draw_packet(sc, subgen, pkt, sc->srcs, sc->cos);
+    // Accumulate all the packets of the subgeneration in one pass over pkt->syms.
+    // For GF(4),...,GF(128), information bytes are treated as individual GF_ELEMENTS
+    // of length 'GFpower'. Caveat: Each source packet has to contain multiples of
+    // GFpower bits, since the last partial element cannot be recovered.
+    if (nsrc > 0)
+        galois_multiply_add_region_multi_packed(sc->gf, pkt->syms, sc->srcs, sc->cos, nsrc, sc->params.size_p);
+    return;
+}
+
+/*
+ * Draw the header of the next packet of a subgeneration: gid, ucid and the
+ * packed coding coefficients. A systematic packet is copied to pkt->syms and
+ * 0 is returned. Otherwise the source packets and their coefficients (esize
+ * bytes each) are stored in srcs and cos, and their number is returned; the
+ * caller accumulates them into pkt->syms.
+ */
+static int draw_packet(struct snc_context *sc, struct subgeneration *subgen, struct snc_packet *pkt, GF_ELEMENT **srcs, GF_ELEMENT *cos)
+{
     int pktid;
     if (sc->params.sys == 1 && sc->count < sc->snum) {
         // send an uncoded source packet
@@ -729,66 +1359,249 @@ static void encode_packet(struct snc_context *sc, struct subgeneration *subgen,
         pkt->ucid = pktid;
         // sc->nccount[gid] += 1;
         sc->count += 1;
-        return;
+        return 0;
     }
 
     // generate coded packet
-    int i, j;
-    GF_ELEMENT co;
+    int nsrc = draw_coded_packet(sc, &sc->crng, (unsigned int) sc->count + 1, subgen, pkt, srcs, cos);
+    // sc->nccount[gid] += 1;
+    sc->count += 1;
+    return nsrc;
+}
+
+/*
+ * Coding coefficient of GF(2^GFpower) from a random word. Subsets of
+ * Raptor codes take non-zero coefficients, so that packets keep the
+ * degrees drawn for them.
+ */
+static inline GF_WORD coefficient_from_word(uint32_t r, int GFpower, int nonzero)
+{
+    if (nonzero)
+        return (GF_WORD) (1 + r % ((1 << GFpower) - 1));
+    return (GF_WORD) (r % (1 << GFpower));
+}
+
+/*
+ * Draw the coding coefficients of a coded packet of a subgeneration from
+ * rng, or from the seeded generator with counter ctr (0 is reserved for
+ * explicit coefficients), and store the source packets and coefficients
+ * in srcs and cos. Slots of pktid -1 beyond the degree of a Raptor subset
+ * get coefficient 0. With nnz > 0, only the nnz members drawn to take
+ * non-zero coefficients are stored. Return the number of stored packets.
+ * The context is only read.
+ */
+static int draw_coded_packet(struct snc_context *sc, struct snc_rng *rng, unsigned int ctr, struct subgeneration *subgen,
+                             struct snc_packet *pkt, GF_ELEMENT **srcs, GF_ELEMENT *cos)
+{
+    int gid = subgen->gid;
+    int pktid;
+    int i;
+    int GFpower = snc_get_GF_power(&sc->params);
+    int esize = gf_field_esize(sc->gf);
+    int nonzero = sc->params.type == RAPTOR_SNC;
+    GF_WORD co;
+    uint32_t r[4];
+    pkt->gid = gid;
+    pkt->ucid = -1;
+    if (sc->params.seeded)
+        pkt->ctr = ctr;
+    if (sc->params.nnz > 0) {
+        int nsrc = 0;
+        memset(pkt->coes, 0, ALIGN(sc->params.size_g*GFpower, 8));
+        draw_sparse_coes(pkt->coes, sc->params.size_g, sc->params.nnz, GFpower, sc->params.seeded ? NULL : rng,
+                         sc->params.seed, gid, pkt->ctr);
+        for (i=0; i<sc->params.size_g; i++) {
+            if ((co = read_coefficient(pkt->coes, sc->params.size_g, GFpower, i)) == 0)
+                continue;
+            srcs[nsrc] = sc->pp[subgen->pktid[i]];
+            gf_set_element(cos, nsrc, co, esize);
+            nsrc++;
+        }
+        return nsrc;
+    }
     for (i=0; i<sc->params.size_g; i++) {
         pktid = subgen->pktid[i];  // The i-th packet of the gid-th generation
+        if (pktid == -1) {
+            srcs[i] = sc->pp[subgen->pktid[0]];
+            gf_set_element(cos, i, 0, esize);
+            continue;
+        }
 
         // co = (GF_ELEMENT) rand() % GFsize;
-        co = (GF_ELEMENT) genrand_int32() % (1 << GFpower);
-        if (GFpower == 1) {
-            if (co == 1) {
-                set_bit_in_array(pkt->coes, i);             // Set the corresponding coefficient as 1
-            }
-        } else if (GFpower == 8){
-            pkt->coes[i] = co;
+        if (sc->params.seeded) {
+            if (i % 4 == 0)
+                seeded_coefficient_block(r, sc->params.seed, gid, pkt->ctr, i / 4);
+            co = coefficient_from_word(r[i % 4], GFpower, nonzero);
         } else {
-            // each coding coefficient occupys len=2,3,...,7 bits
-            // Pack in the byte array. This may not be as efficient as GF(2) and GF(256)
-            pack_bits_in_byte_array(pkt->coes, sc->params.size_g, co, GFpower, i);
+            co = coefficient_from_word(snc_rng_next(rng), GFpower, nonzero);
         }
-        
-        if (GFpower == 1 || GFpower == 8) {
-            galois_multiply_add_region(pkt->syms, sc->pp[pktid], co, sc->params.size_p);
-        } else {
-            // Treat information bytes as individual GF_ELEMENTS of length 'GFpower'
-            // Caveat: Each source packet has to contain multiples of GFpower bits, since
-            // the read_bits_, pack_bits_ functions cannot handle right boundray correctly
-            // at present.
-            int nelem = ALIGN(sc->params.size_p*8, GFpower);
-            galois2n_multiply_add_region(pkt->syms, sc->pp[pktid], co, GFpower, nelem, sc->params.size_p);
-            /*
-            for (j=0; j<ALIGN(sc->params.size_p*8, GFpower); j++) {
-                GF_ELEMENT tmp1 = read_bits_from_byte_array(pkt->syms, sc->params.size_p, GFpower, j);
-                GF_ELEMENT tmp2 = galois_multiply(read_bits_from_byte_array(sc->pp[pktid], sc->params.size_p, GFpower, j), co);
-                pack_bits_in_byte_array(pkt->syms, sc->params.size_p, galois_add(tmp1, tmp2), GFpower, j);
+        pack_coefficient(pkt->coes, sc->params.size_g, co, GFpower, i);
+        srcs[i] = sc->pp[pktid];
+        gf_set_element(cos, i, co, esize);
+    }
+    return sc->params.size_g;
+}
+
+/*
+ * Draw a coefficient vector with nnz non-zero coefficients at distinct
+ * positions (Floyd's sampling) into coes, which must be zero. Two words
+ * are taken per non-zero coefficient, from rng, or from the seeded
+ * generator with counter ctr if rng is NULL, so that receivers can
+ * regenerate the vector.
+ */
+static void draw_sparse_coes(unsigned char *coes, int size_g, int nnz, int GFpower,
+                             struct snc_rng *rng, int seed, int gid, unsigned int ctr)
+{
+    uint32_t r[4];
+    uint32_t word[2];
+    int j, k, w = 0;
+    for (j=size_g-nnz; j<size_g; j++) {
+        for (k=0; k<2; k++, w++) {
+            if (rng != NULL) {
+                word[k] = snc_rng_next(rng);
+            } else {
+                if (w % 4 == 0)
+                    seeded_coefficient_block(r, seed, gid, ctr, w / 4);
+                word[k] = r[w % 4];
             }
-            */
         }
+        int t = word[0] % (j + 1);
+        if (read_coefficient(coes, size_g, GFpower, t) != 0)
+            t = j;      // already drawn
+        pack_coefficient(coes, size_g, coefficient_from_word(word[1], GFpower, 1), GFpower, t);
     }
-    pkt->ucid = -1;
-    // sc->nccount[gid] += 1;
-    sc->count += 1;
-    return;
+}
+
+/*
+ * Create the nworkers encode workers of a context, each to be used by one
+ * thread. Workers generate coded packets of fixed-subgeneration codes
+ * (RAND, BAND, WINDWRAP) concurrently from the same context, which they
+ * only read. Each worker schedules subgenerations and draws coefficients
+ * from its own RNG substream, so that the packets of a worker are
+ * reproducible from the seed and worker ID. Systematic packets are
+ * generated by the context itself, not by workers.
+ */
+struct snc_enc_worker *snc_create_enc_worker(struct snc_context *sc, int wid, int nworkers)
+{
+    static char fname[] = "snc_create_enc_worker";
+    if (sc == NULL || wid < 0 || wid >= nworkers)
+        return NULL;
+    if (sc->params.type != RAND_SNC && sc->params.type != BAND_SNC && sc->params.type != WINDWRAP_SNC) {
+        fprintf(stderr, "%s: code type %d has no fixed subgenerations\n", fname, sc->params.type);
+        return NULL;
+    }
+    struct snc_enc_worker *w = calloc(1, sizeof(struct snc_enc_worker));
+    if (w == NULL)
+        return NULL;
+    w->sc = sc;
+    w->wid = wid;
+    w->nworkers = nworkers;
+    snc_rng_seed(&w->crng, sc->params.seed, 2 + wid);    // streams 0 and 1 belong to the context
+    int esize = gf_field_esize(sc->gf);
+    w->srcs = malloc(sizeof(GF_ELEMENT*) * sc->params.size_g);
+    w->cos  = malloc(sizeof(GF_ELEMENT) * sc->params.size_g * esize);
+    if (w->srcs == NULL || w->cos == NULL) {
+        fprintf(stderr, "%s: malloc srcs/cos failed\n", fname);
+        snc_free_enc_worker(w);
+        return NULL;
+    }
+    return w;
+}
+
+/*
+ * Generate a coded packet in a given memory area by an encode worker.
+ * Seeded coefficient counters of worker wid are wid, wid+nworkers, ...
+ * with the top bit set, so they never collide with each other or with
+ * the counters of the context. Return -1 once a seeded worker has used
+ * up the 2^31 counters.
+ */
+int snc_worker_generate_packet_im(struct snc_enc_worker *w, struct snc_packet *pkt)
+{
+    static char fname[] = "snc_worker_generate_packet_im";
+    if (w == NULL || pkt == NULL || pkt->coes == NULL || pkt->syms == NULL)
+        return -1;
+    struct snc_context *sc = w->sc;
+    uint64_t idx = w->count * w->nworkers + w->wid;
+    if (sc->params.seeded && idx > 0x7fffffffu) {
+        fprintf(stderr, "%s: seeded coefficient counters of worker %d are exhausted\n", fname, w->wid);
+        return -1;
+    }
+    memset(pkt->coes, 0, ALIGN(sc->params.size_g*sc->params.gfpower,8) * sizeof(GF_ELEMENT));
+    memset(pkt->syms, 0, sc->params.size_p*sizeof(GF_ELEMENT));
+    pkt->ctr = 0;
+    int gid = schedule_generation(sc, &w->crng);
+    unsigned int ctr = 0x80000000u | (unsigned int) idx;
+    int nsrc = draw_coded_packet(sc, &w->crng, ctr, sc->gene[gid], pkt, w->srcs, w->cos);
+    galois_multiply_add_region_multi_packed(sc->gf, pkt->syms, w->srcs, w->cos, nsrc, sc->params.size_p);
+    w->count += 1;
+    return (0);
+}
+
+void snc_free_enc_worker(struct snc_enc_worker *w)
+{
+    if (w == NULL)
+        return;
+    free(w->srcs);
+    free(w->cos);
+    free(w);
 }
 
 // Randomly schedule a subset to generate a coded packet
-static int schedule_generation(struct snc_context *sc)
+static int schedule_generation(struct snc_context *sc, struct snc_rng *rng)
 {
     if (sc->gnum == 1)
         return 0;
 
-    char *ur = getenv("SNC_NONUNIFORM_RAND");
-    if ( ur != NULL && atoi(ur) == 1)
-        return banded_nonuniform_sched(sc);
-    int gid = rand() % (sc->gnum);
+    if (sc->fbgids != NULL)
+        return sc->fbgids[snc_rng_next(rng) % sc->fbnum];
+    if (sc->opts.nonuniform_rand)
+        return banded_nonuniform_sched(sc, rng);
+    int gid = snc_rng_next(rng) % (sc->gnum);
     return gid;
 }
 
+/*
+ * Apply decoder feedback to the scheduling of subgenerations. Until the next
+ * feedback, coded packets are generated uniformly from the subgenerations
+ * the decoder has not completed; if fb is NULL or reports all completed,
+ * all subgenerations are scheduled again. Must not be called concurrently
+ * with packet generation of the context.
+ *
+ * Return the number of scheduled subgenerations, or -1 on error.
+ */
+int snc_apply_feedback(struct snc_context *sc, struct snc_feedback *fb)
+{
+    static char fname[] = "snc_apply_feedback";
+    if (sc->fbgids != NULL) {
+        free(sc->fbgids);
+        sc->fbgids = NULL;
+        sc->fbnum  = 0;
+    }
+    if (fb == NULL)
+        return sc->gnum;
+    if (fb->gnum != sc->gnum) {
+        fprintf(stderr, "%s: feedback of %d subgenerations does not match the %d of the context\n", fname, fb->gnum, sc->gnum);
+        return -1;
+    }
+    int *fbgids = malloc(sizeof(int) * sc->gnum);
+    if (fbgids == NULL) {
+        fprintf(stderr, "%s: malloc fbgids failed\n", fname);
+        return -1;
+    }
+    int n = 0;
+    for (int i=0; i<sc->gnum; i++) {
+        if (!get_bit_in_array(fb->completed, i))
+            fbgids[n++] = i;
+    }
+    if (n == 0) {
+        free(fbgids);
+        return sc->gnum;
+    }
+    sc->fbgids = fbgids;
+    sc->fbnum  = n;
+    return n;
+}
+
 /*
  * Non-uniform random scheduling for banded codes
  * NOTE: scheduling of the 0-th and the (M-G)-th generation are not uniform
@@ -798,12 +1611,12 @@ static int schedule_generation(struct snc_context *sc)
  * [G+1, 2, 2, 2,..., 2, G+1]
  * [-----{  2*(M-G-1)  }----]
  */
-static int banded_nonuniform_sched(struct snc_context *sc)
+static int banded_nonuniform_sched(struct snc_context *sc, struct snc_rng *rng)
 {
 	int M = sc->snum + sc->cnum;
 	int G = sc->params.size_g;
 	int upperb = 2*(G+1)+2*(M-G-1);
-    int selected = rand() % upperb + 1;
+    int selected = snc_rng_next(rng) % upperb + 1;
 	// int selected = gsl_rng_uniform_int(r, upperb) + 1;
 
 	if (selected <= G+1) {
@@ -838,14 +1651,14 @@ void print_code_summary(struct snc_context *sc, double overhead, double operatio
         case BATS_SNC:
             strcpy(typestr, "BATS");
             break;
+        case RAPTOR_SNC:
+            strcpy(typestr, "RAPTOR");
+            break;
         default:
             strcpy(typestr, "UNKNOWN");
     }
     // precode type
-    char *hdpc = getenv("SNC_PRECODE");
-    int HDPC = 0;
-    if (hdpc != NULL && strcmp(hdpc, "HDPC") == 0)
-        HDPC = 1;
+    int HDPC = sc->opts.hdpc;
     char typestr2[20];
     if (sc->params.size_c == 0) {
         strcpy(typestr2, "NoPrecode");
@@ -875,13 +1688,15 @@ void print_code_summary(struct snc_context *sc, double overhead, double operatio
     if (sc->params.type == BATS_SNC) {
         printf("BTS: %d ", sc->params.size_b);
         printf("batch-degree: %d ", sc->params.size_g);
+    } else if (sc->params.type == RAPTOR_SNC) {
+        printf("max-degree: %d ", sc->params.size_g);
     } else {
         printf("size_b: %d ", sc->params.size_b);
         printf("size_g: %d ", sc->params.size_g);
     }
     printf("type: [%s::GF(2^%d)::%s::%s] ", typestr, sc->params.gfpower, typestr2, typestr4);
-    if (sc->params.type == BATS_SNC)
-        printf("gnum: %d ", currbid+1);
+    if (sc->params.type == BATS_SNC || sc->params.type == RAPTOR_SNC)
+        printf("gnum: %d ", sc->currbid+1);
     else
         printf("gnum: %d ", sc->gnum);
     if (operations != 0) {
@@ -893,15 +1708,7 @@ void print_code_summary(struct snc_context *sc, double overhead, double operatio
 }
 
 
-// return the GF size used by the code
+// return the GF size used by the code (the GF_POWER option is applied at context creation)
 int snc_get_GF_power(struct snc_parameters *sp) {
-    int GF_power = sp->gfpower;
-
-    // If GF_POWER env is set (for research), overwrite params
-    char *gf_evar = getenv("GF_POWER");
-    if ( gf_evar != NULL && atoi(gf_evar) <= 8) {
-        GF_power = atoi(gf_evar);
-        sp->gfpower = GF_power;
-    }
-    return GF_power;
+    return sp->gfpower;
 }
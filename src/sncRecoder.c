@@ -59,6 +59,17 @@ struct snc_buffer *snc_create_buffer(struct snc_parameters *sp, int bufsize)
         fprintf(stderr, "%s: calloc buf->nsched\n", fname);
         goto Error;
     }
+    if ((buf->gf = gf_field_get(buf->params.gfpower)) == NULL) {
+        fprintf(stderr, "%s: gf_field_get\n", fname);
+        goto Error;
+    }
+    buf->cos  = malloc(sizeof(GF_ELEMENT) * bufsize * gf_field_esize(buf->gf));
+    buf->coes = malloc(sizeof(GF_ELEMENT*) * bufsize);
+    buf->syms = malloc(sizeof(GF_ELEMENT*) * bufsize);
+    if (buf->cos == NULL || buf->coes == NULL || buf->syms == NULL) {
+        fprintf(stderr, "%s: malloc buf->cos/coes/syms\n", fname);
+        goto Error;
+    }
     if (sp->sys == 1) {
         buf->newsys = -1;
         buf->sysgid = -1;
@@ -112,13 +123,13 @@ void snc_buffer_packet(struct snc_buffer *buf, struct snc_packet *pkt)
             // Duplicate and store in the buffers of the subgen to which the packet belongs
             // i.e., treat is as a normal coded packet
             struct snc_packet *pktcopy = snc_duplicate_packet(pkt, &buf->params);
-            int relative_idx = has_item(sc->gene[sgid]->pktid, pkt->ucid, sc->params.size_g);
+            int relative_idx = has_item(get_subgeneration(sc, sgid)->pktid, pkt->ucid, sc->params.size_g);
             // We need to set the corresponding coding coefficient to 1
             memset(pktcopy->coes, 0, ALIGN(buf->params.size_g * gfpower, 8) * sizeof(GF_ELEMENT));
             if (buf->params.gfpower == 1) {
                 set_bit_in_array(pktcopy->coes, relative_idx);
-            } else if (buf->params.gfpower == 8){
-                pktcopy->coes[relative_idx] = 1;
+            } else if (buf->params.gfpower == 8 || buf->params.gfpower == 16){
+                gf_set_element(pktcopy->coes, relative_idx, 1, gf_field_esize(buf->gf));
             } else {
                 pack_bits_in_byte_array(pktcopy->coes, ALIGN(buf->params.size_g*gfpower, 8), 1, gfpower, relative_idx);
             }
@@ -177,24 +188,23 @@ void snc_buffer_packet(struct snc_buffer *buf, struct snc_packet *pkt)
         // printf("Buffer full, accumulating the received packet to buffered packets\n");
          
         for (int i=0; i<buf->size; i++) {
-            GF_ELEMENT co = (GF_ELEMENT) genrand_int32() % (1<<gfpower);
+            GF_WORD co = (GF_WORD) (genrand_int32() % (1<<gfpower));
             if (gfpower == 1) {
                 if (co == 1) {
-                    galois_multiply_add_region(buf->gbuf[gid][i]->coes, pkt->coes, co, ALIGN(buf->params.size_g, 8));
+                    galois_multiply_add_region(buf->gf, buf->gbuf[gid][i]->coes, pkt->coes, co, ALIGN(buf->params.size_g, 8));
                 }
-            } else if (gfpower == 8) {
-                galois_multiply_add_region(buf->gbuf[gid][i]->coes, pkt->coes, co, buf->params.size_g);
+            } else if (gfpower == 8 || gfpower == 16) {
+                galois_multiply_add_region(buf->gf, buf->gbuf[gid][i]->coes, pkt->coes, co, ALIGN(buf->params.size_g*gfpower, 8));
             } else {
                 // coding coefficients of 2,3,...,7 bits
-                galois2n_multiply_add_region(buf->gbuf[gid][i]->coes, pkt->coes, co, gfpower, buf->params.size_g, ALIGN(buf->params.size_g*gfpower, 8));
+                galois2n_multiply_add_region(buf->gf, buf->gbuf[gid][i]->coes, pkt->coes, co, ALIGN(buf->params.size_g*gfpower, 8));
             }
 
             // multiply_add the coded symbols
-            if (gfpower == 1 || gfpower == 8) {
-                galois_multiply_add_region(buf->gbuf[gid][i]->syms, pkt->syms, co, buf->params.size_p);
+            if (gfpower == 1 || gfpower == 8 || gfpower == 16) {
+                galois_multiply_add_region(buf->gf, buf->gbuf[gid][i]->syms, pkt->syms, co, buf->params.size_p);
             } else {
-                int nelem = ALIGN(buf->params.size_p*8, gfpower);
-                galois2n_multiply_add_region(buf->gbuf[gid][i]->syms, pkt->syms, co, gfpower, nelem, buf->params.size_p);
+                galois2n_multiply_add_region(buf->gf, buf->gbuf[gid][i]->syms, pkt->syms, co, buf->params.size_p);
             }
         }
         
@@ -229,6 +239,7 @@ int snc_recode_packet_im(struct snc_buffer *buf, struct snc_packet *pkt, int sch
     // Clean up pkt
     memset(pkt->coes, 0, ALIGN(buf->params.size_g * gfpower, 8)*sizeof(GF_ELEMENT));
     memset(pkt->syms, 0, sizeof(GF_ELEMENT)*buf->params.size_p);
+    pkt->ctr = 0;       // recoded coefficients are always explicit
     
     if (gid == buf->gnum) {
         // A systematic packet is scheduled
@@ -245,31 +256,23 @@ int snc_recode_packet_im(struct snc_buffer *buf, struct snc_packet *pkt, int sch
     // Generate a normal recoded GNC packet
     pkt->gid = gid;
     pkt->ucid = -1;
-    GF_ELEMENT co = 0;
-    int i, j;
+    int i;
+    int nc = buf->nc[gid];
+    int esize = gf_field_esize(buf->gf);
+    GF_ELEMENT *cos = buf->cos;
+    GF_ELEMENT **coes = buf->coes;
+    GF_ELEMENT **syms = buf->syms;
     // Go through the buffered packets of the subgeneration
-    for (i=0; i<buf->nc[gid]; i++) {
-        co = (GF_ELEMENT) genrand_int32() % (1 << gfpower);
-        if (co == 0) {
-            continue;
-        }
-        if (gfpower == 1) {
-            galois_multiply_add_region(pkt->coes, buf->gbuf[gid][i]->coes, co, ALIGN(buf->params.size_g, 8));
-        } else if (gfpower == 8) {
-            galois_multiply_add_region(pkt->coes, buf->gbuf[gid][i]->coes, co, buf->params.size_g);
-        } else {
-            // coding coefficients of 2,3,...,7 bits
-            // int nelem = ALIGN(buf->params.size_g*8, gfpower);
-            galois2n_multiply_add_region(pkt->coes, buf->gbuf[gid][i]->coes, co, gfpower, buf->params.size_g, ALIGN(buf->params.size_g*gfpower, 8));
-        }
-        // linear combinations of coded symbols
-        if (gfpower == 1 || gfpower == 8) {
-            galois_multiply_add_region(pkt->syms, buf->gbuf[gid][i]->syms, co, buf->params.size_p);
-        } else {
-            int nelem = ALIGN(buf->params.size_p*8, gfpower);
-            galois2n_multiply_add_region(pkt->syms, buf->gbuf[gid][i]->syms, co, gfpower, nelem, buf->params.size_p);
-        }
+    for (i=0; i<nc; i++) {
+        gf_set_element(cos, i, genrand_int32() % (1 << gfpower), esize);
+        coes[i] = buf->gbuf[gid][i]->coes;
+        syms[i] = buf->gbuf[gid][i]->syms;
     }
+    // linear combinations of coding coefficients (bit-packed for GF(2), 2,3,...,7 bits
+    // packed for GF(4),...,GF(128), two bytes for GF(2^16)) and of coded symbols
+    int coesize = gfpower == 1 ? ALIGN(buf->params.size_g, 8) : ALIGN(buf->params.size_g*gfpower, 8);
+    galois_multiply_add_region_multi_packed(buf->gf, pkt->coes, coes, cos, nc, coesize);
+    galois_multiply_add_region_multi_packed(buf->gf, pkt->syms, syms, cos, nc, buf->params.size_p);
     return 0;
 }
 
@@ -295,6 +298,10 @@ void snc_free_buffer(struct snc_buffer *buf)
         free(buf->pn);
     if (buf->nsched != NULL)
         free(buf->nsched);
+    free(buf->cos);
+    free(buf->coes);
+    free(buf->syms);
+    gf_field_put(buf->gf);
     free(buf);
     buf = NULL;
 
@@ -2,7 +2,6 @@
 #include "galois.h"
 #include "sparsenc.h"
 
-static int GFpower;
 
 static int s_neq_r = 0;  // indicate whether the sending and receiving batch do not match.
                      // i.e., whether there are more than 1 batches buffered
@@ -22,7 +21,22 @@ struct snc_buffer_bats *snc_create_buffer_bats(struct snc_parameters *sp, int bu
     buf->sbatchid = -1;  // empty buffer
     buf->s_first = -1;
     buf->r_last = -1;
-    GFpower = snc_get_GF_power(&buf->params);
+    buf->cos = NULL;
+    buf->coes = NULL;
+    buf->syms = NULL;
+    if ((buf->gf = gf_field_get(buf->params.gfpower)) == NULL) {
+        fprintf(stderr, "%s: gf_field_get\n", fname);
+        snc_free_buffer_bats(buf);
+        return NULL;
+    }
+    buf->cos  = malloc(sizeof(GF_ELEMENT) * bufsize * gf_field_esize(buf->gf));
+    buf->coes = malloc(sizeof(GF_ELEMENT*) * bufsize);
+    buf->syms = malloc(sizeof(GF_ELEMENT*) * bufsize);
+    if (buf->cos == NULL || buf->coes == NULL || buf->syms == NULL) {
+        fprintf(stderr, "%s: malloc buf->cos/coes/syms\n", fname);
+        snc_free_buffer_bats(buf);
+        return NULL;
+    }
     return buf;
 }
 
@@ -142,6 +156,7 @@ int snc_recode_packet_bats_im(struct snc_buffer_bats *buf, struct snc_packet *pk
     // Reset the snc_packet structure
     pkt->gid = buf->sbatchid;
     pkt->ucid = -1;
+    pkt->ctr = 0;       // recoded coefficients are always explicit
     // Clean up pkt
     memset(pkt->coes, 0, ALIGN(buf->params.size_g * gfpower, 8) * sizeof(GF_ELEMENT));
     /*
@@ -153,47 +168,26 @@ int snc_recode_packet_bats_im(struct snc_buffer_bats *buf, struct snc_packet *pk
     */
     memset(pkt->syms, 0, sizeof(GF_ELEMENT)*buf->params.size_p);
     // Recoding
-    GF_ELEMENT co =0;    
+    int esize = gf_field_esize(buf->gf);
+    GF_ELEMENT *cos = buf->cos;
+    GF_ELEMENT **coes = buf->coes;
+    GF_ELEMENT **syms = buf->syms;
+    int n = 0;
     for (i=0; i<buf->bufsize; i++) {
         pos = (s_pos + i) % buf->bufsize;
         if (buf->srbuf[pos] == NULL || buf->srbuf[pos]->gid != buf->sbatchid)
             break;      // packets belonging to the same batch must be stored adjacently (TODO: is this really true in the asynchronous mode?).
         // Perform random linear combination of buffered packets belonging to the same batch
-        co = (GF_ELEMENT) rand() % (1 << gfpower);
-        /*
-        if (GFpower == 1 && co == 1) {
-            galois_multiply_add_region(pkt->coes, buf->srbuf[pos]->coes, co, ALIGN(buf->params.size_g, 8));
-        } else if (GFpower == 8) {
-            galois_multiply_add_region(pkt->coes, buf->srbuf[pos]->coes, co, buf->params.size_g);
-        } else {
-            for (int j=0; j<buf->params.size_g; j++) {
-                GF_ELEMENT co_buf = read_bits_from_byte_array(buf->srbuf[pos]->coes, buf->params.size_g, GFpower, j);
-                GF_ELEMENT co_pkt = read_bits_from_byte_array(pkt->coes, buf->params.size_g, GFpower, j);
-                GF_ELEMENT co_new = galois_add(co_pkt, galois_multiply(co_buf, co));
-                pack_bits_in_byte_array(pkt->coes, buf->params.size_g, co_new, GFpower, j);
-            }
-        }
-        // random linear combinations of coded symbols 
-        galois_multiply_add_region(pkt->syms, buf->srbuf[pos]->syms, co, buf->params.size_p);
-        */
-        if (gfpower == 1) {
-            galois_multiply_add_region(pkt->coes, buf->srbuf[pos]->coes, co, ALIGN(buf->params.size_g, 8));
-        } else if (gfpower == 8) {
-            galois_multiply_add_region(pkt->coes, buf->srbuf[pos]->coes, co, buf->params.size_g);
-        } else {
-            // coding coefficients of 2,3,...,7 bits
-            // int nelem = ALIGN(buf->params.size_g*8, gfpower);
-            galois2n_multiply_add_region(pkt->coes, buf->srbuf[pos]->coes, co, gfpower, buf->params.size_g, ALIGN(buf->params.size_g*gfpower, 8));
-        }
-        // linear combinations of coded symbols
-        if (gfpower == 1 || gfpower == 8) {
-            galois_multiply_add_region(pkt->syms, buf->srbuf[pos]->syms, co, buf->params.size_p);
-        } else {
-            int nelem = ALIGN(buf->params.size_p*8, gfpower);
-            galois2n_multiply_add_region(pkt->syms, buf->srbuf[pos]->syms, co, gfpower, nelem, buf->params.size_p);
-        }
-
+        gf_set_element(cos, n, rand() % (1 << gfpower), esize);
+        coes[n] = buf->srbuf[pos]->coes;
+        syms[n] = buf->srbuf[pos]->syms;
+        n++;
     }
+    // linear combinations of coding coefficients (bit-packed for GF(2), 2,3,...,7 bits
+    // packed for GF(4),...,GF(128), two bytes for GF(2^16)) and of coded symbols
+    int coesize = gfpower == 1 ? ALIGN(buf->params.size_g, 8) : ALIGN(buf->params.size_g*gfpower, 8);
+    galois_multiply_add_region_multi_packed(buf->gf, pkt->coes, coes, cos, n, coesize);
+    galois_multiply_add_region_multi_packed(buf->gf, pkt->syms, syms, cos, n, buf->params.size_p);
     s_count += 1;
     return 0;
 }
@@ -209,6 +203,10 @@ void snc_free_buffer_bats(struct snc_buffer_bats *buf)
             snc_free_packet(buf->srbuf[i]);
     }
     free(buf->srbuf);
+    free(buf->cos);
+    free(buf->coes);
+    free(buf->syms);
+    gf_field_put(buf->gf);
     free(buf);
     buf = NULL;
     return;
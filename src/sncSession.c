@@ -0,0 +1,542 @@
+/**************************************************************
+ * sncSession.c
+ *
+ * Sessions of objects too large for one code. The object is
+ * split into segments of sp->datasize bytes (the last segment
+ * holds the remainder), each coded by its own encode context
+ * or decoder with the parameters of the session. Coded packets
+ * carry the id of their segment. Creating the contexts,
+ * decoding batches of packets and recovering the object run
+ * segment-parallel, segment s being handled by thread
+ * s % nthreads so that a context is only used by one thread.
+ **************************************************************/
+#define _XOPEN_SOURCE 600    // pwrite(), gettimeofday()
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <pthread.h>
+#include "common.h"
+#include "sparsenc.h"
+
+#define SEGID_LEN   4       // bytes of the segment id prefix of serialized packets
+
+struct snc_session {
+    struct snc_parameters   params;     // code parameters of a full segment, seed shared by all segments
+    long                    size;       // object size in bytes
+    int                     nseg;       // number of segments
+    int                     nthreads;   // threads of segment-parallel work
+    struct snc_context    **sc;         // encode contexts of segments (encode sessions)
+    struct snc_decoder    **dec;        // decoders of segments (decode sessions)
+    int                     d_type;     // decoder type (decode sessions)
+    struct snc_options      opts;       // options of the contexts/decoders of segments
+};
+
+/*
+ * Job of a thread, working on segments first, first+nthreads, ...
+ */
+struct session_job {
+    struct snc_session *ss;
+    int                 first;
+    unsigned char      *buf;        // object buffer (create from buffer, recover to buffer)
+    const char         *filepath;   // object file (create from file)
+    long                start;      // offset of the object in filepath
+    int                 fd;         // object file (recover to file)
+    int                *segids;     // packets to process
+    struct snc_packet **pkts;
+    int                 npkt;
+    int                 failed;     // number of segments the job failed on
+};
+
+static struct snc_session *create_session(long size, struct snc_parameters *sp, int nthreads);
+static int run_jobs(struct snc_session *ss, void *(*run)(void *), struct session_job *jobs);
+
+/*
+ * Parameters of segment segid. A short last segment may have fewer packets
+ * than a subgeneration, in which case its subgenerations are clamped to all
+ * of its packets (dense coefficients).
+ */
+static void segment_params(struct snc_session *ss, int segid, struct snc_parameters *sp)
+{
+    *sp = ss->params;
+    long off = (long) segid * ss->params.datasize;
+    if (ss->size - off < sp->datasize)
+        sp->datasize = ss->size - off;
+    int npkt = ALIGN(sp->datasize, sp->size_p) + sp->size_c;
+    if (sp->size_g > npkt) {
+        sp->size_g = npkt;
+        if (sp->size_b > npkt)
+            sp->size_b = npkt;
+        sp->nnz = 0;
+    }
+}
+
+static struct snc_context *segment_context(struct snc_session *ss, int segid)
+{
+    return ss->sc != NULL ? ss->sc[segid] : snc_get_enc_context(ss->dec[segid]);
+}
+
+// Copy decoded data of a segment to dst
+static void copy_segment(struct snc_context *sc, unsigned char *dst)
+{
+    long datasize = sc->params.datasize;
+    long alwrote = 0;
+    int pc = 0;
+    while (alwrote < datasize) {
+        long towrite = ((alwrote + sc->params.size_p) <= datasize) ? sc->params.size_p : datasize - alwrote;
+        memcpy(dst+alwrote, sc->pp[pc++], sizeof(GF_ELEMENT)*towrite);
+        alwrote += towrite;
+    }
+}
+
+static void *create_enc_segments(void *arg)
+{
+    struct session_job *job = (struct session_job *) arg;
+    struct snc_session *ss = job->ss;
+    for (int s=job->first; s<ss->nseg; s+=ss->nthreads) {
+        struct snc_parameters sp;
+        segment_params(ss, s, &sp);
+        long off = (long) s * ss->params.datasize;
+        if (job->buf != NULL) {
+            ss->sc[s] = create_enc_context(job->buf + off, &sp, 1, &ss->opts);
+        } else {
+            ss->sc[s] = create_enc_context(NULL, &sp, 0, &ss->opts);
+            if (ss->sc[s] != NULL && snc_load_file_to_context(job->filepath, job->start + off, ss->sc[s]) != 0) {
+                snc_free_enc_context(ss->sc[s]);
+                ss->sc[s] = NULL;
+            }
+        }
+        if (ss->sc[s] == NULL)
+            job->failed++;
+    }
+    return NULL;
+}
+
+static void *create_dec_segments(void *arg)
+{
+    struct session_job *job = (struct session_job *) arg;
+    struct snc_session *ss = job->ss;
+    for (int s=job->first; s<ss->nseg; s+=ss->nthreads) {
+        struct snc_parameters sp;
+        segment_params(ss, s, &sp);
+        if ((ss->dec[s] = snc_create_decoder_opt(&sp, ss->d_type, &ss->opts)) == NULL)
+            job->failed++;
+    }
+    return NULL;
+}
+
+static void *process_segment_packets(void *arg)
+{
+    struct session_job *job = (struct session_job *) arg;
+    struct snc_session *ss = job->ss;
+    for (int i=0; i<job->npkt; i++) {
+        int s = job->segids[i];
+        if (s < 0 || s >= ss->nseg || s % ss->nthreads != job->first)
+            continue;
+        if (!snc_decoder_finished(ss->dec[s]))
+            snc_process_packet(ss->dec[s], job->pkts[i]);
+    }
+    return NULL;
+}
+
+static void *recover_segments(void *arg)
+{
+    struct session_job *job = (struct session_job *) arg;
+    struct snc_session *ss = job->ss;
+    for (int s=job->first; s<ss->nseg; s+=ss->nthreads)
+        copy_segment(segment_context(ss, s), job->buf + (long) s * ss->params.datasize);
+    return NULL;
+}
+
+static void *write_segments(void *arg)
+{
+    static char fname[] = "snc_session_recover_to_file";
+    struct session_job *job = (struct session_job *) arg;
+    struct snc_session *ss = job->ss;
+    for (int s=job->first; s<ss->nseg; s+=ss->nthreads) {
+        struct snc_context *sc = segment_context(ss, s);
+        copy_segment(sc, job->buf);
+        long off = job->start + (long) s * ss->params.datasize;
+        long wrote = 0;
+        while (wrote < sc->params.datasize) {
+            ssize_t n = pwrite(job->fd, job->buf + wrote, sc->params.datasize - wrote, off + wrote);
+            if (n <= 0) {
+                fprintf(stderr, "%s: pwrite segment %d\n", fname, s);
+                job->failed++;
+                break;
+            }
+            wrote += n;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Create an encode session of the size bytes of buf. sp->datasize is the
+ * segment size; a seed of -1 is replaced by a time stamp and written
+ * back to sp, and sp must be passed to snc_create_dec_session(). The
+ * segments point into buf, which must outlive the session. nthreads is
+ * the number of threads of segment-parallel work, 0 for automatic.
+ */
+struct snc_session *snc_create_enc_session(unsigned char *buf, long size, struct snc_parameters *sp, int nthreads)
+{
+    static char fname[] = "snc_create_enc_session";
+    if (buf == NULL)
+        return NULL;
+    struct snc_session *ss = create_session(size, sp, nthreads);
+    if (ss == NULL)
+        return NULL;
+    struct session_job *jobs = calloc(ss->nthreads, sizeof(struct session_job));
+    if ((ss->sc = calloc(ss->nseg, sizeof(struct snc_context *))) == NULL || jobs == NULL) {
+        fprintf(stderr, "%s: calloc contexts failed\n", fname);
+        free(jobs);
+        snc_free_session(ss);
+        return NULL;
+    }
+    for (int t=0; t<ss->nthreads; t++)
+        jobs[t].buf = buf;
+    if (run_jobs(ss, create_enc_segments, jobs) != 0) {
+        fprintf(stderr, "%s: create segment contexts failed\n", fname);
+        snc_free_session(ss);
+        ss = NULL;
+    }
+    free(jobs);
+    return ss;
+}
+
+/*
+ * Create an encode session of the size bytes of filepath starting at
+ * offset start, or of the rest of the file if size is -1. Segments are
+ * loaded with snc_load_file_to_context().
+ */
+struct snc_session *snc_create_enc_session_file(const char *filepath, long start, long size, struct snc_parameters *sp, int nthreads)
+{
+    static char fname[] = "snc_create_enc_session_file";
+    if (size == -1) {
+        struct stat st;
+        if (stat(filepath, &st) != 0 || st.st_size <= start) {
+            fprintf(stderr, "%s: %s has no data after offset %ld\n", fname, filepath, start);
+            return NULL;
+        }
+        size = st.st_size - start;
+    }
+    struct snc_session *ss = create_session(size, sp, nthreads);
+    if (ss == NULL)
+        return NULL;
+    struct session_job *jobs = calloc(ss->nthreads, sizeof(struct session_job));
+    if ((ss->sc = calloc(ss->nseg, sizeof(struct snc_context *))) == NULL || jobs == NULL) {
+        fprintf(stderr, "%s: calloc contexts failed\n", fname);
+        free(jobs);
+        snc_free_session(ss);
+        return NULL;
+    }
+    for (int t=0; t<ss->nthreads; t++) {
+        jobs[t].filepath = filepath;
+        jobs[t].start    = start;
+    }
+    if (run_jobs(ss, create_enc_segments, jobs) != 0) {
+        fprintf(stderr, "%s: load segments of %s failed\n", fname, filepath);
+        snc_free_session(ss);
+        ss = NULL;
+    }
+    free(jobs);
+    return ss;
+}
+
+/*
+ * Create a decode session of a size-byte object coded with parameters sp
+ * (as written back by the encode session, seed included).
+ */
+struct snc_session *snc_create_dec_session(long size, struct snc_parameters *sp, int d_type, int nthreads)
+{
+    static char fname[] = "snc_create_dec_session";
+    if (sp->seed == -1) {
+        fprintf(stderr, "%s: the seed of the encode session is needed\n", fname);
+        return NULL;
+    }
+    struct snc_session *ss = create_session(size, sp, nthreads);
+    if (ss == NULL)
+        return NULL;
+    ss->d_type = d_type;
+    struct session_job *jobs = calloc(ss->nthreads, sizeof(struct session_job));
+    if ((ss->dec = calloc(ss->nseg, sizeof(struct snc_decoder *))) == NULL || jobs == NULL) {
+        fprintf(stderr, "%s: calloc decoders failed\n", fname);
+        free(jobs);
+        snc_free_session(ss);
+        return NULL;
+    }
+    if (run_jobs(ss, create_dec_segments, jobs) != 0) {
+        fprintf(stderr, "%s: create segment decoders failed\n", fname);
+        snc_free_session(ss);
+        ss = NULL;
+    }
+    free(jobs);
+    return ss;
+}
+
+static struct snc_session *create_session(long size, struct snc_parameters *sp, int nthreads)
+{
+    static char fname[] = "snc_create_session";
+    if (size <= 0 || sp->datasize <= 0) {
+        fprintf(stderr, "%s: object size %ld and segment size %ld must be positive\n", fname, size, sp->datasize);
+        return NULL;
+    }
+    long nseg = (size + sp->datasize - 1) / sp->datasize;
+    if (nseg > INT_MAX) {
+        fprintf(stderr, "%s: too many segments (%ld)\n", fname, nseg);
+        return NULL;
+    }
+    struct snc_session *ss;
+    if ((ss = calloc(1, sizeof(struct snc_session))) == NULL) {
+        fprintf(stderr, "%s: calloc session failed\n", fname);
+        return NULL;
+    }
+    // All segments share one seed, so that the decode session only needs sp
+    if (sp->seed == -1) {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        sp->seed = tv.tv_sec * 1000 + tv.tv_usec / 1000;
+    }
+    snc_default_options(&ss->opts);
+    if (ss->opts.gfpower != 0)
+        sp->gfpower = ss->opts.gfpower;
+    ss->params   = *sp;
+    ss->size     = size;
+    ss->nseg     = (int) nseg;
+    ss->d_type   = -1;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    ss->nthreads = nthreads > 0 ? nthreads : (int) (ncpu > 0 ? ncpu : 1);
+    if (ss->nthreads > ss->nseg)
+        ss->nthreads = ss->nseg;
+    // Segments are precoded in parallel already
+    if (ss->nthreads > 1 && ss->opts.precode_threads == 0)
+        ss->opts.precode_threads = 1;
+    return ss;
+}
+
+/*
+ * Run job t of jobs on thread t, the calling thread taking job 0 (and
+ * any job whose thread cannot be created). Return the number of failed
+ * segments, which is all of them if the threads cannot be allocated.
+ */
+static int run_jobs(struct snc_session *ss, void *(*run)(void *), struct session_job *jobs)
+{
+    static char fname[] = "run_jobs";
+    int t;
+    pthread_t *tids = calloc(ss->nthreads, sizeof(pthread_t));
+    int *started = calloc(ss->nthreads, sizeof(int));
+    if (tids == NULL || started == NULL) {
+        fprintf(stderr, "%s: calloc threads failed\n", fname);
+        free(tids);
+        free(started);
+        return ss->nseg;
+    }
+    for (t=0; t<ss->nthreads; t++) {
+        jobs[t].ss     = ss;
+        jobs[t].first  = t;
+        jobs[t].failed = 0;
+    }
+    for (t=1; t<ss->nthreads; t++)
+        started[t] = (pthread_create(&tids[t], NULL, run, &jobs[t]) == 0);
+    run(&jobs[0]);
+    int failed = jobs[0].failed;
+    for (t=1; t<ss->nthreads; t++) {
+        if (started[t])
+            pthread_join(tids[t], NULL);
+        else
+            run(&jobs[t]);
+        failed += jobs[t].failed;
+    }
+    free(tids);
+    free(started);
+    return failed;
+}
+
+int snc_session_segments(struct snc_session *ss)
+{
+    return ss->nseg;
+}
+
+struct snc_context *snc_session_get_context(struct snc_session *ss, int segid)
+{
+    if (segid < 0 || segid >= ss->nseg)
+        return NULL;
+    return segment_context(ss, segid);
+}
+
+int snc_session_generate_packet_im(struct snc_session *ss, int segid, struct snc_packet *pkt)
+{
+    if (ss->sc == NULL || segid < 0 || segid >= ss->nseg)
+        return (-1);
+    return snc_generate_packet_im(ss->sc[segid], pkt);
+}
+
+int snc_session_packet_length(struct snc_session *ss)
+{
+    struct snc_parameters sp;
+    segment_params(ss, 0, &sp);
+    int len = snc_packet_length(&sp);
+    segment_params(ss, ss->nseg-1, &sp);
+    int lastlen = snc_packet_length(&sp);
+    return SEGID_LEN + (len > lastlen ? len : lastlen);
+}
+
+int snc_session_serialized_length(struct snc_session *ss, int segid, struct snc_packet *pkt)
+{
+    struct snc_parameters sp;
+    segment_params(ss, segid, &sp);
+    return SEGID_LEN + snc_serialized_length(pkt, &sp);
+}
+
+unsigned char *snc_session_serialize_packet(struct snc_session *ss, int segid, struct snc_packet *pkt)
+{
+    if (pkt == NULL || segid < 0 || segid >= ss->nseg)
+        return NULL;
+    struct snc_parameters sp;
+    segment_params(ss, segid, &sp);
+    unsigned char *body = snc_serialize_packet(pkt, &sp);
+    int len = snc_serialized_length(pkt, &sp);
+    unsigned char *pktstr = malloc(SEGID_LEN + len);
+    if (body == NULL || pktstr == NULL) {
+        free(body);
+        free(pktstr);
+        return NULL;
+    }
+    memcpy(pktstr, &segid, SEGID_LEN);
+    memcpy(pktstr+SEGID_LEN, body, len);
+    free(body);
+    return pktstr;
+}
+
+struct snc_packet *snc_session_deserialize_packet(struct snc_session *ss, unsigned char *pktstr, int *segid)
+{
+    static char fname[] = "snc_session_deserialize_packet";
+    memcpy(segid, pktstr, SEGID_LEN);
+    if (*segid < 0 || *segid >= ss->nseg) {
+        fprintf(stderr, "%s: invalid segment id %d\n", fname, *segid);
+        return NULL;
+    }
+    struct snc_parameters sp;
+    segment_params(ss, *segid, &sp);
+    return snc_deserialize_packet(pktstr+SEGID_LEN, &sp);
+}
+
+void snc_session_process_packet(struct snc_session *ss, int segid, struct snc_packet *pkt)
+{
+    if (ss->dec == NULL || segid < 0 || segid >= ss->nseg)
+        return;
+    if (!snc_decoder_finished(ss->dec[segid]))
+        snc_process_packet(ss->dec[segid], pkt);
+}
+
+int snc_session_process_packets(struct snc_session *ss, int segids[], struct snc_packet *pkts[], int n)
+{
+    static char fname[] = "snc_session_process_packets";
+    if (ss->dec == NULL)
+        return (-1);
+    struct session_job *jobs = calloc(ss->nthreads, sizeof(struct session_job));
+    if (jobs == NULL) {
+        fprintf(stderr, "%s: calloc jobs failed\n", fname);
+        return (-1);
+    }
+    for (int t=0; t<ss->nthreads; t++) {
+        jobs[t].segids = segids;
+        jobs[t].pkts   = pkts;
+        jobs[t].npkt   = n;
+    }
+    int failed = run_jobs(ss, process_segment_packets, jobs);
+    free(jobs);
+    return failed ? (-1) : 0;
+}
+
+int snc_session_segment_finished(struct snc_session *ss, int segid)
+{
+    if (ss->dec == NULL || segid < 0 || segid >= ss->nseg)
+        return 1;
+    return snc_decoder_finished(ss->dec[segid]);
+}
+
+int snc_session_finished(struct snc_session *ss)
+{
+    for (int s=0; s<ss->nseg; s++) {
+        if (!snc_session_segment_finished(ss, s))
+            return 0;
+    }
+    return 1;
+}
+
+unsigned char *snc_session_recover_data(struct snc_session *ss)
+{
+    static char fname[] = "snc_session_recover_data";
+    if (!snc_session_finished(ss)) {
+        fprintf(stderr, "%s: decoding is not finished\n", fname);
+        return NULL;
+    }
+    unsigned char *data;
+    if ((data = malloc(ss->size)) == NULL) {
+        fprintf(stderr, "%s: malloc(size) failed.\n", fname);
+        return NULL;
+    }
+    struct session_job *jobs = calloc(ss->nthreads, sizeof(struct session_job));
+    if (jobs == NULL) {
+        fprintf(stderr, "%s: calloc jobs failed\n", fname);
+        free(data);
+        return NULL;
+    }
+    for (int t=0; t<ss->nthreads; t++)
+        jobs[t].buf = data;
+    int failed = run_jobs(ss, recover_segments, jobs);
+    free(jobs);
+    if (failed) {
+        free(data);
+        return NULL;
+    }
+    return data;
+}
+
+long snc_session_recover_to_file(const char *filepath, long start, struct snc_session *ss)
+{
+    static char fname[] = "snc_session_recover_to_file";
+    if (!snc_session_finished(ss)) {
+        fprintf(stderr, "%s: decoding is not finished\n", fname);
+        return (-1);
+    }
+    int fd;
+    if ((fd = open(filepath, O_WRONLY | O_CREAT, 0644)) == -1)
+        return (-1);
+    struct session_job *jobs = calloc(ss->nthreads, sizeof(struct session_job));
+    int t, failed = (jobs == NULL);
+    for (t=0; t<ss->nthreads && !failed; t++) {
+        jobs[t].fd    = fd;
+        jobs[t].start = start;
+        if ((jobs[t].buf = malloc(ss->params.datasize)) == NULL)
+            failed = 1;
+    }
+    if (failed) {
+        fprintf(stderr, "%s: malloc segment buffers failed\n", fname);
+    } else {
+        failed = run_jobs(ss, write_segments, jobs);
+    }
+    for (t=0; jobs != NULL && t<ss->nthreads; t++)
+        free(jobs[t].buf);
+    free(jobs);
+    if (close(fd) != 0)
+        failed = 1;
+    return failed ? (-1) : ss->size;
+}
+
+void snc_free_session(struct snc_session *ss)
+{
+    if (ss == NULL)
+        return;
+    for (int s=0; s<ss->nseg; s++) {
+        if (ss->sc != NULL && ss->sc[s] != NULL)
+            snc_free_enc_context(ss->sc[s]);
+        if (ss->dec != NULL && ss->dec[s] != NULL)
+            snc_free_decoder(ss->dec[s]);
+    }
+    free(ss->sc);
+    free(ss->dec);
+    free(ss);
+}
@@ -0,0 +1,443 @@
+/**************************************************************
+ * sncStream.c
+ *
+ * Sliding-window encoder and decoder of unbounded packet streams.
+ * The encoder codes over the last size_w source packets appended
+ * by the application. The decoder keeps the rows it received in
+ * a ring of 2*size_w columns indexed by sequence number, solves
+ * them as soon as a closed block of pivots starting from the
+ * oldest unreleased packet is complete, and releases the decoded
+ * packets in sequence order.
+ **************************************************************/
+#define _XOPEN_SOURCE 600    // gettimeofday()
+#include <sys/time.h>
+#include "common.h"
+#include "galois.h"
+#include "sparsenc.h"
+
+struct snc_stream_encoder {
+    int             size_p;
+    int             size_w;     // window size
+    int             gfpower;
+    int             esize;      // bytes per coefficient
+    struct gf_field *gf;
+    struct snc_rng  rng;
+    int             next;       // sequence number of the next appended packet
+    GF_ELEMENT      *slab;      // size_w source packets, packet s at slot s % size_w
+    GF_ELEMENT      **srcs;     // source packets of the current window
+    GF_ELEMENT      *cos;       // coefficients of the current window
+};
+
+// States of decoder columns
+#define COL_EMPTY       0       // no row pivoted at the column yet
+#define COL_ROW         1       // a row pivoted at the column is stored
+#define COL_DECODED     2       // source packet is decoded
+#define COL_LOST        3       // source packet can no longer be decoded
+
+struct stream_column {
+    int         state;
+    int         len;            // row covers columns [seq, seq+len), the pivot first
+    GF_ELEMENT  *coes;          // row coefficients
+    GF_ELEMENT  *syms;          // row payload, or the source packet once decoded
+};
+
+struct snc_stream_decoder {
+    int             size_p;
+    int             size_w;
+    int             esize;
+    int             cap;        // number of columns held, 2*size_w
+    struct gf_field *gf;
+    int             base;       // columns [base, base+cap) are held, column c at cols[c % cap]
+    int             next;       // first column not released yet
+    int             popped;     // next released column to hand out
+    int             wstart;     // latest encoder window start; columns below it are not coded any more
+    struct stream_column *cols;
+    GF_ELEMENT      *coes;      // storage of row coefficients, cap*cap elements
+    GF_ELEMENT      *slab;      // storage of row payloads, stride PADDED(size_p)
+    GF_ELEMENT      *vec;       // coefficients of the packet being processed
+    GF_ELEMENT      *sym;       // payload of the packet being processed
+};
+
+static int verify_stream_parameter(int size_p, int size_w, int gfpower)
+{
+    if (size_p <= 0 || size_w <= 0) {
+        fprintf(stderr, "stream: packet size and window size must be positive\n");
+        return -1;
+    }
+    if (gfpower != 1 && gfpower != 8 && gfpower != 16) {
+        fprintf(stderr, "stream: GF(2^%d) is not supported, use GF(2), GF(2^8) or GF(2^16)\n", gfpower);
+        return -1;
+    }
+    if (gfpower == 16 && size_p % 2 != 0) {
+        fprintf(stderr, "stream: packet size must be even in GF(2^16)\n");
+        return -1;
+    }
+    return 0;
+}
+
+struct snc_stream_encoder *snc_create_stream_encoder(int size_p, int size_w, int gfpower, int seed)
+{
+    if (verify_stream_parameter(size_p, size_w, gfpower) != 0)
+        return NULL;
+    struct snc_stream_encoder *enc = calloc(1, sizeof(struct snc_stream_encoder));
+    if (enc == NULL)
+        return NULL;
+    enc->size_p  = size_p;
+    enc->size_w  = size_w;
+    enc->gfpower = gfpower;
+    enc->esize   = gfpower == 16 ? 2 : 1;
+    if (seed == -1) {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        seed = tv.tv_sec * 1000 + tv.tv_usec / 1000;
+    }
+    snc_rng_seed(&enc->rng, seed, 0);
+    if ((enc->gf = gf_field_get(gfpower)) == NULL
+            || (enc->slab = calloc_payload_slab(size_w, size_p)) == NULL
+            || (enc->srcs = calloc(size_w, sizeof(GF_ELEMENT *))) == NULL
+            || (enc->cos = calloc(size_w, enc->esize)) == NULL) {
+        fprintf(stderr, "malloc stream encoder failed\n");
+        snc_free_stream_encoder(enc);
+        return NULL;
+    }
+    return enc;
+}
+
+int snc_stream_append(struct snc_stream_encoder *enc, const unsigned char *data, int len)
+{
+    if (len < 0 || len > enc->size_p) {
+        fprintf(stderr, "stream: cannot append %d bytes to packets of %d bytes\n", len, enc->size_p);
+        return -1;
+    }
+    GF_ELEMENT *pp = enc->slab + (size_t) (enc->next % enc->size_w) * PADDED(enc->size_p);
+    memcpy(pp, data, len);
+    memset(pp + len, 0, enc->size_p - len);
+    return enc->next++;
+}
+
+int snc_stream_generate_packet_im(struct snc_stream_encoder *enc, struct snc_stream_packet *pkt)
+{
+    if (enc->next == 0)
+        return -1;
+    int first = enc->next > enc->size_w ? enc->next - enc->size_w : 0;
+    int count = enc->next - first;
+    for (int i=0; i<count; i++) {
+        // non-zero coefficients, except in GF(2) where it would repeat the sum of the window
+        GF_WORD co;
+        if (enc->gfpower == 1)
+            co = snc_rng_next(&enc->rng) & 1;
+        else
+            co = 1 + snc_rng_next(&enc->rng) % ((1 << enc->gfpower) - 1);
+        gf_set_element(enc->cos, i, co, enc->esize);
+        enc->srcs[i] = enc->slab + (size_t) ((first + i) % enc->size_w) * PADDED(enc->size_p);
+    }
+    pkt->first = first;
+    pkt->count = count;
+    memcpy(pkt->coes, enc->cos, count * enc->esize);
+    memset(pkt->syms, 0, enc->size_p);
+    galois_multiply_add_region_multi_packed(enc->gf, pkt->syms, enc->srcs, enc->cos, count, enc->size_p);
+    return 0;
+}
+
+int snc_stream_source_packet_im(struct snc_stream_encoder *enc, struct snc_stream_packet *pkt)
+{
+    if (enc->next == 0)
+        return -1;
+    pkt->first = enc->next - 1;
+    pkt->count = 1;
+    gf_set_element(pkt->coes, 0, 1, enc->esize);
+    memcpy(pkt->syms, enc->slab + (size_t) (pkt->first % enc->size_w) * PADDED(enc->size_p), enc->size_p);
+    return 0;
+}
+
+void snc_free_stream_encoder(struct snc_stream_encoder *enc)
+{
+    if (enc == NULL)
+        return;
+    gf_field_put(enc->gf);
+    free(enc->slab);
+    free(enc->srcs);
+    free(enc->cos);
+    free(enc);
+}
+
+struct snc_stream_packet *snc_alloc_stream_packet(int size_p, int size_w, int gfpower)
+{
+    struct snc_stream_packet *pkt = calloc(1, sizeof(struct snc_stream_packet));
+    if (pkt == NULL)
+        return NULL;
+    pkt->coes = calloc(size_w, gfpower == 16 ? 2 : 1);
+    pkt->syms = calloc(size_p, sizeof(GF_ELEMENT));
+    if (pkt->coes == NULL || pkt->syms == NULL) {
+        snc_free_stream_packet(pkt);
+        return NULL;
+    }
+    return pkt;
+}
+
+void snc_free_stream_packet(struct snc_stream_packet *pkt)
+{
+    if (pkt == NULL)
+        return;
+    free(pkt->coes);
+    free(pkt->syms);
+    free(pkt);
+}
+
+/*
+ * A serialized stream packet consists of the 4-byte first and count, the
+ * count coefficients of the window (bit-packed in GF(2)), and the size_p
+ * bytes of payload.
+ */
+int snc_stream_packet_length(struct snc_stream_packet *pkt, int size_p, int gfpower)
+{
+    return 4 + 4 + ALIGN(pkt->count * gfpower, 8) + size_p;
+}
+
+unsigned char *snc_stream_serialize_packet(struct snc_stream_packet *pkt, int size_p, int gfpower)
+{
+    if (pkt == NULL)
+        return NULL;
+    unsigned char *pktstr = calloc(snc_stream_packet_length(pkt, size_p, gfpower), sizeof(unsigned char));
+    if (pktstr == NULL)
+        return NULL;
+    int ces_len = ALIGN(pkt->count * gfpower, 8);
+    memcpy(pktstr, &pkt->first, 4);
+    memcpy(pktstr+4, &pkt->count, 4);
+    if (gfpower == 1) {
+        for (int i=0; i<pkt->count; i++) {
+            if (pkt->coes[i])
+                set_bit_in_array(pktstr+8, i);
+        }
+    } else {
+        memcpy(pktstr+8, pkt->coes, ces_len);
+    }
+    memcpy(pktstr+8+ces_len, pkt->syms, size_p);
+    return pktstr;
+}
+
+struct snc_stream_packet *snc_stream_deserialize_packet(unsigned char *pktstr, int size_p, int size_w, int gfpower)
+{
+    if (pktstr == NULL)
+        return NULL;
+    int first, count;
+    memcpy(&first, pktstr, 4);
+    memcpy(&count, pktstr+4, 4);
+    if (first < 0 || count <= 0 || count > size_w) {
+        fprintf(stderr, "stream: packet of window [%d, %d+%d) does not fit windows of %d packets\n", first, first, count, size_w);
+        return NULL;
+    }
+    struct snc_stream_packet *pkt = snc_alloc_stream_packet(size_p, size_w, gfpower);
+    if (pkt == NULL)
+        return NULL;
+    int ces_len = ALIGN(count * gfpower, 8);
+    pkt->first = first;
+    pkt->count = count;
+    if (gfpower == 1) {
+        for (int i=0; i<count; i++)
+            pkt->coes[i] = get_bit_in_array(pktstr+8, i);
+    } else {
+        memcpy(pkt->coes, pktstr+8, ces_len);
+    }
+    memcpy(pkt->syms, pktstr+8+ces_len, size_p);
+    return pkt;
+}
+
+struct snc_stream_decoder *snc_create_stream_decoder(int size_p, int size_w, int gfpower)
+{
+    if (verify_stream_parameter(size_p, size_w, gfpower) != 0)
+        return NULL;
+    struct snc_stream_decoder *dec = calloc(1, sizeof(struct snc_stream_decoder));
+    if (dec == NULL)
+        return NULL;
+    dec->size_p = size_p;
+    dec->size_w = size_w;
+    dec->esize  = gfpower == 16 ? 2 : 1;
+    dec->cap    = 2 * size_w;
+    int cap = dec->cap;
+    if ((dec->gf = gf_field_get(gfpower)) == NULL
+            || (dec->cols = calloc(cap, sizeof(struct stream_column))) == NULL
+            || (dec->coes = calloc((size_t) cap * cap, dec->esize)) == NULL
+            || (dec->slab = calloc_payload_slab(cap, size_p)) == NULL
+            || (dec->vec = calloc(cap, dec->esize)) == NULL
+            || (dec->sym = calloc_payload(size_p)) == NULL) {
+        fprintf(stderr, "malloc stream decoder failed\n");
+        snc_free_stream_decoder(dec);
+        return NULL;
+    }
+    for (int i=0; i<cap; i++) {
+        dec->cols[i].coes = dec->coes + (size_t) i * cap * dec->esize;
+        dec->cols[i].syms = dec->slab + (size_t) i * PADDED(size_p);
+    }
+    return dec;
+}
+
+static inline struct stream_column *column(struct snc_stream_decoder *dec, int c)
+{
+    return &dec->cols[c % dec->cap];
+}
+
+/*
+ * Drop columns below newbase to make room for newer ones. Columns among
+ * them that are not popped by the application yet are popped as lost.
+ */
+static void slide_columns(struct snc_stream_decoder *dec, int newbase)
+{
+    for (int c=dec->base; c<newbase; c++)
+        column(dec, c)->state = COL_EMPTY;
+    if (dec->next < newbase)
+        dec->next = newbase;
+    dec->base = newbase;
+}
+
+/*
+ * Reduce the packet against decoded columns and stored rows. Store the
+ * result as a new row pivoted at its first non-zero column. Return 1 if
+ * the packet is innovative, 0 otherwise.
+ */
+static int insert_row(struct snc_stream_decoder *dec, struct snc_stream_packet *pkt)
+{
+    int esize = dec->esize;
+    int first = pkt->first;
+    int hi    = first + pkt->count;
+    GF_ELEMENT *vec = dec->vec;     // column c at vec[(c-first)*esize]
+    memset(vec, 0, dec->cap * esize);
+    memcpy(vec, pkt->coes, pkt->count * esize);
+    memcpy(dec->sym, pkt->syms, dec->size_p);
+    for (int c=first; c<hi; c++) {
+        GF_WORD x = gf_get_element(vec, c-first, esize);
+        if (x == 0)
+            continue;
+        struct stream_column *col = column(dec, c);
+        GF_WORD q;
+        switch (col->state) {
+        case COL_DECODED:
+            galois_multiply_add_region(dec->gf, dec->sym, col->syms, x, dec->size_p);
+            gf_set_element(vec, c-first, 0, esize);
+            break;
+        case COL_ROW:
+            q = galois_divide(dec->gf, x, gf_get_element(col->coes, 0, esize));
+            galois_multiply_add_region(dec->gf, &vec[(c-first)*esize], col->coes, q, col->len*esize);
+            galois_multiply_add_region(dec->gf, dec->sym, col->syms, q, dec->size_p);
+            if (c + col->len > hi)
+                hi = c + col->len;
+            break;
+        case COL_LOST:
+            return 0;
+        default:
+            // trailing zeros are not stored
+            while (gf_get_element(vec, hi-1-first, esize) == 0)
+                hi--;
+            col->len = hi - c;
+            memcpy(col->coes, &vec[(c-first)*esize], col->len * esize);
+            memcpy(col->syms, dec->sym, dec->size_p);
+            col->state = COL_ROW;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Back-substitute the closed block of rows pivoted at columns [from, to)
+static void solve_block(struct snc_stream_decoder *dec, int from, int to)
+{
+    int esize = dec->esize;
+    for (int p=to-1; p>=from; p--) {
+        struct stream_column *col = column(dec, p);
+        for (int j=1; j<col->len; j++) {
+            GF_WORD x = gf_get_element(col->coes, j, esize);
+            if (x != 0)
+                galois_multiply_add_region(dec->gf, col->syms, column(dec, p+j)->syms, x, dec->size_p);
+        }
+        GF_WORD pivot = gf_get_element(col->coes, 0, esize);
+        if (pivot != 1)
+            galois_multiply_region(dec->gf, col->syms, galois_divide(dec->gf, 1, pivot), dec->size_p);
+        col->state = COL_DECODED;
+    }
+}
+
+/*
+ * Release columns from next on in order. A row pivoted at next is solved
+ * when the rows pivoted at next and onwards form a closed block, i.e.
+ * every column they cover has a pivot. A column below wstart without a
+ * pivot will never get one, so it is lost together with the rows
+ * covering it. Return the number of released columns.
+ */
+static int release_columns(struct snc_stream_decoder *dec)
+{
+    int released = 0;
+    while (dec->next < dec->base + dec->cap) {
+        struct stream_column *col = column(dec, dec->next);
+        if (col->state == COL_LOST) {
+            dec->next++;
+            released++;
+            continue;
+        }
+        if (col->state == COL_EMPTY) {
+            if (dec->next >= dec->wstart)
+                break;
+            col->state = COL_LOST;
+            dec->next++;
+            released++;
+            continue;
+        }
+        int c = dec->next;
+        int end = c + 1;
+        while (c < end && column(dec, c)->state == COL_ROW) {
+            if (c + column(dec, c)->len > end)
+                end = c + column(dec, c)->len;
+            c++;
+        }
+        if (c == end) {
+            solve_block(dec, dec->next, end);
+            released += end - dec->next;
+            dec->next = end;
+            continue;
+        }
+        if (c >= dec->wstart)
+            break;      // column c may be covered by future packets
+        column(dec, c)->state = COL_LOST;
+        for (int p=dec->next; p<c; p++) {
+            if (column(dec, p)->state == COL_ROW && p + column(dec, p)->len > c)
+                column(dec, p)->state = COL_EMPTY;
+        }
+    }
+    return released;
+}
+
+int snc_stream_process_packet(struct snc_stream_decoder *dec, struct snc_stream_packet *pkt)
+{
+    if (pkt->count <= 0 || pkt->count > dec->size_w || pkt->first < dec->base)
+        return 0;       // malformed, or covers columns no longer held
+    if (pkt->first + pkt->count > dec->base + dec->cap)
+        slide_columns(dec, pkt->first + pkt->count - dec->cap);
+    // the encoder window ends with the packet, earlier columns have left it
+    if (pkt->first + pkt->count - dec->size_w > dec->wstart)
+        dec->wstart = pkt->first + pkt->count - dec->size_w;
+    insert_row(dec, pkt);
+    return release_columns(dec);
+}
+
+int snc_stream_pop(struct snc_stream_decoder *dec, unsigned char *data, int *lost)
+{
+    if (dec->popped >= dec->next)
+        return -1;
+    struct stream_column *col = column(dec, dec->popped);
+    *lost = dec->popped < dec->base || col->state != COL_DECODED;
+    if (!*lost)
+        memcpy(data, col->syms, dec->size_p);
+    return dec->popped++;
+}
+
+void snc_free_stream_decoder(struct snc_stream_decoder *dec)
+{
+    if (dec == NULL)
+        return;
+    gf_field_put(dec->gf);
+    free(dec->cols);
+    free(dec->coes);
+    free(dec->slab);
+    free(dec->vec);
+    free(dec->sym);
+    free(dec);
+}